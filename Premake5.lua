@@ -106,6 +106,11 @@ Dependencies = {
 	"tinyGLTF",
 }
 
+-- Set this to true once the bullet libraries in dependencies/bullet3/lib have been rebuilt with
+-- BT_THREADSAFE=1 (BULLET2_MULTITHREADING in bullet's CMake). The prebuilt ones were not, and
+-- BT_THREADSAFE has to match how bullet was built, so the multithreaded physics world is left out
+BulletThreadSafe = false
+
 DependenciesDebug = {
 	"dependencies/bullet3/lib/Bullet3Common_Debug.lib",
 	"dependencies/bullet3/lib/BulletCollision_Debug.lib",
@@ -353,11 +358,17 @@ function AddProjects(groupName, folders)
 	            "%{prj.location}\\src\\**.hpp"
 			}
 
-			-- Disable CRT secure warnings
+			-- Disable CRT secure warnings, and let GUIDs be stored in cereal archives
 			defines {
-				"_CRT_SECURE_NO_WARNINGS"
+				"_CRT_SECURE_NO_WARNINGS",
+				"GUID_CEREAL_ARCHIVES"
 			}
 
+			-- Enables the multithreaded physics world, see BulletThreadSafe above
+			if BulletThreadSafe then
+				defines { "BT_THREADSAFE=1" }
+			end
+
 			-- We update the reserved include directory to be the project's source directory
 			ProjIncludes[1] = srcdir
 			-- Defines what directories we want to include
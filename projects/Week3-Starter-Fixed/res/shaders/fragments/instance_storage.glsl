@@ -0,0 +1,24 @@
+// Stores the per-instance data for instanced draws, each instance's record matches the
+// layout of b_InstanceLevelUniforms in frame_uniforms.glsl
+struct InstanceData {
+    // Complete MVP
+    mat4 ModelViewProjection;
+    // Just the model transform, we'll do worldspace lighting
+    mat4 Model;
+    // Normal Matrix for transforming normals
+    mat4 NormalMatrix;
+};
+
+// The renderer binds the range of records for each instanced batch, so we can index by gl_InstanceID
+layout (std430, binding = 1) readonly buffer b_InstanceData {
+    InstanceData u_Instances[];
+};
+
+// For multi-draw batches, each draw's offset into the records is passed in here (see GeometryStore.h),
+// for regular instanced draws the attribute is disabled and will read as 0
+layout (location = 15) in float inDrawOffset;
+
+// Gets the index of this instance's record in u_Instances
+int GetInstanceIndex() {
+    return gl_InstanceID + int(inDrawOffset);
+}
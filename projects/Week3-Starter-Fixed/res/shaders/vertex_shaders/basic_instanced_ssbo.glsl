@@ -0,0 +1,36 @@
+#version 440
+
+// Include our common vertex shader attributes and uniforms
+#include "../fragments/vs_common.glsl"
+// Include the per-instance matrices
+#include "../fragments/instance_storage.glsl"
+
+void main() {
+	// Grab this instance's matrices from the instance buffer
+	InstanceData instance = u_Instances[GetInstanceIndex()];
+
+	gl_Position = instance.ModelViewProjection * vec4(inPosition, 1.0);
+
+	// Lecture 5
+	// Pass vertex pos in world space to frag shader
+	outWorldPos = (instance.Model * vec4(inPosition, 1.0)).xyz;
+
+	// Normals
+	outNormal = mat3(instance.NormalMatrix) * inNormal;
+
+    // We use a TBN matrix for tangent space normal mapping
+    vec3 T = normalize(vec3(mat3(instance.NormalMatrix) * inTangent));
+    vec3 B = normalize(vec3(mat3(instance.NormalMatrix) * inBiTangent));
+    vec3 N = normalize(vec3(mat3(instance.NormalMatrix) * inNormal));
+    mat3 TBN = mat3(T, B, N);
+
+    // We can pass the TBN matrix to the fragment shader to save computation
+    outTBN = TBN;
+
+	// Pass our UV coords to the fragment shader
+	outUV = inUV;
+
+	///////////
+	outColor = inColor;
+
+}
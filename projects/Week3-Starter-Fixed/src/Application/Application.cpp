@@ -7,10 +7,12 @@
 #include "Logging.h"
 #include "Gameplay/InputEngine.h"
 #include "Application/Timing.h"
+#include "Application/JobSystem.h"
 #include <filesystem>
 #include "Layers/GLAppLayer.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/ResourceManager/ResourceManager.h"
+#include "Utils/VirtualFileSystem.h"
 #include "Utils/ImGuiHelper.h"
 
 // Graphics
@@ -22,6 +24,7 @@
 #include "Graphics/Textures/Texture2D.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Textures/TextureCube.h"
+#include "Graphics/Textures/TextureUploader.h"
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Font.h"
 #include "Graphics/GuiBatcher.h"
@@ -53,6 +56,8 @@
 #include "Gameplay/Components/GUI/GuiText.h"
 #include "Gameplay/Components/ComponentManager.h"
 
+#include "Application/SelfTest.h"
+
 // Layers
 #include "Layers/RenderLayer.h"
 #include "Layers/InterfaceLayer.h"
@@ -73,6 +78,10 @@ Application::Application() :
 	_windowSize({DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT}),
 	_isRunning(false),
 	_isEditor(true),
+	_runSelfTests(false),
+	_runBenchmarks(false),
+	_selfTestFilter(""),
+	_exitCode(0),
 	_windowTitle("INFR - 2350U"),
 	_currentScene(nullptr),
 	_targetScene(nullptr),
@@ -86,10 +95,24 @@ Application& Application::Get() {
 	return *_singleton;
 }
 
-void Application::Start(int argCount, char** arguments) {
+int Application::Start(int argCount, char** arguments) {
 	LOG_ASSERT(_singleton == nullptr, "Application has already been started!");
 	_singleton = new Application();
+
+	// Check if we've been asked to run tests rather than the game
+	for (int ix = 1; ix < argCount; ix++) {
+		std::string arg = arguments[ix];
+		if (arg == "--selftest" || arg == "--benchmark") {
+			_singleton->_runSelfTests = arg == "--selftest";
+			_singleton->_runBenchmarks = arg == "--benchmark";
+			if (ix + 1 < argCount && arguments[ix + 1][0] != '-') {
+				_singleton->_selfTestFilter = arguments[++ix];
+			}
+		}
+	}
+
 	_singleton->_Run();
+	return _singleton->_exitCode;
 }
 
 GLFWwindow* Application::GetWindow() { return _window; }
@@ -115,16 +138,23 @@ void Application::Quit() {
 }
 
 bool Application::LoadScene(const std::string& path) {
-	if (std::filesystem::exists(path)) { 
+	if (VirtualFileSystem::Exists(path)) { 
 
 		std::string manifestPath = std::filesystem::path(path).stem().string() + "-manifest.json";
-		if (std::filesystem::exists(manifestPath)) {
+		if (VirtualFileSystem::Exists(manifestPath)) {
 			LOG_INFO("Loading manifest from \"{}\"", manifestPath);
-			ResourceManager::LoadManifest(manifestPath);
+			// Preload everything up front, so independent resources can load in parallel rather than one at a time as the scene asks for them
+			ResourceManager::LoadManifest(manifestPath, true, [](uint32_t loaded, uint32_t total) {
+				LOG_TRACE("Loading resources: {}/{}", loaded, total);
+			});
 		}
 
-		Gameplay::Scene::Sptr scene = Gameplay::Scene::Load(path);
-		LoadScene(scene);
+		// Binary scenes are picked out by their extension, everything else is treated as JSON
+		Gameplay::Scene::Sptr scene = std::filesystem::path(path).extension() == Gameplay::Scene::BINARY_EXTENSION ?
+			Gameplay::Scene::LoadBinary(path) : Gameplay::Scene::Load(path);
+		if (scene != nullptr) {
+			LoadScene(scene);
+		}
 		return scene != nullptr;
 	}
 	return false;
@@ -172,6 +202,18 @@ void Application::_Run()
 	// By default, we want our viewport to be the whole screen
 	_primaryViewport = { 0, 0, _windowSize.x, _windowSize.y };
 
+	// Spin up our worker threads, 0 will use all available hardware threads
+	JobSystem::Init(JsonGet(_appSettings, "worker_threads", 0));
+
+	// Mount any asset packs that have been built, files that aren't in a pack will still be read from disk
+	if (_appSettings["asset_packs"].is_array()) {
+		for (const auto& pack : _appSettings["asset_packs"]) {
+			if (pack.is_string() && std::filesystem::exists(pack.get<std::string>())) {
+				VirtualFileSystem::Mount(pack.get<std::string>());
+			}
+		}
+	}
+
 	// Register all component and resource types
 	_RegisterClasses();
 
@@ -179,6 +221,16 @@ void Application::_Run()
 	// Load all layers
 	_Load();
 
+	// Tests need the GL context and registered types, but should not run any frames
+	if (_runSelfTests || _runBenchmarks) {
+		_exitCode = SelfTest::Run(_runBenchmarks, _selfTestFilter);
+		_Unload();
+		return;
+	}
+
+	// The time we can spend each frame on uploading resources that were loaded in the background
+	double uploadBudget = JsonGet(_appSettings, "upload_budget_ms", 2.0) / 1000.0;
+
 	// Grab current time as the previous frame
 	double lastFrame =  glfwGetTime();
 
@@ -216,6 +268,9 @@ void Application::_Run()
 		timing._timeSinceSceneLoad += scaledDt;
 		timing._unscaledTimeSinceSceneLoad += dt;
 
+		// Finish off any resources that have loaded in the background, before anyone tries to draw them
+		ResourceManager::ProcessUploads(uploadBudget);
+
 		ImGuiHelper::StartFrame();
 
 		// Core update loop
@@ -387,6 +442,19 @@ void Application::_Unload() {
 
 	// Clean up ImGui
 	ImGuiHelper::Cleanup();
+
+	// Finish any loads that are still in flight while the workers and GL context are still around, their uploads
+	// still hold on to the resources they're loading
+	ResourceManager::Cleanup();
+
+	// Release the staging buffer used for texture uploads
+	TextureUploader::Cleanup();
+
+	// Stop our worker threads
+	JobSystem::Shutdown();
+
+	// Release our asset packs now that nothing can be loading from them
+	VirtualFileSystem::UnmountAll();
 }
 
 void Application::_HandleSceneChange() {
@@ -470,6 +538,9 @@ nlohmann::json Application::_GetDefaultAppSettings()
 
 	result["window_width"]  = DEFAULT_WINDOW_WIDTH;
 	result["window_height"] = DEFAULT_WINDOW_HEIGHT;
+	result["worker_threads"] = 0;
+	result["upload_budget_ms"] = 2.0;
+	result["asset_packs"] = nlohmann::json::array({ "assets" + AssetPack::EXTENSION });
 	return result;
 }
 
@@ -31,8 +31,13 @@ public:
 	/**
 	 * Called by the entry point to begin the application, creating the singleton 
 	 * intance and performing any library initialization
+	 * 
+	 * Passing --selftest or --benchmark (optionally followed by a filter) will run the
+	 * engine's built in tests instead of the game loop, see SelfTest.h
+	 * 
+	 * @returns The exit code for the process, the number of failed tests when running tests
 	 */
-	static void Start(int argCount, char** arguments);
+	static int Start(int argCount, char** arguments);
 
 	/**
 	 * Gets the GLFW window for the application
@@ -126,6 +131,13 @@ protected:
 	// Not an idea way of distinguising, since we need to build editor into our game, but good 'nuff for GDW
 	bool        _isEditor;
 
+	// If set, we run the built in checks or benchmarks instead of the game loop
+	bool        _runSelfTests;
+	bool        _runBenchmarks;
+	std::string _selfTestFilter;
+	// The code to return from Start
+	int         _exitCode;
+
 	// The primary viewport that the game will render into, in client window bounds
 	glm::uvec4  _primaryViewport;
 
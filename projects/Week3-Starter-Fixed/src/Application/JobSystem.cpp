@@ -0,0 +1,212 @@
+#include "Application/JobSystem.h"
+#include "Logging.h"
+
+std::vector<std::unique_ptr<JobSystem::WorkerQueue>> JobSystem::_queues;
+JobSystem::WorkerQueue   JobSystem::_backgroundQueue;
+std::vector<std::thread> JobSystem::_workers;
+std::atomic<bool>        JobSystem::_isRunning{ false };
+int                      JobSystem::_requestedWorkers = 0;
+std::atomic<uint32_t>    JobSystem::_queuedJobs{ 0 };
+std::atomic<uint32_t>    JobSystem::_nextQueue{ 0 };
+std::mutex               JobSystem::_sleepMutex;
+std::condition_variable  JobSystem::_wakeCondition;
+thread_local uint32_t    JobSystem::_threadIndex = 0;
+
+void JobSystem::Init(int numWorkers) {
+	LOG_ASSERT(!_isRunning, "Job system has already been initialized!");
+	_requestedWorkers = numWorkers;
+
+	// Leave a hardware thread for the main thread
+	if (numWorkers <= 0) {
+		int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	// One queue for the main thread, plus one for each worker
+	_queues.clear();
+	for (int ix = 0; ix <= numWorkers; ix++) {
+		_queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	_isRunning = true;
+	for (int ix = 1; ix <= numWorkers; ix++) {
+		_workers.emplace_back(&JobSystem::_WorkerMain, static_cast<uint32_t>(ix));
+	}
+
+	LOG_INFO("Job system started with {} worker threads", numWorkers);
+}
+
+void JobSystem::Shutdown() {
+	if (!_isRunning) {
+		return;
+	}
+
+	// Flag the workers to stop and wake them all up so they can see it
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_isRunning = false;
+	}
+	_wakeCondition.notify_all();
+
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+
+	// Someone may still be waiting on the jobs that were left behind, so rather than dropping them (and leaving
+	// their counters pending forever) we run them here. Anything they submit lands in the queues and gets run too
+	while (_TryRunJob(0)) { }
+
+	_queues.clear();
+	_queuedJobs = 0;
+}
+
+uint32_t JobSystem::WorkerCount() {
+	return static_cast<uint32_t>(_workers.size());
+}
+
+int JobSystem::RequestedWorkers() {
+	return _requestedWorkers;
+}
+
+bool JobSystem::IsRunning() {
+	return _isRunning;
+}
+
+void JobSystem::Submit(Job job, JobCounter& counter, JobPriority priority) {
+	// If we have no queues, there's no one to run the job but us
+	if (_queues.empty()) {
+		job();
+		return;
+	}
+
+	counter.Pending.fetch_add(1, std::memory_order_relaxed);
+
+	// Increment the count under the sleep lock so that workers can't miss the wake up, we do this
+	// before pushing so that the count can never drop below the number of jobs in the queues
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_queuedJobs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Background work all goes in one shared queue. Otherwise workers push to their own queue, and
+	// other threads spread their work over everyone's queues
+	if (priority == JobPriority::Background) {
+		std::lock_guard<std::mutex> lock(_backgroundQueue.Mutex);
+		_backgroundQueue.Jobs.push_back({ std::move(job), &counter });
+	} else {
+		uint32_t queueIndex = _threadIndex != 0 ? _threadIndex : _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+		WorkerQueue& queue = *_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back({ std::move(job), &counter });
+	}
+	_wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	// Rather than sleeping, we help chew through our own jobs until they are done. Jobs from other
+	// counters are left alone, since we have no idea how long they will take
+	while (counter.Pending.load(std::memory_order_acquire) > 0) {
+		if (!_TryRunJob(_threadIndex, &counter)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::TryRunJob(JobCounter& counter) {
+	return counter.Pending.load(std::memory_order_acquire) > 0 && _TryRunJob(_threadIndex, &counter);
+}
+
+bool JobSystem::_TryRunJob(uint32_t threadIndex, const JobCounter* onlyCounter) {
+	if (_queues.empty()) {
+		return false;
+	}
+
+	QueuedJob job{ nullptr, nullptr };
+
+	// Start with our own queue, taking the most recent job since it's most likely to be hot in cache
+	bool found = _TakeJob(*_queues[threadIndex], true, onlyCounter, job);
+
+	// If we're out of work, steal the oldest job from another thread
+	for (size_t ix = 1; !found && ix < _queues.size(); ix++) {
+		found = _TakeJob(*_queues[(threadIndex + ix) % _queues.size()], false, onlyCounter, job);
+	}
+
+	// Background work is only picked up once there's nothing more pressing to do
+	if (!found) {
+		found = _TakeJob(_backgroundQueue, false, onlyCounter, job);
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+	// A throwing job must still be counted as done, otherwise anyone waiting on it would hang (and
+	// an exception escaping a worker's thread function would terminate the app)
+	try {
+		job.Callback();
+	}
+	catch (const std::exception& e) {
+		LOG_ERROR("Job threw an exception: {}", e.what());
+	}
+	catch (...) {
+		LOG_ERROR("Job threw an unknown exception");
+	}
+	job.Counter->Pending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+bool JobSystem::_TakeJob(WorkerQueue& queue, bool fromBack, const JobCounter* onlyCounter, QueuedJob& result) {
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Jobs.empty()) {
+		return false;
+	}
+
+	// Any job will do, so we can just grab one off the end
+	if (onlyCounter == nullptr) {
+		if (fromBack) {
+			result = std::move(queue.Jobs.back());
+			queue.Jobs.pop_back();
+		} else {
+			result = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+		}
+		return true;
+	}
+
+	// Otherwise we need to search for a job that belongs to the counter
+	if (fromBack) {
+		for (auto it = queue.Jobs.rbegin(); it != queue.Jobs.rend(); ++it) {
+			if (it->Counter == onlyCounter) {
+				result = std::move(*it);
+				queue.Jobs.erase(std::next(it).base());
+				return true;
+			}
+		}
+	} else {
+		for (auto it = queue.Jobs.begin(); it != queue.Jobs.end(); ++it) {
+			if (it->Counter == onlyCounter) {
+				result = std::move(*it);
+				queue.Jobs.erase(it);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void JobSystem::_WorkerMain(uint32_t threadIndex) {
+	_threadIndex = threadIndex;
+
+	while (_isRunning) {
+		if (!_TryRunJob(threadIndex)) {
+			// Nothing to do, sleep until more work is submitted or we're shutting down
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_wakeCondition.wait(lock, []() {
+				return !_isRunning || _queuedJobs.load(std::memory_order_relaxed) > 0;
+			});
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Utils/Macros.h"
+
+/**
+ * A counter that tracks a group of submitted jobs. Every job submitted against the counter
+ * increments it, and it is decremented as each job finishes. JobSystem::Wait can be used to
+ * block until all of the jobs have completed
+ */
+struct JobCounter {
+	NO_MOVE(JobCounter)
+	NO_COPY(JobCounter)
+
+	JobCounter() = default;
+
+	std::atomic<uint32_t> Pending{ 0 };
+};
+
+/**
+ * Controls which jobs the pool picks up first
+ */
+enum class JobPriority {
+	// Work that someone is going to wait on soon, ex: splitting up a frame's update
+	Normal,
+	// Long running work that nobody is blocked on, ex: decoding resources in the background. Workers
+	// only pick these up when there is no normal work to do
+	Background
+};
+
+/**
+ * The job system is a simple work-stealing thread pool. Each thread (including the main thread)
+ * owns a queue of jobs, and will take work from the back of it's own queue. Threads that run out
+ * of work will steal jobs from the front of other thread's queues.
+ *
+ * Threads that are waiting on a JobCounter will help out by running jobs tracked by that counter
+ * while they wait, so it is safe to submit and wait on jobs from within other jobs. Waiting threads
+ * never pick up unrelated jobs, so a frame waiting on it's own work can't get stuck behind a long
+ * running background job
+ *
+ * Exceptions thrown by jobs are caught and logged, and the job still counts as finished
+ */
+class JobSystem final {
+public:
+	typedef std::function<void()> Job;
+
+	/**
+	 * Starts the worker threads for the job system, should be called once when the application starts
+	 *
+	 * @param numWorkers The number of worker threads to create, if 0 or less, one worker will be created
+	 *                   for each hardware thread other than the main thread
+	 */
+	static void Init(int numWorkers = 0);
+	/**
+	 * Stops and joins all worker threads. Any jobs left in the queues are run on the calling thread
+	 * before this returns, so that nothing waiting on them is left hanging
+	 */
+	static void Shutdown();
+
+	/**
+	 * Gets the number of worker threads that are running, not including the main thread
+	 */
+	static uint32_t WorkerCount();
+	/**
+	 * Gets the worker count that was passed to the last call to Init, so that the job system can be
+	 * restarted with the same settings (0 or less meaning one worker per extra hardware thread)
+	 */
+	static int RequestedWorkers();
+	/**
+	 * Returns true if Init has been called, and Shutdown has not been called since
+	 */
+	static bool IsRunning();
+
+	/**
+	 * Submits a job to be executed by the pool. If the job system has not been initialized,
+	 * the job will be run immediately on the calling thread
+	 *
+	 * @param job      The job to run
+	 * @param counter  The counter to track the job with, must outlive the job
+	 * @param priority The priority of the job, see JobPriority
+	 */
+	static void Submit(Job job, JobCounter& counter, JobPriority priority = JobPriority::Normal);
+
+	/**
+	 * Waits for all jobs submitted against the counter to finish. The calling thread will run
+	 * any of the counter's jobs that are still queued while it waits
+	 *
+	 * @param counter The counter to wait on
+	 */
+	static void Wait(JobCounter& counter);
+	/**
+	 * Runs one of the counter's jobs on the calling thread if any are still queued, without waiting
+	 * for jobs that other threads are running. Lets a thread help out with work while it does
+	 * something else between jobs (ex: reporting progress)
+	 *
+	 * @param counter The counter whose jobs may be run
+	 * @returns True if a job was run, false if none of the counter's jobs were queued
+	 */
+	static bool TryRunJob(JobCounter& counter);
+
+	/**
+	 * Splits the range [0, count) into chunks of grainSize elements, and runs the callback for each
+	 * chunk across the pool. Blocks until all chunks are complete, so this doubles as a barrier
+	 *
+	 * @param count     The number of elements to process
+	 * @param grainSize The number of elements to process in each job, should be large enough that
+	 *                  the work in each job outweighs the cost of scheduling it
+	 * @param func      The callback to invoke, with the signature void(size_t start, size_t end)
+	 */
+	template <typename Func>
+	static void ParallelFor(size_t count, size_t grainSize, const Func& func) {
+		if (count == 0) {
+			return;
+		}
+		grainSize = grainSize == 0 ? 1 : grainSize;
+
+		// If there's nobody to share with, or the workload is tiny, just run it in place
+		if (WorkerCount() == 0 || count <= grainSize) {
+			func(static_cast<size_t>(0), count);
+			return;
+		}
+
+		JobCounter counter;
+		for (size_t start = 0; start < count; start += grainSize) {
+			size_t end = start + grainSize < count ? start + grainSize : count;
+			Submit([&func, start, end]() { func(start, end); }, counter);
+		}
+		Wait(counter);
+	}
+
+protected:
+	JobSystem() = default;
+
+	// A job that is waiting in a queue, along with the counter that's tracking it
+	struct QueuedJob {
+		Job         Callback;
+		JobCounter* Counter;
+	};
+
+	// Each thread owns one of these, index 0 belongs to the main thread
+	struct WorkerQueue {
+		std::mutex            Mutex;
+		std::deque<QueuedJob> Jobs;
+	};
+
+	static std::vector<std::unique_ptr<WorkerQueue>> _queues;
+	// Shared by all threads, holds background priority jobs in the order they were submitted
+	static WorkerQueue              _backgroundQueue;
+	static std::vector<std::thread> _workers;
+	static std::atomic<bool>        _isRunning;
+	// The worker count passed to Init, see RequestedWorkers
+	static int                      _requestedWorkers;
+	// Total number of jobs sitting in all queues, lets sleeping workers know when to wake up
+	static std::atomic<uint32_t>    _queuedJobs;
+	// Used to spread work from non-worker threads over all the queues
+	static std::atomic<uint32_t>    _nextQueue;
+	static std::mutex               _sleepMutex;
+	static std::condition_variable  _wakeCondition;
+
+	// The index of the queue owned by the current thread
+	static thread_local uint32_t    _threadIndex;
+
+	// Runs a single job, if onlyCounter is set, only jobs tracked by that counter will be run
+	static bool _TryRunJob(uint32_t threadIndex, const JobCounter* onlyCounter = nullptr);
+	// Takes a job out of a queue, searching from the back or the front. Returns false if no job was found
+	static bool _TakeJob(WorkerQueue& queue, bool fromBack, const JobCounter* onlyCounter, QueuedJob& result);
+	static void _WorkerMain(uint32_t threadIndex);
+};
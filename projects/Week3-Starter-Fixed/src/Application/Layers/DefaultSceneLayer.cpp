@@ -71,6 +71,7 @@
 #include "Gameplay/Components/ParticleSystem.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Textures/Texture1D.h"
+#include "Utils/VirtualFileSystem.h"
 
 DefaultSceneLayer::DefaultSceneLayer() :
 	ApplicationLayer()
@@ -94,7 +95,7 @@ void DefaultSceneLayer::_CreateScene()
 
 	bool loadScene = false;
 	// For now we can use a toggle to generate our scene vs load from file
-	if (loadScene && std::filesystem::exists("scene.json")) {
+	if (loadScene && VirtualFileSystem::Exists("scene.json")) {
 		app.LoadScene("scene.json");
 	} else {
 		// This shader handles blinn-phong lighting and all the necessary toggles involved
@@ -103,22 +104,31 @@ void DefaultSceneLayer::_CreateScene()
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/frag_blinn_phong_textured.glsl" }
 		});
 		basicShader->SetDebugName("Blinn-phong");
+
+		// Same as above, but reads the matrices from the instance buffer so the renderer can batch objects
+		ShaderProgram::Sptr basicInstancedShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
+			{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic_instanced_ssbo.glsl" },
+			{ ShaderPartType::Fragment, "shaders/fragment_shaders/frag_blinn_phong_textured.glsl" }
+		});
+		basicInstancedShader->SetDebugName("Blinn-phong (Instanced)");
 		
 		// Load in the meshes
-		MeshResource::Sptr sandMesh = ResourceManager::CreateAsset<MeshResource>("sand.obj");
-		MeshResource::Sptr binMesh = ResourceManager::CreateAsset<MeshResource>("sandbin.obj");
-		MeshResource::Sptr trunkMesh = ResourceManager::CreateAsset<MeshResource>("trunk.obj");
-		MeshResource::Sptr leafMesh = ResourceManager::CreateAsset<MeshResource>("leaf.obj");
-		MeshResource::Sptr ballMesh = ResourceManager::CreateAsset<MeshResource>("ball.obj");
-		MeshResource::Sptr waterMesh = ResourceManager::CreateAsset<MeshResource>("water.obj");
-
-		// Load in some textures
-		Texture2D::Sptr sandTex = ResourceManager::CreateAsset<Texture2D>("textures/sand.png");
-		Texture2D::Sptr binTex = ResourceManager::CreateAsset<Texture2D>("textures/bin.png");
-		Texture2D::Sptr trunkTex = ResourceManager::CreateAsset<Texture2D>("textures/trunk.png");
-		Texture2D::Sptr leafTex = ResourceManager::CreateAsset<Texture2D>("textures/leaf.png");
-		Texture2D::Sptr ballTex = ResourceManager::CreateAsset<Texture2D>("textures/ball.png");
-		Texture2D::Sptr waterTex = ResourceManager::CreateAsset<Texture2D>("textures/water.png");
+		MeshResource::Sptr sandMesh = ResourceManager::CreateAssetAsync<MeshResource>("sand.obj");
+		MeshResource::Sptr binMesh = ResourceManager::CreateAssetAsync<MeshResource>("sandbin.obj");
+		MeshResource::Sptr trunkMesh = ResourceManager::CreateAssetAsync<MeshResource>("trunk.obj");
+		MeshResource::Sptr leafMesh = ResourceManager::CreateAssetAsync<MeshResource>("leaf.obj");
+		MeshResource::Sptr ballMesh = ResourceManager::CreateAssetAsync<MeshResource>("ball.obj");
+		MeshResource::Sptr waterMesh = ResourceManager::CreateAssetAsync<MeshResource>("water.obj");
+
+		// Load in some textures, our diffuse textures are block compressed to save on memory and load times
+		Texture2DDescription compressedDesc = Texture2DDescription();
+		compressedDesc.Compress = true;
+		Texture2D::Sptr sandTex = ResourceManager::CreateAssetAsync<Texture2D>("textures/sand.png", compressedDesc);
+		Texture2D::Sptr binTex = ResourceManager::CreateAssetAsync<Texture2D>("textures/bin.png", compressedDesc);
+		Texture2D::Sptr trunkTex = ResourceManager::CreateAssetAsync<Texture2D>("textures/trunk.png", compressedDesc);
+		Texture2D::Sptr leafTex = ResourceManager::CreateAssetAsync<Texture2D>("textures/leaf.png", compressedDesc);
+		Texture2D::Sptr ballTex = ResourceManager::CreateAssetAsync<Texture2D>("textures/ball.png", compressedDesc);
+		Texture2D::Sptr waterTex = ResourceManager::CreateAssetAsync<Texture2D>("textures/water.png", compressedDesc);
 
 		Texture1D::Sptr diffRamp = ResourceManager::CreateAsset<Texture1D>("luts/diffuse-1D.png");
 		diffRamp->SetWrap(WrapMode::ClampToEdge);
@@ -135,7 +145,7 @@ void DefaultSceneLayer::_CreateScene()
 		toonLut->SetWrap(WrapMode::ClampToEdge);
 
 		// Here we'll load in the cubemap, as well as a special shader to handle drawing the skybox
-		TextureCube::Sptr testCubemap = ResourceManager::CreateAsset<TextureCube>("cubemaps/ocean/ocean.jpg");
+		TextureCube::Sptr testCubemap = ResourceManager::CreateAssetAsync<TextureCube>("cubemaps/ocean/ocean.jpg");
 		ShaderProgram::Sptr      skyboxShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
 			{ ShaderPartType::Vertex, "shaders/vertex_shaders/skybox_vert.glsl" },
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/skybox_frag.glsl" }
@@ -165,6 +175,7 @@ void DefaultSceneLayer::_CreateScene()
 			sandMaterial->Set("u_Material.Shininess", 0.1f);
 			sandMaterial->Set("u_Material.DiffRamp", diffRamp);
 			sandMaterial->Set("u_Material.SpecRamp", specRamp);
+			sandMaterial->SetInstancedShader(basicInstancedShader);
 		}
 		
 		// This will be the reflective material, we'll make the whole thing 90% reflective
@@ -175,6 +186,7 @@ void DefaultSceneLayer::_CreateScene()
 			binMaterial->Set("u_Material.Shininess", 0.1f);
 			binMaterial->Set("u_Material.DiffRamp", diffRamp);
 			binMaterial->Set("u_Material.SpecRamp", specRamp);
+			binMaterial->SetInstancedShader(basicInstancedShader);
 		}
 
 		// This will be the reflective material, we'll make the whole thing 90% reflective
@@ -185,6 +197,7 @@ void DefaultSceneLayer::_CreateScene()
 			trunkMaterial->Set("u_Material.Shininess", 0.1f);
 			trunkMaterial->Set("u_Material.DiffRamp", diffRamp);
 			trunkMaterial->Set("u_Material.SpecRamp", specRamp);
+			trunkMaterial->SetInstancedShader(basicInstancedShader);
 		}
 
 		Material::Sptr leafMaterial = ResourceManager::CreateAsset<Material>(basicShader);
@@ -194,6 +207,7 @@ void DefaultSceneLayer::_CreateScene()
 			leafMaterial->Set("u_Material.Shininess", 0.1f);
 			leafMaterial->Set("u_Material.DiffRamp", diffRamp);
 			leafMaterial->Set("u_Material.SpecRamp", specRamp);
+			leafMaterial->SetInstancedShader(basicInstancedShader);
 		}
 		
 		// Our toon shader material
@@ -204,6 +218,7 @@ void DefaultSceneLayer::_CreateScene()
 			ballMaterial->Set("u_Material.Shininess", 0.8f);
 			ballMaterial->Set("u_Material.DiffRamp", diffRamp);
 			ballMaterial->Set("u_Material.SpecRamp", specRamp);
+			ballMaterial->SetInstancedShader(basicInstancedShader);
 		}
 
 		Material::Sptr waterMaterial = ResourceManager::CreateAsset<Material>(basicShader);
@@ -213,6 +228,7 @@ void DefaultSceneLayer::_CreateScene()
 			waterMaterial->Set("u_Material.Shininess", 0.9f);
 			waterMaterial->Set("u_Material.DiffRamp", diffRamp);
 			waterMaterial->Set("u_Material.SpecRamp", specRamp);
+			waterMaterial->SetInstancedShader(basicInstancedShader);
 		}
 		
 		// Create some lights for our scene
@@ -5,6 +5,7 @@
 #include "Gameplay/Scene.h"
 #include "../Timing.h"
 #include "Utils/Windows/FileDialogs.h"
+#include "Utils/AssetPack.h"
 #include <filesystem>
 #include "RenderLayer.h"
 #include "../Windows/HierarchyWindow.h"
@@ -158,7 +159,7 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 				// Load scene item
 				if (ImGui::MenuItem("Load Scene", NULL, false)) {
-					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json\0\0");
+					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json;*.bscn\0\0");
 					if (path.has_value()) {
 						app.LoadScene(path.value());
 					}
@@ -166,15 +167,38 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 				// Save scene item
 				if (ImGui::MenuItem("Save Scene", NULL, false)) {
-					std::optional<std::string> path = FileDialogs::SaveFile("Scene File\0*.json\0\0");
+					std::optional<std::string> path = FileDialogs::SaveFile("Scene File\0*.json\0Binary Scene File\0*.bscn\0\0");
 					if (path.has_value()) {
-						app.CurrentScene()->Save(path.value());
+						if (std::filesystem::path(path.value()).extension() == Gameplay::Scene::BINARY_EXTENSION) {
+							app.CurrentScene()->SaveBinary(path.value());
+						} else {
+							app.CurrentScene()->Save(path.value());
+						}
 
 						std::string newFilename = std::filesystem::path(path.value()).stem().string() + "-manifest.json";
 						ResourceManager::SaveManifest(newFilename);
 					}
 				}
 
+				// Packs the current scene and everything it's manifest references into a single file
+				if (ImGui::MenuItem("Build Asset Pack", NULL, false)) {
+					std::optional<std::string> path = FileDialogs::SaveFile("Asset Pack\0*.pak\0\0");
+					if (path.has_value()) {
+						const std::string& scenePath = app.CurrentScene()->GetFilePath();
+						std::string manifestPath = std::filesystem::path(scenePath.empty() ? path.value() : scenePath).stem().string() + "-manifest.json";
+						ResourceManager::SaveManifest(manifestPath);
+
+						// Shaders pull in includes and fonts/LUTs may be loaded by name, so we take those folders wholesale
+						std::vector<std::string> extraPaths = { "shaders", "fonts", "luts" };
+						if (!scenePath.empty()) {
+							std::error_code error;
+							std::filesystem::path relativePath = std::filesystem::relative(scenePath, error);
+							extraPaths.push_back(error ? scenePath : relativePath.string());
+						}
+						AssetPack::Build(path.value(), manifestPath, extraPaths);
+					}
+				}
+
 				ImGui::EndMenu();
 			}
 
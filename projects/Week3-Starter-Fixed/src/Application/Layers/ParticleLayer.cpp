@@ -19,9 +19,9 @@ void ParticleLayer::OnUpdate()
 	// Only update the particle systems when the game is playing, so we can edit them in
 	// the inspector
 	if (app.CurrentScene()->IsPlaying) {
-		app.CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
-			if (system->IsEnabled) {
-				system->Update();
+		app.CurrentScene()->Components().Each<ParticleSystem>([](ParticleSystem& system) {
+			if (system.IsEnabled) {
+				system.Update();
 			}
 		});
 	}
@@ -29,9 +29,9 @@ void ParticleLayer::OnUpdate()
 
 void ParticleLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 {
-	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
-		if (system->IsEnabled) {
-			system->Render();
+	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](ParticleSystem& system) {
+		if (system.IsEnabled) {
+			system.Render();
 		}
 	});
 }
@@ -7,6 +7,7 @@
 #include "../Timing.h"
 #include "Gameplay/Components/ComponentManager.h"
 #include "Gameplay/Components/RenderComponent.h"
+#include "Utils/RadixSort.h"
 
 // GLM math library
 #include <GLM/glm.hpp>
@@ -23,7 +24,16 @@ RenderLayer::RenderLayer() :
 	_frameUniforms(nullptr),
 	_instanceUniforms(nullptr),
 	_renderFlags(RenderFlags::EnableColorCorrection),
-	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f })
+	_multiDrawEnabled(false),
+	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f }),
+	_renderQueue(std::vector<DrawItem>()),
+	_renderQueueScratch(std::vector<DrawItem>()),
+	_frustum(Frustum()),
+	_cullCandidates(std::vector<RenderComponent*>()),
+	_visibility(std::vector<uint8_t>()),
+	_drawBatches(std::vector<DrawBatch>()),
+	_geometryStores(std::vector<GeometryStore::Sptr>()),
+	_renderStats(RenderStats())
 {
 	Name = "Rendering";
 	Overrides = AppLayerFunctions::OnAppLoad | AppLayerFunctions::OnRender | AppLayerFunctions::OnWindowResize;
@@ -57,10 +67,6 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 
-	// The current material that is bound for rendering
-	Material::Sptr currentMat = nullptr;
-	ShaderProgram::Sptr shader = nullptr;
-
 	// Bind the skybox texture to a reserved texture slot
 	// See Material.h and Material.cpp for how we're reserving texture slots
 	TextureCube::Sptr environment = app.CurrentScene()->GetSkyboxTexture();
@@ -74,10 +80,10 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 		colorLUT->Bind(14);
 	}
 
-	// Here we'll bind all the UBOs to their corresponding slots
+	// Here we'll bind all the UBOs to their corresponding slots, the instance data is bound
+	// per draw since each object has it's own range in the instance ring
 	app.CurrentScene()->PreRender();
 	_frameUniforms->Bind(FRAME_UBO_BINDING);
-	_instanceUniforms->Bind(INSTANCE_UBO_BINDING);
 
 	// Draw physics debug
 	app.CurrentScene()->DrawPhysicsDebug();
@@ -94,57 +100,346 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	_frameUniforms->Update();
 
 	Material::Sptr defaultMat = app.CurrentScene()->DefaultMaterial;
-
-	// Render all our objects
-	app.CurrentScene()->Components().Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
+	glm::vec3 cameraPos = glm::vec3(camera->GetGameObject()->GetTransform()[3]);
+
+	// Reset our counters for this frame
+	_renderStats = RenderStats();
+
+	// Adds a renderable to the render queue with the appropriate sorting key
+	_renderQueue.clear();
+	auto enqueue = [&](RenderComponent& renderable) {
+		const Material::Sptr& material = renderable.GetMaterial();
+		glm::vec3 offset = glm::vec3(renderable.GetGameObject()->GetTransform()[3]) - cameraPos;
+
+		DrawItem item;
+		item.Key = _MakeDrawKey(
+			material->IsTransparent,
+			material->GetShader()->GetHandle(),
+			material->GetSortId(),
+			renderable.GetMesh()->GetHandle(),
+			glm::dot(offset, offset)
+		);
+		item.Renderable = &renderable;
+		_renderQueue.push_back(item);
+	};
+
+	// Collect all our renderable objects, anything with bounds gets tested against the camera's frustum
+	_frustum.SetViewProjection(viewProj);
+	_frustum.ClearBoxes();
+	_cullCandidates.clear();
+	app.CurrentScene()->Components().Each<RenderComponent>([&](RenderComponent& renderable) {
 		// Early bail if mesh not set
-		if (renderable->GetMesh() == nullptr) {
+		if (renderable.GetMesh() == nullptr) {
 			return;
 		}
 
 		// If we don't have a material, try getting the scene's fallback material
 		// If none exists, do not draw anything
-		if (renderable->GetMaterial() == nullptr) {
+		if (renderable.GetMaterial() == nullptr) {
 			if (defaultMat != nullptr) {
-				renderable->SetMaterial(defaultMat);
+				renderable.SetMaterial(defaultMat);
 			} else {
 				return;
 			}
 		}
 
-		// If the material has changed, we need to bind the new shader and set up our material and frame data
-		// Note: This is a good reason why we should be sorting the render components in ComponentManager
-		if (renderable->GetMaterial() != currentMat) {
-			currentMat = renderable->GetMaterial();
-			shader = currentMat->GetShader();
+		// Meshes without bounds can't be culled, so they always get drawn
+		const MeshBounds& bounds = renderable.GetMesh()->GetBounds();
+		if (bounds.IsValid) {
+			_frustum.AddBox(bounds, renderable.GetGameObject()->GetTransform());
+			_cullCandidates.push_back(&renderable);
+		} else {
+			enqueue(renderable);
+		}
+	});
 
-			shader->Bind();
-			currentMat->Apply();
+	// Test all the boxes at once, and queue up the ones that survived
+	uint32_t visibleCount = _frustum.Cull(_visibility);
+	for (size_t ix = 0; ix < _cullCandidates.size(); ix++) {
+		if (_visibility[ix]) {
+			enqueue(*_cullCandidates[ix]);
+		}
+	}
+	_renderStats.CulledItems = static_cast<uint32_t>(_cullCandidates.size()) - visibleCount;
+	_renderStats.VisibleItems = static_cast<uint32_t>(_renderQueue.size());
+
+	// Sort by our keys, this groups objects by state and puts transparent objects at the end
+	RadixSort::Sort64(_renderQueue, _renderQueueScratch, [](const DrawItem& item) { return item.Key; });
+
+	// Find where our transparent items start
+	size_t transparentStart = _renderQueue.size();
+	for (size_t ix = 0; ix < _renderQueue.size(); ix++) {
+		if (_renderQueue[ix].Key & TRANSPARENT_KEY_BIT) {
+			transparentStart = ix;
+			break;
 		}
+	}
+	_renderStats.OpaqueItems = static_cast<uint32_t>(transparentStart);
+	_renderStats.TransparentItems = static_cast<uint32_t>(_renderQueue.size() - transparentStart);
 
-		// Grab the game object so we can do some stuff with it
-		GameObject* object = renderable->GetGameObject();
+	// Group the queue into batches, we keep opaque and transparent batches separate since they
+	// need different render states
+	_drawBatches.clear();
+	uint32_t instanceBytes = _BuildDrawBatches(0, transparentStart);
+	size_t transparentBatchStart = _drawBatches.size();
+	instanceBytes += _BuildDrawBatches(transparentStart, _renderQueue.size());
 
-		// Use our uniform buffer for our instance level uniforms
-		auto& instanceData = _instanceUniforms->GetData();
-		instanceData.u_Model = object->GetTransform();
-		instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
-		_instanceUniforms->Update();
+	// Write all our instance data for the frame in one go, straight into mapped memory
+	_instanceUniforms->BeginFrame(instanceBytes);
+	_WriteInstanceData(viewProj);
+	_renderStats.InstanceDataBytes = _instanceUniforms->GetFrameBytesUsed();
 
-		// Draw the object
-		renderable->GetMesh()->Draw();
-	});
+	// Draw all our opaque objects first
+	_DrawBatches(0, transparentBatchStart);
 
 	// Use our cubemap to draw our skybox
 	app.CurrentScene()->DrawSkybox();
 
+	// Transparent objects are drawn last with blending enabled, we don't want them to write to
+	// depth so that they don't hide other transparent objects behind them
+	if (transparentStart < _renderQueue.size()) {
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+
+		_DrawBatches(transparentBatchStart, _drawBatches.size());
+
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+	}
+
+	// Fence off this frame's instance data so we don't overwrite it while the GPU is using it
+	_instanceUniforms->EndFrame();
+
 	// Unbind our primary framebuffer so subsequent draw calls do not modify it
 	//_primaryFBO->Unbind();
 
 	VertexArrayObject::Unbind();
 }
 
+uint64_t RenderLayer::_MakeDrawKey(bool transparent, uint32_t shader, uint32_t material, uint32_t mesh, float depth)
+{
+	// For positive floats, the bit pattern sorts in the same order as the value, so we can
+	// use it directly in our key. We drop the sign bit since distances are never negative
+	uint32_t depthBits = glm::floatBitsToUint(depth) & 0x7FFFFFFF;
+
+	// Note that IDs are masked to fit in the key, so very large IDs may collide. This only affects
+	// how well we group draws, since we still compare the actual state before binding
+	if (transparent) {
+		// Back to front first, then by state
+		uint64_t invDepth = static_cast<uint64_t>(~depthBits & 0x7FFFFFFF);
+		return TRANSPARENT_KEY_BIT |
+			(invDepth << 32) |
+			(static_cast<uint64_t>(shader & 0xFF) << 24) |
+			(static_cast<uint64_t>(material & 0xFFFF) << 8) |
+			static_cast<uint64_t>(mesh & 0xFF);
+	} else {
+		// Shader changes are the most expensive, followed by materials, then meshes. We use the
+		// top 23 bits of the depth to draw roughly front to back within each group
+		return
+			(static_cast<uint64_t>(shader & 0xFFF) << 51) |
+			(static_cast<uint64_t>(material & 0xFFFF) << 35) |
+			(static_cast<uint64_t>(mesh & 0xFFF) << 23) |
+			static_cast<uint64_t>(depthBits >> 8);
+	}
+}
+
+GeometryStore* RenderLayer::_GetGeometryStore(VertexArrayObject* mesh)
+{
+	GeometryStore* store = mesh->GetSharedGeometry().Store;
+	if (store != nullptr || !GeometryStore::CanStore(mesh)) {
+		return store;
+	}
+
+	// Find a store with a matching vertex layout, or make a new one if there are none
+	for (const GeometryStore::Sptr& candidate : _geometryStores) {
+		if (candidate->Add(mesh)) {
+			return candidate.get();
+		}
+	}
+
+	GeometryStore::Sptr result = std::make_shared<GeometryStore>(mesh->GetVertexBuffers()[0]->GetAttributes());
+	_geometryStores.push_back(result);
+	LOG_INFO("Created geometry store #{} for static meshes", _geometryStores.size());
+
+	result->Add(mesh);
+	return result.get();
+}
+
+uint32_t RenderLayer::_BuildDrawBatches(size_t start, size_t end)
+{
+	using namespace Gameplay;
+
+	uint32_t requiredBytes = 0;
+	size_t ix = start;
+	while (ix < end) {
+		RenderComponent* renderable = _renderQueue[ix].Renderable;
+		Material* material = renderable->GetMaterial().get();
+		VertexArrayObject* mesh = renderable->GetMesh().get();
+
+		DrawBatch batch;
+		batch.Start = static_cast<uint32_t>(ix);
+		batch.Instances = { nullptr, 0, 0 };
+		batch.Commands = { nullptr, 0, 0 };
+
+		// Static meshes that live in the same geometry store can all be drawn with a single multi-draw
+		// call, regardless of which mesh they use, as long as they share a material
+		GeometryStore* store = nullptr;
+		if (_multiDrawEnabled && material->GetInstancedShader() != nullptr) {
+			store = _GetGeometryStore(mesh);
+		}
+
+		size_t runEnd = ix + 1;
+		if (store != nullptr) {
+			while (runEnd < end &&
+				_renderQueue[runEnd].Renderable->GetMaterial().get() == material &&
+				_GetGeometryStore(_renderQueue[runEnd].Renderable->GetMesh().get()) == store) {
+				runEnd++;
+			}
+
+			batch.Count = static_cast<uint32_t>(runEnd - ix);
+			batch.Instanced = true;
+			batch.MultiDraw = true;
+			requiredBytes += AbstractUniformBuffer::GetAlignedSize(batch.Count * sizeof(GeometryStore::DrawCommand));
+		} else {
+			// Since the queue is sorted by material then mesh, matching items will be next to each other
+			if (material->GetInstancedShader() != nullptr) {
+				while (runEnd < end &&
+					_renderQueue[runEnd].Renderable->GetMaterial().get() == material &&
+					_renderQueue[runEnd].Renderable->GetMesh().get() == mesh) {
+					runEnd++;
+				}
+			}
+
+			batch.Count = static_cast<uint32_t>(runEnd - ix);
+			batch.Instanced = batch.Count >= MIN_INSTANCED_BATCH_SIZE;
+			batch.MultiDraw = false;
+
+			// Items that aren't instanced get a batch each
+			if (!batch.Instanced) {
+				runEnd = ix + 1;
+				batch.Count = 1;
+			}
+		}
+		requiredBytes += AbstractUniformBuffer::GetAlignedSize(batch.Count * sizeof(InstanceLevelUniforms));
+
+		_drawBatches.push_back(batch);
+		ix = runEnd;
+	}
+	return requiredBytes;
+}
+
+void RenderLayer::_WriteInstanceData(const glm::mat4& viewProj)
+{
+	using namespace Gameplay;
+
+	for (DrawBatch& batch : _drawBatches) {
+		// Instanced batches get one contiguous block so the shader can index it by gl_InstanceID
+		batch.Instances = _instanceUniforms->Allocate(batch.Count * sizeof(InstanceLevelUniforms));
+		InstanceLevelUniforms* records = reinterpret_cast<InstanceLevelUniforms*>(batch.Instances.Data);
+		if (records == nullptr) {
+			continue;
+		}
+
+		for (uint32_t ix = 0; ix < batch.Count; ix++) {
+			GameObject* object = _renderQueue[batch.Start + ix].Renderable->GetGameObject();
+			const glm::mat4& transform = object->GetTransform();
+
+			InstanceLevelUniforms& record = records[ix];
+			record.u_Model = transform;
+			record.u_ModelViewProjection = viewProj * transform;
+			record.u_NormalMatrix = glm::mat3(glm::transpose(object->GetInverseTransform()));
+		}
+
+		// Multi-draw batches get one command per object, with the base instance pointing at the object's
+		// record so the shader can find it
+		if (batch.MultiDraw) {
+			batch.Commands = _instanceUniforms->Allocate(batch.Count * sizeof(GeometryStore::DrawCommand));
+			GeometryStore::DrawCommand* commands = reinterpret_cast<GeometryStore::DrawCommand*>(batch.Commands.Data);
+			if (commands == nullptr) {
+				continue;
+			}
+
+			for (uint32_t ix = 0; ix < batch.Count; ix++) {
+				const VertexArrayObject::SharedGeometry& geometry = _renderQueue[batch.Start + ix].Renderable->GetMesh()->GetSharedGeometry();
+
+				GeometryStore::DrawCommand& command = commands[ix];
+				command.Count = geometry.IndexCount;
+				command.InstanceCount = 1;
+				command.FirstIndex = geometry.FirstIndex;
+				command.BaseVertex = geometry.BaseVertex;
+				command.BaseInstance = ix;
+			}
+		}
+	}
+}
+
+void RenderLayer::_DrawBatches(size_t start, size_t end)
+{
+	using namespace Gameplay;
+
+	// The current shader and material that are bound for rendering, note that a material
+	// may be bound with either it's regular or instanced shader
+	ShaderProgram* currentShader = nullptr;
+	Material* currentMat = nullptr;
+
+	for (size_t ix = start; ix < end; ix++) {
+		const DrawBatch& batch = _drawBatches[ix];
+
+		// If we ran out of room in the ring, we have no data to draw the batch with
+		if (batch.Instances.Data == nullptr || (batch.MultiDraw && batch.Commands.Data == nullptr)) {
+			continue;
+		}
+
+		RenderComponent* renderable = _renderQueue[batch.Start].Renderable;
+		Material* material = renderable->GetMaterial().get();
+		ShaderProgram* shader = batch.Instanced ? material->GetInstancedShader().get() : material->GetShader().get();
+
+		// Only re-bind the shader and material if they have changed since the last draw
+		if (shader != currentShader) {
+			currentShader = shader;
+			currentShader->Bind();
+			_renderStats.ShaderBinds++;
+			// The material's uniforms live in the shader, so we need to re-apply it
+			currentMat = nullptr;
+		}
+		if (material != currentMat) {
+			currentMat = material;
+			if (batch.Instanced) {
+				currentMat->ApplyInstanced();
+			} else {
+				currentMat->Apply();
+			}
+			_renderStats.MaterialBinds++;
+		}
+
+		if (batch.MultiDraw) {
+			// All the meshes share the store's VAO, and each command tells the shader which record to read
+			_instanceUniforms->BindRange(batch.Instances, INSTANCE_SSBO_BINDING, BufferType::ShaderStorage);
+			renderable->GetMesh()->GetSharedGeometry().Store->DrawMultiIndirect(_instanceUniforms->GetHandle(), batch.Commands.Offset, batch.Count);
+			_renderStats.DrawCalls++;
+			_renderStats.MultiDraws++;
+			_renderStats.MultiDrawItems += batch.Count;
+		} else if (batch.Instanced) {
+			// Our instanced shaders read their records from a storage buffer, indexed by gl_InstanceID
+			_instanceUniforms->BindRange(batch.Instances, INSTANCE_SSBO_BINDING, BufferType::ShaderStorage);
+			renderable->GetMesh()->DrawInstanced(batch.Count);
+			_renderStats.DrawCalls++;
+			_renderStats.InstancedDraws++;
+			_renderStats.InstancedItems += batch.Count;
+		} else {
+			// Point the instance UBO at this object's record, no upload required
+			_instanceUniforms->BindRange(batch.Instances, INSTANCE_UBO_BINDING);
+			renderable->GetMesh()->Draw();
+			_renderStats.DrawCalls++;
+		}
+	}
+}
+
+const RenderLayer::RenderStats& RenderLayer::GetRenderStats() const {
+	return _renderStats;
+}
+
 void RenderLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
 {
 	if (newSize.x * newSize.y == 0) return;
@@ -183,6 +478,14 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	// Create our common uniform buffers
 	_frameUniforms = std::make_shared<UniformBuffer<FrameLevelUniforms>>(BufferUsage::DynamicDraw);
 	_instanceUniforms = std::make_shared<UniformBuffer<InstanceLevelUniforms>>(BufferUsage::DynamicDraw);
+
+	_instanceUniforms->EnableRingAllocation(INSTANCE_RING_FRAME_SIZE);
+
+	// Multi-draw indirect is core in 4.3, older contexts will fall back to regular draws
+	SetMultiDrawEnabled(true);
+	if (!_multiDrawEnabled) {
+		LOG_WARN("Multi-draw indirect is not supported, static meshes will be drawn individually");
+	}
 }
 
 const Framebuffer::Sptr& RenderLayer::GetPrimaryFBO() const {
@@ -216,3 +519,11 @@ void RenderLayer::SetRenderFlags(RenderFlags value) {
 RenderFlags RenderLayer::GetRenderFlags() const {
 	return _renderFlags;
 }
+
+bool RenderLayer::IsMultiDrawEnabled() const {
+	return _multiDrawEnabled;
+}
+
+void RenderLayer::SetMultiDrawEnabled(bool value) {
+	_multiDrawEnabled = value && GeometryStore::IsSupported();
+}
@@ -2,6 +2,11 @@
 #include "../ApplicationLayer.h"
 #include "Graphics/Framebuffer.h"
 #include "Graphics/Buffers/UniformBuffer.h"
+#include "Graphics/Frustum.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/GeometryStore.h"
+
+class RenderComponent;
 
 ENUM_FLAGS(RenderFlags, uint32_t,
 	None = 0,
@@ -44,9 +49,39 @@ public:
 		glm::mat4 u_NormalMatrix;
 	};
 
+	// Counters for the render queue, reset at the start of each frame
+	struct RenderStats {
+		// The number of draw calls issued for render components
+		uint32_t DrawCalls;
+		// The number of times a shader program was bound
+		uint32_t ShaderBinds;
+		// The number of times a material was applied
+		uint32_t MaterialBinds;
+		// The number of opaque and transparent items that were submitted to the queue
+		uint32_t OpaqueItems;
+		uint32_t TransparentItems;
+		// The number of items that passed and failed frustum culling, items without bounds
+		// are always considered visible
+		uint32_t VisibleItems;
+		uint32_t CulledItems;
+		// The number of instanced draws issued, and the total number of objects they covered
+		uint32_t InstancedDraws;
+		uint32_t InstancedItems;
+		// The number of multi-draw indirect calls issued, and the total number of objects they covered
+		uint32_t MultiDraws;
+		uint32_t MultiDrawItems;
+		// The number of bytes of instance data written to the ring buffer
+		uint32_t InstanceDataBytes;
+	};
+
 	RenderLayer();
 	virtual ~RenderLayer();
 
+	/// <summary>
+	/// Gets the render queue counters for the last frame that was rendered
+	/// </summary>
+	const RenderStats& GetRenderStats() const;
+
 	/// <summary>
 	/// Gets the primary framebuffer that is being rendered to
 	/// </summary>
@@ -61,6 +96,16 @@ public:
 	void SetRenderFlags(RenderFlags value);
 	RenderFlags GetRenderFlags() const;
 
+	/// <summary>
+	/// Returns true if static meshes are being drawn from shared geometry stores with multi-draw indirect
+	/// </summary>
+	bool IsMultiDrawEnabled() const;
+	/// <summary>
+	/// Enables or disables drawing static meshes with multi-draw indirect, when disabled or unsupported
+	/// every object is drawn from it's own VAO
+	/// </summary>
+	void SetMultiDrawEnabled(bool value);
+
 	// Inherited from ApplicationLayer
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
@@ -73,10 +118,92 @@ protected:
 	bool              _blitFbo;
 	glm::vec4         _clearColor;
 	RenderFlags       _renderFlags;
+	bool              _multiDrawEnabled;
 
 	const int FRAME_UBO_BINDING = 0;
 	UniformBuffer<FrameLevelUniforms>::Sptr _frameUniforms;
 
+	// Instance data is written to a ring-allocated buffer once per frame, non-instanced draws bind
+	// their record as a UBO range, instanced batches bind their records as an SSBO range
 	const int INSTANCE_UBO_BINDING = 1;
+	const int INSTANCE_SSBO_BINDING = 1;
+	// The starting size of each frame's region in the instance ring, it will grow as needed
+	static const uint32_t INSTANCE_RING_FRAME_SIZE = 1024 * 1024;
 	UniformBuffer<InstanceLevelUniforms>::Sptr _instanceUniforms;
+
+	// Set on the keys of transparent items, so they always sort after opaque ones
+	static const uint64_t TRANSPARENT_KEY_BIT = 1ull << 63;
+
+	// A single entry in the render queue, the key packs together the state that we sort by
+	// (see _MakeDrawKey)
+	struct DrawItem {
+		uint64_t         Key;
+		RenderComponent* Renderable;
+	};
+
+	// Storage for our render queue, we keep these around to avoid re-allocating every frame
+	std::vector<DrawItem> _renderQueue;
+	std::vector<DrawItem> _renderQueueScratch;
+
+	// Used for culling objects outside of the camera's view before they get queued
+	Frustum                       _frustum;
+	std::vector<RenderComponent*> _cullCandidates;
+	std::vector<uint8_t>          _visibility;
+
+	// Runs of queue items that share a mesh and material can be drawn with a single instanced
+	// draw, as long as the material provides an instanced shader
+	static const uint32_t MIN_INSTANCED_BATCH_SIZE = 2;
+
+	// A range of the render queue that will be drawn together. Multi-draw batches are also
+	// instanced, since they use the material's instanced shader
+	struct DrawBatch {
+		uint32_t Start;
+		uint32_t Count;
+		bool     Instanced;
+		bool     MultiDraw;
+		// The instance records for the batch, allocated from the instance ring
+		AbstractUniformBuffer::RingAllocation Instances;
+		// The indirect draw commands for multi-draw batches, also allocated from the instance ring
+		AbstractUniformBuffer::RingAllocation Commands;
+	};
+
+	std::vector<DrawBatch> _drawBatches;
+
+	// Static meshes get copied into a shared store for their vertex layout the first time
+	// that they are drawn, so that runs of them can be drawn with a single multi-draw call
+	std::vector<GeometryStore::Sptr> _geometryStores;
+
+	RenderStats _renderStats;
+
+	/// <summary>
+	/// Packs an object's render state into a sorting key. Opaque keys sort by shader, then
+	/// material, then mesh, then front to back. Transparent keys always sort after opaque
+	/// keys and sort back to front first, so that blending is correct
+	/// </summary>
+	static uint64_t _MakeDrawKey(bool transparent, uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+
+	/// <summary>
+	/// Gets the geometry store that contains the mesh, adding the mesh to a store if it is static
+	/// and has not been added yet
+	/// </summary>
+	/// <returns>The mesh's store, or nullptr if the mesh must be drawn from it's own VAO</returns>
+	GeometryStore* _GetGeometryStore(VertexArrayObject* mesh);
+
+	/// <summary>
+	/// Splits a range of the sorted render queue into draw batches
+	/// </summary>
+	/// <returns>The number of bytes the batches will need in the instance ring</returns>
+	uint32_t _BuildDrawBatches(size_t start, size_t end);
+
+	/// <summary>
+	/// Writes the instance records and multi-draw commands for all batches into this frame's region
+	/// of the instance ring
+	/// </summary>
+	void _WriteInstanceData(const glm::mat4& viewProj);
+
+	/// <summary>
+	/// Draws a range of batches, only re-binding shaders and materials when they change
+	/// between batches
+	/// </summary>
+	void _DrawBatches(size_t start, size_t end);
 };
\ No newline at end of file
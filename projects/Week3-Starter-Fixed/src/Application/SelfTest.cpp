@@ -0,0 +1,1247 @@
+#include "Application/SelfTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <typeindex>
+#include <utility>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <glad/glad.h>
+
+#include "Logging.h"
+#include "Application/JobSystem.h"
+#include "Gameplay/Scene.h"
+#include "Gameplay/TransformSystem.h"
+#include "Gameplay/Components/ComponentManager.h"
+#include "Gameplay/Components/ParticleSystem.h"
+#include "Gameplay/Components/RotatingBehaviour.h"
+#include "Gameplay/Physics/PhysicsTaskScheduler.h"
+#include "Gameplay/Physics/RigidBody.h"
+#include "Gameplay/Physics/TriggerEventTracker.h"
+#include "Gameplay/Physics/TriggerVolume.h"
+#include "Gameplay/Physics/Colliders/BoxCollider.h"
+#include "Gameplay/Physics/Colliders/SphereCollider.h"
+#include "Graphics/Textures/TextureCompressor.h"
+#include "Utils/MeshFactory.h"
+#include "Utils/ObjParser.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+
+using namespace Gameplay;
+using namespace Gameplay::Physics;
+
+// Small helper for timing benchmarks, returns the time the callback took in milliseconds
+template <typename Func>
+static double TimeMs(Func&& func) {
+	auto start = std::chrono::high_resolution_clock::now();
+	func();
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/*
+ * Jobs
+ */
+
+// Waiting on frame work must never pick up slow background jobs, even if the whole pool is busy with them
+static bool CheckWaitSkipsBackgroundJobs() {
+	const int sleepMs = 200;
+	JobCounter background;
+	for (uint32_t ix = 0; ix <= JobSystem::WorkerCount(); ix++) {
+		JobSystem::Submit([sleepMs]() { std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs)); }, background, JobPriority::Background);
+	}
+
+	std::atomic<size_t> sum{ 0 };
+	double frameMs = TimeMs([&]() {
+		JobSystem::ParallelFor(10000, 100, [&](size_t start, size_t end) {
+			sum += end - start;
+		});
+	});
+	JobSystem::Wait(background);
+
+	LOG_INFO("Frame work took {:.3f}ms with {}ms background jobs queued", frameMs, sleepMs);
+	return sum == 10000 && frameMs < sleepMs / 2;
+}
+
+// Times Scene::Update on a scene full of parallel components, restarting the job system with more
+// threads each time to see how the update scales
+static bool BenchmarkSceneUpdateScaling() {
+	const int numObjects = 50000;
+	const int numFrames  = 20;
+	bool wasRunning = JobSystem::IsRunning();
+	int requestedWorkers = JobSystem::RequestedWorkers();
+	int hardwareThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < hardwareThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(hardwareThreads);
+
+	// Restarting the job system runs anything still queued on this thread, so let background loads finish first
+	ResourceManager::FinishLoads();
+
+	double singleThreadMs = 0.0;
+	for (int threads : threadCounts) {
+		// The main thread counts as one of the threads. With no workers we leave the job system
+		// stopped, so that every job runs inline
+		JobSystem::Shutdown();
+		if (threads > 1) {
+			JobSystem::Init(threads - 1);
+		}
+
+		Scene::Sptr scene = std::make_shared<Scene>();
+		for (int ix = 0; ix < numObjects; ix++) {
+			GameObject::Sptr object = scene->CreateGameObject("Object");
+			object->Add<RotatingBehaviour>()->RotationSpeed = glm::vec3(0.0f, 0.0f, 90.0f);
+		}
+		scene->IsPlaying = true;
+		scene->Update(0.016f);
+
+		double frameMs = TimeMs([&]() {
+			for (int ix = 0; ix < numFrames; ix++) {
+				scene->Update(0.016f);
+			}
+		}) / numFrames;
+		singleThreadMs = threads == 1 ? frameMs : singleThreadMs;
+
+		LOG_INFO("{} threads: {:.3f}ms per update for {} objects ({:.2f}x)", threads, frameMs, numObjects, singleThreadMs / std::max(frameMs, 1e-6));
+	}
+
+	// Put the job system back the way the application set it up, using the count it asked for rather than the count
+	// it ended up with, since Init(0) means one worker per hardware thread rather than no workers
+	JobSystem::Shutdown();
+	if (wasRunning) {
+		JobSystem::Init(requestedWorkers);
+	}
+	return true;
+}
+
+/*
+ * Components
+ */
+
+// Destroying components from inside Each should neither skip nor repeat any of the survivors
+static bool CheckEachWithRemovals() {
+	const int count = 64;
+	ComponentManager manager;
+	std::vector<RotatingBehaviour::Sptr> components;
+	for (int ix = 0; ix < count; ix++) {
+		components.push_back(manager.Create<RotatingBehaviour>());
+		components.back()->RotationSpeed = glm::vec3(static_cast<float>(ix), 0.0f, 0.0f);
+	}
+
+	// Each visited component destroys the one at the end of the list, which is the component that a
+	// swap and pop removal would have moved into the freed slot
+	std::vector<int> visits(count, 0);
+	manager.Each<RotatingBehaviour>([&](const RotatingBehaviour::Sptr& component) {
+		visits[static_cast<int>(component->RotationSpeed.x)]++;
+		for (int ix = count - 1; ix >= 0; ix--) {
+			if (components[ix] != nullptr && components[ix] != component) {
+				components[ix] = nullptr;
+				break;
+			}
+		}
+	});
+
+	// Every component that was still alive when we got to it must have been visited exactly once
+	for (int ix = 0; ix < count; ix++) {
+		if (visits[ix] > 1 || (components[ix] != nullptr && visits[ix] != 1)) {
+			LOG_WARN("Component {} was visited {} times", ix, visits[ix]);
+			return false;
+		}
+	}
+
+	// The pool should be compacted once iteration is done
+	size_t alive = 0;
+	for (const auto& component : components) {
+		alive += component != nullptr ? 1 : 0;
+	}
+	return manager.Count<RotatingBehaviour>() == alive;
+}
+
+// Recreates the weak_ptr store that ComponentManager used before it had dense pools, so the benchmark
+// below has something to compare against
+template <typename ComponentType>
+static void EachWeakPtr(std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>>& store,
+	std::function<void(const std::shared_ptr<ComponentType>&)> callback, bool includeDisabled = false) {
+	for (auto& wptr : store[std::type_index(typeid(ComponentType))]) {
+		std::shared_ptr<IComponent> sptr = wptr.lock();
+		if (sptr && (sptr->IsEnabled || includeDisabled)) {
+			callback(std::dynamic_pointer_cast<ComponentType>(sptr));
+		}
+	}
+}
+
+// Compares walking the component pool against the old weak_ptr store, and against looking components
+// up on each game object
+static bool BenchmarkComponentIteration() {
+	for (int count : { 1000, 10000, 100000 }) {
+		Scene::Sptr scene = std::make_shared<Scene>();
+		std::vector<GameObject::Sptr> objects;
+		std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>> weakStore;
+		objects.reserve(count);
+		for (int ix = 0; ix < count; ix++) {
+			GameObject::Sptr object = scene->CreateGameObject("Object");
+			RotatingBehaviour::Sptr component = object->Add<RotatingBehaviour>();
+			component->RotationSpeed = glm::vec3(1.0f);
+			weakStore[std::type_index(typeid(RotatingBehaviour))].push_back(component);
+			objects.push_back(object);
+		}
+
+		glm::vec3 sum = glm::vec3(0.0f);
+		double byWeakPtr = TimeMs([&]() {
+			EachWeakPtr<RotatingBehaviour>(weakStore, [&](const RotatingBehaviour::Sptr& component) { sum += component->RotationSpeed; });
+		});
+		double byRef = TimeMs([&]() {
+			scene->Components().Each<RotatingBehaviour>([&](RotatingBehaviour& component) { sum += component.RotationSpeed; });
+		});
+		double byPtr = TimeMs([&]() {
+			scene->Components().Each<RotatingBehaviour>([&](const RotatingBehaviour::Sptr& component) { sum += component->RotationSpeed; });
+		});
+		double byObject = TimeMs([&]() {
+			for (const auto& object : objects) {
+				sum += object->Get<RotatingBehaviour>()->RotationSpeed;
+			}
+		});
+
+		LOG_INFO("{} components: weak_ptr store {:.3f}ms, Each by reference {:.3f}ms ({:.1f}x), Each by shared_ptr {:.3f}ms ({:.1f}x), GameObject::Get {:.3f}ms (checksum {})",
+			count, byWeakPtr, byRef, byWeakPtr / std::max(byRef, 1e-6), byPtr, byWeakPtr / std::max(byPtr, 1e-6), byObject, sum.x);
+	}
+	return true;
+}
+
+// Empty component types for the lookup benchmark, so objects can have up to 16 different components
+// without dragging in GL or physics resources
+template <int N>
+class LookupComponent : public IComponent {
+public:
+	typedef std::shared_ptr<LookupComponent<N>> Sptr;
+	int Value = N;
+
+	virtual void RenderImGui() override {}
+	virtual nlohmann::json ToJson() const override { return {}; }
+	static Sptr FromJson(const nlohmann::json&) { return std::make_shared<LookupComponent<N>>(); }
+
+	MAKE_TYPENAME(LookupComponent<N>);
+};
+
+template <int... Ns>
+static void RegisterLookupComponents(std::integer_sequence<int, Ns...>) {
+	(ComponentManager::RegisterType<LookupComponent<Ns>>(), ...);
+}
+
+template <int... Ns>
+static void AddLookupComponents(const GameObject::Sptr& object, int count, std::integer_sequence<int, Ns...>) {
+	((Ns < count ? (void)object->Add<LookupComponent<Ns>>() : (void)0), ...);
+}
+
+// Times GameObject::Get on objects with 1, 4 and 16 components attached. Each object is asked for
+// the component it got first, the one it got last and one that it does not have
+static bool BenchmarkComponentLookup() {
+	const int numObjects = 10000;
+	const int numPasses  = 10;
+	RegisterLookupComponents(std::make_integer_sequence<int, 17>());
+
+	for (int numComponents : { 1, 4, 16 }) {
+		Scene::Sptr scene = std::make_shared<Scene>();
+		std::vector<GameObject::Sptr> objects;
+		objects.reserve(numObjects);
+		for (int ix = 0; ix < numObjects; ix++) {
+			GameObject::Sptr object = scene->CreateGameObject("Object");
+			AddLookupComponents(object, numComponents, std::make_integer_sequence<int, 16>());
+			objects.push_back(object);
+		}
+
+		int sum = 0;
+		double firstMs = TimeMs([&]() {
+			for (int pass = 0; pass < numPasses; pass++) {
+				for (const auto& object : objects) {
+					sum += object->Get<LookupComponent<0>>()->Value;
+				}
+			}
+		});
+		double lastMs = TimeMs([&]() {
+			for (int pass = 0; pass < numPasses; pass++) {
+				for (const auto& object : objects) {
+					sum += numComponents == 16 ? object->Get<LookupComponent<15>>()->Value :
+					       numComponents == 4  ? object->Get<LookupComponent<3>>()->Value :
+					                             object->Get<LookupComponent<0>>()->Value;
+				}
+			}
+		});
+		double missingMs = TimeMs([&]() {
+			for (int pass = 0; pass < numPasses; pass++) {
+				for (const auto& object : objects) {
+					sum += object->Has<LookupComponent<16>>() ? 1 : 0;
+				}
+			}
+		});
+
+		size_t lookups = static_cast<size_t>(numObjects) * numPasses;
+		LOG_INFO("{} components: first {:.2f}ns, last {:.2f}ns, missing {:.2f}ns per lookup (checksum {})",
+			numComponents, firstMs * 1e6 / lookups, lastMs * 1e6 / lookups, missingMs * 1e6 / lookups, sum);
+	}
+	return true;
+}
+
+/*
+ * Transforms
+ */
+
+// Builds count transforms, where each root has fanOut children, and each of those has fanOut children
+// and so on. A fan out of 1 gives long chains, a large fan out gives wide and shallow trees
+static std::vector<TransformSystem::Handle> MakeTransformTree(TransformSystem& system, int count, int fanOut, int numRoots) {
+	std::vector<TransformSystem::Handle> handles;
+	handles.reserve(count);
+	for (int ix = 0; ix < count; ix++) {
+		TransformSystem::Handle handle = system.Create();
+		system.SetPosition(handle, glm::vec3(0.01f * ix, 1.0f, 0.0f));
+		system.SetRotation(handle, glm::angleAxis(0.001f * ix, glm::vec3(0.0f, 0.0f, 1.0f)));
+		if (ix >= numRoots) {
+			system.SetParent(handle, handles[(ix - numRoots) / fanOut]);
+		}
+		handles.push_back(handle);
+	}
+	return handles;
+}
+
+// Times the transform system on deep and wide hierarchies: propagating world matrices when every root
+// moves, re-sorting after re-parenting, and destroying every transform
+static bool BenchmarkTransformHierarchy() {
+	const int count = 50000;
+	struct Shape {
+		const char* Name;
+		int         FanOut;
+		int         NumRoots;
+	};
+	for (const Shape& shape : { Shape{ "deep", 1, 50 }, Shape{ "wide", 500, 100 }, Shape{ "binary", 2, 2 } }) {
+		TransformSystem system;
+		std::vector<TransformSystem::Handle> handles;
+		double buildMs = TimeMs([&]() {
+			handles = MakeTransformTree(system, count, shape.FanOut, shape.NumRoots);
+			system.Update();
+		});
+
+		// Moving every root dirties the whole hierarchy
+		const int numFrames = 20;
+		double updateMs = TimeMs([&]() {
+			for (int frame = 0; frame < numFrames; frame++) {
+				for (int ix = 0; ix < shape.NumRoots; ix++) {
+					system.SetPosition(handles[ix], glm::vec3(frame * 0.1f, 0.0f, 0.0f));
+				}
+				system.Update();
+			}
+		}) / numFrames;
+
+		// Hang the first root's tree off of the last transform, which forces a re-sort
+		double reparentMs = TimeMs([&]() {
+			system.SetParent(handles[0], handles.back());
+			system.Update();
+		});
+
+		glm::vec3 checksum = glm::vec3(system.GetWorldTransform(handles.back())[3]);
+		double destroyMs = TimeMs([&]() {
+			for (TransformSystem::Handle handle : handles) {
+				system.Destroy(handle);
+			}
+			system.Update();
+		});
+
+		LOG_INFO("{} {} transforms: build {:.3f}ms, update {:.3f}ms, re-parent {:.3f}ms, destroy all {:.3f}ms (checksum {})",
+			count, shape.Name, buildMs, updateMs, reparentMs, destroyMs, checksum.x);
+	}
+	return true;
+}
+
+/*
+ * Particles
+ */
+
+// Times whole frames of particle updates and draws with 1, 10 and 50 particle systems. The CPU time
+// is what we spend issuing the work (which used to include stalling on the particle count readback),
+// the frame time also includes waiting for the GPU to finish, like a swap would
+static bool BenchmarkParticleFrames() {
+	const int numFrames = 300;
+	for (int count : { 1, 10, 50 }) {
+		Scene::Sptr scene = std::make_shared<Scene>();
+		for (int ix = 0; ix < count; ix++) {
+			GameObject::Sptr object = scene->CreateGameObject("Particles");
+			ParticleSystem::Sptr particles = object->Add<ParticleSystem>();
+			particles->AddEmitter(glm::vec3(ix * 0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 5.0f), 100.0f);
+		}
+		scene->Awake();
+		scene->IsPlaying = true;
+		glFinish();
+
+		double cpuMs = 0.0;
+		double frameMs = TimeMs([&]() {
+			for (int frame = 0; frame < numFrames; frame++) {
+				cpuMs += TimeMs([&]() {
+					scene->Components().Each<ParticleSystem>([](ParticleSystem& system) { system.Update(); });
+					scene->Components().Each<ParticleSystem>([](ParticleSystem& system) { system.Render(); });
+				});
+				glFinish();
+			}
+		});
+
+		LOG_INFO("{} particle systems: {:.3f}ms CPU, {:.3f}ms per frame ({} frames)", count, cpuMs / numFrames, frameMs / numFrames, numFrames);
+	}
+	return true;
+}
+
+/*
+ * Scenes
+ */
+
+// Saving a scene to a binary file and loading it back must give exactly the same scene as the JSON format
+static bool CheckSceneBinaryRoundTrip() {
+	Scene::Sptr scene = std::make_shared<Scene>();
+	scene->SetAmbientLight(glm::vec3(0.2f, 0.3f, 0.4f));
+	scene->SetFixedPhysicsTimestep(false);
+	scene->SetPhysicsTimestep(1.0f / 120.0f);
+	scene->SetMaxPhysicsSubSteps(8);
+	scene->SetMultithreadedPhysics(true);
+
+	GameObject::Sptr parent = scene->CreateGameObject("Parent");
+	parent->SetPostion(glm::vec3(1.0f, 2.0f, 3.0f));
+	parent->Add<RotatingBehaviour>()->RotationSpeed = glm::vec3(0.0f, 0.0f, 90.0f);
+	for (int ix = 0; ix < 3; ix++) {
+		GameObject::Sptr child = scene->CreateGameObject("Child " + std::to_string(ix));
+		child->SetPostion(glm::vec3(ix * 0.5f, 0.0f, -1.0f));
+		child->SetRotation(glm::angleAxis(ix * 0.3f, glm::vec3(0.0f, 0.0f, 1.0f)));
+		child->SetScale(glm::vec3(1.0f + ix));
+		child->HideInHierarchy = ix == 1;
+		parent->AddChild(child);
+	}
+
+	Light light;
+	light.Position = glm::vec3(-1.0f, 4.0f, 2.5f);
+	light.Color = glm::vec3(1.0f, 0.5f, 0.25f);
+	light.Range = 12.0f;
+	scene->Lights.push_back(light);
+
+	std::string path = (std::filesystem::temp_directory_path() / ("selftest" + Scene::BINARY_EXTENSION)).string();
+	nlohmann::json expected = scene->ToJson();
+	scene->SaveBinary(path);
+	Scene::Sptr loaded = Scene::LoadBinary(path);
+	std::filesystem::remove(path);
+	if (loaded == nullptr) {
+		return false;
+	}
+
+	nlohmann::json actual = loaded->ToJson();
+	if (actual != expected) {
+		LOG_WARN("Loaded scene differs from the saved scene: {}", nlohmann::json::diff(expected, actual).dump());
+		return false;
+	}
+	return true;
+}
+
+// Times saving and loading scenes of increasing size with the JSON and binary formats
+static bool BenchmarkSceneSaveLoad() {
+	std::filesystem::path dir = std::filesystem::temp_directory_path();
+	std::string jsonPath = (dir / "selftest_bench.json").string();
+	std::string binaryPath = (dir / ("selftest_bench" + Scene::BINARY_EXTENSION)).string();
+
+	for (int count : { 1000, 10000, 50000 }) {
+		// Build a scene with a mix of roots and children, each with a component
+		Scene::Sptr scene = std::make_shared<Scene>();
+		GameObject::Sptr parent = nullptr;
+		for (int ix = 0; ix < count; ix++) {
+			GameObject::Sptr object = scene->CreateGameObject("Object " + std::to_string(ix));
+			object->SetPostion(glm::vec3(ix * 0.1f, 0.0f, 1.0f));
+			object->SetRotation(glm::vec3(0.0f, 0.0f, ix * 1.0f));
+			object->Add<RotatingBehaviour>()->RotationSpeed = glm::vec3(0.0f, 0.0f, 90.0f);
+			if (ix % 10 == 0) {
+				parent = object;
+			} else {
+				parent->AddChild(object);
+			}
+		}
+
+		double jsonSaveMs   = TimeMs([&]() { scene->Save(jsonPath); });
+		double binarySaveMs = TimeMs([&]() { scene->SaveBinary(binaryPath); });
+		Scene::Sptr fromJson, fromBinary;
+		double jsonLoadMs   = TimeMs([&]() { fromJson = Scene::Load(jsonPath); });
+		double binaryLoadMs = TimeMs([&]() { fromBinary = Scene::LoadBinary(binaryPath); });
+
+		LOG_INFO("{} objects: JSON save {:.1f}ms load {:.1f}ms ({:.2f}MB), binary save {:.1f}ms load {:.1f}ms ({:.2f}MB)",
+			count, jsonSaveMs, jsonLoadMs, std::filesystem::file_size(jsonPath) / (1024.0 * 1024.0),
+			binarySaveMs, binaryLoadMs, std::filesystem::file_size(binaryPath) / (1024.0 * 1024.0));
+		if (fromJson == nullptr || fromBinary == nullptr) {
+			return false;
+		}
+	}
+
+	std::filesystem::remove(jsonPath);
+	std::filesystem::remove(binaryPath);
+	return true;
+}
+
+/*
+ * Meshes
+ */
+
+// Asks the OS to drop a file from it's file cache, so that the next read has to go to the disk. On
+// Windows, opening a file without buffering purges it's cached pages as long as no one else has it
+// open. This is best effort, and may do nothing on some file systems
+static void EvictFromFileCache(const std::string& filename) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+	}
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file >= 0) {
+		fdatasync(file);
+		posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+		close(file);
+	}
+#endif
+}
+
+// Converts every OBJ in the resource folder to a version 2 binary mesh, then times loading all of them
+// with the files evicted from the OS file cache, and again once they are cached
+static bool BenchmarkBinaryMeshLoad() {
+	const int numWarmPasses = 5;
+	std::filesystem::path outDir = std::filesystem::temp_directory_path() / "selftest_meshes";
+	std::filesystem::create_directories(outDir);
+
+	std::vector<std::string> files;
+	size_t totalBytes = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(".")) {
+		if (entry.is_regular_file() && entry.path().extension() == ".obj") {
+			std::string binPath = (outDir / entry.path().stem()).string() + ".bin";
+			OptimizedObjLoader::ConvertToBinary(entry.path().string(), binPath);
+			totalBytes += static_cast<size_t>(std::filesystem::file_size(binPath));
+			files.push_back(binPath);
+		}
+	}
+	if (files.empty()) {
+		LOG_WARN("No OBJ files found in {}", std::filesystem::current_path().string());
+		return false;
+	}
+
+	// Loads every mesh, and waits for the uploads so that the driver's copies are included
+	bool loadedAll = true;
+	auto loadAll = [&]() {
+		for (const std::string& file : files) {
+			loadedAll &= OptimizedObjLoader::LoadFromFile(file) != nullptr;
+		}
+		glFinish();
+	};
+
+	for (const std::string& file : files) {
+		EvictFromFileCache(file);
+	}
+	double coldMs = TimeMs(loadAll);
+	double warmMs = TimeMs([&]() {
+		for (int pass = 0; pass < numWarmPasses; pass++) {
+			loadAll();
+		}
+	}) / numWarmPasses;
+
+	std::filesystem::remove_all(outDir);
+
+	double megabytes = totalBytes / (1024.0 * 1024.0);
+	LOG_INFO("{} meshes ({:.2f}MB): cold cache {:.3f}ms ({:.1f}MB/s), warm cache {:.3f}ms ({:.1f}MB/s)",
+		files.size(), megabytes, coldMs, megabytes / (coldMs / 1000.0), warmMs, megabytes / (warmMs / 1000.0));
+	return loadedAll;
+}
+
+// Builds the text for an OBJ file containing a bumpy grid of quads, the bottom half of the faces use
+// negative (relative) indices, and every other row leaves out the UVs
+static std::string MakeGridObj(int size) {
+	std::string text = "# Self test grid\n";
+	char line[256];
+	for (int y = 0; y <= size; y++) {
+		for (int x = 0; x <= size; x++) {
+			snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn %f 1.0 %f\n",
+				x * 0.5f, glm::sin(x * 0.1f) * glm::cos(y * 0.1f), y * 0.5f,
+				static_cast<float>(x) / size, static_cast<float>(y) / size,
+				glm::sin(x * 0.3f) * 0.1f, glm::cos(y * 0.3f) * 0.1f);
+			text += line;
+		}
+	}
+
+	int total = (size + 1) * (size + 1);
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			int corners[4] = { y * (size + 1) + x + 1, y * (size + 1) + x + 2, (y + 1) * (size + 1) + x + 2, (y + 1) * (size + 1) + x + 1 };
+			if (y >= size / 2) {
+				for (int& corner : corners) {
+					corner = corner - total - 1;
+				}
+			}
+			if (y % 2 == 0) {
+				snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+					corners[0], corners[0], corners[0], corners[1], corners[1], corners[1],
+					corners[2], corners[2], corners[2], corners[3], corners[3], corners[3]);
+			} else {
+				snprintf(line, sizeof(line), "f %d//%d %d//%d %d//%d %d//%d\n",
+					corners[0], corners[0], corners[1], corners[1], corners[2], corners[2], corners[3], corners[3]);
+			}
+			text += line;
+		}
+	}
+	return text;
+}
+
+// Reads a whole file into a string, returns false if it could not be opened
+static bool ReadWholeFile(const std::string& filename, std::string& result) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	result.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// Measures how many MB/s of OBJ text the parser gets through, both serially and across the job system.
+// Files are read into memory up front so that only the parsing is timed
+static bool BenchmarkObjParseThroughput() {
+	const int numPasses = 5;
+	std::vector<std::pair<std::string, std::string>> inputs;
+	for (const auto& entry : std::filesystem::directory_iterator(".")) {
+		if (entry.is_regular_file() && entry.path().extension() == ".obj") {
+			std::string text;
+			if (ReadWholeFile(entry.path().string(), text)) {
+				inputs.emplace_back(entry.path().filename().string(), std::move(text));
+			}
+		}
+	}
+	// Our assets are all fairly small, so we add a large generated mesh as well
+	inputs.emplace_back("generated grid", MakeGridObj(1000));
+
+	for (const auto& [name, text] : inputs) {
+		ObjData data;
+		double serialMs = TimeMs([&]() {
+			for (int pass = 0; pass < numPasses; pass++) {
+				ObjParser::Parse(text.data(), text.size(), data);
+			}
+		}) / numPasses;
+		double parallelMs = TimeMs([&]() {
+			for (int pass = 0; pass < numPasses; pass++) {
+				ObjParser::ParseParallel(text.data(), text.size(), data);
+			}
+		}) / numPasses;
+
+		double megabytes = text.size() / (1024.0 * 1024.0);
+		LOG_INFO("{} ({:.2f}MB, {} triangles): serial {:.1f}MB/s, parallel {:.1f}MB/s",
+			name, megabytes, data.Indices.size() / 3, megabytes / (serialMs / 1000.0), megabytes / (parallelMs / 1000.0));
+	}
+	return true;
+}
+
+// The parallel OBJ parser must produce exactly the same data as the serial one
+static bool CheckObjParallelParse() {
+	std::string text = MakeGridObj(200);
+
+	ObjData serial, parallel;
+	ObjParser::Parse(text.data(), text.size(), serial);
+	// Use small chunks so the text is split many times, including through the middle of the faces
+	ObjParser::ParseParallel(text.data(), text.size(), parallel, 16 * 1024);
+
+	bool same =
+		serial.Positions == parallel.Positions &&
+		serial.Normals   == parallel.Normals &&
+		serial.UVs       == parallel.UVs &&
+		serial.Vertices  == parallel.Vertices &&
+		serial.Indices   == parallel.Indices;
+	if (!same) {
+		LOG_WARN("Serial parse has {} vertices and {} indices, parallel parse has {} vertices and {} indices",
+			serial.Vertices.size(), serial.Indices.size(), parallel.Vertices.size(), parallel.Indices.size());
+	}
+	return same && !serial.Indices.empty();
+}
+
+// Our own assets must import identically on the serial and parallel paths. Most of them are smaller
+// than a parse chunk, so we also parse their text in tiny chunks to make sure they get split up, and
+// test.obj is large enough to be split and have it's tangents calculated in parallel as is
+static bool CheckObjParallelImportAssets() {
+	bool passed = true;
+	for (const char* filename : { "monkey.obj", "sand.obj", "leaf.obj", "trunk.obj", "test.obj" }) {
+		std::string text;
+		if (!ReadWholeFile(filename, text)) {
+			LOG_WARN("Could not read {}", filename);
+			passed = false;
+			continue;
+		}
+
+		ObjData serialData, parallelData;
+		ObjParser::Parse(text.data(), text.size(), serialData);
+		ObjParser::ParseParallel(text.data(), text.size(), parallelData, 1024);
+		if (serialData.Positions != parallelData.Positions || serialData.Normals != parallelData.Normals || serialData.UVs != parallelData.UVs ||
+			serialData.Vertices != parallelData.Vertices || serialData.Indices != parallelData.Indices) {
+			LOG_WARN("{}: parsing in small chunks does not match the serial parse", filename);
+			passed = false;
+		}
+
+		// Compare the final buffers that get written to the binary file
+		std::unique_ptr<MeshBuilder<VertexPosNormTexColTangents>> serial = OptimizedObjLoader::ParseObjFile(filename, false);
+		std::unique_ptr<MeshBuilder<VertexPosNormTexColTangents>> parallel = OptimizedObjLoader::ParseObjFile(filename, true);
+		bool same =
+			serial->GetVertexCount() == parallel->GetVertexCount() &&
+			serial->GetIndexCount()  == parallel->GetIndexCount() &&
+			memcmp(serial->GetVertexDataPtr(), parallel->GetVertexDataPtr(), serial->GetVertexCount() * sizeof(VertexPosNormTexColTangents)) == 0 &&
+			memcmp(serial->GetIndexDataPtr(), parallel->GetIndexDataPtr(), serial->GetIndexCount() * sizeof(uint32_t)) == 0;
+		if (!same) {
+			LOG_WARN("{}: serial import has {} vertices and {} indices, parallel import has {} vertices and {} indices",
+				filename, serial->GetVertexCount(), serial->GetIndexCount(), parallel->GetVertexCount(), parallel->GetIndexCount());
+		}
+		passed &= same && serial->GetIndexCount() > 0;
+	}
+	return passed;
+}
+
+// Calculating tangents across the job system must give exactly the same results as the serial loop
+static bool CheckParallelTBN() {
+	std::string text = MakeGridObj(200);
+	ObjData data;
+	ObjParser::Parse(text.data(), text.size(), data);
+
+	MeshBuilder<VertexPosNormTexColTangents> serial;
+	for (const glm::ivec3& vertex : data.Vertices) {
+		serial.AddVertex(
+			data.Positions[vertex.x],
+			vertex.z >= 0 ? data.Normals[vertex.z] : glm::vec3(0.0f, 1.0f, 0.0f),
+			vertex.y >= 0 ? data.UVs[vertex.y] : glm::vec2(0.0f),
+			glm::vec4(1.0f));
+	}
+	for (uint32_t index : data.Indices) {
+		serial.AddIndex(index);
+	}
+	MeshBuilder<VertexPosNormTexColTangents> parallel = serial;
+
+	MeshFactory::CalculateTBN(serial, false);
+	MeshFactory::CalculateTBN(parallel, true);
+
+	const VertexPosNormTexColTangents* a = serial.GetVertexDataPtr();
+	const VertexPosNormTexColTangents* b = parallel.GetVertexDataPtr();
+	for (size_t ix = 0; ix < serial.GetVertexCount(); ix++) {
+		if (a[ix].Tangent != b[ix].Tangent || a[ix].BiTangent != b[ix].BiTangent) {
+			LOG_WARN("Tangents differ at vertex {}", ix);
+			return false;
+		}
+	}
+	return serial.GetTriangleCount() > 0;
+}
+
+/*
+ * Textures
+ */
+
+// Expands a 5:6:5 color to 8 bits per channel, the same way the GPU does
+static glm::vec3 ExpandColor565(uint16_t color) {
+	int r = (color >> 11) & 0x1F;
+	int g = (color >> 5) & 0x3F;
+	int b = color & 0x1F;
+	return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+// Decodes an 8 byte BC1 color block into the RGB channels of 16 pixels
+static void DecodeColorBlock(const uint8_t* block, uint8_t result[16][4]) {
+	uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+	glm::vec3 palette[4];
+	palette[0] = ExpandColor565(color0);
+	palette[1] = ExpandColor565(color1);
+	if (color0 > color1) {
+		palette[2] = (palette[0] * 2.0f + palette[1]) / 3.0f;
+		palette[3] = (palette[0] + palette[1] * 2.0f) / 3.0f;
+	} else {
+		palette[2] = (palette[0] + palette[1]) / 2.0f;
+		palette[3] = glm::vec3(0.0f);
+	}
+
+	uint32_t indices = 0;
+	memcpy(&indices, block + 4, sizeof(uint32_t));
+	for (int ix = 0; ix < 16; ix++) {
+		glm::vec3 color = glm::round(palette[(indices >> (ix * 2)) & 0x3]);
+		for (int c = 0; c < 3; c++) {
+			result[ix][c] = static_cast<uint8_t>(color[c]);
+		}
+	}
+}
+
+// Decodes an 8 byte BC4 block (also the BC3 alpha block and each half of a BC5 block) into one channel of 16 pixels
+static void DecodeChannelBlock(const uint8_t* block, int channel, uint8_t result[16][4]) {
+	int palette[8];
+	palette[0] = block[0];
+	palette[1] = block[1];
+	if (palette[0] > palette[1]) {
+		for (int ix = 2; ix < 8; ix++) {
+			palette[ix] = ((8 - ix) * palette[0] + (ix - 1) * palette[1] + 3) / 7;
+		}
+	} else {
+		for (int ix = 2; ix < 6; ix++) {
+			palette[ix] = ((6 - ix) * palette[0] + (ix - 1) * palette[1] + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (int ix = 0; ix < 6; ix++) {
+		indices |= static_cast<uint64_t>(block[2 + ix]) << (ix * 8);
+	}
+	for (int ix = 0; ix < 16; ix++) {
+		result[ix][channel] = static_cast<uint8_t>(palette[(indices >> (ix * 3)) & 0x7]);
+	}
+}
+
+// Each of our block formats must decode back to something close to the block it was given
+static bool CheckTextureBlockEncoding() {
+	// A color gradient across the block with a little noise down it, and an alpha ramp with 16 different
+	// values. The colors lie close to a line, which is the case BC1 is built for
+	uint8_t pixels[16 * 4];
+	for (int ix = 0; ix < 16; ix++) {
+		int x = ix & 3;
+		int y = ix >> 2;
+		pixels[ix * 4 + 0] = static_cast<uint8_t>(40 + x * 56 + y * 2);
+		pixels[ix * 4 + 1] = static_cast<uint8_t>(200 - x * 48 + y * 2);
+		pixels[ix * 4 + 2] = static_cast<uint8_t>(90 + x * 20 + y * 2);
+		pixels[ix * 4 + 3] = static_cast<uint8_t>(255 - ix * 12);
+	}
+
+	struct FormatCase {
+		InternalFormat Format;
+		// The channels that the format stores, starting from red
+		int            NumChannels;
+		float          MaxRmse;
+	};
+	// BC1 should only be off by the 5:6:5 rounding. The single channel blocks spread 8 values over a range of
+	// about 180, so even a perfect encoder is off by up to 13 for some of the pixels
+	const FormatCase cases[] = {
+		{ InternalFormat::BC1, 3, 6.0f },
+		{ InternalFormat::BC3, 4, 6.0f },
+		{ InternalFormat::BC4, 1, 8.0f },
+		{ InternalFormat::BC5, 2, 8.0f },
+	};
+
+	bool passed = true;
+	for (const FormatCase& test : cases) {
+		uint8_t block[16];
+		TextureCompressor::Compress(test.Format, pixels, 4, 4, 4, block);
+
+		uint8_t decoded[16][4] = { };
+		switch (test.Format) {
+			case InternalFormat::BC1:
+				DecodeColorBlock(block, decoded);
+				break;
+			case InternalFormat::BC3:
+				DecodeChannelBlock(block, 3, decoded);
+				DecodeColorBlock(block + 8, decoded);
+				break;
+			case InternalFormat::BC4:
+				DecodeChannelBlock(block, 0, decoded);
+				break;
+			case InternalFormat::BC5:
+				DecodeChannelBlock(block, 0, decoded);
+				DecodeChannelBlock(block + 8, 1, decoded);
+				break;
+			default:
+				break;
+		}
+
+		float error = 0.0f;
+		for (int ix = 0; ix < 16; ix++) {
+			for (int c = 0; c < test.NumChannels; c++) {
+				float d = (float)decoded[ix][c] - (float)pixels[ix * 4 + c];
+				error += d * d;
+			}
+		}
+		float rmse = glm::sqrt(error / (16.0f * test.NumChannels));
+		LOG_INFO("{}: RMSE {:.2f}", ~test.Format, rmse);
+		if (rmse > test.MaxRmse) {
+			LOG_WARN("{} decodes with an RMSE of {:.2f}, expected at most {:.2f}", ~test.Format, rmse, test.MaxRmse);
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+// Writing a .ctex file and mapping it back must give the full mip chain, with every level where the header says it is
+static bool CheckTextureCacheRoundTrip() {
+	// Not a multiple of 4 in either direction, so the edge blocks get padded on every level
+	const int width = 20, height = 12;
+	std::vector<uint8_t> pixels((size_t)width * height * 4);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			uint8_t* pixel = &pixels[((size_t)y * width + x) * 4];
+			pixel[0] = static_cast<uint8_t>(x * 12);
+			pixel[1] = static_cast<uint8_t>(y * 20);
+			pixel[2] = static_cast<uint8_t>((x + y) * 7);
+			pixel[3] = static_cast<uint8_t>(x < width / 2 ? 255 : 128);
+		}
+	}
+
+	std::string path = (std::filesystem::temp_directory_path() / ("selftest" + TextureCompressor::CACHE_EXTENSION)).string();
+	if (!TextureCompressor::WriteCache(path, { { pixels.data(), width, height } }, 4)) {
+		return false;
+	}
+
+	bool passed = true;
+	{
+		TextureCompressor::CompressedImage image;
+		if (!TextureCompressor::LoadCache(path, image)) {
+			std::filesystem::remove(path);
+			return false;
+		}
+
+		const uint8_t* data = image.File.GetData();
+		size_t size = image.File.GetSize();
+		if (memcmp(data, "CTEX", 4) != 0) {
+			LOG_WARN("Cache file does not start with the CTEX header bytes");
+			passed = false;
+		}
+		if (image.Format != InternalFormat::BC3 || image.NumChannels != 4) {
+			LOG_WARN("Cache file has format {} with {} channels, expected BC3 with 4", ~image.Format, image.NumChannels);
+			passed = false;
+		}
+
+		// 20x12, 10x6, 5x3, 2x1, 1x1
+		if (image.Levels.size() != 5) {
+			LOG_WARN("Cache file has {} levels, expected 5", image.Levels.size());
+			passed = false;
+		}
+
+		size_t prevEnd = 0;
+		for (size_t ix = 0; ix < image.Levels.size(); ix++) {
+			const TextureCompressor::CompressedLevel& level = image.Levels[ix];
+			size_t offset = static_cast<size_t>(level.Data - data);
+			int expectedWidth = glm::max(1, width >> ix);
+			int expectedHeight = glm::max(1, height >> ix);
+			// Levels are aligned to 16 bytes, after the header and level table
+			bool valid =
+				level.Width == expectedWidth &&
+				level.Height == expectedHeight &&
+				level.Size == TextureCompressor::GetCompressedSize(image.Format, expectedWidth, expectedHeight) &&
+				offset % 16 == 0 &&
+				offset > 0 && offset >= prevEnd &&
+				offset + level.Size <= size;
+			if (!valid) {
+				LOG_WARN("Level {} is {}x{} with {} bytes at offset {}", ix, level.Width, level.Height, level.Size, offset);
+				passed = false;
+			}
+			prevEnd = offset + level.Size;
+		}
+
+		// The base level's blocks must be exactly what we get from compressing the image ourselves
+		if (!image.Levels.empty()) {
+			std::vector<uint8_t> expected(TextureCompressor::GetCompressedSize(InternalFormat::BC3, width, height));
+			TextureCompressor::Compress(InternalFormat::BC3, pixels.data(), width, height, 4, expected.data());
+			if (image.Levels[0].Size != expected.size() || memcmp(image.Levels[0].Data, expected.data(), expected.size()) != 0) {
+				LOG_WARN("Base level blocks in the cache file do not match the compressed image");
+				passed = false;
+			}
+		}
+
+		image.File.Close();
+	}
+	std::filesystem::remove(path);
+	return passed;
+}
+
+/*
+ * Physics
+ */
+
+// Makes a playing scene with a tower of spheres dropped onto a floor, the scene is identical every time
+static Scene::Sptr MakePhysicsScene(int count, std::vector<GameObject::Sptr>& outBodies, bool multithreaded = false) {
+	Scene::Sptr scene = std::make_shared<Scene>();
+	scene->SetMultithreadedPhysics(multithreaded);
+
+	GameObject::Sptr floor = scene->CreateGameObject("Floor");
+	floor->Add<RigidBody>(RigidBodyType::Static)->AddCollider(BoxCollider::Create(glm::vec3(20.0f, 20.0f, 1.0f)));
+
+	outBodies.clear();
+	for (int ix = 0; ix < count; ix++) {
+		GameObject::Sptr ball = scene->CreateGameObject("Ball");
+		ball->SetPostion(glm::vec3((ix % 16 - 7.5f) * 0.9f, ((ix / 16) % 16 - 7.5f) * 0.9f, 2.0f + (ix / 256) * 1.1f + (ix % 3) * 0.05f));
+		RigidBody::Sptr body = ball->Add<RigidBody>(RigidBodyType::Dynamic);
+		body->AddCollider(SphereCollider::Create(0.5f));
+		outBodies.push_back(ball);
+	}
+
+	scene->Awake();
+	scene->IsPlaying = true;
+	return scene;
+}
+
+// With a fixed timestep, replaying the same frame times must give exactly the same simulation, no
+// matter how the frame times line up with the physics steps
+static bool CheckPhysicsReplay() {
+	// Uneven frame times, including frames shorter than a step and frames long enough to hit the step cap
+	std::vector<float> frameTimes;
+	for (int ix = 0; ix < 300; ix++) {
+		frameTimes.push_back(ix % 37 == 0 ? 0.1f : 0.004f + (ix % 7) * 0.0035f);
+	}
+
+	std::vector<GameObject::Sptr> bodiesA, bodiesB;
+	Scene::Sptr sceneA = MakePhysicsScene(64, bodiesA);
+	Scene::Sptr sceneB = MakePhysicsScene(64, bodiesB);
+	for (float dt : frameTimes) {
+		sceneA->DoPhysics(dt);
+	}
+	for (float dt : frameTimes) {
+		sceneB->DoPhysics(dt);
+	}
+
+	for (size_t ix = 0; ix < bodiesA.size(); ix++) {
+		if (bodiesA[ix]->GetPosition() != bodiesB[ix]->GetPosition() || bodiesA[ix]->GetRotation() != bodiesB[ix]->GetRotation()) {
+			LOG_WARN("Body {} differs between runs", ix);
+			return false;
+		}
+	}
+
+	// Make sure the bodies actually fell, otherwise the comparison above proves nothing
+	return bodiesA[0]->GetPosition().z < 1.9f;
+}
+
+// Times fixed physics steps for increasingly large piles of bodies, to see how stepping scales with body count
+static bool BenchmarkPhysicsStep() {
+	const int numSteps = 120;
+	for (int count : { 1000, 5000, 10000 }) {
+		std::vector<GameObject::Sptr> bodies;
+		Scene::Sptr scene = MakePhysicsScene(count, bodies);
+		double totalMs = TimeMs([&]() {
+			for (int ix = 0; ix < numSteps; ix++) {
+				scene->DoPhysics(scene->GetPhysicsTimestep());
+			}
+		});
+		LOG_INFO("{} bodies: {:.3f}ms per step ({} steps)", count, totalMs / numSteps, numSteps);
+	}
+	return true;
+}
+
+// Times fixed steps of the multithreaded world for 1k, 5k and 10k bodies, from 1 thread up to every thread the
+// job system has. The thread count is capped through Bullet's scheduler rather than by restarting the job
+// system like jobs.scene_update_scaling does, since Bullet never reuses the thread indices it hands out
+static bool BenchmarkPhysicsThreadScaling() {
+#if BT_THREADSAFE
+	const int numSteps = 60;
+	PhysicsTaskScheduler& scheduler = PhysicsTaskScheduler::Get();
+	int maxThreads = scheduler.getNumThreads();
+
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	for (int count : { 1000, 5000, 10000 }) {
+		double singleThreadMs = 0.0;
+		for (int threads : threadCounts) {
+			scheduler.setNumThreads(threads);
+
+			std::vector<GameObject::Sptr> bodies;
+			Scene::Sptr scene = MakePhysicsScene(count, bodies, true);
+			double stepMs = TimeMs([&]() {
+				for (int ix = 0; ix < numSteps; ix++) {
+					scene->DoPhysics(scene->GetPhysicsTimestep());
+				}
+			}) / numSteps;
+			singleThreadMs = threads == 1 ? stepMs : singleThreadMs;
+
+			LOG_INFO("{} bodies, {} threads: {:.3f}ms per step ({:.2f}x)", count, threads, stepMs, singleThreadMs / std::max(stepMs, 1e-6));
+		}
+	}
+
+	scheduler.setNumThreads(maxThreads);
+	return true;
+#else
+	LOG_WARN("Bullet was built without BT_THREADSAFE, so there is no multithreaded physics world to benchmark (see BulletThreadSafe in Premake5.lua)");
+	return true;
+#endif
+}
+
+// Counts how many of the bodies in a physics world are awake
+static int CountActiveBodies(btDynamicsWorld* world) {
+	int active = 0;
+	const btCollisionObjectArray& objects = world->getCollisionObjectArray();
+	for (int ix = 0; ix < objects.size(); ix++) {
+		active += objects[ix]->isStaticObject() || !objects[ix]->isActive() ? 0 : 1;
+	}
+	return active;
+}
+
+// Times physics steps for a grid of 5,000 boxes resting on a floor. Once the boxes have fallen asleep,
+// stepping should cost next to nothing, we compare that against the same boxes with sleeping disabled
+static bool BenchmarkRestingBoxes() {
+	const int size = 71;
+	const int numSteps = 120;
+
+	Scene::Sptr scene = std::make_shared<Scene>();
+	GameObject::Sptr floor = scene->CreateGameObject("Floor");
+	floor->Add<RigidBody>(RigidBodyType::Static)->AddCollider(BoxCollider::Create(glm::vec3(50.0f, 50.0f, 1.0f)));
+	for (int ix = 0; ix < size * size; ix++) {
+		GameObject::Sptr box = scene->CreateGameObject("Box");
+		box->SetPostion(glm::vec3((ix % size - size / 2) * 1.2f, (ix / size - size / 2) * 1.2f, 1.51f));
+		box->Add<RigidBody>(RigidBodyType::Dynamic)->AddCollider(BoxCollider::Create(glm::vec3(0.5f)));
+	}
+	scene->Awake();
+	scene->IsPlaying = true;
+
+	// Give the boxes time to settle and fall asleep
+	int settleSteps = 0;
+	while (settleSteps < 1200 && CountActiveBodies(scene->GetPhysicsWorld()) > 0) {
+		scene->DoPhysics(scene->GetPhysicsTimestep());
+		settleSteps++;
+	}
+	int sleeping = size * size - CountActiveBodies(scene->GetPhysicsWorld());
+
+	double sleepingMs = TimeMs([&]() {
+		for (int ix = 0; ix < numSteps; ix++) {
+			scene->DoPhysics(scene->GetPhysicsTimestep());
+		}
+	}) / numSteps;
+	int stillSleeping = size * size - CountActiveBodies(scene->GetPhysicsWorld());
+
+	// Keep every box awake, which is what resetting their transforms every step used to do
+	const btCollisionObjectArray& objects = scene->GetPhysicsWorld()->getCollisionObjectArray();
+	for (int ix = 0; ix < objects.size(); ix++) {
+		if (!objects[ix]->isStaticObject()) {
+			objects[ix]->forceActivationState(DISABLE_DEACTIVATION);
+		}
+	}
+	double awakeMs = TimeMs([&]() {
+		for (int ix = 0; ix < numSteps; ix++) {
+			scene->DoPhysics(scene->GetPhysicsTimestep());
+		}
+	}) / numSteps;
+
+	LOG_INFO("{} resting boxes: {} asleep after {} steps, {:.3f}ms per step asleep ({} still asleep), {:.3f}ms per step awake",
+		size * size, sleeping, settleSteps, sleepingMs, stillSleeping, awakeMs);
+
+	// Nothing touched the boxes, so any that fell asleep must have stayed asleep
+	return stillSleeping == sleeping && sleeping > 0;
+}
+
+// Times the trigger pass for 500 trigger volumes over 2,000 bodies resting on a floor. The scene's own tracker
+// runs as part of each step, so we time a second tracker over the same world to see what the pass costs alone
+static bool BenchmarkTriggerEvents() {
+	const int numTriggers = 500;
+	const int numBodies   = 2000;
+	const int numSteps    = 120;
+
+	Scene::Sptr scene = std::make_shared<Scene>();
+	GameObject::Sptr floor = scene->CreateGameObject("Floor");
+	floor->Add<RigidBody>(RigidBodyType::Static)->AddCollider(BoxCollider::Create(glm::vec3(50.0f, 50.0f, 1.0f)));
+
+	// A 25x20 grid of triggers just above the floor, covering the same area as the bodies
+	for (int ix = 0; ix < numTriggers; ix++) {
+		GameObject::Sptr trigger = scene->CreateGameObject("Trigger");
+		trigger->SetPostion(glm::vec3((ix % 25 - 12) * 2.2f, (ix / 25 - 10) * 2.7f, 1.6f));
+		trigger->Add<TriggerVolume>()->AddCollider(BoxCollider::Create(glm::vec3(1.0f, 1.0f, 0.5f)));
+	}
+	for (int ix = 0; ix < numBodies; ix++) {
+		GameObject::Sptr ball = scene->CreateGameObject("Ball");
+		ball->SetPostion(glm::vec3((ix % 50 - 25) * 1.1f, (ix / 50 - 20) * 1.35f, 1.6f));
+		RigidBody::Sptr body = ball->Add<RigidBody>(RigidBodyType::Dynamic);
+		body->AddCollider(SphereCollider::Create(0.5f));
+	}
+	scene->Awake();
+	scene->IsPlaying = true;
+
+	// Let the bodies land, and keep them awake so every step has the same amount of work
+	for (int ix = 0; ix < 60; ix++) {
+		scene->DoPhysics(scene->GetPhysicsTimestep());
+	}
+	const btCollisionObjectArray& objects = scene->GetPhysicsWorld()->getCollisionObjectArray();
+	for (int ix = 0; ix < objects.size(); ix++) {
+		if (!objects[ix]->isStaticObject()) {
+			objects[ix]->forceActivationState(DISABLE_DEACTIVATION);
+		}
+	}
+
+	double stepMs = TimeMs([&]() {
+		for (int ix = 0; ix < numSteps; ix++) {
+			scene->DoPhysics(scene->GetPhysicsTimestep());
+		}
+	}) / numSteps;
+
+	// The first update sees every overlap as new, after that we're timing the steady state
+	TriggerEventTracker tracker;
+	tracker.Update(scene->GetPhysicsWorld());
+	double trackerMs = TimeMs([&]() {
+		for (int ix = 0; ix < numSteps; ix++) {
+			tracker.Update(scene->GetPhysicsWorld());
+		}
+	}) / numSteps;
+
+	LOG_INFO("{} triggers, {} bodies: {:.3f}ms per step, {:.3f}ms of it in the trigger pass ({} overlaps)",
+		numTriggers, numBodies, stepMs, trackerMs, tracker.NumOverlaps());
+
+	// The bodies rest inside the triggers, so if nothing overlaps the tracker isn't seeing them
+	return tracker.NumOverlaps() > 0;
+}
+
+const std::vector<SelfTest::Test>& SelfTest::_GetTests() {
+	static std::vector<Test> tests = {
+		{ "jobs.wait_skips_background",    false, CheckWaitSkipsBackgroundJobs },
+		{ "jobs.scene_update_scaling",     true,  BenchmarkSceneUpdateScaling },
+		{ "components.each_with_removals", false, CheckEachWithRemovals },
+		{ "components.iteration",          true,  BenchmarkComponentIteration },
+		{ "components.lookup",             true,  BenchmarkComponentLookup },
+		{ "transforms.hierarchy",          true,  BenchmarkTransformHierarchy },
+		{ "particles.frame_time",          true,  BenchmarkParticleFrames },
+		{ "scenes.binary_round_trip",      false, CheckSceneBinaryRoundTrip },
+		{ "scenes.save_load",              true,  BenchmarkSceneSaveLoad },
+		{ "meshes.binary_load",            true,  BenchmarkBinaryMeshLoad },
+		{ "meshes.obj_parse_throughput",   true,  BenchmarkObjParseThroughput },
+		{ "meshes.obj_parallel_parse",     false, CheckObjParallelParse },
+		{ "meshes.obj_parallel_import",    false, CheckObjParallelImportAssets },
+		{ "meshes.parallel_tbn",           false, CheckParallelTBN },
+		{ "textures.block_encoding",       false, CheckTextureBlockEncoding },
+		{ "textures.cache_round_trip",     false, CheckTextureCacheRoundTrip },
+		{ "physics.fixed_step_replay",     false, CheckPhysicsReplay },
+		{ "physics.step",                  true,  BenchmarkPhysicsStep },
+		{ "physics.thread_scaling",        true,  BenchmarkPhysicsThreadScaling },
+		{ "physics.resting_boxes",         true,  BenchmarkRestingBoxes },
+		{ "physics.trigger_events",        true,  BenchmarkTriggerEvents },
+	};
+	return tests;
+}
+
+int SelfTest::Run(bool benchmarks, const std::string& filter) {
+	int failures = 0;
+	int ran = 0;
+	for (const Test& test : _GetTests()) {
+		if (test.IsBenchmark != benchmarks || (!filter.empty() && test.Name.find(filter) == std::string::npos)) {
+			continue;
+		}
+
+		LOG_INFO("[ RUN  ] {}", test.Name);
+		bool passed = false;
+		try {
+			passed = test.Func();
+		} catch (const std::exception& e) {
+			LOG_WARN("Exception: {}", e.what());
+		}
+		LOG_INFO("[ {} ] {}", passed ? " OK " : "FAIL", test.Name);
+
+		failures += passed ? 0 : 1;
+		ran++;
+	}
+
+	LOG_INFO("Ran {} {}, {} failed", ran, benchmarks ? "benchmarks" : "checks", failures);
+	return failures;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Runs the engine's built in checks and benchmarks, these are started from the command line:
+ *   --selftest   Runs every check, the process exit code is the number of checks that failed
+ *   --benchmark  Runs every benchmark and logs the timings
+ *
+ * An optional filter can follow either flag, in which case only tests whose name contains the
+ * filter are run (ex: --selftest scene)
+ *
+ * Tests are run once the application has a GL context and all component and resource types have
+ * been registered, but before the first frame
+ */
+class SelfTest final {
+public:
+	typedef std::function<bool()> TestFunc;
+
+	/**
+	 * Runs all checks or all benchmarks that match the filter
+	 *
+	 * @param benchmarks True to run the benchmarks, false to run the checks
+	 * @param filter Only tests whose name contains this will be run, empty to run all of them
+	 * @returns The number of tests that failed
+	 */
+	static int Run(bool benchmarks, const std::string& filter = "");
+
+protected:
+	SelfTest() = default;
+
+	struct Test {
+		std::string Name;
+		bool        IsBenchmark;
+		TestFunc    Func;
+	};
+
+	// Gets the list of all tests that we know about
+	static const std::vector<Test>& _GetTests();
+};
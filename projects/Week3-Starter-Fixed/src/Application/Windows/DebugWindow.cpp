@@ -24,6 +24,33 @@ void DebugWindow::RenderMenuBar()
 		app.CurrentScene()->SetPhysicsDebugDrawMode(physicsDrawMode);
 	}
 
+	bool fixedTimestep = app.CurrentScene()->IsFixedPhysicsTimestep();
+	if (ImGui::Checkbox("Fixed Physics Timestep", &fixedTimestep)) {
+		app.CurrentScene()->SetFixedPhysicsTimestep(fixedTimestep);
+	}
+	if (fixedTimestep) {
+		float physicsRate = 1.0f / app.CurrentScene()->GetPhysicsTimestep();
+		ImGui::SetNextItemWidth(100.0f);
+		if (ImGui::DragFloat("Steps/s", &physicsRate, 1.0f, 10.0f, 240.0f, "%.0f")) {
+			app.CurrentScene()->SetPhysicsTimestep(1.0f / glm::max(physicsRate, 10.0f));
+		}
+		int maxSubSteps = app.CurrentScene()->GetMaxPhysicsSubSteps();
+		ImGui::SetNextItemWidth(100.0f);
+		if (ImGui::DragInt("Max Sub Steps", &maxSubSteps, 0.1f, 1, 16)) {
+			app.CurrentScene()->SetMaxPhysicsSubSteps(glm::max(maxSubSteps, 1));
+		}
+	}
+
+#if BT_THREADSAFE
+	bool multithreaded = app.CurrentScene()->IsMultithreadedPhysics();
+	if (ImGui::Checkbox("Multithreaded Physics", &multithreaded)) {
+		app.CurrentScene()->SetMultithreadedPhysics(multithreaded);
+	}
+	if (ImGui::IsItemHovered()) {
+		ImGui::SetTooltip("Rebuilds the physics world, pays off for scenes with thousands of bodies");
+	}
+#endif
+
 	ImGui::Separator();
 
 	RenderFlags flags = renderLayer->GetRenderFlags();
@@ -37,4 +64,17 @@ void DebugWindow::RenderMenuBar()
 	if (changed) {
 		renderLayer->SetRenderFlags(flags);
 	}
+
+	bool multiDraw = renderLayer->IsMultiDrawEnabled();
+	if (ImGui::Checkbox("Multi-Draw Static Meshes", &multiDraw)) {
+		renderLayer->SetMultiDrawEnabled(multiDraw);
+	}
+
+	ImGui::Separator();
+
+	const RenderLayer::RenderStats& stats = renderLayer->GetRenderStats();
+	ImGui::Text("Draws: %u  Shader Binds: %u  Material Binds: %u  Opaque: %u  Transparent: %u",
+		stats.DrawCalls, stats.ShaderBinds, stats.MaterialBinds, stats.OpaqueItems, stats.TransparentItems);
+	ImGui::Text("Visible: %u  Culled: %u  Instanced Draws: %u (%u objects)", stats.VisibleItems, stats.CulledItems, stats.InstancedDraws, stats.InstancedItems);
+	ImGui::Text("Multi-Draws: %u (%u objects)  Instance Data: %u bytes", stats.MultiDraws, stats.MultiDrawItems, stats.InstanceDataBytes);
 }
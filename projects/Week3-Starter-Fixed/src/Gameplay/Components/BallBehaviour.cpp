@@ -25,7 +25,7 @@ nlohmann::json BallBehaviour::ToJson() const {
 }
 
 BallBehaviour::Sptr BallBehaviour::FromJson(const nlohmann::json& data) {
-	BallBehaviour::Sptr result = std::make_shared<BallBehaviour>();
+	BallBehaviour::Sptr result = Gameplay::MakeComponent<BallBehaviour>();
 	result->BallSpeed = JsonGet(data, "speed", result->BallSpeed);
 	return result;
 }
\ No newline at end of file
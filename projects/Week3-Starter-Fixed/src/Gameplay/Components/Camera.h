@@ -14,7 +14,7 @@ namespace Gameplay {
 		typedef std::shared_ptr<Camera> Sptr;
 
 		inline static Sptr Create() {
-			return std::make_shared<Camera>();
+			return MakeComponent<Camera>();
 		}
 
 	// IComponent implementation
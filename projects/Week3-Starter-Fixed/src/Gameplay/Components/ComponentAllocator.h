@@ -0,0 +1,123 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+namespace Gameplay {
+	/// <summary>
+	/// Hands out fixed size blocks of memory from chunks of blocks, so that objects of the same size end
+	/// up next to each other in memory rather than wherever the heap puts them. Blocks that are freed are
+	/// handed out again before any new chunks are allocated, and chunks are never moved, so objects stay
+	/// where they were created
+	/// </summary>
+	/// <typeparam name="BlockSize">The size of each block, in bytes</typeparam>
+	/// <typeparam name="BlockAlign">The alignment of each block, in bytes</typeparam>
+	template <size_t BlockSize, size_t BlockAlign>
+	class ComponentChunkStore {
+	public:
+		// The number of blocks that get allocated at once
+		static constexpr size_t BLOCKS_PER_CHUNK = 256;
+
+		/// <summary>
+		/// Gets a block of at least BlockSize bytes
+		/// </summary>
+		static void* Allocate() {
+			Store& store = _GetStore();
+			std::lock_guard<std::mutex> lock(store.Mutex);
+			if (store.FreeList == nullptr) {
+				_AddChunk(store);
+			}
+			Block* block = store.FreeList;
+			store.FreeList = block->Next;
+			return block->Data;
+		}
+
+		/// <summary>
+		/// Returns a block that was given out by Allocate
+		/// </summary>
+		static void Free(void* ptr) {
+			Store& store = _GetStore();
+			std::lock_guard<std::mutex> lock(store.Mutex);
+			Block* block = reinterpret_cast<Block*>(ptr);
+			block->Next = store.FreeList;
+			store.FreeList = block;
+		}
+
+	private:
+		union Block {
+			Block* Next;
+			alignas(BlockAlign) unsigned char Data[BlockSize];
+		};
+
+		struct Store {
+			std::mutex                            Mutex;
+			Block*                                FreeList = nullptr;
+			std::vector<std::unique_ptr<Block[]>> Chunks;
+		};
+
+		static Store& _GetStore() {
+			// Never destroyed, components that are held by other statics can be released after
+			// this would have been destroyed on exit
+			static Store* store = new Store();
+			return *store;
+		}
+
+		static void _AddChunk(Store& store) {
+			store.Chunks.push_back(std::make_unique<Block[]>(BLOCKS_PER_CHUNK));
+			Block* chunk = store.Chunks.back().get();
+			// Link the blocks back to front, so that they get handed out in the order they sit in memory
+			for (size_t ix = BLOCKS_PER_CHUNK; ix > 0; ix--) {
+				chunk[ix - 1].Next = store.FreeList;
+				store.FreeList = &chunk[ix - 1];
+			}
+		}
+	};
+
+	/// <summary>
+	/// An allocator for std::allocate_shared that places objects (along with their shared_ptr control
+	/// block) into chunks, shared with every other object of the same size and alignment
+	/// </summary>
+	template <typename T>
+	class ComponentAllocator {
+	public:
+		typedef T value_type;
+
+		ComponentAllocator() noexcept = default;
+		template <typename U>
+		ComponentAllocator(const ComponentAllocator<U>&) noexcept { }
+
+		T* allocate(size_t count) {
+			// allocate_shared only ever asks for one object at a time
+			if (count != 1) {
+				return std::allocator<T>().allocate(count);
+			}
+			return static_cast<T*>(ComponentChunkStore<sizeof(T), alignof(T)>::Allocate());
+		}
+
+		void deallocate(T* ptr, size_t count) noexcept {
+			if (count != 1) {
+				std::allocator<T>().deallocate(ptr, count);
+			} else {
+				ComponentChunkStore<sizeof(T), alignof(T)>::Free(ptr);
+			}
+		}
+
+		template <typename U>
+		bool operator==(const ComponentAllocator<U>&) const noexcept { return true; }
+		template <typename U>
+		bool operator!=(const ComponentAllocator<U>&) const noexcept { return false; }
+	};
+
+	/// <summary>
+	/// Creates a component in the chunks for it's type, use this in place of std::make_shared when
+	/// creating components (ex: in FromJson) so that components of a type are packed together and
+	/// ComponentManager::Each walks through memory in order rather than all over the heap
+	/// </summary>
+	/// <typeparam name="ComponentType">The type of component to create</typeparam>
+	/// <param name="...args">The arguments to forward to the component's constructor</param>
+	template <typename ComponentType, typename ... TArgs>
+	std::shared_ptr<ComponentType> MakeComponent(TArgs&& ... args) {
+		return std::allocate_shared<ComponentType>(ComponentAllocator<ComponentType>(), std::forward<TArgs>(args)...);
+	}
+}
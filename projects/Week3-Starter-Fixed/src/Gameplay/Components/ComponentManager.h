@@ -38,11 +38,10 @@ namespace Gameplay {
 					IComponent::LoadBaseJson(result, blob);
 
 					// Make sure the component knows it's own type
-					result->_realType = typeIndex.value();
 					result->_weakSelfPtr = result;
 
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_AddToPool(result.get(), typeIndex.value());
 					return result;
 				}
 			}
@@ -68,10 +67,9 @@ namespace Gameplay {
 					// Invoke the loader, also load additional component data
 					IComponent::Sptr result = callback();
 					// Make sure the component knows it's own type
-					result->_realType = typeIndex.value();
 					result->_weakSelfPtr = result;
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_AddToPool(result.get(), typeIndex.value());
 					return result;
 				}
 			}
@@ -95,10 +93,9 @@ namespace Gameplay {
 				// Invoke the loader, also load additional component data
 				IComponent::Sptr result = callback();
 				// Make sure the component knows it's own type
-				result->_realType = type;
 				result->_weakSelfPtr = result;
 				// Add the component to the global pools
-				_Components[result->_realType].push_back(result);
+				_AddToPool(result.get(), type);
 				return result;
 			}
 			return nullptr;
@@ -131,16 +128,14 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Create component, forwarding arguments
-			std::shared_ptr<ComponentType> component = std::make_shared<ComponentType>(std::forward<TArgs>(args)...);
+			// Create component in the chunks for it's type, forwarding arguments
+			std::shared_ptr<ComponentType> component = MakeComponent<ComponentType>(std::forward<TArgs>(args)...);
 
-			// Make sure the component knows it's concrete type
-			component->_realType = type;
 			// Give the component a weak pointer to itself that it can upcast to a shared pointer when needed
 			component->_weakSelfPtr = component;
 
-			// Add to global component list for that type
-			_Components[type].push_back(component);
+			// Add to global component pool for that type, this also lets the component know it's concrete type
+			_AddToPool(component.get(), type);
 
 			// Return the result
 			return component;
@@ -157,56 +152,124 @@ namespace Gameplay {
 			typename ComponentType,
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
 		std::shared_ptr<ComponentType> GetComponentByGUID(Guid id) {
-			// We can use typeid and type_index to get a unique ID for our types
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
-
-			// Clear any dead weak pointers
-			auto removeIt = std::remove_if(_Components[type].begin(), _Components[type].end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			_Components[type].erase(removeIt, _Components[type].end());
+			// Registered types have a dense ID that we can use to look up their pool directly
+			ComponentTypeId typeId = TypeId<ComponentType>();
+			LOG_ASSERT(typeId != INVALID_COMPONENT_TYPE, "You must register component types before creating them!");
 
 			// Search the component store for a component that matches that ID
-			auto& it = std::find_if(_Components[type].begin(), _Components[type].end(), [&](const std::weak_ptr<IComponent>& ptr) {
-				return (ptr.lock())->GetGUID() == id;
-			});
-
-			// If the component was found, return it. Otherwise return nullptr
-			if (it != _Components[type].end()) {
-				// We need to lock the weak pointer to convert it to a shared ptr
-				return std::dynamic_pointer_cast<ComponentType>((*it).lock());
-			} else {
-				return nullptr;
+			if (typeId < _Pools.size()) {
+				for (IComponent* component : _Pools[typeId]) {
+					if (component != nullptr && component->GetGUID() == id) {
+						// We need to lock the weak pointer to convert it to a shared ptr
+						return std::static_pointer_cast<ComponentType>(component->_weakSelfPtr.lock());
+					}
+				}
 			}
+
+			// The component was not found
+			return nullptr;
 		}
 
 		/// <summary>
-		/// Iterates over all components of the given type and invokes a method with them
+		/// Iterates over all components of the given type and invokes a method with them. The pool
+		/// for the type is walked directly, so callbacks that take the component by reference (ex:
+		/// [](RigidBody& body) { ... }) will not incur any locking, casting or std::function overhead. 
+		/// Callbacks that take a const std::shared_ptr&lt;ComponentType&gt;&amp; are still supported
+		/// 
+		/// Components destroyed while iterating are removed from their pools once the outermost Each
+		/// finishes, so no component is skipped. Callbacks that take the component by reference must not
+		/// destroy the component they were given, since nothing is keeping it alive (use
+		/// Scene::RemoveGameObject, which is deferred, or take a shared_ptr instead)
 		/// </summary>
 		/// <typeparam name="ComponentType">The type of component to iterate on</typeparam>
+		/// <typeparam name="Func">The type of the callback, will be deduced from the callback</typeparam>
 		/// <param name="callback">The callback to invoke with the components</param>
 		/// <param name="includeDisabled">True to include disabled components, false if otherwise</param>
 		template <
 			typename ComponentType,
+			typename Func,
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
-		void Each(std::function<void(const std::shared_ptr<ComponentType>&)> callback, bool includeDisabled = false) {
-			// We can use typeid and type_index to get a unique ID for our types
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
+		void Each(Func&& callback, bool includeDisabled = false) {
+			// Registered types have a dense ID that we can use to look up their pool directly
+			ComponentTypeId typeId = TypeId<ComponentType>();
+			LOG_ASSERT(typeId != INVALID_COMPONENT_TYPE, "You must register component types before creating them!");
+
+			// No components of this type have been created yet
+			if (typeId >= _Pools.size()) {
+				return;
+			}
 
-			// Iterate over all the components in the store
-			for (auto& wptr : _Components[type]) {
-				// Lock the weak pointer to get a shared pointer (maybe)
-				std::shared_ptr<IComponent> sptr = wptr.lock();
-				// If the pointer is alive and matches our enabled criteria, invoke the callback
-				if (sptr && sptr->IsEnabled | includeDisabled) {
-					// Upcast to component type and invoke the callback
-					callback(std::dynamic_pointer_cast<ComponentType>(sptr));
+			// Iterate over all the components in the store. While we're iterating, removals only clear
+			// the component's slot, so nothing moves under us. We index the pool each time since
+			// callbacks that create components can cause it to reallocate. The scope also handles
+			// compacting once the outermost Each is done, even if a callback throws
+			_IterationScope scope(*this);
+			for (size_t ix = 0; ix < _Pools[typeId].size(); ix++) {
+				// Everything in this pool is of the concrete type, so a static cast is safe
+				ComponentType* component = static_cast<ComponentType*>(_Pools[typeId][ix]);
+
+				// If the component matches our enabled criteria, invoke the callback. Slots are null if the
+				// component was destroyed earlier in this pass
+				if (component != nullptr && (component->IsEnabled || includeDisabled)) {
+					if constexpr (std::is_invocable<Func, ComponentType&>::value) {
+						callback(*component);
+						LOG_ASSERT(_Pools[typeId][ix] != nullptr, "A component was destroyed from inside it's own by-reference Each callback!");
+					} else {
+						callback(std::static_pointer_cast<ComponentType>(component->_weakSelfPtr.lock()));
+					}
 				}
 			}
 		}
 
+		/// <summary>
+		/// Gets the number of live components of the given type that are stored in this manager. This
+		/// does not include components destroyed during an Each that are still waiting to be compacted
+		/// </summary>
+		/// <typeparam name="ComponentType">The type of component to count</typeparam>
+		template <
+			typename ComponentType,
+			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
+		size_t Count() const {
+			ComponentTypeId typeId = TypeId<ComponentType>();
+			return typeId < _PoolLiveCounts.size() ? _PoolLiveCounts[typeId] : 0;
+		}
+
+		/// <summary>
+		/// Gets the dense integer ID that was assigned to the given component type when it was
+		/// registered, or INVALID_COMPONENT_TYPE if the type has not been registered
+		/// </summary>
+		/// <typeparam name="T">The type of component to get the ID for</typeparam>
+		template <typename T>
+		static ComponentTypeId TypeId() {
+			return _StaticTypeId<T>();
+		}
+
+		/// <summary>
+		/// Gets the dense integer ID that was assigned to the given component type when it was
+		/// registered, or INVALID_COMPONENT_TYPE if the type has not been registered
+		/// </summary>
+		/// <param name="type">The type of component to get the ID for</param>
+		static ComponentTypeId TypeId(const std::type_index& type) {
+			auto it = _TypeIdRegistry.find(type);
+			return it != _TypeIdRegistry.end() ? it->second : INVALID_COMPONENT_TYPE;
+		}
+
+		/// <summary>
+		/// Returns true if the component type with the given ID has opted into parallel updates
+		/// (see IComponent::ParallelUpdate)
+		/// </summary>
+		/// <param name="typeId">The ID of the type to check</param>
+		static bool IsParallelUpdateType(ComponentTypeId typeId) {
+			return typeId < _TypeParallelUpdate.size() && _TypeParallelUpdate[typeId];
+		}
+
+		/// <summary>
+		/// Gets the number of component types that have been registered
+		/// </summary>
+		static ComponentTypeId NumRegisteredTypes() {
+			return static_cast<ComponentTypeId>(_TypeIdRegistry.size());
+		}
+
 		/// <summary>
 		/// Attempts to register a given type as a component, should be called for each component type 
 		/// at the start of you application
@@ -227,6 +290,12 @@ namespace Gameplay {
 				_TypeLoadRegistry[type] = &ComponentManager::ParseTypeFromBlob<T>;
 				_TypeCreateRegistry[type] = &ComponentManager::_InternalCreate<T>;
 				_TypeNameMap[StringTools::SanitizeClassName(typeid(T).name())] = type;
+
+				// Assign the next dense type ID, this is what we'll use to index our component pools
+				ComponentTypeId typeId = static_cast<ComponentTypeId>(_TypeIdRegistry.size());
+				_TypeIdRegistry[type] = typeId;
+				_StaticTypeId<T>() = typeId;
+				_TypeParallelUpdate.push_back(T::ParallelUpdate);
 			}
 		}
 
@@ -234,7 +303,22 @@ namespace Gameplay {
 		/// Removes all components of all types from the registry, whether they are referenced elsewhere or not
 		/// </summary>
 		inline void FlushAll() {
-			_Components = std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>>();
+			// Make sure any surviving components don't try and remove themselves from us later
+			for (auto& pool : _Pools) {
+				for (IComponent* component : pool) {
+					if (component != nullptr) {
+						component->_manager = nullptr;
+					}
+				}
+			}
+			_Pools.clear();
+			_PoolLiveCounts.clear();
+			_hasPendingRemovals = false;
+		}
+
+		ComponentManager() = default;
+		~ComponentManager() {
+			FlushAll();
 		}
 
 	private:
@@ -249,11 +333,78 @@ namespace Gameplay {
 		inline static std::unordered_map<std::type_index, LoadComponentFunc> _TypeLoadRegistry;
 		// Stores functions to load components from JSON, indexed on the type that they load
 		inline static std::unordered_map<std::type_index, CreateComponentFunc> _TypeCreateRegistry;
+		// Maps types to the dense integer IDs assigned in RegisterType
+		inline static std::unordered_map<std::type_index, ComponentTypeId> _TypeIdRegistry;
+		// Whether each component type has opted into parallel updates, indexed by type ID
+		inline static std::vector<bool> _TypeParallelUpdate;
+
+		// One contiguous pool per registered component type, indexed by the type's ID. We store raw
+		// pointers here so that we don't affect the lifetime of components, components will remove
+		// themselves from their pool when they are destroyed (see IComponent's destructor). The
+		// components themselves live in per-type chunks (see MakeComponent), so walking a pool
+		// walks through memory mostly in order
+		std::vector<std::vector<IComponent*>> _Pools;
+		// The number of components in each pool that are still alive, the pools can also hold null
+		// slots for components destroyed during iteration until they are compacted
+		std::vector<size_t> _PoolLiveCounts;
+		// How many calls to Each are currently running, pools are only compacted when this is zero
+		int  _iterationDepth = 0;
+		// True if components were destroyed during iteration, and their null slots need to be removed
+		bool _hasPendingRemovals = false;
+
+		// Marks the pools as being iterated for as long as it's alive, so that the iteration depth is
+		// restored even if an Each callback throws
+		struct _IterationScope {
+			ComponentManager& Manager;
+
+			explicit _IterationScope(ComponentManager& manager) : Manager(manager) {
+				Manager._iterationDepth++;
+			}
+			~_IterationScope() {
+				Manager._iterationDepth--;
+
+				// Now that no one is walking the pools, we can compact out anything destroyed during iteration
+				if (Manager._iterationDepth == 0 && Manager._hasPendingRemovals) {
+					Manager._CompactPools();
+				}
+			}
+
+			_IterationScope(const _IterationScope&) = delete;
+			_IterationScope& operator=(const _IterationScope&) = delete;
+		};
 
-		// Weak pointers let us store a reference to an object stored by a shared pointer, without
-		// actually increasing the reference count. Thus components will be destroyed at the correct
-		// time (when the only reference is the one stored here).
-		std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>> _Components;  
+		// Storage for the type ID of each registered component type, allows for lookups without
+		// needing to hash the type_index
+		template <typename T>
+		static ComponentTypeId& _StaticTypeId() {
+			static ComponentTypeId id = INVALID_COMPONENT_TYPE;
+			return id;
+		}
+
+		/// <summary>
+		/// Adds a newly created component to the end of the pool for it's type
+		/// </summary>
+		/// <param name="component">The component to add</param>
+		/// <param name="type">The concrete type of the component</param>
+		inline void _AddToPool(IComponent* component, const std::type_index& type) {
+			ComponentTypeId typeId = TypeId(type);
+			LOG_ASSERT(typeId != INVALID_COMPONENT_TYPE, "You must register component types before creating them!");
+
+			// Pools are allocated lazily, since types may be registered after the manager is created
+			if (typeId >= _Pools.size()) {
+				_Pools.resize(static_cast<size_t>(NumRegisteredTypes()));
+				_PoolLiveCounts.resize(_Pools.size(), 0);
+			}
+
+			std::vector<IComponent*>& pool = _Pools[typeId];
+			component->_realType  = type;
+			component->_typeId    = typeId;
+			component->_poolIndex = pool.size();
+			component->_manager   = this;
+			component->_isParallelUpdate = IsParallelUpdateType(typeId);
+			pool.push_back(component);
+			_PoolLiveCounts[typeId]++;
+		}
 
 		template <typename T>
 		static IComponent::Sptr ParseTypeFromBlob(const nlohmann::json& blob) {
@@ -266,8 +417,8 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Create component, forwarding arguments
-			std::shared_ptr<ComponentType> component = std::make_shared<ComponentType>();
+			// Create component in the chunks for it's type
+			std::shared_ptr<ComponentType> component = MakeComponent<ComponentType>();
 
 			// Make sure the component knows it's concrete type
 			component->_realType = type;
@@ -280,24 +431,53 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Removes a given component from the global pools. To be used in the IComponent destructor
+		/// The last component in the pool is swapped into the removed slot, so this is constant time
 		/// </summary>
-		/// <typeparam name="ComponentType">The type of component to destroy</typeparam>
 		/// <param name="component">A raw pointer to the component to remove (should be called from IComponent destructor)</param>
-		/// <returns>True if the element was removed, false if not</returns>
 		inline void Remove(const IComponent* component) {
 			// Make sure the component's type was one that was registered
-			LOG_ASSERT(_TypeLoadRegistry[component->_realType] != nullptr, "You must register component types before creating them!");
+			LOG_ASSERT(component->_typeId != INVALID_COMPONENT_TYPE, "You must register component types before creating them!");
+			if (component->_typeId >= _Pools.size()) {
+				return;
+			}
 
 			// Get a reference to the vector of components for easy access
-			std::vector<std::weak_ptr<IComponent>>& componentStore = _Components[component->_realType];
-
-			// Clear any dead weak pointers
-			auto it = std::remove_if(componentStore.begin(), componentStore.end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			if (it != componentStore.end()) {
-				componentStore.erase(it);
+			std::vector<IComponent*>& componentStore = _Pools[component->_typeId];
+
+			// Make sure the slot actually belongs to this component before we remove it
+			size_t index = component->_poolIndex;
+			if (index < componentStore.size() && componentStore[index] == component) {
+				_PoolLiveCounts[component->_typeId]--;
+
+				// Swapping while an Each is running would move an unvisited component into a slot that was
+				// already visited, so we just clear the slot and compact once iteration is done
+				if (_iterationDepth > 0) {
+					componentStore[index] = nullptr;
+					_hasPendingRemovals = true;
+				} else {
+					componentStore[index] = componentStore.back();
+					componentStore[index]->_poolIndex = index;
+					componentStore.pop_back();
+				}
+			}
+		}
+
+		/// <summary>
+		/// Removes the null slots left behind by components that were destroyed during iteration
+		/// </summary>
+		inline void _CompactPools() {
+			for (auto& pool : _Pools) {
+				size_t count = 0;
+				for (size_t ix = 0; ix < pool.size(); ix++) {
+					if (pool[ix] != nullptr) {
+						pool[count] = pool[ix];
+						pool[count]->_poolIndex = count;
+						count++;
+					}
+				}
+				pool.resize(count);
 			}
+			_hasPendingRemovals = false;
 		}
 	};
 }
\ No newline at end of file
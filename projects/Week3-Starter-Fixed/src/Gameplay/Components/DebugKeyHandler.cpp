@@ -112,7 +112,7 @@ nlohmann::json DebugKeyHandler::ToJson() const {
 }
 
 DebugKeyHandler::Sptr DebugKeyHandler::FromJson(const nlohmann::json& data) {
-	DebugKeyHandler::Sptr result = std::make_shared<DebugKeyHandler>();
+	DebugKeyHandler::Sptr result = Gameplay::MakeComponent<DebugKeyHandler>();
 	result->diffuseRamp = JsonGet(data, "ramp", result->diffuseRamp);
 	return result;
 }
\ No newline at end of file
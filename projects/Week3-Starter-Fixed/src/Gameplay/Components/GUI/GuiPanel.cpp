@@ -70,7 +70,7 @@ nlohmann::json GuiPanel::ToJson() const {
 }
 
 GuiPanel::Sptr GuiPanel::FromJson(const nlohmann::json& blob) {
-	GuiPanel::Sptr result = std::make_shared<GuiPanel>();
+	GuiPanel::Sptr result = Gameplay::MakeComponent<GuiPanel>();
 
 	result->_color        = JsonGet(blob, "color", result->_color);
 	result->_borderRadius = JsonGet(blob, "border", 0);
@@ -113,7 +113,7 @@ nlohmann::json GuiText::ToJson() const {
 }
 
 GuiText::Sptr GuiText::FromJson(const nlohmann::json& blob) {
-	GuiText::Sptr result = std::make_shared<GuiText>();
+	GuiText::Sptr result = Gameplay::MakeComponent<GuiText>();
 	result->_color     = JsonGet(blob, "color", result->_color);
 	result->_textScale = JsonGet(blob, "scale", 1.0f);
 	result->_text      = JsonGet<std::wstring>(blob, "text", LR"()");
@@ -28,10 +28,16 @@ namespace Gameplay {
 		IResource(),
 		IsEnabled(true),
 		_realType(typeid(IComponent)),
-		_context(nullptr)
+		_context(nullptr),
+		_typeId(INVALID_COMPONENT_TYPE),
+		_poolIndex(0),
+		_manager(nullptr),
+		_isParallelUpdate(false)
 	{ }
 
 	IComponent::~IComponent() {
-		_context->GetScene()->Components().Remove(this);
+		if (_manager != nullptr) {
+			_manager->Remove(this);
+		}
 	}
 }
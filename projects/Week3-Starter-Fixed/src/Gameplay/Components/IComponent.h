@@ -8,16 +8,29 @@
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/TypeHelpers.h"
+#include "Gameplay/Components/ComponentAllocator.h"
 
 namespace Gameplay {
 	// We pre-declare GameObject to avoid circular dependencies in the headers
 	class GameObject;
 
+	class ComponentManager;
+
 	namespace Physics {
 		class TriggerVolume;
 		class RigidBody;
 	}
 
+	/// <summary>
+	/// Dense integer ID assigned to each component type when it is registered
+	/// with the ComponentManager, used to index into per-type storage
+	/// </summary>
+	typedef uint32_t ComponentTypeId;
+	/// <summary>
+	/// Type ID for component types that have not been registered
+	/// </summary>
+	constexpr ComponentTypeId INVALID_COMPONENT_TYPE = static_cast<ComponentTypeId>(-1);
+
 	/// <summary>
 	/// Base class for components that can be attached to game objects
 	/// 
@@ -38,6 +51,18 @@ namespace Gameplay {
 		/// </summary>
 		bool IsEnabled;
 
+		/// <summary>
+		/// Component types can shadow this with true to opt into parallel updates. Components
+		/// that opt in promise that their Update only reads and modifies their own game object
+		/// and it's components, so that objects can be updated on multiple threads at once
+		/// 
+		/// During a parallel update, the world transform getters (GetTransform, GetInverseTransform)
+		/// return the object's world transform from the start of the update, and will not reflect
+		/// changes made to the object's position, rotation or scale until the update has finished.
+		/// Parallel components must not create or destroy objects, or change an object's parent
+		/// </summary>
+		static constexpr bool ParallelUpdate = false;
+
 		virtual ~IComponent();
 
 		/// <summary>
@@ -159,10 +184,19 @@ namespace Gameplay {
 	private:
 		friend class ComponentManager;
 		friend class GameObject;
+		friend class Scene;
 
 		std::type_index _realType;
 		GameObject* _context;
 
+		// The integer type ID and the slot within the component manager's pool for that type,
+		// these let us remove ourselves from the pool in constant time
+		ComponentTypeId   _typeId;
+		size_t            _poolIndex;
+		ComponentManager* _manager;
+		// Cached from the type's ParallelUpdate flag when the component is created
+		bool              _isParallelUpdate;
+
 		// By storing a weak pointer to ourselves, we can pass a pointer to this
 		// for things like bullet user pointers
 		std::weak_ptr<IComponent> _weakSelfPtr;
@@ -31,7 +31,7 @@ JumpBehaviour::JumpBehaviour() :
 JumpBehaviour::~JumpBehaviour() = default;
 
 JumpBehaviour::Sptr JumpBehaviour::FromJson(const nlohmann::json& blob) {
-	JumpBehaviour::Sptr result = std::make_shared<JumpBehaviour>();
+	JumpBehaviour::Sptr result = Gameplay::MakeComponent<JumpBehaviour>();
 	result->_impulse = blob["impulse"];
 	return result;
 }
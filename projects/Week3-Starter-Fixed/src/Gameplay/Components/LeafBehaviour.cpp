@@ -25,7 +25,7 @@ nlohmann::json LeafBehaviour::ToJson() const {
 }
 
 LeafBehaviour::Sptr LeafBehaviour::FromJson(const nlohmann::json& data) {
-	LeafBehaviour::Sptr result = std::make_shared<LeafBehaviour>();
+	LeafBehaviour::Sptr result = Gameplay::MakeComponent<LeafBehaviour>();
 	result->WindSpeed = JsonGet(data, "speed", result->WindSpeed);
 	return result;
 }
\ No newline at end of file
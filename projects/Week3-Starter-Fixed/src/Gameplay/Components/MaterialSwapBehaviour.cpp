@@ -38,7 +38,7 @@ nlohmann::json MaterialSwapBehaviour::ToJson() const {
 }
 
 MaterialSwapBehaviour::Sptr MaterialSwapBehaviour::FromJson(const nlohmann::json& blob) {
-	MaterialSwapBehaviour::Sptr result = std::make_shared<MaterialSwapBehaviour>();
+	MaterialSwapBehaviour::Sptr result = Gameplay::MakeComponent<MaterialSwapBehaviour>();
 	result->EnterMaterial = ResourceManager::Get<Gameplay::Material>(Guid(blob["enter_material"]));
 	result->ExitMaterial  = ResourceManager::Get<Gameplay::Material>(Guid(blob["exit_material"]));
 	return result;
@@ -11,7 +11,9 @@ ParticleSystem::ParticleSystem() :
 	_numParticles(0),
 	_particleBuffers(),
 	_feedbackBuffers(),
-	_query(0),
+	_queries(),
+	_queryPending(),
+	_queryIndex(0),
 	_currentVertexBuffer(0),
 	_currentFeedbackBuffer(1),
 	_updateShader(nullptr),
@@ -25,7 +27,7 @@ ParticleSystem::~ParticleSystem()
 	if (_hasInit) {
 		glDeleteBuffers(2, _particleBuffers);
 		glDeleteTransformFeedbacks(2, _feedbackBuffers);
-		glDeleteQueries(1, &_query);
+		glDeleteQueries(QUERY_COUNT, _queries);
 		_updateShader = nullptr;
 		_renderShader = nullptr;
 	}
@@ -61,8 +63,9 @@ void ParticleSystem::Update()
 		glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_DYNAMIC_DRAW);
 		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _particleBuffers[1]);
 
-		// We create a query object to track the number of particles we're simulating
-		glGenQueries(1, &_query);
+		// We create a few query objects to track the number of particles we're simulating, so
+		// we can read them back a few frames later without stalling
+		glGenQueries(QUERY_COUNT, _queries);
 
 		// We no longer need the CPU copy
 		delete[] data;
@@ -94,12 +97,17 @@ void ParticleSystem::Update()
 	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Lifetime)); // metadata 
 	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Metadata)); // metadata 
 
+	// Grab any particle counts that are ready, if the query we're about to re-use still isn't
+	// done we just drop it's result since we'll have a newer one soon
+	_ReadQueryResults();
+	_queryPending[_queryIndex] = false;
+
 	// Bind the update shader and send our relevant uniforms
 	_updateShader->Bind();
 	_updateShader->SetUniform("u_Gravity", _gravity);
 
 	// Our particles are points that we're simulating
-	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _query);
+	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _queries[_queryIndex]);
 	glBeginTransformFeedback(GL_POINTS);
 
 	// If this is our first pass, we use drawArrays to get the initial state, otherwise we use transform feedback for rendering
@@ -114,14 +122,9 @@ void ParticleSystem::Update()
 	glEndTransformFeedback();
 	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
 
-	// Use our query to get the number of particles
-	glGetQueryObjectuiv(_query, GL_QUERY_RESULT, &_numParticles);
-	if (_numParticles >= _emitters.size()) {
-		_numParticles -= _emitters.size();
-	}
-	else {
-		_numParticles = 0;
-	}
+	// The result will be read back in a later frame, by then the GPU should be done with it
+	_queryPending[_queryIndex] = true;
+	_queryIndex = (_queryIndex + 1) % QUERY_COUNT;
 
 	// Clean up our state
 	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
@@ -143,6 +146,30 @@ void ParticleSystem::Update()
 	_currentFeedbackBuffer = (_currentFeedbackBuffer + 1) & 0x01;
 }
 
+void ParticleSystem::_ReadQueryResults()
+{
+	// Check our queries from oldest to newest, the GPU finishes them in order so we can stop at
+	// the first one that isn't ready yet
+	for (uint32_t ix = 0; ix < QUERY_COUNT; ix++) {
+		uint32_t query = (_queryIndex + ix) % QUERY_COUNT;
+		if (!_queryPending[query]) {
+			continue;
+		}
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE) {
+			break;
+		}
+
+		// Emitters are written out as well, so we don't count them as particles
+		GLuint written = 0;
+		glGetQueryObjectuiv(_queries[query], GL_QUERY_RESULT, &written);
+		_numParticles = written >= _emitters.size() ? written - static_cast<GLuint>(_emitters.size()) : 0;
+		_queryPending[query] = false;
+	}
+}
+
 void ParticleSystem::Render()
 {
 	// Make sure that we've actually initialized our stuff
@@ -290,7 +317,7 @@ nlohmann::json ParticleSystem::ToJson() const {
 }
 
 ParticleSystem::Sptr ParticleSystem::FromJson(const nlohmann::json& blob) {
-	ParticleSystem::Sptr result = std::make_shared<ParticleSystem>();
+	ParticleSystem::Sptr result = Gameplay::MakeComponent<ParticleSystem>();
 
 	result->_gravity = JsonGet(blob, "gravity", result->_gravity);
 	result->_maxParticles = JsonGet(blob, "max_particled", result->_maxParticles);
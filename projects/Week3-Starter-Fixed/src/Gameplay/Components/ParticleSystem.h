@@ -39,14 +39,21 @@ protected:
 		glm::vec4    Metadata;
 	};
 
+	// The number of queries we cycle through for reading back particle counts, this is how many
+	// frames the GPU can get ahead of us before we have to drop a result
+	static const uint32_t QUERY_COUNT = 3;
+
 	bool _hasInit;
 
 	uint32_t _maxParticles;
+	// The most recent particle count we've read back, this will lag a frame or two behind the GPU
 	GLuint _numParticles;
 
 	uint32_t _particleBuffers[2];
 	uint32_t _feedbackBuffers[2];
-	uint32_t _query;
+	uint32_t _queries[QUERY_COUNT];
+	bool     _queryPending[QUERY_COUNT];
+	uint32_t _queryIndex;
 
 	uint32_t _currentVertexBuffer;
 	uint32_t _currentFeedbackBuffer;
@@ -56,4 +63,7 @@ protected:
 	glm::vec3           _gravity;
 
 	std::vector<ParticleData> _emitters;
+
+	// Reads back the results of any queries that the GPU has finished with, without waiting
+	void _ReadQueryResults();
 };
\ No newline at end of file
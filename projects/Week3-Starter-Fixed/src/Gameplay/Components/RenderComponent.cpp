@@ -44,7 +44,7 @@ nlohmann::json RenderComponent::ToJson() const {
 }
 
 RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
-	RenderComponent::Sptr result = std::make_shared<RenderComponent>();
+	RenderComponent::Sptr result = Gameplay::MakeComponent<RenderComponent>();
 	result->_mesh = ResourceManager::Get<Gameplay::MeshResource>(Guid(data["mesh"].get<std::string>()));
 	result->_material = ResourceManager::Get<Gameplay::Material>(Guid(data["material"].get<std::string>()));
 
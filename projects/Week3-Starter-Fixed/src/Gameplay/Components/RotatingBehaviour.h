@@ -11,6 +11,9 @@ public:
 	RotatingBehaviour() = default;
 	glm::vec3 RotationSpeed;
 
+	// Only modifies our own transform, so we can be updated in parallel
+	static constexpr bool ParallelUpdate = true;
+
 	virtual void Update(float deltaTime) override;
 
 	virtual void RenderImGui() override;
@@ -26,6 +26,6 @@ nlohmann::json TriggerVolumeEnterBehaviour::ToJson() const {
 }
 
 TriggerVolumeEnterBehaviour::Sptr TriggerVolumeEnterBehaviour::FromJson(const nlohmann::json& blob) {
-	TriggerVolumeEnterBehaviour::Sptr result = std::make_shared<TriggerVolumeEnterBehaviour>();
+	TriggerVolumeEnterBehaviour::Sptr result = Gameplay::MakeComponent<TriggerVolumeEnterBehaviour>();
 	return result;
 }
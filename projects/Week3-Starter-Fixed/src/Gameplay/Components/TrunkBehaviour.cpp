@@ -24,7 +24,7 @@ nlohmann::json TrunkBehaviour::ToJson() const {
 }
 
 TrunkBehaviour::Sptr TrunkBehaviour::FromJson(const nlohmann::json& data) {
-	TrunkBehaviour::Sptr result = std::make_shared<TrunkBehaviour>();
+	TrunkBehaviour::Sptr result = Gameplay::MakeComponent<TrunkBehaviour>();
 	result->WindSpeed = JsonGet(data, "speed", result->WindSpeed);
 	return result;
 }
\ No newline at end of file
@@ -15,6 +15,9 @@ public:
 	glm::vec3 startRotation;
 	glm::vec3 startPosition;
 
+	// Only modifies our own transform, so we can be updated in parallel
+	static constexpr bool ParallelUpdate = true;
+
 	virtual void Update(float deltaTime) override;
 
 	virtual void RenderImGui() override;
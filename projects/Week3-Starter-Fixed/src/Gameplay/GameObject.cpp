@@ -14,64 +14,23 @@
 #include "Gameplay/Scene.h"
 
 namespace Gameplay {
-	GameObject::GameObject() :
+	GameObject::GameObject(Scene* scene) :
 		IResource(),
 		Name("Unknown"),
 		HideInHierarchy(false),
 		_components(std::vector<IComponent::Sptr>()),
-		_scene(nullptr),
-		_position(ZERO),
-		_rotation(glm::quat(glm::vec3(0.0f))),
-		_scale(ONE),
-		_localTransform(MAT4_IDENTITY),
-		_inverseLocalTransform(MAT4_IDENTITY),
-		_isLocalTransformDirty(true),
-		_worldTransform(MAT4_IDENTITY),
-		_inverseWorldTransform(MAT4_IDENTITY),
-		_isWorldTransformDirty(true),
+		_componentSlots(std::vector<uint16_t>()),
+		_scene(scene),
+		_transforms(scene->_transforms),
+		_transform(TransformSystem::INVALID_HANDLE),
 		_parent(WeakRef()),
 		_children(std::vector<WeakRef>())
-	{ }
-
-	void GameObject::_RecalcLocalTransform() const
 	{
-		if (_isLocalTransformDirty) {
-			_localTransform = glm::translate(MAT4_IDENTITY, _position) * glm::mat4_cast(_rotation) * glm::scale(MAT4_IDENTITY, _scale);
-			_inverseLocalTransform = glm::inverse(_localTransform);
-			_isLocalTransformDirty = false;
-			_isWorldTransformDirty = true;
-
-			// Dirty all the child objects world transforms
-			for (const auto& childPtr : _children) {
-				GameObject::Sptr childSptr = childPtr;
-				if (childSptr != nullptr) {
-					childSptr->_isWorldTransformDirty = true;
-				}
-			}
-		}
+		_transform = _transforms->Create();
 	}
 
-	void GameObject::_RecalcWorldTransform() const {
-		// Start by determining our local transform if required
-		_RecalcLocalTransform();
-
-		// If our world transform has been marked as dirty, we need to recalculate it!
-		if (_isWorldTransformDirty) {
-			GameObject::Sptr parent = _parent;
-
-			// If out parent exists, we apply our local transformation relative to the parent's world transformation
-			if (parent != nullptr) {
-				_worldTransform = parent->GetTransform() * _localTransform;
-				_inverseWorldTransform = glm::inverse(_worldTransform);
-			}
-
-			// If our parent is null, we can simply use the local transform as the world transform
-			else {
-				_worldTransform = _localTransform;
-				_inverseWorldTransform = _inverseLocalTransform;
-			}
-			_isWorldTransformDirty = false;
-		}
+	GameObject::~GameObject() {
+		_transforms->Destroy(_transform);
 	}
 
 	void GameObject::_PurgeDeletedChildren() {
@@ -81,8 +40,31 @@ namespace Gameplay {
 		_children.erase(it, _children.end());
 	}
 
+	void GameObject::_AttachComponent(const IComponent::Sptr& component) {
+		LOG_ASSERT(component->_typeId != INVALID_COMPONENT_TYPE, "You must register component types before creating them!");
+
+		LOG_ASSERT(_components.size() < UINT16_MAX, "Too many components on one game object!");
+
+		if (component->_typeId >= _componentSlots.size()) {
+			_componentSlots.resize(component->_typeId + 1, 0);
+		}
+		_components.push_back(component);
+		_componentSlots[component->_typeId] = static_cast<uint16_t>(_components.size());
+	}
+
+	void GameObject::_RemoveComponentAt(size_t index) {
+		IComponent::Sptr component = _components[index];
+		_componentSlots[component->_typeId] = 0;
+		_components.erase(_components.begin() + index);
+
+		// Everything after the removed component has shifted down by one
+		for (size_t ix = index; ix < _components.size(); ix++) {
+			_componentSlots[_components[ix]->_typeId] = static_cast<uint16_t>(ix + 1);
+		}
+	}
+
 	void GameObject::LookAt(const glm::vec3& point) {
-		glm::mat4 rot = glm::lookAt(_position, point, glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 rot = glm::lookAt(GetPosition(), point, glm::vec3(0.0f, 0.0f, 1.0f));
 		// Take the conjugate of the quaternion, as lookAt returns the *inverse* rotation
 		SetRotation(glm::conjugate(glm::quat_cast(rot)));
 	}
@@ -112,60 +94,56 @@ namespace Gameplay {
 	}
 
 	void GameObject::SetPostion(const glm::vec3& position) {
-		_position = position;
-		_isLocalTransformDirty = true;
+		_transforms->SetPosition(_transform, position);
 	}
 
-	const glm::vec3& GameObject::GetPosition() const {
-		return _position;
+	glm::vec3 GameObject::GetPosition() const {
+		return _transforms->GetPosition(_transform);
 	}
 
 	void GameObject::SetRotation(const glm::quat& value) {
-		_rotation = value;
-		_isLocalTransformDirty = true;
+		_transforms->SetRotation(_transform, value);
 	}
 
-	const glm::quat& GameObject::GetRotation() const {
-		return _rotation;
+	glm::quat GameObject::GetRotation() const {
+		return _transforms->GetRotation(_transform);
 	}
 
 	void GameObject::SetRotation(const glm::vec3& eulerAngles) {
-		_rotation = glm::quat(glm::radians(eulerAngles));
-		_isLocalTransformDirty = true;
+		_transforms->SetRotation(_transform, glm::quat(glm::radians(eulerAngles)));
 	}
 
 	glm::vec3 GameObject::GetRotationEuler() const {
-		return glm::degrees(glm::eulerAngles(_rotation));
+		return glm::degrees(glm::eulerAngles(GetRotation()));
 	}
 
 	void GameObject::SetScale(const glm::vec3& value) {
-		_scale = value;
-		_isLocalTransformDirty = true;
+		_transforms->SetScale(_transform, value);
+	}
+
+	glm::vec3 GameObject::GetScale() const {
+		return _transforms->GetScale(_transform);
 	}
 
-	const glm::vec3& GameObject::GetScale() const {
-		return _scale;
+	uint32_t GameObject::GetTransformVersion() const {
+		return _transforms->GetLocalVersion(_transform);
 	}
 
-	const glm::mat4& GameObject::GetTransform() const {
-		_RecalcWorldTransform();
-		return _worldTransform;
+	glm::mat4 GameObject::GetTransform() const {
+		return _transforms->GetWorldTransform(_transform);
 	}
 
-	const glm::mat4& GameObject::GetInverseTransform() const {
-		_RecalcWorldTransform();
-		return _inverseWorldTransform;
+	glm::mat4 GameObject::GetInverseTransform() const {
+		return _transforms->GetInverseWorldTransform(_transform);
 	}
 
-	const glm::mat4& GameObject::GetLocalTransform() const
+	glm::mat4 GameObject::GetLocalTransform() const
 	{
-		_RecalcLocalTransform();
-		return _localTransform;
+		return _transforms->GetLocalTransform(_transform);
 	}
 
-	const glm::mat4& GameObject::GetInverseLocalTransform() const {
-		_RecalcLocalTransform();
-		return _inverseLocalTransform;
+	glm::mat4 GameObject::GetInverseLocalTransform() const {
+		return _transforms->GetInverseLocalTransform(_transform);
 	}
 
 	void GameObject::RenderGUI() {
@@ -212,32 +190,31 @@ namespace Gameplay {
 			}
 		}
 
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
 		_PurgeDeletedChildren();
 	}
 
-	bool GameObject::Has(const std::type_index& type) {
-		// Iterate over all the pointers in the components list
-		for (const auto& ptr : _components) {
-			// If the pointer type matches T, we return true
-			if (std::type_index(typeid(*ptr.get())) == type) {
-				return true;
+	void GameObject::_UpdateComponents(float dt, bool parallel) {
+		for (auto& component : _components) {
+			if (component->IsEnabled && component->_isParallelUpdate == parallel) {
+				component->Update(dt);
 			}
 		}
-		return false;
+	}
+
+	void GameObject::_FinishUpdate() {
+		_PurgeDeletedChildren();
+	}
+
+	bool GameObject::Has(const std::type_index& type) {
+		// Translate the type into it's registered ID and check the slots
+		return _FindComponent(ComponentManager::TypeId(type)) != nullptr;
 	}
 
 	std::shared_ptr<IComponent> GameObject::Get(const std::type_index& type)
 	{
-		// Iterate over all the pointers in the binding list
-		for (const auto& ptr : _components) {
-			// If the pointer type matches T, we return that behaviour, making sure to cast it back to the requested type
-			if (std::type_index(typeid(*ptr.get())) == type) {
-				return ptr;
-			}
-		}
-		return nullptr;
+		// Translate the type into it's registered ID and return whatever is in the slot
+		const IComponent::Sptr* component = _FindComponent(ComponentManager::TypeId(type));
+		return component != nullptr ? *component : nullptr;
 	}
 
 	std::shared_ptr<IComponent> GameObject::Add(const std::type_index& type)
@@ -250,7 +227,7 @@ namespace Gameplay {
 		component->_context = this;
 
 		// Append it to the binding component's storage, and invoke the OnLoad
-		_components.push_back(component);
+		_AttachComponent(component);
 		component->OnLoad();
 
 		if (_scene->GetIsAwake()) {
@@ -275,7 +252,7 @@ namespace Gameplay {
 			// applies to the child
 			_children.push_back(child);
 			child->_parent = _selfRef.lock();
-			child->_isWorldTransformDirty = true;
+			_transforms->SetParent(child->_transform, _transform);
 		} else {
 			LOG_WARN("Attempting to add same child twice, ignoring: {}", child->Name);
 		}
@@ -288,6 +265,7 @@ namespace Gameplay {
 		if (it != _children.end()) { 
 			// Clear the object's parent and remove from our list of children
 			child->_parent.Reset();
+			_transforms->SetParent(child->_transform, TransformSystem::INVALID_HANDLE);
 			_children.erase(it);
 			return true;
 		} else {
@@ -350,16 +328,19 @@ namespace Gameplay {
 			}
 
 			// Render position label
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f);
+			glm::vec3 position = GetPosition();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Position", &position.x, 0.01f)) {
+				SetPostion(position);
+			}
 			
 			// Get the ImGui storage state so we can avoid gimbal locking issues by storing euler angles in the editor
 			glm::vec3 euler = GetRotationEuler();
 			ImGuiStorage* guiStore = ImGui::GetStateStorage();
 
-			// Extract the angles from the storage, note that we're only using the address of the position for unique IDs
-			euler.x = guiStore->GetFloat(ImGui::GetID(&_position.x), euler.x);
-			euler.y = guiStore->GetFloat(ImGui::GetID(&_position.y), euler.y);
-			euler.z = guiStore->GetFloat(ImGui::GetID(&_position.z), euler.z);
+			// Extract the angles from the storage, our ID scope is unique to this object so we can use fixed names
+			euler.x = guiStore->GetFloat(ImGui::GetID("##euler_x"), euler.x);
+			euler.y = guiStore->GetFloat(ImGui::GetID("##euler_y"), euler.y);
+			euler.z = guiStore->GetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 			//Draw the slider for angles
 			if (LABEL_LEFT(ImGui::DragFloat3, "Rotation", &euler.x, 1.0f)) {
@@ -367,16 +348,19 @@ namespace Gameplay {
 				euler = Wrap(euler, -180.0f, 180.0f);
 
 				// Update the editor state with our new values
-				guiStore->SetFloat(ImGui::GetID(&_position.x), euler.x);
-				guiStore->SetFloat(ImGui::GetID(&_position.y), euler.y);
-				guiStore->SetFloat(ImGui::GetID(&_position.z), euler.z);
+				guiStore->SetFloat(ImGui::GetID("##euler_x"), euler.x);
+				guiStore->SetFloat(ImGui::GetID("##euler_y"), euler.y);
+				guiStore->SetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 				//Send new rotation to the gameobject
 				SetRotation(euler);
 			}
 			
 			// Draw the scale
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f);
+			glm::vec3 scale = GetScale();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &scale.x, 0.01f, 0.0f)) {
+				SetScale(scale);
+			}
 
 			ImGui::Separator();
 			ImGui::TextUnformatted("Components");
@@ -390,7 +374,7 @@ namespace Gameplay {
 					component->RenderImGui();
 					// Render a delete button for the component
 					if (ImGuiHelper::WarningButton("Delete")) {
-						_components.erase(_components.begin() + ix);
+						_RemoveComponentAt(ix);
 						ix--;
 					}
 					ImGui::PopID();
@@ -434,10 +418,6 @@ namespace Gameplay {
 			ImGui::Unindent();
 		}
 		ImGui::PopID(); // Pop the ImGui ID scope for the object
-
-		// For if we're not in play mode
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
 	}
 
 	std::shared_ptr<GameObject> GameObject::SelfRef() {
@@ -448,46 +428,52 @@ namespace Gameplay {
 	{
 		// We need to manually construct since the GameObject constructor is
 		// protected. We can call it here since Scene is a friend class of GameObjects
-		GameObject::Sptr result(new GameObject());
-		result->_scene = scene;
+		GameObject::Sptr result(new GameObject(scene));
 
 		// Load in basic info
 		result->Name = data["name"];
 		result->_guid = Guid(data["guid"]);
 		result->_parent = WeakRef(Guid(data.contains("parent") ? data["parent"] : "null"), nullptr);
-		result->_position = (data["position"]);
-		result->_rotation = (data["rotation"]);
-		result->_scale    = (data["scale"]);
+		result->SetPostion(data["position"]);
+		result->SetRotation((glm::quat)(data["rotation"]));
+		result->SetScale(data["scale"]);
 		result->HideInHierarchy = JsonGet(data, "hide_in_inspector", false);
-		result->_isLocalTransformDirty = true;
-		result->_isWorldTransformDirty = true;
 
 		// Since our components are stored based on the type name, we iterate
 		// on the keys and values from the components object
 		nlohmann::json components = data["components"];
 		for (auto& [typeName, value] : components.items()) {
-			// We need to reference the component registry to load our components
-			// based on the type name (note that all component types need to be
-			// registered at the start of the application)
-			IComponent::Sptr component = scene->Components().Load(typeName, value);
-			component->_context = result.get();
-
-			// Add component to object and allow it to perform self initialization
-			result->_components.push_back(component);
-			component->OnLoad();
+			result->_LoadComponent(typeName, value);
 		}
 
 		return result;
 	}
 
+	IComponent::Sptr GameObject::_LoadComponent(const std::string& typeName, const nlohmann::json& blob) {
+		// We need to reference the component registry to load our components
+		// based on the type name (note that all component types need to be
+		// registered at the start of the application)
+		IComponent::Sptr component = _scene->Components().Load(typeName, blob);
+		if (component == nullptr) {
+			LOG_WARN("Component type \"{}\" has not been registered, skipping", typeName);
+			return nullptr;
+		}
+		component->_context = this;
+
+		// Add component to object and allow it to perform self initialization
+		_AttachComponent(component);
+		component->OnLoad();
+		return component;
+	}
+
 	nlohmann::json GameObject::ToJson() const {
 		GameObject::Sptr parent = _parent;
 		nlohmann::json result = {
 			{ "name", Name },
 			{ "guid", _guid.str() },
-			{ "position", _position },
-			{ "rotation", _rotation },
-			{ "scale",    _scale },
+			{ "position", GetPosition() },
+			{ "rotation", GetRotation() },
+			{ "scale",    GetScale() },
 			{ "parent",   parent == nullptr ? "null" : parent->_guid.str() },
 			{ "hide_in_inspector", HideInHierarchy }
 		};
@@ -11,6 +11,7 @@
 // Others
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/ComponentManager.h"
+#include "Gameplay/TransformSystem.h"
 #include "Utils/ResourceManager/IResource.h"
 
 class InspectorWindow;
@@ -34,6 +35,8 @@ namespace Gameplay {
 		typedef std::shared_ptr<GameObject> Sptr;
 		typedef std::weak_ptr<GameObject> Wptr;
 
+		virtual ~GameObject();
+
 		/// <summary>
 		/// Structure to assist in wrapping weak references to GameObjects
 		/// Can track the object's GUID before and after creation
@@ -178,7 +181,7 @@ namespace Gameplay {
 		/// <summary>
 		/// Gets the object's position in world space
 		/// </summary>
-		const glm::vec3& GetPosition() const;
+		glm::vec3 GetPosition() const;
 
 		/// <summary>
 		/// Sets the rotation of this object to a quaternion value
@@ -188,7 +191,7 @@ namespace Gameplay {
 		/// <summary>
 		/// Gets the object's rotation as a quaternion value
 		/// </summary>
-		const glm::quat& GetRotation() const;
+		glm::quat GetRotation() const;
 
 		/// <summary>
 		/// Sets the rotation of the object in euler degrees (yaw, pitch, roll)
@@ -208,21 +211,27 @@ namespace Gameplay {
 		/// <summary>
 		/// Gets the scaling factor for the game object
 		/// </summary>
-		const glm::vec3& GetScale() const;
+		glm::vec3 GetScale() const;
+
+		/// <summary>
+		/// Gets a counter that changes every time the object's position, rotation or scale is set.
+		/// Store this and compare against it later to cheaply tell if the object has been moved
+		/// </summary>
+		uint32_t GetTransformVersion() const;
 
 		/// <summary>
 		/// Gets or recalculates and gets the object's world transform
 		/// This matrix transforms points from local space to world space
 		/// </summary>
-		const glm::mat4& GetTransform() const;
+		glm::mat4 GetTransform() const;
 		/// <summary>
 		/// Gets or recalculates the inverse of this object's world transform
 		/// This matrix transforms points from world space to local space
 		/// </summary>
-		const glm::mat4& GetInverseTransform() const;
+		glm::mat4 GetInverseTransform() const;
 
-		const glm::mat4& GetLocalTransform() const;
-		const glm::mat4& GetInverseLocalTransform() const;
+		glm::mat4 GetLocalTransform() const;
+		glm::mat4 GetInverseLocalTransform() const;
 
 		/// <summary>
 		/// Allows components to render GUI elements to the screen
@@ -251,14 +260,8 @@ namespace Gameplay {
 		/// <typeparam name="T">The type of component to search for</typeparam>
 		template <typename T, typename = typename std::enable_if<std::is_base_of<IComponent, T>::value>::type>
 		bool Has() {
-			// Iterate over all the pointers in the components list
-			for (const auto& ptr : _components) {
-				// If the pointer type matches T, we return true
-				if (std::type_index(typeid(*ptr.get())) == std::type_index(typeid(T))) {
-					return true;
-				}
-			}
-			return false;
+			// Components are slotted by their registered type ID, so this is a single array lookup
+			return _FindComponent(ComponentManager::TypeId<T>()) != nullptr;
 		}
 
 		bool Has(const std::type_index& type);
@@ -269,14 +272,9 @@ namespace Gameplay {
 		/// <typeparam name="T">The type of component to search for</typeparam>
 		template <typename T, typename = typename std::enable_if<std::is_base_of<IComponent, T>::value>::type>
 		std::shared_ptr<T> Get() {
-			// Iterate over all the pointers in the binding list
-			for (const auto& ptr : _components) {
-				// If the pointer type matches T, we return that behaviour, making sure to cast it back to the requested type
-				if (std::type_index(typeid(*ptr.get())) == std::type_index(typeid(T))) {
-					return std::dynamic_pointer_cast<T>(ptr);
-				}
-			}
-			return nullptr;
+			// Look up the slot for the type, anything stored there is guaranteed to be a T, so no RTTI is needed
+			const IComponent::Sptr* component = _FindComponent(ComponentManager::TypeId<T>());
+			return component != nullptr ? std::static_pointer_cast<T>(*component) : nullptr;
 		}
 
 		std::shared_ptr<IComponent> Get(const std::type_index& type);
@@ -298,7 +296,7 @@ namespace Gameplay {
 			component->_context = this;
 
 			// Append it to the binding component's storage, and invoke the OnLoad
-			_components.push_back(component);
+			_AttachComponent(component);
 			component->OnLoad();
 
 			if (_scene->GetIsAwake()) {
@@ -337,21 +335,10 @@ namespace Gameplay {
 		friend class InspectorWindow;
 		friend class HierarchyWindow;
 
-		// Rotation of the object as a quaternion
-		glm::quat _rotation;
-		// Position of the object
-		glm::vec3 _position;
-		// The scale of the object
-		glm::vec3 _scale;
-
-		// The object's world transform
-		mutable glm::mat4 _localTransform;
-		mutable glm::mat4 _inverseLocalTransform;
-		mutable bool _isLocalTransformDirty;
-
-		mutable glm::mat4 _worldTransform;
-		mutable glm::mat4 _inverseWorldTransform;
-		mutable bool _isWorldTransformDirty;
+		// Our position, rotation, scale and matrices are stored in the scene's transform
+		// system, we keep a reference to the system in case we outlive the scene
+		TransformSystem::Sptr   _transforms;
+		TransformSystem::Handle _transform;
 
 		// For the hierarchy
 		WeakRef _parent;
@@ -359,6 +346,10 @@ namespace Gameplay {
 
 		// The components that this game object has attached to it
 		std::vector<IComponent::Sptr> _components;
+		// Indexed by registered type ID, stores the index of the component of that type in _components
+		// plus one, or 0 if we don't have one. This only grows to the highest type ID we've had attached,
+		// so it's a couple bytes per registered type at most
+		std::vector<uint16_t> _componentSlots;
 		std::weak_ptr<GameObject> _selfRef;
 
 		// Pointer to the scene, we use raw pointers since 
@@ -369,13 +360,54 @@ namespace Gameplay {
 		/// <summary>
 		/// Only scenes will be allowed to create gameobjects
 		/// </summary>
-		GameObject();
-
-		// Recalculates the transform matrix for the object when required
-		void _RecalcLocalTransform() const;
-		void _RecalcWorldTransform() const;
+		/// <param name="scene">The scene that the object belongs to</param>
+		GameObject(Scene* scene);
 
 		void _PurgeDeletedChildren();
+
+		/// <summary>
+		/// Gets the component with the given registered type ID, or nullptr if this object does not have one
+		/// </summary>
+		inline const IComponent::Sptr* _FindComponent(ComponentTypeId typeId) const {
+			// Unregistered types have an ID of INVALID_COMPONENT_TYPE, which is always out of range
+			if (typeId >= _componentSlots.size() || _componentSlots[typeId] == 0) {
+				return nullptr;
+			}
+			return &_components[_componentSlots[typeId] - 1];
+		}
+
+		/// <summary>
+		/// Invokes update on either the parallel or the serial components of this object,
+		/// used by the scene to split updates across the job system
+		/// </summary>
+		/// <param name="dt">The time since the last frame, in seconds</param>
+		/// <param name="parallel">True to update components that opted into ParallelUpdate, false for all others</param>
+		void _UpdateComponents(float dt, bool parallel);
+		/// <summary>
+		/// Handles the end of the update, cleaning up children
+		/// </summary>
+		void _FinishUpdate();
+
+		/// <summary>
+		/// Appends a component to this object's component list and stores it in
+		/// the slot for it's type
+		/// </summary>
+		/// <param name="component">The component to attach, should already have it's type ID assigned</param>
+		void _AttachComponent(const IComponent::Sptr& component);
+		/// <summary>
+		/// Removes the component at the given index in the component list, and clears
+		/// it's type slot
+		/// </summary>
+		/// <param name="index">The index of the component in _components</param>
+		void _RemoveComponentAt(size_t index);
+		/// <summary>
+		/// Loads a component from a JSON blob using the scene's component registry, attaches it
+		/// to this object and lets it perform self initialization
+		/// </summary>
+		/// <param name="typeName">The registered type name of the component</param>
+		/// <param name="blob">The component's JSON data</param>
+		/// <returns>The new component, or nullptr if the type has not been registered</returns>
+		IComponent::Sptr _LoadComponent(const std::string& typeName, const nlohmann::json& blob);
 	};
 
 }
\ No newline at end of file
@@ -42,5 +42,13 @@ namespace Gameplay {
 			};
 		}
 
+		/// <summary>
+		/// Reads or writes this light with a cereal archive, used by binary scene files
+		/// </summary>
+		template <class Archive>
+		void serialize(Archive& archive) {
+			archive(Position, Color, Range);
+		}
+
 	};
 }
@@ -11,16 +11,24 @@
 namespace Gameplay {
 	Material::Material(const ShaderProgram::Sptr& shader) :
 		IResource(),
+		IsTransparent(false),
 		_shader(shader),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_instancedShader(nullptr),
+		_instancedLocations(std::unordered_map<std::string, int>()),
+		_uniforms(std::unordered_map<std::string, UniformData>()),
+		_sortId(_nextSortId++)
 	{
 		_PopulateUniforms();
 	}
 
 	Material::Material() :
 		IResource(),
+		IsTransparent(false),
 		_shader(nullptr),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_instancedShader(nullptr),
+		_instancedLocations(std::unordered_map<std::string, int>()),
+		_uniforms(std::unordered_map<std::string, UniformData>()),
+		_sortId(_nextSortId++)
 	{ }
 
 	void Material::Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize)
@@ -60,40 +68,70 @@ namespace Gameplay {
 		return _shader;
 	}
 
+	void Material::SetInstancedShader(const ShaderProgram::Sptr& shader) {
+		_instancedShader = shader;
+		_instancedLocations.clear();
+	}
+
+	const ShaderProgram::Sptr& Material::GetInstancedShader() const {
+		return _instancedShader;
+	}
+
 	void Material::Apply() {
 		if (_shader != nullptr) {
-			// Skip the reserved # of texture slots
-			int textureSlot = 0;
-			
-			// Iterate over the uniforms map
-			for (auto&[name, data] : _uniforms) {
-				// The typecode is basically the underlying type of the uniform
-				// ex: float, matrix, texture, etc...
-				ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
-
-				// If the uniform is a texture, we try and bind it, then move to the next slot
-				if (typeCode == ShaderDataTypecode::Texture) {
-					if (textureSlot >= MAX_TEXTURE_SLOTS) {
-						LOG_WARN("Ignoring material binding, exceeds allowed number of textures");
+			_ApplyUniforms(_shader.get(), false);
+		}
+	}
+
+	void Material::ApplyInstanced() {
+		if (_instancedShader != nullptr) {
+			_ApplyUniforms(_instancedShader.get(), true);
+		}
+	}
+
+	void Material::_ApplyUniforms(ShaderProgram* shader, bool instanced) {
+		// Skip the reserved # of texture slots
+		int textureSlot = 0;
+
+		// Iterate over the uniforms map
+		for (auto&[name, data] : _uniforms) {
+			// The instanced shader is a separate program, so we need to look up where the uniform lives in it
+			int location = data.Location;
+			if (instanced) {
+				auto it = _instancedLocations.find(name);
+				if (it == _instancedLocations.end()) {
+					ShaderProgram::UniformInfo info;
+					it = _instancedLocations.emplace(name, shader->FindUniform(name, &info) ? info.Location : -1).first;
+				}
+				location = it->second;
+			}
+
+			// The typecode is basically the underlying type of the uniform
+			// ex: float, matrix, texture, etc...
+			ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
+
+			// If the uniform is a texture, we try and bind it, then move to the next slot
+			if (typeCode == ShaderDataTypecode::Texture) {
+				if (textureSlot >= MAX_TEXTURE_SLOTS) {
+					LOG_WARN("Ignoring material binding, exceeds allowed number of textures");
+				}
+				else {
+					ITexture::Sptr texture = data.TextureAsset;
+					if (texture != nullptr) {
+						texture->Bind(textureSlot);
 					}
 					else {
-						ITexture::Sptr texture = data.TextureAsset;
-						if (texture != nullptr) {
-							texture->Bind(textureSlot);
-						}
-						else {
-							ITexture::Unbind(textureSlot);
-						}
-						// Send the slot to the shader
-						_shader->SetUniform(data.Location, data.Type, &textureSlot);
-						textureSlot++;
+						ITexture::Unbind(textureSlot);
 					}
-				}
-				// The uniform is a plain ol' value type, send it in
-				else {
-					_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+					// Send the slot to the shader
+					shader->SetUniform(location, data.Type, &textureSlot);
+					textureSlot++;
 				}
 			}
+			// The uniform is a plain ol' value type, send it in
+			else {
+				shader->SetUniform(location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+			}
 		}
 	}
 
@@ -106,6 +144,8 @@ namespace Gameplay {
 
 		if (open) {
 			ImGui::Text("Shader: %s", _shader != nullptr ? _shader->GetDebugName().c_str() : "null");
+			ImGui::Text("Instanced Shader: %s", _instancedShader != nullptr ? _instancedShader->GetDebugName().c_str() : "none");
+			ImGui::Checkbox("Transparent", &IsTransparent);
 			// Draw all of our valid uniforms
 			for (auto&[key, value] : _uniforms) {
 				if (value.Location != -2 && value.Location != -1) {
@@ -132,6 +172,11 @@ namespace Gameplay {
 		result->OverrideGUID(Guid(data["guid"]));
 		result->Name = data["name"].get<std::string>();
 		result->_shader = ResourceManager::Get<ShaderProgram>(Guid(data["shader"]));
+		result->IsTransparent = JsonGet(data, "transparent", false);
+		std::string instancedShader = JsonGet<std::string>(data, "instanced_shader", "null");
+		if (instancedShader != "null") {
+			result->_instancedShader = ResourceManager::Get<ShaderProgram>(Guid(instancedShader));
+		}
 		result->_PopulateUniforms();
 
 		// material specific parameters'
@@ -153,6 +198,8 @@ namespace Gameplay {
 			{ "guid", GetGUID().str() },
 			{ "name", Name },
 			{ "shader", _shader ? _shader->GetGUID().str() : "null" },
+			{ "transparent", IsTransparent },
+			{ "instanced_shader", _instancedShader ? _instancedShader->GetGUID().str() : "null" },
 			{ "parameters", nlohmann::json() }
 		};
 
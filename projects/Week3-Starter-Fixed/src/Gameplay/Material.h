@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <atomic>
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/ITexture.h"
 
@@ -24,6 +25,12 @@ namespace Gameplay {
 		/// </summary>
 		std::string     Name;
 
+		/// <summary>
+		/// Transparent materials are drawn after all opaque objects, sorted back to front
+		/// and with alpha blending enabled
+		/// </summary>
+		bool            IsTransparent;
+
 		/// <summary>
 		/// Default constructor, to be used by Resource manager and smart pointers only
 		/// </summary>
@@ -60,11 +67,35 @@ namespace Gameplay {
 		/// </summary>
 		const ShaderProgram::Sptr& GetShader() const;
 
+		/// <summary>
+		/// Sets an optional variant of this material's shader that reads it's matrices from the
+		/// renderer's instance buffer (see basic_instanced_ssbo.glsl). Materials with an
+		/// instanced shader can be batched into instanced draws by the renderer
+		/// </summary>
+		/// <param name="shader">The instanced shader, or nullptr to disable instancing</param>
+		void SetInstancedShader(const ShaderProgram::Sptr& shader);
+		/// <summary>
+		/// Gets the instanced variant of this material's shader, or nullptr if the material
+		/// does not support instancing
+		/// </summary>
+		const ShaderProgram::Sptr& GetInstancedShader() const;
+
+		/// <summary>
+		/// Gets a small unique integer for this material, used by the renderer to group
+		/// draw calls that share a material
+		/// </summary>
+		uint32_t GetSortId() const { return _sortId; }
+
 		/// <summary>
 		/// Handles applying this material's state to the OpenGL pipeline
 		/// Will bind the shader, update material uniforms, and bind textures
 		/// </summary>
 		virtual void Apply();
+		/// <summary>
+		/// Handles applying this material's state to the instanced variant of the shader,
+		/// the instanced shader should already be bound
+		/// </summary>
+		virtual void ApplyInstanced();
 
 		/// <summary>
 		/// Renders some UI controls for manipulating a material at runtime
@@ -171,11 +202,27 @@ namespace Gameplay {
 		/// </summary>
 		ShaderProgram::Sptr    _shader;
 		/// <summary>
+		/// The optional instanced variant of the shader, see SetInstancedShader
+		/// </summary>
+		ShaderProgram::Sptr    _instancedShader;
+		/// <summary>
+		/// Caches the locations of our uniforms within the instanced shader, since they
+		/// may not match the locations in the main shader
+		/// </summary>
+		std::unordered_map<std::string, int> _instancedLocations;
+		/// <summary>
 		/// The uniforms that the material will be modifying
 		/// </summary>
 		std::unordered_map<std::string, UniformData> _uniforms;
+		/// <summary>
+		/// Unique ID for the material, see GetSortId
+		/// </summary>
+		uint32_t _sortId;
+
+		inline static std::atomic<uint32_t> _nextSortId{ 0 };
 
 		UniformData& _GetUniform(const std::string& name);
+		void _ApplyUniforms(ShaderProgram* shader, bool instanced);
 		void _PopulateUniforms();
 	};
 }
\ No newline at end of file
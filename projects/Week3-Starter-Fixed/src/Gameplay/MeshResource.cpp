@@ -2,6 +2,9 @@
 #include <filesystem>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Utils/VirtualFileSystem.h"
 
 namespace Gameplay {
 	MeshResource::MeshResource() :
@@ -9,7 +12,8 @@ namespace Gameplay {
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		BulletTriMesh(nullptr),
+		ConvexHull(nullptr)
 	{ }
 
 	MeshResource::MeshResource(const std::string& filename) :
@@ -17,9 +21,11 @@ namespace Gameplay {
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		BulletTriMesh(nullptr),
+		ConvexHull(nullptr)
 	{
 		Mesh = ObjLoader::LoadFromFile(filename);
+		_MarkStatic();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -54,7 +60,7 @@ namespace Gameplay {
 			result->Mesh = mesh.Bake();
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
-			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
+			if (result->Filename != "null" && VirtualFileSystem::Exists(result->Filename)) {
 				#ifdef OPTIMIZED_OBJ_LOADER
 				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
 				#else
@@ -63,9 +69,53 @@ namespace Gameplay {
 
 			}
 		}
+		result->_MarkStatic();
 		return result;
 	}
 
+	MeshResource::Sptr MeshResource::LoadAsync(const std::string& filename) {
+		// Start off with an empty mesh, so that anything using the resource still has something to draw
+		MeshResource::Sptr result = std::make_shared<MeshResource>();
+		result->Filename = filename;
+		result->Mesh = _GetPlaceholderMesh();
+
+		// Read the file on a worker, we only need the main thread to create the buffers
+		ResourceManager::QueueLoad([result, filename]() -> ResourceManager::UploadCallback {
+			#ifdef OPTIMIZED_OBJ_LOADER
+			std::shared_ptr<OptimizedObjLoader::MeshData> data = OptimizedObjLoader::LoadMeshData(filename);
+			if (data == nullptr) {
+				return nullptr;
+			}
+			return [result, data]() {
+				result->Mesh = OptimizedObjLoader::CreateVao(*data);
+				result->_MarkStatic();
+			};
+			#else
+			std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>> mesh = std::make_shared<MeshBuilder<VertexPosNormTexColTangents>>();
+			ObjLoader::LoadMeshBuilder(filename, *mesh);
+			return [result, mesh]() {
+				result->Mesh = mesh->Bake();
+				result->_MarkStatic();
+			};
+			#endif
+		});
+
+		return result;
+	}
+
+	MeshResource::Sptr MeshResource::FromJsonAsync(const nlohmann::json& blob) {
+		// Generated meshes are quick to build, so only meshes from files are worth loading in the background
+		if (blob.contains("params") && blob["params"].is_array()) {
+			return FromJson(blob);
+		}
+
+		std::string filename = JsonGet<std::string>(blob, "filename", "null");
+		if (filename != "null" && VirtualFileSystem::Exists(filename)) {
+			return LoadAsync(filename);
+		}
+		return FromJson(blob);
+	}
+
 	void MeshResource::GenerateMesh() {
 		MeshBuilder<VertexPosNormTexColTangents> mesh;
 		for (auto& param : MeshBuilderParams) {
@@ -73,9 +123,35 @@ namespace Gameplay {
 		}
 		MeshFactory::CalculateTBN(mesh);
 		Mesh = mesh.Bake();
+		_MarkStatic();
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
+
+	VertexArrayObject::Sptr MeshResource::_GetPlaceholderMesh() {
+		// A single triangle with all it's corners at the origin, which draws nothing. It's never marked as static,
+		// so the renderer won't try to pack it into a geometry store. We only hold a weak pointer, so that it's
+		// freed once the last load finishes rather than outliving the GL context
+		static std::weak_ptr<VertexArrayObject> shared;
+		VertexArrayObject::Sptr placeholder = shared.lock();
+		if (placeholder == nullptr) {
+			MeshBuilder<VertexPosNormTexColTangents> mesh;
+			for (int ix = 0; ix < 3; ix++) {
+				mesh.AddIndex(mesh.AddVertex(VertexPosNormTexColTangents()));
+			}
+			placeholder = mesh.Bake();
+			shared = placeholder;
+		}
+		return placeholder;
+	}
+
+	void MeshResource::_MarkStatic() {
+		// Nothing modifies the buffers of resource meshes after they're loaded, so the renderer
+		// is free to pack them into shared geometry stores
+		if (Mesh != nullptr) {
+			Mesh->SetStatic(true);
+		}
+	}
 }
\ No newline at end of file
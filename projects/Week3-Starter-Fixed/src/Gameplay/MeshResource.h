@@ -3,8 +3,9 @@
 #include "Graphics/VertexArrayObject.h"
 #include "Utils/MeshFactory.h"
 
-// bullet triangle mesh pre-declaration
+// bullet triangle mesh and hull pre-declarations
 class btTriangleMesh;
+class btConvexHullShape;
 
 namespace Gameplay {
 	/// <summary>
@@ -50,6 +51,10 @@ namespace Gameplay {
 		/// Allows for bullet to generate a triangle mesh from this mesh and cache it
 		/// </summary>
 		std::shared_ptr<btTriangleMesh> BulletTriMesh;
+		/// <summary>
+		/// The simplified convex hull cooked from this mesh, shared by all convex mesh colliders that use it
+		/// </summary>
+		std::shared_ptr<btConvexHullShape> ConvexHull;
 
 		/// <summary>
 		/// Generates a new mesh from the mesh builder parameters
@@ -65,5 +70,22 @@ namespace Gameplay {
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+
+		/// <summary>
+		/// Creates a mesh resource that loads it's mesh from a file in the background. Until the load
+		/// completes, Mesh is a shared placeholder that draws nothing
+		/// </summary>
+		/// <param name="filename">The path to the OBJ file to load</param>
+		static MeshResource::Sptr LoadAsync(const std::string& filename);
+		/// <summary>
+		/// Same as FromJson, but meshes loaded from files will load in the background
+		/// </summary>
+		static MeshResource::Sptr FromJsonAsync(const nlohmann::json& blob);
+
+	protected:
+		// Gets the empty mesh that is shared by all meshes that are still loading
+		static VertexArrayObject::Sptr _GetPlaceholderMesh();
+		// Marks the loaded mesh as static, so it can be drawn from shared geometry
+		void _MarkStatic();
 	};
 }
\ No newline at end of file
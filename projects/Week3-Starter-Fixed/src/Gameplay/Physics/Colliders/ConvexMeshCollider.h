@@ -5,6 +5,9 @@
 namespace Gameplay::Physics {
 	/// <summary>
 	/// A complex collider type that allows us to construct collision hulls from arbitrary convex meshes
+	/// 
+	/// The hull is a simplified version of the mesh, cooked once per mesh resource and shared between
+	/// all colliders that use that mesh
 	/// </summary>
 	class ConvexMeshCollider final : public ICollider {
 	public:
@@ -19,7 +22,9 @@ namespace Gameplay::Physics {
 		virtual void FromJson(const nlohmann::json& data) override;
 
 	protected:
-		btTriangleMesh* _triMesh;
+		// The cooked hull we're using, owned by the mesh resource. We keep a reference so the points stay
+		// alive as long as our shape does
+		std::shared_ptr<btConvexHullShape> _hull;
 		ConvexMeshCollider();
 
 		virtual btCollisionShape* CreateShape() const override;
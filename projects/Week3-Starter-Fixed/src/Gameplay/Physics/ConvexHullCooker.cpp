@@ -0,0 +1,230 @@
+#include "Gameplay/Physics/ConvexHullCooker.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btShapeHull.h>
+
+#include "Gameplay/MeshResource.h"
+#include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Logging.h"
+
+namespace fs = std::filesystem;
+
+namespace Gameplay::Physics {
+	std::shared_ptr<btConvexHullShape> ConvexHullCooker::GetHull(const std::shared_ptr<MeshResource>& mesh) {
+		if (mesh == nullptr) {
+			return nullptr;
+		}
+
+		// Meshes with an explicit collider mesh should use that instead
+		MeshResource::Sptr source = mesh->ColliderMeshData != nullptr ? mesh->ColliderMeshData : mesh;
+
+		// Someone has already cooked this mesh, share it
+		if (source->ConvexHull != nullptr) {
+			return source->ConvexHull;
+		}
+
+		float startTime = static_cast<float>(glfwGetTime());
+
+		// Try and grab the hull from the cache first, we can only cache meshes that came from files
+		std::vector<glm::vec3> hull;
+		bool fromCache = false;
+		if (!source->Filename.empty() && source->Filename != "null") {
+			fromCache = _LoadCache(_GetCachePath(source->Filename), hull);
+		}
+
+		// Nothing in the cache, we need to cook it from the mesh's vertices
+		if (!fromCache) {
+			std::vector<glm::vec3> positions;
+			if (!_GatherPositions(*source, positions)) {
+				LOG_WARN("Could not get vertex positions for convex mesh collider");
+				return nullptr;
+			}
+			if (!Cook(positions, hull)) {
+				LOG_WARN("Failed to build hull for convex mesh");
+				return nullptr;
+			}
+			if (!source->Filename.empty() && source->Filename != "null") {
+				_SaveCache(_GetCachePath(source->Filename), hull);
+			}
+		}
+
+		// Store the hull in the mesh so any other colliders using it can share it
+		btConvexHullShape* shape = new btConvexHullShape();
+		for (const glm::vec3& point : hull) {
+			shape->addPoint(btVector3(point.x, point.y, point.z), false);
+		}
+		shape->recalcLocalAabb();
+		source->ConvexHull = std::shared_ptr<btConvexHullShape>(shape);
+
+		float endTime = static_cast<float>(glfwGetTime());
+		LOG_TRACE("{} convex hull for \"{}\" in {} seconds ({} points)", fromCache ? "Loaded" : "Cooked", source->Filename, endTime - startTime, hull.size());
+
+		return source->ConvexHull;
+	}
+
+	bool ConvexHullCooker::Cook(const std::vector<glm::vec3>& points, std::vector<glm::vec3>& outHull) {
+		outHull.clear();
+		if (points.empty()) {
+			return false;
+		}
+
+		// Wrap all the points in a hull shape, so that btShapeHull can sample it's support points
+		btConvexHullShape source = btConvexHullShape();
+		for (const glm::vec3& point : points) {
+			source.addPoint(btVector3(point.x, point.y, point.z), false);
+		}
+		// The support points include the shape's margin, and the collider adds it's own margin on top of the
+		// cooked points, so we need to sample the bare mesh or the hull ends up inflated twice
+		source.setMargin(0.0f);
+		source.recalcLocalAabb();
+
+		// The shape hull only keeps the points that are furthest along a fixed set of directions, which gives
+		// us a hull with a small and bounded number of points, no matter how detailed the mesh is
+		btShapeHull shapeHull = btShapeHull(&source);
+		if (!shapeHull.buildHull(0.0f)) {
+			return false;
+		}
+
+		const btVector3* vertices = shapeHull.getVertexPointer();
+		outHull.reserve(shapeHull.numVertices());
+		for (int ix = 0; ix < shapeHull.numVertices(); ix++) {
+			outHull.push_back(glm::vec3(vertices[ix].x(), vertices[ix].y(), vertices[ix].z()));
+		}
+		return !outHull.empty();
+	}
+
+	std::string ConvexHullCooker::_GetCachePath(const std::string& filename) {
+		return fs::path(filename).replace_extension(".hull").string();
+	}
+
+	bool ConvexHullCooker::_LoadCache(const std::string& filename, std::vector<glm::vec3>& outHull) {
+		if (!VirtualFileSystem::Exists(filename)) {
+			return false;
+		}
+
+		VirtualFile file;
+		if (!file.Open(filename)) {
+			return false;
+		}
+
+		const uint8_t* data = file.GetData();
+		size_t size = file.GetSize();
+
+		CacheHeader header = CacheHeader();
+		CacheHeader expected = CacheHeader();
+		if (size < sizeof(CacheHeader)) {
+			return false;
+		}
+		memcpy(&header, data, sizeof(CacheHeader));
+
+		// Caches from older versions are just cooked again and overwritten
+		if (memcmp(header.HeaderBytes, expected.HeaderBytes, sizeof(expected.HeaderBytes)) != 0 || header.Version != CACHE_VERSION) {
+			return false;
+		}
+		if (header.NumPoints == 0 || size < sizeof(CacheHeader) + header.NumPoints * sizeof(glm::vec3)) {
+			LOG_WARN("Hull cache \"{}\" is truncated, cooking again", filename);
+			return false;
+		}
+
+		outHull.resize(header.NumPoints);
+		memcpy(outHull.data(), data + sizeof(CacheHeader), header.NumPoints * sizeof(glm::vec3));
+		return true;
+	}
+
+	void ConvexHullCooker::_SaveCache(const std::string& filename, const std::vector<glm::vec3>& hull) {
+		std::ofstream file(filename, std::ios::binary);
+		if (!file) {
+			// Not being able to cache (ex: the mesh lives in a read only location) isn't fatal, we'll just cook it again next time
+			LOG_WARN("Failed to write hull cache \"{}\"", filename);
+			return;
+		}
+
+		CacheHeader header = CacheHeader();
+		header.Version   = CACHE_VERSION;
+		header.NumPoints = static_cast<uint32_t>(hull.size());
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+		file.write(reinterpret_cast<const char*>(hull.data()), hull.size() * sizeof(glm::vec3));
+	}
+
+	bool ConvexHullCooker::_GatherPositions(const MeshResource& mesh, std::vector<glm::vec3>& outPositions) {
+		outPositions.clear();
+
+		// Meshes from files can be read straight from disk, preferring the binary mesh if it exists since
+		// it's far faster to read than the OBJ
+		if (!mesh.Filename.empty() && mesh.Filename != "null") {
+			fs::path filePath = fs::path(mesh.Filename);
+			std::string extension = filePath.extension().string();
+			StringTools::ToLower(extension);
+
+			std::string binPath = extension == ".bin" ? mesh.Filename : fs::path(mesh.Filename).replace_extension(".bin").string();
+			if (VirtualFileSystem::Exists(binPath) && OptimizedObjLoader::LoadPositions(binPath, outPositions)) {
+				return true;
+			}
+
+			if (extension == ".obj" && VirtualFileSystem::Exists(mesh.Filename)) {
+				MeshBuilder<VertexPosNormTexColTangents> builder;
+				ObjLoader::LoadMeshBuilder(mesh.Filename, builder, false);
+				outPositions.reserve(builder.GetVertexCount());
+				const VertexPosNormTexColTangents* vertices = builder.GetVertexDataPtr();
+				for (size_t ix = 0; ix < builder.GetVertexCount(); ix++) {
+					outPositions.push_back(vertices[ix].Position);
+				}
+				return !outPositions.empty();
+			}
+		}
+
+		// Generated meshes are cheap to build again on the CPU
+		if (mesh.MeshBuilderParams.size() > 0) {
+			MeshBuilder<VertexPosNormTexColTangents> builder;
+			for (const MeshBuilderParam& param : mesh.MeshBuilderParams) {
+				MeshFactory::AddParameterized(builder, param);
+			}
+			outPositions.reserve(builder.GetVertexCount());
+			const VertexPosNormTexColTangents* vertices = builder.GetVertexDataPtr();
+			for (size_t ix = 0; ix < builder.GetVertexCount(); ix++) {
+				outPositions.push_back(vertices[ix].Position);
+			}
+			return !outPositions.empty();
+		}
+
+		// Last resort, the mesh only exists on the GPU
+		return _ReadBackPositions(mesh.Mesh, outPositions);
+	}
+
+	bool ConvexHullCooker::_ReadBackPositions(const VertexArrayObject::Sptr& vao, std::vector<glm::vec3>& outPositions) {
+		if (vao == nullptr) {
+			return false;
+		}
+
+		// Get the attribute for positions from the vertex declaration
+		const VertexArrayObject::VertexDeclaration& VDecl = vao->GetVDecl();
+		auto it = std::find_if(VDecl.begin(), VDecl.end(), [](const BufferAttribute& attrib) {
+			return attrib.Usage == AttribUsage::Position;
+		});
+		const auto* vertBuff = vao->GetBufferBinding(AttribUsage::Position);
+		if (it == VDecl.end() || vertBuff == nullptr) {
+			return false;
+		}
+		BufferAttribute posAttrib = *it;
+		VertexBuffer::Sptr vertexBuff = vertBuff->GetBuffer();
+
+		// The hull doesn't care about how the vertices are connected, so we don't need the index buffer. Meshes
+		// in a geometry store share their buffer with other meshes, so only read back our own range
+		size_t vertexCount = vao->GetVertexCount();
+		std::vector<uint8_t> vertexStore(vertexCount * posAttrib.Stride);
+		glGetNamedBufferSubData(vertexBuff->GetHandle(), (GLintptr)vao->GetBaseVertex() * posAttrib.Stride, vertexStore.size(), vertexStore.data());
+
+		outPositions.resize(vertexCount);
+		for (size_t ix = 0; ix < outPositions.size(); ix++) {
+			memcpy(&outPositions[ix], vertexStore.data() + (ix * posAttrib.Stride) + posAttrib.Offset, sizeof(glm::vec3));
+		}
+		return !outPositions.empty();
+	}
+}
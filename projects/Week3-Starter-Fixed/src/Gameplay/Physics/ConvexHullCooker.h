@@ -0,0 +1,68 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GLM/glm.hpp>
+
+#include "Graphics/VertexArrayObject.h"
+
+class btConvexHullShape;
+
+namespace Gameplay {
+	class MeshResource;
+}
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Cooks simplified convex hulls for meshes, so that convex mesh colliders don't need to work with
+	/// every triangle of the render mesh. Hulls for meshes loaded from files are cached in a .hull file
+	/// beside the mesh (and it's .bin), so they only need to be cooked once
+	/// </summary>
+	class ConvexHullCooker {
+	public:
+		/// <summary>
+		/// Gets the cooked hull for the given mesh resource, loading it from the cache or cooking it on
+		/// first use. The hull is stored in the mesh resource, so all colliders using the mesh share it
+		/// </summary>
+		/// <param name="mesh">The mesh resource to get the hull for</param>
+		/// <returns>The cooked hull, or nullptr if the mesh has no usable vertex data</returns>
+		static std::shared_ptr<btConvexHullShape> GetHull(const std::shared_ptr<MeshResource>& mesh);
+
+		/// <summary>
+		/// Cooks a simplified convex hull that contains the given points
+		/// </summary>
+		/// <param name="points">The points to wrap the hull around</param>
+		/// <param name="outHull">The vector to store the hull's vertices in, will be cleared first</param>
+		/// <returns>True if the hull was built, false if otherwise</returns>
+		static bool Cook(const std::vector<glm::vec3>& points, std::vector<glm::vec3>& outHull);
+
+	protected:
+		ConvexHullCooker() = default;
+		~ConvexHullCooker() = default;
+
+		// Will be put at the start of the cache file
+		struct CacheHeader {
+			// A check value so we can ensure that we're loading in the right file type
+			char      HeaderBytes[4] = { 'B', 'H', 'U', 'L' };
+			// The version code, we can use this to create different loaders if our format changes
+			uint16_t  Version = 0;
+			// The number of hull vertices that follow the header
+			uint32_t  NumPoints = 0;
+		};
+
+		// The current version of the cache format that we write out
+		// Version 2 cooks from the mesh without a collision margin, version 1 hulls were inflated by it
+		static const uint16_t CACHE_VERSION = 0x02;
+
+		// Gets the path to the hull cache for a mesh file
+		static std::string _GetCachePath(const std::string& filename);
+		static bool _LoadCache(const std::string& filename, std::vector<glm::vec3>& outHull);
+		static void _SaveCache(const std::string& filename, const std::vector<glm::vec3>& hull);
+
+		// Gets the vertex positions for a mesh from CPU side data where we can
+		static bool _GatherPositions(const MeshResource& mesh, std::vector<glm::vec3>& outPositions);
+		// Reads the vertex positions back from a VAO's buffers, only used for meshes that have no other source
+		static bool _ReadBackPositions(const VertexArrayObject::Sptr& vao, std::vector<glm::vec3>& outPositions);
+	};
+}
@@ -17,7 +17,8 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		_isShapeDirty(true),
 		_collisionGroup(0x01),
 		_collisionMask(0xFFFFFFFF),
-		_prevScale(glm::vec3(1.0f))
+		_prevScale(glm::vec3(1.0f)),
+		_syncedTransformVersion(0)
 	{ }
 
 	PhysicsBase::~PhysicsBase() {
@@ -215,9 +216,14 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		return false;
 	}
 
+	bool PhysicsBase::_IsTransformChanged() const {
+		return GetGameObject()->GetTransformVersion() != _syncedTransformVersion;
+	}
+
 	void PhysicsBase::_CopyGameobjectTransformTo(btTransform& transform) {
 
 		GameObject* context = GetGameObject();
+		_syncedTransformVersion = context->GetTransformVersion();
 
 		// Copy our transform info from OpenGL
 		transform.setIdentity();
@@ -236,5 +242,8 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		// Update the pos and rotation params
 		context->SetPostion(ToGlm(transform.getOrigin()));
 		context->SetRotation(ToGlm(transform.getRotation()));
+
+		// We've moved the object ourselves, so don't treat it as a change from gameplay
+		_syncedTransformVersion = context->GetTransformVersion();
 	}
 }
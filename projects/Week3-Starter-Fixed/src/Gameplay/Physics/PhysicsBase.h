@@ -73,6 +73,8 @@ namespace Gameplay {
 			/// <summary>
 			/// Invoked for each RigidBody before the physics world is stepped forward a frame,
 			/// handles body initialization, shape changes, mass changes, etc...
+			/// The gameobject's transform should only be sent to Bullet when _IsTransformChanged
+			/// is true, so that resting objects can go to sleep
 			/// </summary>
 			/// <param name="dt">The time in seconds since the last frame</param>
 			virtual void PhysicsPreStep(float dt) = 0;
@@ -102,6 +104,9 @@ namespace Gameplay {
 			mutable bool _isGroupMaskDirty;
 
 			glm::vec3 _prevScale;
+			// The gameobject's transform version when we last synced with it, if the gameobject's
+			// version no longer matches then gameplay code has moved it
+			uint32_t  _syncedTransformVersion;
 
 			PhysicsBase();
 
@@ -118,6 +123,8 @@ namespace Gameplay {
 
 			bool _HandleGroupDirty();
 
+			// Returns true if the gameobject has been moved since we last synced our transform with it
+			bool _IsTransformChanged() const;
 			// Copies the gameobject's transform the the bullet transform
 			void _CopyGameobjectTransformTo(btTransform& transform);
 			void _CopyGameobjectTransformFrom(const btTransform& transform);
@@ -0,0 +1,102 @@
+#include "Gameplay/Physics/PhysicsTaskScheduler.h"
+
+#if BT_THREADSAFE
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "Application/JobSystem.h"
+#include "Logging.h"
+
+namespace Gameplay::Physics {
+	// Splits [0, count) into chunks of grainSize, and runs them on at most numThreads threads. Each job keeps
+	// taking the next chunk until there are none left, so the number of jobs is what caps the thread count
+	template <typename Func>
+	static void RunChunks(int numThreads, int count, int grainSize, const Func& func) {
+		int grain = std::max(grainSize, 1);
+		int numChunks = (count + grain - 1) / grain;
+		std::atomic<int> nextChunk{ 0 };
+		auto runChunks = [&]() {
+			for (int chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+				func(chunk, chunk * grain, std::min((chunk + 1) * grain, count));
+			}
+		};
+
+		// The calling thread takes a share as well, so we only need to hand out the rest
+		JobCounter counter;
+		int numJobs = std::min(numThreads, numChunks) - 1;
+		for (int ix = 0; ix < numJobs; ix++) {
+			JobSystem::Submit(runChunks, counter);
+		}
+		runChunks();
+		JobSystem::Wait(counter);
+	}
+
+	PhysicsTaskScheduler::PhysicsTaskScheduler() :
+		btITaskScheduler("JobSystem"),
+		_threadLimit(0)
+	{ }
+
+	PhysicsTaskScheduler& PhysicsTaskScheduler::Get() {
+		static PhysicsTaskScheduler instance;
+		return instance;
+	}
+
+	void PhysicsTaskScheduler::Install() {
+		PhysicsTaskScheduler& scheduler = Get();
+		if (btGetTaskScheduler() != &scheduler) {
+			btSetTaskScheduler(&scheduler);
+			LOG_INFO("Bullet task scheduler using {} threads", scheduler.GetActiveThreads());
+		}
+	}
+
+	int PhysicsTaskScheduler::GetActiveThreads() const {
+		int available = getNumThreads();
+		return _threadLimit > 0 ? std::min(_threadLimit, available) : available;
+	}
+
+	int PhysicsTaskScheduler::getMaxNumThreads() const {
+		return static_cast<int>(BT_MAX_THREAD_COUNT);
+	}
+
+	int PhysicsTaskScheduler::getNumThreads() const {
+		// Bullet sizes it's per-thread storage from this and indexes it by btGetCurrentThreadIndex, so it needs
+		// to cover the main thread and every worker, even when setNumThreads limits how many run at once
+		return std::min(static_cast<int>(JobSystem::WorkerCount()) + 1, static_cast<int>(BT_MAX_THREAD_COUNT));
+	}
+
+	void PhysicsTaskScheduler::setNumThreads(int numThreads) {
+		_threadLimit = std::max(numThreads, 1);
+	}
+
+	void PhysicsTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) {
+		if (iEnd <= iBegin) {
+			return;
+		}
+		RunChunks(GetActiveThreads(), iEnd - iBegin, grainSize, [&](int chunk, int start, int end) {
+			body.forLoop(iBegin + start, iBegin + end);
+		});
+	}
+
+	btScalar PhysicsTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) {
+		if (iEnd <= iBegin) {
+			return btScalar(0);
+		}
+
+		// Each chunk writes to it's own slot, then we add them up in order so the result doesn't
+		// depend on which thread finished first
+		int count = iEnd - iBegin;
+		int grain = std::max(grainSize, 1);
+		std::vector<btScalar> sums((count + grain - 1) / grain, btScalar(0));
+		RunChunks(GetActiveThreads(), count, grain, [&](int chunk, int start, int end) {
+			sums[chunk] = body.sumLoop(iBegin + start, iBegin + end);
+		});
+
+		btScalar result = btScalar(0);
+		for (btScalar sum : sums) {
+			result += sum;
+		}
+		return result;
+	}
+}
+#endif
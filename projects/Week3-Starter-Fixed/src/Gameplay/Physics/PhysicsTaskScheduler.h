@@ -0,0 +1,54 @@
+#pragma once
+#include <LinearMath/btThreads.h>
+
+#include "Utils/Macros.h"
+
+// Bullet only runs it's parallel loops through a task scheduler when it is built with BT_THREADSAFE,
+// see BulletThreadSafe in Premake5.lua
+#if BT_THREADSAFE
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Implements Bullet's task scheduler interface on top of our JobSystem, so that the
+	/// multithreaded dynamics world shares the same worker threads as the rest of the engine
+	/// rather than spinning up a second pool. By default every job system worker plus the main thread
+	/// can help with Bullet's loops, setNumThreads can lower that (ex: to measure how physics scales)
+	///
+	/// Bullet hands out a thread index the first time a thread runs it's code and never reuses them, so
+	/// the job system should not be restarted once a multithreaded world has been stepped
+	/// </summary>
+	class PhysicsTaskScheduler final : public btITaskScheduler {
+	public:
+		NO_COPY(PhysicsTaskScheduler);
+		NO_MOVE(PhysicsTaskScheduler);
+
+		/// <summary>
+		/// Gets the shared scheduler instance
+		/// </summary>
+		static PhysicsTaskScheduler& Get();
+
+		/// <summary>
+		/// Makes this the scheduler that Bullet will use for parallel work. Bullet requires this to
+		/// be called from the main thread
+		/// </summary>
+		static void Install();
+
+		/// <summary>
+		/// Gets the number of threads that will run Bullet's loops, including the calling thread
+		/// </summary>
+		int GetActiveThreads() const;
+
+		// Inherited from btITaskScheduler
+		virtual int getMaxNumThreads() const override;
+		virtual int getNumThreads() const override;
+		virtual void setNumThreads(int numThreads) override;
+		virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+		virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+	protected:
+		PhysicsTaskScheduler();
+
+		// The most threads that may work on a single loop, 0 to use every thread the job system has
+		int _threadLimit;
+	};
+}
+#endif
@@ -21,13 +21,16 @@ namespace Gameplay::Physics {
 		_motionState(nullptr),
 		_linearDamping(0.0f),
 		_angularDamping(0.005f),
+		_isDampingDirty(true),
 		_inertia(btVector3()),
 		_linearVelocity(btVector3(0, 0, 0)),
 		_linearVelocityDirty(false),
 		_angularVelocity(btVector3(0, 0, 0)),
 		_angularVelocityDirty(false),
 		_angularFactor(btVector3(1,1,1)),
-		_angularFactorDirty(false)
+		_angularFactorDirty(false),
+		_prevTransform(btTransform::getIdentity()),
+		_isRenderAtRest(false)
 	{ }
 
 	RigidBody::~RigidBody() {
@@ -101,26 +104,33 @@ namespace Gameplay::Physics {
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce) {
+		// Forces do nothing to a sleeping body, so make sure it's awake
+		_body->activate(true);
 		_body->applyCentralForce(ToBt(worldForce));
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce, const glm::vec3& localOffset) {
+		_body->activate(true);
 		_body->applyForce(ToBt(worldForce), ToBt(localOffset));
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce) {
+		_body->activate(true);
 		_body->applyCentralImpulse(ToBt(worldForce));
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce, const glm::vec3& localOffset) {
+		_body->activate(true);
 		_body->applyImpulse(ToBt(worldForce), ToBt(localOffset));
 	}
 
 	void RigidBody::ApplyTorque(const glm::vec3& worldTorque) {
+		_body->activate(true);
 		_body->applyTorque(ToBt(worldTorque));
 	}
 
 	void RigidBody::ApplyTorqueImpulse(const glm::vec3& worldTorque) {
+		_body->activate(true);
 		_body->applyTorqueImpulse(ToBt(worldTorque));
 	}
 
@@ -131,6 +141,14 @@ namespace Gameplay::Physics {
 			int flags = _body->getCollisionFlags() & ~btCollisionObject::CF_STATIC_OBJECT;
 			flags = _body->getCollisionFlags() & ~btCollisionObject::CF_KINEMATIC_OBJECT;
 
+			// Kinematic bodies must never sleep, everything else may
+			if (_type == RigidBodyType::Kinematic) {
+				_body->setActivationState(DISABLE_DEACTIVATION);
+			} else {
+				_body->forceActivationState(ACTIVE_TAG);
+				_body->activate(true);
+			}
+
 			// Set appropriate flags
 			if (_type == RigidBodyType::Kinematic) {
 				_body->setCollisionFlags(flags | btCollisionObject::CF_KINEMATIC_OBJECT);
@@ -155,32 +173,67 @@ namespace Gameplay::Physics {
 		// Update any dirty state that may have changed
 		_HandleStateDirty();
 
-		if (_type != RigidBodyType::Static) {		
+		// Only send our transform to Bullet if gameplay code has moved the object since we last synced, resetting
+		// the transform every step would keep bodies from sleeping and throw away their cached contacts
+		if (_type != RigidBodyType::Static && _IsTransformChanged()) {		
 			btTransform transform;
 			_CopyGameobjectTransformTo(transform);
 
 			// Copy to body and to it's motion state
 			if (_type == RigidBodyType::Dynamic) {
 				_body->setWorldTransform(transform);
+				_body->setInterpolationWorldTransform(transform);
+				_body->activate(true);
 			} else {
 				// Kinematics prefer to be driven my motion state for some reason :|
 				_body->getMotionState()->setWorldTransform(transform);
 			}
 		}
+
+		// Sleeping bodies don't move, so they can keep their previous state
+		if (_type == RigidBodyType::Dynamic && _body->isActive()) {
+			_prevTransform = _body->getWorldTransform();
+		}
 	}
 
 	void RigidBody::PhysicsPostStep(float dt) {
 		// Kinematics are driven externally and statics don't move, so only need to get data out for dynamics!
-		if (_type == RigidBodyType::Dynamic) {
-			btTransform transform = _body->getWorldTransform();
-			_CopyGameobjectTransformFrom(transform);
-
+		// The transform itself is copied out in PhysicsInterpolate, once all steps for the frame are done
+		if (_type == RigidBodyType::Dynamic && _body->isActive()) {
 			// Store a copy of our velocities
 			_linearVelocity = _body->getLinearVelocity();
 			_angularVelocity = _body->getAngularVelocity();
 		}
 	}
 
+	void RigidBody::PhysicsInterpolate(float alpha) {
+		if (_type != RigidBodyType::Dynamic || _body == nullptr) {
+			return;
+		}
+
+		// Gameplay has moved the object, leave it be until the next step picks it up
+		if (_IsTransformChanged()) {
+			return;
+		}
+
+		// Once a body is asleep we only need to copy out it's resting transform once
+		if (!_body->isActive()) {
+			if (_isRenderAtRest) {
+				return;
+			}
+			alpha = 1.0f;
+			_isRenderAtRest = true;
+		} else {
+			_isRenderAtRest = false;
+		}
+
+		const btTransform& current = _body->getWorldTransform();
+		btTransform transform;
+		transform.setOrigin(_prevTransform.getOrigin().lerp(current.getOrigin(), alpha));
+		transform.setRotation(_prevTransform.getRotation().slerp(current.getRotation(), alpha));
+		_CopyGameobjectTransformFrom(transform);
+	}
+
 	void RigidBody::Awake() {
 		GameObject* context = GetGameObject();
 		_scene = context->GetScene();
@@ -213,6 +266,8 @@ namespace Gameplay::Physics {
 		transform.setOrigin(ToBt(context->GetPosition()));
 		transform.setRotation(ToBt(context->GetRotation()));
 		_motionState->setWorldTransform(transform);
+		_prevTransform = transform;
+		_syncedTransformVersion = context->GetTransformVersion();
 
 		// Create the bullet rigidbody and add it to the physics scene
 		_body = new btRigidBody(_mass, _motionState, _shape, _inertia);
@@ -230,8 +285,12 @@ namespace Gameplay::Physics {
 			_body->setGravity(btVector3(0.0f, 0.0f, 0.0f));
 			_body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
 		}
-	
-		_body->setActivationState(DISABLE_DEACTIVATION);
+
+		// Kinematic bodies are moved by us rather than the solver, so Bullet needs them to stay awake. Everything
+		// else is allowed to sleep once it comes to rest
+		if (_type == RigidBodyType::Kinematic) {
+			_body->setActivationState(DISABLE_DEACTIVATION);
+		}
 
 		// Copy over group and mask info
 		_body->getBroadphaseProxy()->m_collisionFilterGroup = _collisionGroup;
@@ -257,7 +316,7 @@ namespace Gameplay::Physics {
 	}
 
 	RigidBody::Sptr RigidBody::FromJson(const nlohmann::json& data) {
-		RigidBody::Sptr result = std::make_shared<RigidBody>();
+		RigidBody::Sptr result = MakeComponent<RigidBody>();
 		// Read out the RigidBody config
 		result->_type = ParseRigidBodyType(data["type"], RigidBodyType::Unknown);
 		result->_mass = data["mass"];
@@ -269,29 +328,37 @@ namespace Gameplay::Physics {
 	}
 
 	void RigidBody::_HandleStateDirty() {
+		// Set if anything changes that a sleeping body would need to wake up for
+		bool wake = false;
+
 		// Only dynamic bodies have velocities
 		if (_type == RigidBodyType::Dynamic) {
 			// If outside code has changed our velocity, send that to Bullet
 			if (_linearVelocityDirty) {
 				_body->setLinearVelocity(_linearVelocity);
 				_linearVelocityDirty = false;
+				wake = true;
 			}
 
 			// If outside code has changed our angular velocity, send that to Bullet
 			if (_angularVelocityDirty) {
 				_body->setAngularVelocity(_angularVelocity);
 				_angularVelocityDirty = false;
+				wake = true;
 			}
 
 			// If outside code has changed the angular factor, send to Bullet
 			if (_angularFactorDirty) {
 				_body->setAngularFactor(_angularFactor);
 				_angularFactorDirty = false;
+				wake = true;
 			}
 		}
 
 		// If one of our colliders has changed, replace it's shape with it's
-		_isMassDirty |= _HandleShapeDirty();
+		bool shapeChanged = _HandleShapeDirty();
+		_isMassDirty |= shapeChanged;
+		wake |= shapeChanged;
 
 		// Handle updating our group or mask if they've changed
 		_HandleGroupDirty();
@@ -300,6 +367,7 @@ namespace Gameplay::Physics {
 		if (_isDampingDirty) {
 			_body->setDamping(_linearDamping, _angularDamping);
 			_isDampingDirty = false;
+			wake = true;
 		}
 
 		// If the mass has changed, we need to notify bullet
@@ -311,6 +379,11 @@ namespace Gameplay::Physics {
 				_body->setMassProps(_mass, _inertia);
 			}
 			_isMassDirty = false;
+			wake = true;
+		}
+
+		if (wake && _type == RigidBodyType::Dynamic) {
+			_body->activate(true);
 		}
 	}
 
@@ -160,10 +160,19 @@ namespace Gameplay::Physics {
 		virtual void PhysicsPreStep(float dt) override;
 		/// <summary>
 		/// Invoked for each RigidBody after the physics world is stepped forward a frame,
-		/// handles copying transform to the OpenGL state
+		/// handles copying velocities back out of Bullet
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPostStep(float dt) override;
+		/// <summary>
+		/// Invoked for each RigidBody once the scene has finished stepping physics for the frame,
+		/// copies a transform part way between the body's last two physics states to the gameobject
+		/// 
+		/// If gameplay code has moved the gameobject since the last call, the gameobject is left
+		/// alone, and the body will be teleported to it on the next pre step
+		/// </summary>
+		/// <param name="alpha">How far between the previous and current physics states to render, in the 0-1 range</param>
+		void PhysicsInterpolate(float alpha);
 
 		// Inherited from IComponent
 		virtual void Awake() override;
@@ -198,6 +207,11 @@ namespace Gameplay::Physics {
 		btVector3        _angularFactor;
 		bool             _angularFactorDirty;
 
+		// The body's transform before the most recent physics step, used for interpolation
+		btTransform      _prevTransform;
+		// Set once a sleeping body's resting transform has been copied to the gameobject
+		bool             _isRenderAtRest;
+
 		// Handles resolving any dirty state stuff for our object
 		void _HandleStateDirty();
 
@@ -0,0 +1,103 @@
+#include "Gameplay/Physics/TriggerEventTracker.h"
+
+#include <btBulletDynamicsCommon.h>
+
+#include "Gameplay/Physics/TriggerVolume.h"
+#include "Gameplay/Physics/RigidBody.h"
+#include "Gameplay/GameObject.h"
+
+namespace Gameplay::Physics {
+	TriggerEventTracker::TriggerEventTracker() :
+		_overlaps(),
+		_updateIndex(0),
+		_entered(),
+		_left()
+	{ }
+
+	void TriggerEventTracker::Update(btDynamicsWorld* world) {
+		_updateIndex++;
+
+		// The dispatcher has already run the narrowphase for every pair in the world, including triggers, so
+		// all we need to do is look for manifolds between a trigger and a body that actually have contacts
+		btDispatcher* dispatcher = world->getDispatcher();
+		const int numManifolds = dispatcher->getNumManifolds();
+		for (int ix = 0; ix < numManifolds; ix++) {
+			const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(ix);
+			if (manifold->getNumContacts() == 0) {
+				continue;
+			}
+			const btCollisionObject* a = manifold->getBody0();
+			const btCollisionObject* b = manifold->getBody1();
+			if (a->getInternalType() == btCollisionObject::CO_GHOST_OBJECT) {
+				_HandleContact(a, b);
+			} else if (b->getInternalType() == btCollisionObject::CO_GHOST_OBJECT) {
+				_HandleContact(b, a);
+			}
+		}
+
+		// Anything we didn't see this update has left it's trigger
+		for (auto it = _overlaps.begin(); it != _overlaps.end();) {
+			if (it->second.LastSeen != _updateIndex) {
+				// If either side has been destroyed there's nobody left to tell
+				TriggerVolume::Sptr trigger = it->second.Trigger.lock();
+				RigidBody::Sptr body = it->second.Body.lock();
+				if (trigger != nullptr && body != nullptr) {
+					_left.emplace_back(trigger, body);
+				}
+				it = _overlaps.erase(it);
+			} else {
+				it++;
+			}
+		}
+
+		// Dispatch everything in one go, now that we're done walking the world's data
+		for (const auto& [trigger, body] : _entered) {
+			body->GetGameObject()->OnEnteredTrigger(trigger);
+			trigger->GetGameObject()->OnTriggerVolumeEntered(body);
+		}
+		for (const auto& [trigger, body] : _left) {
+			body->GetGameObject()->OnLeavingTrigger(trigger);
+			trigger->GetGameObject()->OnTriggerVolumeLeaving(body);
+		}
+		_entered.clear();
+		_left.clear();
+	}
+
+	void TriggerEventTracker::Clear() {
+		_overlaps.clear();
+		_entered.clear();
+		_left.clear();
+	}
+
+	void TriggerEventTracker::_HandleContact(const btCollisionObject* ghost, const btCollisionObject* other) {
+		// Only rigid bodies can set off triggers (no trigger-trigger interactions)
+		if (other->getInternalType() != btCollisionObject::CO_RIGID_BODY || ghost->getUserPointer() == nullptr || other->getUserPointer() == nullptr) {
+			return;
+		}
+
+		// Compound shapes can give us several manifolds for the same pair, we only need the first one
+		OverlapKey key = OverlapKey(ghost, other);
+		auto it = _overlaps.find(key);
+		if (it != _overlaps.end() && it->second.LastSeen == _updateIndex) {
+			return;
+		}
+		// The pair is still overlapping, as long as it's the same components (the memory may have been re-used)
+		if (it != _overlaps.end() && !it->second.Trigger.expired() && !it->second.Body.expired()) {
+			it->second.LastSeen = _updateIndex;
+			return;
+		}
+
+		// Extract the weak pointers that we store in all our physics object's user pointers
+		std::shared_ptr<TriggerVolume> trigger = std::dynamic_pointer_cast<TriggerVolume>(reinterpret_cast<std::weak_ptr<IComponent>*>(ghost->getUserPointer())->lock());
+		std::shared_ptr<RigidBody> body = std::dynamic_pointer_cast<RigidBody>(reinterpret_cast<std::weak_ptr<IComponent>*>(other->getUserPointer())->lock());
+		if (trigger == nullptr || body == nullptr || body->GetGameObject() == trigger->GetGameObject() || !trigger->_ShouldTrigger(other)) {
+			return;
+		}
+
+		Overlap& overlap = _overlaps[key];
+		overlap.Trigger = trigger;
+		overlap.Body = body;
+		overlap.LastSeen = _updateIndex;
+		_entered.emplace_back(trigger, body);
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+#include "Utils/Macros.h"
+
+class btDynamicsWorld;
+class btCollisionObject;
+
+namespace Gameplay::Physics {
+	class TriggerVolume;
+	class RigidBody;
+
+	/// <summary>
+	/// Tracks which rigid bodies are inside which trigger volumes for an entire scene. Rather than
+	/// each trigger querying it's own pair cache, the tracker reads the contact manifolds that the
+	/// world's dispatcher has already built during the step, so each overlap is looked at once per
+	/// step. Enter and leave events are gathered up and dispatched together once the pass is done
+	/// </summary>
+	class TriggerEventTracker final {
+	public:
+		MAKE_PTRS(TriggerEventTracker);
+		NO_COPY(TriggerEventTracker);
+		NO_MOVE(TriggerEventTracker);
+
+		TriggerEventTracker();
+		~TriggerEventTracker() = default;
+
+		/// <summary>
+		/// Gathers all trigger overlaps from the world, and invokes the enter and leave events on
+		/// any game objects whose overlaps have changed since the last update. Should be called
+		/// once after each time the world is stepped
+		/// </summary>
+		/// <param name="world">The world that was just stepped</param>
+		void Update(btDynamicsWorld* world);
+
+		/// <summary>
+		/// Forgets all known overlaps without invoking any events, use this if the world is rebuilt
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Gets the number of trigger/body pairs that are currently overlapping
+		/// </summary>
+		size_t NumOverlaps() const { return _overlaps.size(); }
+
+	protected:
+		// A trigger's ghost object and the body that's overlapping it
+		typedef std::pair<const btCollisionObject*, const btCollisionObject*> OverlapKey;
+
+		struct OverlapKeyHash {
+			size_t operator()(const OverlapKey& key) const {
+				size_t a = std::hash<const void*>()(key.first);
+				size_t b = std::hash<const void*>()(key.second);
+				return a ^ (b + 0x9e3779b9 + (a << 6) + (a >> 2));
+			}
+		};
+
+		struct Overlap {
+			std::weak_ptr<TriggerVolume> Trigger;
+			std::weak_ptr<RigidBody>     Body;
+			// The update that this overlap was last seen in, anything older has left the trigger
+			uint32_t                     LastSeen;
+		};
+
+		typedef std::pair<std::shared_ptr<TriggerVolume>, std::shared_ptr<RigidBody>> OverlapEvent;
+
+		std::unordered_map<OverlapKey, Overlap, OverlapKeyHash> _overlaps;
+		uint32_t                  _updateIndex;
+
+		// Kept between updates so we don't need to re-allocate them every step
+		std::vector<OverlapEvent> _entered;
+		std::vector<OverlapEvent> _left;
+
+		// Handles a single pair of objects that have contacts, checking if it's a trigger and a body
+		void _HandleContact(const btCollisionObject* a, const btCollisionObject* b);
+	};
+}
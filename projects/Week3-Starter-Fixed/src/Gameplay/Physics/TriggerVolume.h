@@ -5,6 +5,7 @@
 #include "EnumToString.h"
 
 class btPairCachingGhostObject;
+class btCollisionObject;
 
 namespace Gameplay::Physics {
 
@@ -33,8 +34,8 @@ namespace Gameplay::Physics {
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPreStep(float dt) override;
 		/// <summary>
-		/// Invoked for each RigidBody after the physics world is stepped forward a frame,
-		/// handles copying transform to the OpenGL state
+		/// Invoked for each RigidBody after the physics world is stepped forward a frame. Trigger
+		/// events are handled for the whole scene by the TriggerEventTracker, so this does nothing
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPostStep(float dt) override;
@@ -51,10 +52,13 @@ namespace Gameplay::Physics {
 		MAKE_TYPENAME(TriggerVolume);
 
 	protected:
+		friend class TriggerEventTracker;
+
 		btPairCachingGhostObject*   _ghost;
 		TriggerTypeFlags            _typeFlags;
 
-		std::vector<std::weak_ptr<RigidBody>> _currentCollisions;
+		// Returns true if the given object overlapping our volume should invoke our trigger events
+		bool _ShouldTrigger(const btCollisionObject* obj) const;
 
 		virtual btBroadphaseProxy* _GetBroadphaseHandle() override;
 
@@ -3,12 +3,31 @@
 #include <GLFW/glfw3.h>
 #include <locale>
 #include <codecvt>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cmath>
+#include <unordered_map>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include <CerealGLM.h>
+
+#if BT_THREADSAFE
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#endif
 
 #include "Utils/FileHelpers.h"
+#include "Utils/VirtualFileSystem.h"
 #include "Utils/GlmBulletConversions.h"
 
 #include "Gameplay/Physics/RigidBody.h"
 #include "Gameplay/Physics/TriggerVolume.h"
+#include "Gameplay/Physics/PhysicsTaskScheduler.h"
+#include "Gameplay/Physics/TriggerEventTracker.h"
 #include "Gameplay/MeshResource.h"
 #include "Gameplay/Material.h"
 
@@ -16,9 +35,48 @@
 #include "Graphics/Textures/TextureCube.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Application/Application.h"
+#include "Application/JobSystem.h"
 
 namespace Gameplay {
+	// Will be put at the start of binary scene files, so we can make sure we're loading the right file type
+	static const char BINARY_SCENE_HEADER[4] = { 'B', 'S', 'C', 'N' };
+	// The current version of the binary scene format. This is frozen once a release ships with it, so
+	// only bump it (and keep a reader for the old version) when changing a format that has been released
+	static const uint16_t BINARY_SCENE_VERSION = 0x01;
+
+	// A single game object in a binary scene, names and GUIDs are indices into the file's tables
+	struct BinarySceneObject {
+		uint32_t  Name = 0;
+		uint32_t  Guid = 0;
+		// The index of the parent object's GUID, or -1 if the object has no parent
+		int32_t   Parent = -1;
+		glm::vec3 Position = glm::vec3(0.0f);
+		glm::quat Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 Scale = glm::vec3(1.0f);
+		bool      HideInHierarchy = false;
+
+		template <class Archive>
+		void serialize(Archive& archive) {
+			archive(Name, Guid, Parent, Position, Rotation, Scale, HideInHierarchy);
+		}
+	};
+
+	// Every component of a single type in a binary scene. Each component's JSON is stored as MessagePack in
+	// a single shared blob, with Offsets marking where each one starts (and a final entry for the end of the blob)
+	struct BinarySceneComponents {
+		uint32_t              TypeName = 0;
+		std::vector<uint32_t> Objects;
+		std::vector<uint64_t> Offsets;
+		std::vector<uint8_t>  Data;
+
+		template <class Archive>
+		void serialize(Archive& archive) {
+			archive(TypeName, Objects, Offsets, Data);
+		}
+	};
+
 	Scene::Scene() :
+		_transforms(std::make_shared<TransformSystem>()),
 		_objects(std::vector<GameObject::Sptr>()),
 		_deletionQueue(std::vector<std::weak_ptr<GameObject>>()),
 		Lights(std::vector<Light>()),
@@ -31,7 +89,14 @@ namespace Gameplay {
 		_skyboxMesh(nullptr),
 		_skyboxTexture(nullptr),
 		_skyboxRotation(glm::mat3(1.0f)),
-		_gravity(glm::vec3(0.0f, 0.0f, -9.81f))
+		_gravity(glm::vec3(0.0f, 0.0f, -9.81f)),
+		_useFixedTimestep(true),
+		_physicsTimestep(1.0f / DEFAULT_PHYSICS_RATE),
+		_maxPhysicsSubSteps(DEFAULT_MAX_PHYSICS_SUBSTEPS),
+		_physicsAccumulator(0.0f),
+		_useMultithreadedPhysics(false),
+		_solverPool(nullptr),
+		_triggerEvents(std::make_shared<Physics::TriggerEventTracker>())
 	{
 		_lightingUbo = std::make_shared<UniformBuffer<LightingUboStruct>>();
 		_lightingUbo->GetData().AmbientCol = glm::vec3(0.1f);
@@ -64,6 +129,55 @@ namespace Gameplay {
 		return (BulletDebugMode)_bulletDebugDraw->getDebugMode();
 	}
 
+	void Scene::SetFixedPhysicsTimestep(bool enabled) {
+		_useFixedTimestep = enabled;
+		_physicsAccumulator = 0.0f;
+	}
+
+	bool Scene::IsFixedPhysicsTimestep() const {
+		return _useFixedTimestep;
+	}
+
+	void Scene::SetPhysicsTimestep(float seconds) {
+		LOG_ASSERT(seconds > 0.0f, "Physics timestep must be greater than zero!");
+		_physicsTimestep = seconds;
+	}
+
+	float Scene::GetPhysicsTimestep() const {
+		return _physicsTimestep;
+	}
+
+	void Scene::SetMaxPhysicsSubSteps(int value) {
+		LOG_ASSERT(value > 0, "Must allow at least one physics step per frame!");
+		_maxPhysicsSubSteps = value;
+	}
+
+	int Scene::GetMaxPhysicsSubSteps() const {
+		return _maxPhysicsSubSteps;
+	}
+
+	void Scene::SetMultithreadedPhysics(bool enabled) {
+		if (_useMultithreadedPhysics == enabled) {
+			return;
+		}
+		_useMultithreadedPhysics = enabled;
+
+#if BT_THREADSAFE
+		_RebuildPhysicsWorld();
+#else
+		// Note that we still store (and save) the flag here, so it's a request for the threaded world rather
+		// than the world we're actually using. That way a scene saved from this build will still get the
+		// threaded world when it's loaded by a build that has BT_THREADSAFE
+		if (enabled) {
+			LOG_WARN("Bullet was built without BT_THREADSAFE, the scene will use the single threaded physics world");
+		}
+#endif
+	}
+
+	bool Scene::IsMultithreadedPhysics() const {
+		return _useMultithreadedPhysics;
+	}
+
 	void Scene::SetSkyboxShader(const std::shared_ptr<ShaderProgram>& shader) {
 		_skyboxShader = shader;
 	}
@@ -100,7 +214,7 @@ namespace Gameplay {
 
 	GameObject::Sptr Scene::CreateGameObject(const std::string& name)
 	{
-		GameObject::Sptr result(new GameObject());
+		GameObject::Sptr result(new GameObject(this));
 		result->Name = name;
 		result->_scene = this;
 		result->_selfRef = result;
@@ -162,24 +276,82 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
-		_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-			body->PhysicsPreStep(dt);
+		// While editing, we still need to push any changes to our bodies through to Bullet
+		if (!IsPlaying) {
+			_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody& body) {
+				body.PhysicsPreStep(dt);
+			});
+			_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume& body) {
+				body.PhysicsPreStep(dt);
+			});
+			_physicsAccumulator = 0.0f;
+			return;
+		}
+
+		// Variable timestep, step by however long the last frame took
+		if (!_useFixedTimestep) {
+			_StepPhysics(dt);
+			_components.Each<Gameplay::Physics::RigidBody>([](Gameplay::Physics::RigidBody& body) {
+				body.PhysicsInterpolate(1.0f);
+			});
+			return;
+		}
+
+		// Only ever step the world by the fixed timestep, carrying any left over time into the next frame
+		_physicsAccumulator += dt;
+		int numSteps = 0;
+		while (_physicsAccumulator >= _physicsTimestep && numSteps < _maxPhysicsSubSteps) {
+			_StepPhysics(_physicsTimestep);
+			_physicsAccumulator -= _physicsTimestep;
+			numSteps++;
+		}
+
+		// If we hit the step cap, drop the time we couldn't simulate rather than trying to catch
+		// up next frame, which would make the next frame even slower
+		if (_physicsAccumulator >= _physicsTimestep) {
+			_physicsAccumulator = std::fmod(_physicsAccumulator, _physicsTimestep);
+		}
+
+		// Render bodies part way between their last two physics states, based on the time left over
+		float alpha = _physicsAccumulator / _physicsTimestep;
+		_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody& body) {
+			body.PhysicsInterpolate(alpha);
 		});
-		_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-			body->PhysicsPreStep(dt);
+	}
+
+	void Scene::_StepPhysics(float dt) {
+		_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody& body) {
+			body.PhysicsPreStep(dt);
+		});
+		_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume& body) {
+			body.PhysicsPreStep(dt);
 		});
 
-		if (IsPlaying) {
+		// A max sub step count of 0 tells Bullet to take exactly one step of length dt
+		_physicsWorld->stepSimulation(dt, 0);
 
-			_physicsWorld->stepSimulation(dt, 1);
+		_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody& body) {
+			body.PhysicsPostStep(dt);
+		});
 
-			_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-				body->PhysicsPostStep(dt);
-			});
-			_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-				body->PhysicsPostStep(dt);
-			});
+		// Trigger volumes don't need a post step, all their overlaps are gathered at once
+		_triggerEvents->Update(_physicsWorld);
+	}
+
+	void Scene::_LoadPhysicsSettings(bool useFixedTimestep, float timestep, int maxSubSteps) {
+		// A zero or NaN timestep would make the accumulator loop divide by zero, so fall back to the defaults
+		if (!std::isfinite(timestep) || timestep <= 0.0f) {
+			LOG_WARN("Scene has an invalid physics timestep ({}), using the default", timestep);
+			timestep = 1.0f / DEFAULT_PHYSICS_RATE;
+		}
+		if (maxSubSteps < 1) {
+			LOG_WARN("Scene has an invalid max physics sub step count ({}), using the default", maxSubSteps);
+			maxSubSteps = DEFAULT_MAX_PHYSICS_SUBSTEPS;
 		}
+
+		SetFixedPhysicsTimestep(useFixedTimestep);
+		SetPhysicsTimestep(timestep);
+		SetMaxPhysicsSubSteps(maxSubSteps);
 	}
 
 	void Scene::DrawPhysicsDebug() {
@@ -192,11 +364,34 @@ namespace Gameplay {
 	void Scene::Update(float dt) {
 		_FlushDeleteQueue();
 		if (IsPlaying) {
+			// Components that have not opted into parallel updates run on the main thread first
 			for (auto& obj : _objects) {
-				obj->Update(dt);
+				obj->_UpdateComponents(dt, false);
+			}
+
+			// Resolve all world matrices up front, so that workers never have to resolve (and write to) a
+			// parent's transform that another worker may be reading
+			_transforms->BeginParallelUpdate();
+
+			// Parallel components only touch their own object, so we can split objects between workers.
+			// ParallelFor blocks until all jobs are done, so this acts as our barrier before physics
+			JobSystem::ParallelFor(_objects.size(), PARALLEL_UPDATE_GRAIN_SIZE, [&](size_t start, size_t end) {
+				for (size_t ix = start; ix < end; ix++) {
+					_objects[ix]->_UpdateComponents(dt, true);
+				}
+			});
+			_transforms->EndParallelUpdate();
+
+			// Clean up any children that were deleted during the update
+			for (auto& obj : _objects) {
+				obj->_FinishUpdate();
 			}
 		}
 		_FlushDeleteQueue();
+
+		// Recalculate all dirty world matrices in one pass, so that physics and rendering don't
+		// have to resolve them one object at a time
+		_transforms->Update();
 	}
 
 	void Scene::PreRender() {
@@ -261,6 +456,15 @@ namespace Gameplay {
 			result->SetAmbientLight((data["ambient"]));
 		}
 
+		if (data.contains("physics") && data["physics"].is_object()) {
+			const nlohmann::json& physics = data["physics"];
+			result->_LoadPhysicsSettings(
+				physics.value("fixed_timestep", result->_useFixedTimestep),
+				physics.value("timestep", result->_physicsTimestep),
+				physics.value("max_substeps", result->_maxPhysicsSubSteps));
+			result->SetMultithreadedPhysics(physics.value("multithreaded", false));
+		}
+
 		if (data.contains("skybox") && data["skybox"].is_object()) {
 			nlohmann::json& blob = data["skybox"].get<nlohmann::json>();
 			result->_skyboxMesh = ResourceManager::Get<MeshResource>(Guid(blob["mesh"]));
@@ -306,6 +510,12 @@ namespace Gameplay {
 
 		blob["ambient"] = GetAmbientLight();
 
+		blob["physics"] = nlohmann::json();
+		blob["physics"]["fixed_timestep"] = _useFixedTimestep;
+		blob["physics"]["timestep"] = _physicsTimestep;
+		blob["physics"]["max_substeps"] = _maxPhysicsSubSteps;
+		blob["physics"]["multithreaded"] = _useMultithreadedPhysics;
+
 		blob["skybox"] = nlohmann::json();
 		blob["skybox"]["mesh"] = _skyboxMesh ? _skyboxMesh->GetGUID().str() : "null";
 		blob["skybox"]["shader"] = _skyboxShader ? _skyboxShader->GetGUID().str() : "null";
@@ -351,6 +561,244 @@ namespace Gameplay {
 		return result;
 	}
 
+	void Scene::SaveBinary(const std::string& path) {
+		_filePath = path;
+		float startTime = static_cast<float>(glfwGetTime());
+
+		// Strings are stored once in a table, and referenced by their index
+		std::vector<std::string> strings;
+		std::unordered_map<std::string, uint32_t> stringLookup;
+		auto addString = [&](const std::string& value) {
+			auto it = stringLookup.find(value);
+			if (it != stringLookup.end()) {
+				return it->second;
+			}
+			uint32_t index = static_cast<uint32_t>(strings.size());
+			strings.push_back(value);
+			stringLookup[value] = index;
+			return index;
+		};
+
+		// Every object's GUID goes into the GUID table at the same index as the object
+		std::vector<Guid> guids(_objects.size());
+		std::unordered_map<Guid, uint32_t> guidLookup;
+		for (size_t ix = 0; ix < _objects.size(); ix++) {
+			guids[ix] = _objects[ix]->GetGUID();
+			guidLookup[guids[ix]] = static_cast<uint32_t>(ix);
+		}
+
+		// Converting components to JSON is the slowest part of saving, and each object is independent
+		std::vector<std::vector<std::pair<std::string, std::vector<uint8_t>>>> componentData(_objects.size());
+		JobSystem::ParallelFor(_objects.size(), 64, [&](size_t start, size_t end) {
+			for (size_t ix = start; ix < end; ix++) {
+				for (const IComponent::Sptr& component : _objects[ix]->_components) {
+					nlohmann::json blob = component->ToJson();
+					IComponent::SaveBaseJson(component, blob);
+					componentData[ix].emplace_back(component->ComponentTypeName(), nlohmann::json::to_msgpack(blob));
+				}
+			}
+		});
+
+		// Build our object table, and group the components by type. The groups are sorted by type name
+		std::vector<BinarySceneObject> objects(_objects.size());
+		std::map<std::string, BinarySceneComponents> components;
+		for (size_t ix = 0; ix < _objects.size(); ix++) {
+			const GameObject::Sptr& object = _objects[ix];
+			GameObject::Sptr parent = object->_parent;
+			auto parentIt = parent != nullptr ? guidLookup.find(parent->GetGUID()) : guidLookup.end();
+
+			BinarySceneObject& entry = objects[ix];
+			entry.Name            = addString(object->Name);
+			entry.Guid            = static_cast<uint32_t>(ix);
+			entry.Parent          = parentIt != guidLookup.end() ? static_cast<int32_t>(parentIt->second) : -1;
+			entry.Position        = object->GetPosition();
+			entry.Rotation        = object->GetRotation();
+			entry.Scale           = object->GetScale();
+			entry.HideInHierarchy = object->HideInHierarchy;
+
+			for (auto& [typeName, data] : componentData[ix]) {
+				BinarySceneComponents& group = components[typeName];
+				if (group.Offsets.empty()) {
+					group.TypeName = addString(typeName);
+					group.Offsets.push_back(0);
+				}
+				group.Objects.push_back(static_cast<uint32_t>(ix));
+				group.Data.insert(group.Data.end(), data.begin(), data.end());
+				group.Offsets.push_back(group.Data.size());
+			}
+		}
+
+		std::vector<BinarySceneComponents> componentGroups;
+		componentGroups.reserve(components.size());
+		for (auto& [typeName, group] : components) {
+			componentGroups.push_back(std::move(group));
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file) {
+			LOG_ERROR("Failed to open \"{}\" for writing", path);
+			return;
+		}
+
+		// Resources are referenced by GUID, an invalid GUID stands in for a missing resource
+		cereal::BinaryOutputArchive archive(file);
+		archive(cereal::binary_data(BINARY_SCENE_HEADER, sizeof(BINARY_SCENE_HEADER)), BINARY_SCENE_VERSION);
+		archive(
+			DefaultMaterial ? DefaultMaterial->GetGUID() : Guid(),
+			GetAmbientLight(),
+			_skyboxMesh ? _skyboxMesh->GetGUID() : Guid(),
+			_skyboxShader ? _skyboxShader->GetGUID() : Guid(),
+			_skyboxTexture ? _skyboxTexture->GetGUID() : Guid(),
+			(glm::quat)_skyboxRotation,
+			MainCamera != nullptr ? MainCamera->GetGUID() : Guid()
+		);
+		archive(_useFixedTimestep, _physicsTimestep, _maxPhysicsSubSteps, _useMultithreadedPhysics);
+		archive(strings, guids, objects, componentGroups, Lights);
+
+		float endTime = static_cast<float>(glfwGetTime());
+		LOG_INFO("Saved scene to \"{}\" in {} seconds", path, endTime - startTime);
+	}
+
+	Scene::Sptr Scene::LoadBinary(const std::string& path)
+	{
+		LOG_INFO("Loading scene from \"{}\"", path);
+		float startTime = static_cast<float>(glfwGetTime());
+
+		// Read through the virtual file system, so that scenes can come from mounted asset packs
+		std::string contents;
+		if (!VirtualFileSystem::ReadFile(path, contents)) {
+			LOG_ERROR("Failed to open \"{}\"", path);
+			return nullptr;
+		}
+		std::istringstream file(contents, std::ios::binary);
+
+		Guid defaultMaterial, skyboxMesh, skyboxShader, skyboxTexture, mainCamera;
+		glm::vec3 ambient;
+		glm::quat skyboxRotation;
+		bool useFixedTimestep = true;
+		float physicsTimestep = 1.0f / DEFAULT_PHYSICS_RATE;
+		int maxPhysicsSubSteps = DEFAULT_MAX_PHYSICS_SUBSTEPS;
+		bool useMultithreadedPhysics = false;
+		std::vector<std::string> strings;
+		std::vector<Guid> guids;
+		std::vector<BinarySceneObject> objects;
+		std::vector<BinarySceneComponents> componentGroups;
+		std::vector<Light> lights;
+
+		// Cereal throws if it runs out of data, which we treat the same as any other invalid file
+		try {
+			cereal::BinaryInputArchive archive(file);
+
+			char header[sizeof(BINARY_SCENE_HEADER)];
+			uint16_t version = 0;
+			archive(cereal::binary_data(header, sizeof(header)), version);
+			if (memcmp(header, BINARY_SCENE_HEADER, sizeof(header)) != 0) {
+				LOG_ERROR("\"{}\" is not a binary scene file!", path);
+				return nullptr;
+			}
+			if (version != BINARY_SCENE_VERSION) {
+				LOG_ERROR("Unsupported binary scene version {} in \"{}\"", version, path);
+				return nullptr;
+			}
+
+			archive(defaultMaterial, ambient, skyboxMesh, skyboxShader, skyboxTexture, skyboxRotation, mainCamera);
+			archive(useFixedTimestep, physicsTimestep, maxPhysicsSubSteps, useMultithreadedPhysics);
+			archive(strings, guids, objects, componentGroups, lights);
+		}
+		catch (const cereal::Exception& e) {
+			LOG_ERROR("Failed to read binary scene \"{}\": {}", path, e.what());
+			return nullptr;
+		}
+
+		// Make sure every index in the file is in range before we start building the scene
+		bool valid = true;
+		for (const BinarySceneObject& object : objects) {
+			valid &= object.Name < strings.size() && object.Guid < guids.size() && object.Parent < (int32_t)guids.size();
+		}
+		for (const BinarySceneComponents& group : componentGroups) {
+			valid &= group.TypeName < strings.size() && group.Offsets.size() == group.Objects.size() + 1;
+			for (size_t ix = 0; valid && ix < group.Objects.size(); ix++) {
+				valid &= group.Objects[ix] < objects.size() && group.Offsets[ix] <= group.Offsets[ix + 1] && group.Offsets[ix + 1] <= group.Data.size();
+			}
+		}
+		if (!valid) {
+			LOG_ERROR("Binary scene \"{}\" is corrupt!", path);
+			return nullptr;
+		}
+
+		// Decode each component's JSON across the job system, this does not touch the scene
+		std::vector<std::vector<nlohmann::json>> componentData(componentGroups.size());
+		for (size_t groupIx = 0; groupIx < componentGroups.size(); groupIx++) {
+			const BinarySceneComponents& group = componentGroups[groupIx];
+			std::vector<nlohmann::json>& data = componentData[groupIx];
+			data.resize(group.Objects.size());
+			JobSystem::ParallelFor(group.Objects.size(), 64, [&](size_t start, size_t end) {
+				for (size_t ix = start; ix < end; ix++) {
+					const uint8_t* dataBegin = group.Data.data() + group.Offsets[ix];
+					const uint8_t* dataEnd = group.Data.data() + group.Offsets[ix + 1];
+					data[ix] = nlohmann::json::from_msgpack(dataBegin, dataEnd);
+				}
+			});
+		}
+
+		Scene::Sptr result = std::make_shared<Scene>();
+		result->MainCamera = nullptr;
+		result->_objects.clear();
+		result->DefaultMaterial = ResourceManager::Get<Material>(defaultMaterial);
+		result->SetAmbientLight(ambient);
+		result->_skyboxMesh = ResourceManager::Get<MeshResource>(skyboxMesh);
+		result->SetSkyboxShader(ResourceManager::Get<ShaderProgram>(skyboxShader));
+		result->SetSkyboxTexture(ResourceManager::Get<TextureCube>(skyboxTexture));
+		result->SetSkyboxRotation(glm::mat3_cast(skyboxRotation));
+		result->_LoadPhysicsSettings(useFixedTimestep, physicsTimestep, maxPhysicsSubSteps);
+		result->SetMultithreadedPhysics(useMultithreadedPhysics);
+
+		// Create all our objects
+		result->_objects.reserve(objects.size());
+		for (const BinarySceneObject& object : objects) {
+			// We need to manually construct since the GameObject constructor is protected
+			GameObject::Sptr obj(new GameObject(result.get()));
+			obj->Name = strings[object.Name];
+			obj->OverrideGUID(guids[object.Guid]);
+			obj->_parent = GameObject::WeakRef(object.Parent >= 0 ? guids[object.Parent] : Guid(), result.get());
+			obj->SetPostion(object.Position);
+			obj->SetRotation(object.Rotation);
+			obj->SetScale(object.Scale);
+			obj->HideInHierarchy = object.HideInHierarchy;
+			obj->_selfRef = obj;
+			result->_objects.push_back(obj);
+		}
+
+		// Attach components object by object, in type name order, to match the order the JSON loader uses
+		std::vector<std::vector<std::pair<uint32_t, uint32_t>>> objectComponents(objects.size());
+		for (size_t groupIx = 0; groupIx < componentGroups.size(); groupIx++) {
+			const BinarySceneComponents& group = componentGroups[groupIx];
+			for (size_t ix = 0; ix < group.Objects.size(); ix++) {
+				objectComponents[group.Objects[ix]].emplace_back(static_cast<uint32_t>(groupIx), static_cast<uint32_t>(ix));
+			}
+		}
+		for (size_t ix = 0; ix < objects.size(); ix++) {
+			for (const auto& [groupIx, componentIx] : objectComponents[ix]) {
+				result->_objects[ix]->_LoadComponent(strings[componentGroups[groupIx].TypeName], componentData[groupIx][componentIx]);
+			}
+		}
+
+		// Re-build the parent hierarchy
+		for (const auto& object : result->_objects) {
+			if (object->GetParent() != nullptr) {
+				object->GetParent()->AddChild(object);
+			}
+		}
+
+		result->Lights = std::move(lights);
+		result->MainCamera = result->_components.GetComponentByGUID<Camera>(mainCamera);
+		result->_filePath = path;
+
+		float endTime = static_cast<float>(glfwGetTime());
+		LOG_INFO("Loaded {} objects from \"{}\" in {} seconds", objects.size(), path, endTime - startTime);
+		return result;
+	}
+
 	int Scene::NumObjects() const {
 		return static_cast<int>(_objects.size());
 	}
@@ -360,19 +808,51 @@ namespace Gameplay {
 	}
 
 	void Scene::_InitPhysics() {
-		_collisionConfig = new btDefaultCollisionConfiguration();
-		_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
-		_broadphaseInterface = new btDbvtBroadphase();
-		_ghostCallback = new btGhostPairCallback();
-		_broadphaseInterface->getOverlappingPairCache()->setInternalGhostPairCallback(_ghostCallback);
-		_constraintSolver = new btSequentialImpulseConstraintSolver();
-		_physicsWorld = new btDiscreteDynamicsWorld(
-			_collisionDispatcher,
-			_broadphaseInterface,
-			_constraintSolver,
-			_collisionConfig
-		);
+#if BT_THREADSAFE
+		if (_useMultithreadedPhysics) {
+			// Bullet's parallel loops will run on our job system's threads
+			Physics::PhysicsTaskScheduler::Install();
+			int numThreads = Physics::PhysicsTaskScheduler::Get().getNumThreads();
+
+			// Scenes that want threaded physics tend to have a lot of bodies, so start with bigger pools
+			btDefaultCollisionConstructionInfo constructionInfo;
+			constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 80000;
+			constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
+			_collisionConfig = new btDefaultCollisionConfiguration(constructionInfo);
+			_collisionDispatcher = new btCollisionDispatcherMt(_collisionConfig, 40);
+			_broadphaseInterface = new btDbvtBroadphase();
+			_ghostCallback = new btGhostPairCallback();
+			_broadphaseInterface->getOverlappingPairCache()->setInternalGhostPairCallback(_ghostCallback);
+			// Small islands are solved in parallel by the pool, large islands by the threaded solver
+			_solverPool = new btConstraintSolverPoolMt(numThreads);
+			_constraintSolver = new btSequentialImpulseConstraintSolverMt();
+			_physicsWorld = new btDiscreteDynamicsWorldMt(
+				_collisionDispatcher,
+				_broadphaseInterface,
+				_solverPool,
+				_constraintSolver,
+				_collisionConfig
+			);
+		} else
+#endif
+		{
+			_collisionConfig = new btDefaultCollisionConfiguration();
+			_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
+			_broadphaseInterface = new btDbvtBroadphase();
+			_ghostCallback = new btGhostPairCallback();
+			_broadphaseInterface->getOverlappingPairCache()->setInternalGhostPairCallback(_ghostCallback);
+			_solverPool = nullptr;
+			_constraintSolver = new btSequentialImpulseConstraintSolver();
+			_physicsWorld = new btDiscreteDynamicsWorld(
+				_collisionDispatcher,
+				_broadphaseInterface,
+				_constraintSolver,
+				_collisionConfig
+			);
+		}
 		_physicsWorld->setGravity(ToBt(_gravity));
+		// Only recalculate bounds for objects that are awake, so that sleeping bodies cost us nothing
+		_physicsWorld->setForceUpdateAllAabbs(false);
 		// TODO bullet debug drawing
 		_bulletDebugDraw = new BulletDebugDraw();
 		_physicsWorld->setDebugDrawer(_bulletDebugDraw);
@@ -380,14 +860,63 @@ namespace Gameplay {
 	}
 
 	void Scene::_CleanupPhysics() {
+		_triggerEvents->Clear();
 		delete _physicsWorld;
+#if BT_THREADSAFE
+		delete _solverPool;
+#endif
+		_solverPool = nullptr;
 		delete _constraintSolver;
 		delete _broadphaseInterface;
 		delete _ghostCallback;
 		delete _collisionDispatcher;
 		delete _collisionConfig;
-	}
+		delete _bulletDebugDraw;
+	}
+
+
+	void Scene::_RebuildPhysicsWorld() {
+		// Bodies and triggers add themselves to the world when they wake up, so we need to pull them out of
+		// the old world (remembering their filters) and put them into the new one ourselves
+		struct WorldObject {
+			btCollisionObject* Object;
+			int                Group;
+			int                Mask;
+		};
+		std::vector<WorldObject> objects;
+		btCollisionObjectArray& worldObjects = _physicsWorld->getCollisionObjectArray();
+		objects.reserve(worldObjects.size());
+		for (int ix = worldObjects.size() - 1; ix >= 0; ix--) {
+			btCollisionObject* object = worldObjects[ix];
+			btBroadphaseProxy* proxy = object->getBroadphaseHandle();
+			objects.push_back({ object, proxy->m_collisionFilterGroup, proxy->m_collisionFilterMask });
+
+			btRigidBody* body = btRigidBody::upcast(object);
+			if (body != nullptr) {
+				_physicsWorld->removeRigidBody(body);
+			} else {
+				_physicsWorld->removeCollisionObject(object);
+			}
+		}
+
+		// The debug drawer gets recreated with the world, so hang on to what we were drawing
+		int debugMode = _bulletDebugDraw->getDebugMode();
 
+		_CleanupPhysics();
+		_InitPhysics();
+
+		_bulletDebugDraw->setDebugMode(debugMode);
+
+		// Add them back in the order they were originally added
+		for (auto it = objects.rbegin(); it != objects.rend(); it++) {
+			btRigidBody* body = btRigidBody::upcast(it->Object);
+			if (body != nullptr) {
+				_physicsWorld->addRigidBody(body, it->Group, it->Mask);
+			} else {
+				_physicsWorld->addCollisionObject(it->Object, it->Group, it->Mask);
+			}
+		}
+	}
 
 	void Scene::_FlushDeleteQueue() {
 		for (auto& weakPtr : _deletionQueue) {
@@ -12,6 +12,7 @@
 #include "Graphics/Textures/Texture3D.h"
 
 struct GLFWwindow;
+class btConstraintSolverPoolMt;
 
 class TextureCube;
 class ShaderProgram;
@@ -24,6 +25,7 @@ const int LIGHT_UBO_BINDING_SLOT = 0;
 namespace Gameplay {
 	namespace Physics {
 		class RigidBody;
+		class TriggerEventTracker;
 	}
 
 	class MeshResource;
@@ -40,6 +42,12 @@ namespace Gameplay {
 
 		static const int MAX_LIGHTS = 8;
 		static const int LIGHT_UBO_BINDING = 2;
+		// The number of objects to hand to each job when performing parallel updates
+		static const size_t PARALLEL_UPDATE_GRAIN_SIZE = 256;
+		// The default rate that physics is stepped at when using a fixed timestep, in steps per second
+		static constexpr float DEFAULT_PHYSICS_RATE = 60.0f;
+		// The default cap on how many fixed steps we will take in a single frame
+		static const int DEFAULT_MAX_PHYSICS_SUBSTEPS = 4;
 
 		// Stores all the lights in our scene
 		std::vector<Light>         Lights;
@@ -59,6 +67,58 @@ namespace Gameplay {
 		void SetPhysicsDebugDrawMode(BulletDebugMode mode);
 		BulletDebugMode GetPhysicsDebugDrawMode() const;
 
+		/// <summary>
+		/// Enables or disables fixed timestep physics. When enabled, the physics world is only ever stepped
+		/// forward by the fixed timestep, so the simulation does not depend on the frame rate, and dynamic
+		/// bodies are rendered by interpolating between their last two physics states
+		/// When disabled, the world is stepped once per frame by the frame's delta time
+		/// </summary>
+		/// <param name="enabled">True to use a fixed timestep, false to step by the frame time</param>
+		void SetFixedPhysicsTimestep(bool enabled);
+		/// <summary>
+		/// Returns true if the physics world is being stepped with a fixed timestep
+		/// </summary>
+		bool IsFixedPhysicsTimestep() const;
+		/// <summary>
+		/// Sets the length of a single fixed physics step
+		/// </summary>
+		/// <param name="seconds">The timestep in seconds, ex: 1/60 for 60 steps per second</param>
+		void SetPhysicsTimestep(float seconds);
+		/// <summary>
+		/// Gets the length of a single fixed physics step, in seconds
+		/// </summary>
+		float GetPhysicsTimestep() const;
+		/// <summary>
+		/// Sets the most fixed steps that will be taken in a single frame. If a frame takes longer than
+		/// this many steps, the extra time is dropped and the simulation will run slower than real time
+		/// rather than spiralling into longer and longer frames
+		/// </summary>
+		/// <param name="value">The maximum number of steps per frame, must be at least 1</param>
+		void SetMaxPhysicsSubSteps(int value);
+		/// <summary>
+		/// Gets the most fixed steps that will be taken in a single frame
+		/// </summary>
+		int GetMaxPhysicsSubSteps() const;
+
+		/// <summary>
+		/// Sets whether the scene should use Bullet's multithreaded dynamics world, which splits collision
+		/// detection, island solving and integration across the job system's threads. This pays off for
+		/// scenes with thousands of bodies, but adds overhead for small scenes
+		/// 
+		/// Changing this rebuilds the physics world, moving any bodies and triggers that are already
+		/// in the world over to the new one
+		/// 
+		/// The threaded world needs Bullet to be built with BT_THREADSAFE (see BulletThreadSafe in
+		/// Premake5.lua). Without it the setting is still saved with the scene as a request for the
+		/// threaded world, but the single threaded world is used
+		/// </summary>
+		/// <param name="enabled">True to use the multithreaded world, false for the single threaded world</param>
+		void SetMultithreadedPhysics(bool enabled);
+		/// <summary>
+		/// Returns true if the scene is configured to use the multithreaded physics world
+		/// </summary>
+		bool IsMultithreadedPhysics() const;
+
 		void SetSkyboxShader(const std::shared_ptr<ShaderProgram>& shader);
 		std::shared_ptr<ShaderProgram> GetSkyboxShader() const;
 
@@ -130,6 +190,10 @@ namespace Gameplay {
 		/// Performs physics updates for all physics bodies in this scene,
 		/// should be called after Update in the main loop
 		/// 
+		/// When using a fixed timestep, the frame time is added to an accumulator and
+		/// the world is stepped as many times as fits (up to the max sub steps), then
+		/// dynamic bodies are interpolated by whatever time is left over
+		/// 
 		/// Only invokes events if IsPlaying is true
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
@@ -207,6 +271,25 @@ namespace Gameplay {
 		/// <returns>A new scene loaded from the file</returns>
 		static Scene::Sptr Load(const std::string& path);
 
+		/// <summary>
+		/// The file extension used for binary scene files
+		/// </summary>
+		inline static const std::string BINARY_EXTENSION = ".bscn";
+
+		/// <summary>
+		/// Saves this scene to a compact binary file. Names and object GUIDs are stored once in tables and
+		/// referenced by index, and components are grouped by type with their data stored as MessagePack,
+		/// which is much quicker to read and write than the pretty-printed JSON files
+		/// </summary>
+		/// <param name="path">The path of the file to write to</param>
+		void SaveBinary(const std::string& path);
+		/// <summary>
+		/// Loads a scene from a binary file written by SaveBinary
+		/// </summary>
+		/// <param name="path">The path of the file to read from</param>
+		/// <returns>A new scene loaded from the file, or nullptr if the file could not be loaded</returns>
+		static Scene::Sptr LoadBinary(const std::string& path);
+
 
 		int NumObjects() const;
 		GameObject::Sptr GetObjectByIndex(int index) const;
@@ -217,6 +300,8 @@ namespace Gameplay {
 
 		// The component manager will store all components for objects in this scene
 		ComponentManager _components;
+		// Stores the positions, rotations, scales and matrices for all objects in the scene
+		TransformSystem::Sptr _transforms;
 
 		// Bullet physics stuff world
 		btDynamicsWorld*          _physicsWorld;
@@ -228,8 +313,12 @@ namespace Gameplay {
 		btBroadphaseInterface*    _broadphaseInterface;
 		// Resolves contraints (ex: hinge constraints, angle axis, etc...)
 		btConstraintSolver*       _constraintSolver;
+		// Holds a solver per thread for solving islands in parallel, only used by the multithreaded world
+		btConstraintSolverPoolMt* _solverPool;
 		// this is what allows us to get our pairs from the trigger volumes
 		btGhostPairCallback*      _ghostCallback;
+		// Gathers trigger overlaps for the whole scene after each step, and invokes trigger events
+		std::shared_ptr<Physics::TriggerEventTracker> _triggerEvents;
 
 		BulletDebugDraw* _bulletDebugDraw;
 
@@ -239,6 +328,15 @@ namespace Gameplay {
 		// Our physics scene's global gravity, default matches earth's gravity (m/s^2)
 		glm::vec3 _gravity;
 
+		// Fixed timestep configuration, see SetFixedPhysicsTimestep
+		bool      _useFixedTimestep;
+		float     _physicsTimestep;
+		int       _maxPhysicsSubSteps;
+		// The frame time that has not yet been simulated, always less than one timestep between frames
+		float     _physicsAccumulator;
+		// Whether the physics world was (or will be) built with Bullet's multithreaded world
+		bool      _useMultithreadedPhysics;
+
 		// Stores all the objects in our scene
 		std::vector<GameObject::Sptr>  _objects;
 		std::vector<std::weak_ptr<GameObject>>  _deletionQueue;
@@ -293,6 +391,24 @@ namespace Gameplay {
 		/// Handles cleaning up bullet physics for this scene
 		/// </summary>
 		void _CleanupPhysics();
+		/// <summary>
+		/// Replaces the physics world with a new one (ex: after switching between the single and
+		/// multithreaded worlds), moving all the bodies and triggers in the old world into the new one
+		/// </summary>
+		void _RebuildPhysicsWorld();
+		/// <summary>
+		/// Steps the physics world forward once, invoking the pre and post step events on all bodies
+		/// </summary>
+		/// <param name="dt">The time in seconds to step the world forward by</param>
+		void _StepPhysics(float dt);
+		/// <summary>
+		/// Applies the fixed timestep settings read from a scene file, replacing any invalid values with
+		/// the defaults so a bad file can't stall or break the physics step
+		/// </summary>
+		/// <param name="useFixedTimestep">True to use a fixed timestep, false to step by the frame time</param>
+		/// <param name="timestep">The length of a fixed step in seconds, must be finite and greater than zero</param>
+		/// <param name="maxSubSteps">The most fixed steps to take per frame, must be at least 1</param>
+		void _LoadPhysicsSettings(bool useFixedTimestep, float timestep, int maxSubSteps);
 
 		void _FlushDeleteQueue();
 	};
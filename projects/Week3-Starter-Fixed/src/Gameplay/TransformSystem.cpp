@@ -0,0 +1,410 @@
+#include "Gameplay/TransformSystem.h"
+
+#include <algorithm>
+#include <GLM/gtc/matrix_inverse.hpp>
+
+#include "Logging.h"
+
+namespace Gameplay {
+	TransformSystem::TransformSystem() :
+		_isHierarchyDirty(false),
+		_isParallelUpdate(false)
+	{ }
+
+	TransformSystem::Handle TransformSystem::Create() {
+		LOG_ASSERT(!_isParallelUpdate, "Transforms cannot be created during a parallel update!");
+
+		// Re-use old handles where we can to keep the handle table small
+		Handle handle;
+		if (!_freeHandles.empty()) {
+			handle = _freeHandles.back();
+			_freeHandles.pop_back();
+		} else {
+			handle = static_cast<Handle>(_handleToIndex.size());
+			_handleToIndex.push_back(INVALID_INDEX);
+			_firstChildHandles.push_back(INVALID_HANDLE);
+			_nextSiblingHandles.push_back(INVALID_HANDLE);
+			_prevSiblingHandles.push_back(INVALID_HANDLE);
+		}
+
+		// New transforms have no parent, so appending them will never break our ordering
+		uint32_t index = static_cast<uint32_t>(_positions.size());
+		_handleToIndex[handle] = index;
+		_indexToHandle.push_back(handle);
+
+		_positions.push_back(glm::vec3(0.0f));
+		_rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		_scales.push_back(glm::vec3(1.0f));
+		_localTransforms.push_back(glm::mat4(1.0f));
+		_worldTransforms.push_back(glm::mat4(1.0f));
+		_inverseLocalTransforms.push_back(glm::mat4(1.0f));
+		_inverseWorldTransforms.push_back(glm::mat4(1.0f));
+		_flags.push_back(0);
+		_worldVersions.push_back(0);
+		_parentVersions.push_back(0);
+		_localVersions.push_back(0);
+		_parents.push_back(INVALID_INDEX);
+		_parentHandles.push_back(INVALID_HANDLE);
+
+		return handle;
+	}
+
+	void TransformSystem::Destroy(Handle handle) {
+		LOG_ASSERT(handle < _handleToIndex.size() && _handleToIndex[handle] != INVALID_INDEX, "Attempting to destroy an invalid transform handle!");
+		LOG_ASSERT(!_isParallelUpdate, "Transforms cannot be destroyed during a parallel update!");
+		uint32_t index = _handleToIndex[handle];
+
+		if (_parentHandles[index] != INVALID_HANDLE) {
+			_UnlinkChild(handle, _parentHandles[index]);
+		}
+
+		// Any children of the transform become roots, this matches what happens when a parent
+		// game object is deleted. Roots can go anywhere in the arrays, so this doesn't affect our ordering
+		Handle child = _firstChildHandles[handle];
+		while (child != INVALID_HANDLE) {
+			Handle next = _nextSiblingHandles[child];
+			uint32_t childIndex = _handleToIndex[child];
+			_parentHandles[childIndex] = INVALID_HANDLE;
+			_parents[childIndex] = INVALID_INDEX;
+			_flags[childIndex] |= WorldDirty;
+			_nextSiblingHandles[child] = INVALID_HANDLE;
+			_prevSiblingHandles[child] = INVALID_HANDLE;
+			child = next;
+		}
+		_firstChildHandles[handle] = INVALID_HANDLE;
+
+		// Swap the last transform into the removed slot. The last transform can't have any children
+		// after it, so this only breaks our parent-first ordering if it's parent is after the slot
+		uint32_t last = static_cast<uint32_t>(_positions.size() - 1);
+		if (index != last) {
+			_MoveTransform(last, index);
+			if (_parents[index] != INVALID_INDEX && _parents[index] > index) {
+				_isHierarchyDirty = true;
+			}
+		}
+
+		_positions.pop_back();
+		_rotations.pop_back();
+		_scales.pop_back();
+		_localTransforms.pop_back();
+		_worldTransforms.pop_back();
+		_inverseLocalTransforms.pop_back();
+		_inverseWorldTransforms.pop_back();
+		_flags.pop_back();
+		_worldVersions.pop_back();
+		_parentVersions.pop_back();
+		_localVersions.pop_back();
+		_parents.pop_back();
+		_parentHandles.pop_back();
+		_indexToHandle.pop_back();
+
+		_handleToIndex[handle] = INVALID_INDEX;
+		_freeHandles.push_back(handle);
+	}
+
+	void TransformSystem::SetParent(Handle handle, Handle parent) {
+		uint32_t index = _handleToIndex[handle];
+		if (_parentHandles[index] != parent) {
+			LOG_ASSERT(!_isParallelUpdate, "Transforms cannot be re-parented during a parallel update!");
+			if (_parentHandles[index] != INVALID_HANDLE) {
+				_UnlinkChild(handle, _parentHandles[index]);
+			}
+			if (parent != INVALID_HANDLE) {
+				_LinkChild(handle, parent);
+			}
+			_parentHandles[index] = parent;
+			_flags[index] |= WorldDirty;
+
+			// We only need to re-sort if the new parent comes after us
+			if (!_isHierarchyDirty) {
+				uint32_t parentIndex = parent != INVALID_HANDLE ? _handleToIndex[parent] : INVALID_INDEX;
+				if (parentIndex == INVALID_INDEX || parentIndex < index) {
+					_parents[index] = parentIndex;
+				} else {
+					_isHierarchyDirty = true;
+				}
+			}
+		}
+	}
+
+	void TransformSystem::SetPosition(Handle handle, const glm::vec3& value) {
+		uint32_t index = _handleToIndex[handle];
+		_positions[index] = value;
+		_flags[index] |= LocalDirty;
+		_localVersions[index]++;
+	}
+
+	glm::vec3 TransformSystem::GetPosition(Handle handle) const {
+		return _positions[_handleToIndex[handle]];
+	}
+
+	void TransformSystem::SetRotation(Handle handle, const glm::quat& value) {
+		uint32_t index = _handleToIndex[handle];
+		_rotations[index] = value;
+		_flags[index] |= LocalDirty;
+		_localVersions[index]++;
+	}
+
+	glm::quat TransformSystem::GetRotation(Handle handle) const {
+		return _rotations[_handleToIndex[handle]];
+	}
+
+	void TransformSystem::SetScale(Handle handle, const glm::vec3& value) {
+		uint32_t index = _handleToIndex[handle];
+		_scales[index] = value;
+		_flags[index] |= LocalDirty;
+		_localVersions[index]++;
+	}
+
+	glm::vec3 TransformSystem::GetScale(Handle handle) const {
+		return _scales[_handleToIndex[handle]];
+	}
+
+	uint32_t TransformSystem::GetLocalVersion(Handle handle) const {
+		return _localVersions[_handleToIndex[handle]];
+	}
+
+	glm::mat4 TransformSystem::GetLocalTransform(Handle handle) {
+		// Other threads may be resolving our parents, so we can only touch our own transform
+		if (_isParallelUpdate) {
+			uint32_t index = _handleToIndex[handle];
+			_UpdateLocal(index);
+			return _localTransforms[index];
+		}
+
+		RebuildHierarchy();
+		uint32_t index = _handleToIndex[handle];
+		// The local transform doesn't depend on the parent, but resolving it here keeps the flags consistent
+		_ResolveTransform(index);
+		return _localTransforms[index];
+	}
+
+	glm::mat4 TransformSystem::GetInverseLocalTransform(Handle handle) {
+		// Other threads may be resolving our parents, so we can only touch our own transform
+		if (!_isParallelUpdate) {
+			RebuildHierarchy();
+		}
+		uint32_t index = _handleToIndex[handle];
+		if (_isParallelUpdate) {
+			_UpdateLocal(index);
+		} else {
+			_ResolveTransform(index);
+		}
+		if (_flags[index] & InverseLocalDirty) {
+			_inverseLocalTransforms[index] = glm::affineInverse(_localTransforms[index]);
+			_flags[index] &= ~InverseLocalDirty;
+		}
+		return _inverseLocalTransforms[index];
+	}
+
+	glm::mat4 TransformSystem::GetWorldTransform(Handle handle) {
+		// World matrices were all resolved when the parallel update started, and resolving them now
+		// would write to our parents, which other threads may be reading
+		if (_isParallelUpdate) {
+			return _worldTransforms[_handleToIndex[handle]];
+		}
+
+		RebuildHierarchy();
+		uint32_t index = _handleToIndex[handle];
+		_ResolveTransform(index);
+		return _worldTransforms[index];
+	}
+
+	glm::mat4 TransformSystem::GetInverseWorldTransform(Handle handle) {
+		// Same as above, we use the world matrix as it was at the start of the parallel update
+		if (!_isParallelUpdate) {
+			RebuildHierarchy();
+		}
+		uint32_t index = _handleToIndex[handle];
+		if (!_isParallelUpdate) {
+			_ResolveTransform(index);
+		}
+		if (_flags[index] & InverseWorldDirty) {
+			_inverseWorldTransforms[index] = glm::affineInverse(_worldTransforms[index]);
+			_flags[index] &= ~InverseWorldDirty;
+		}
+		return _inverseWorldTransforms[index];
+	}
+
+	void TransformSystem::RebuildHierarchy() {
+		if (!_isHierarchyDirty) {
+			return;
+		}
+		LOG_ASSERT(!_isParallelUpdate, "The transform hierarchy cannot be rebuilt during a parallel update!");
+		uint32_t count = static_cast<uint32_t>(_positions.size());
+
+		// Resolve the parent indices from the handles, parents that no longer exist are treated as roots
+		for (uint32_t ix = 0; ix < count; ix++) {
+			Handle parent = _parentHandles[ix];
+			_parents[ix] = parent != INVALID_HANDLE ? _handleToIndex[parent] : INVALID_INDEX;
+		}
+
+		// Determine the depth of each transform in the hierarchy, memoizing as we go
+		std::vector<uint32_t>& depths = _sortDepths;
+		depths.assign(count, INVALID_INDEX);
+		std::vector<uint32_t> stack;
+		uint32_t maxDepth = 0;
+		for (uint32_t ix = 0; ix < count; ix++) {
+			uint32_t current = ix;
+			while (current != INVALID_INDEX && depths[current] == INVALID_INDEX) {
+				stack.push_back(current);
+				current = _parents[current];
+			}
+			uint32_t depth = current == INVALID_INDEX ? 0 : depths[current] + 1;
+			while (!stack.empty()) {
+				depths[stack.back()] = depth++;
+				stack.pop_back();
+			}
+			maxDepth = std::max(maxDepth, depths[ix]);
+		}
+
+		// Sorting by depth guarantees that parents come before their children. Depths are small, so we
+		// use a counting sort, which also keeps siblings in their relative order
+		std::vector<uint32_t>& offsets = _sortOffsets;
+		offsets.assign(maxDepth + 2, 0);
+		for (uint32_t ix = 0; ix < count; ix++) {
+			offsets[depths[ix] + 1]++;
+		}
+		for (uint32_t depth = 1; depth < offsets.size(); depth++) {
+			offsets[depth] += offsets[depth - 1];
+		}
+		std::vector<uint32_t>& order = _sortOrder;
+		order.resize(count);
+		for (uint32_t ix = 0; ix < count; ix++) {
+			order[offsets[depths[ix]]++] = ix;
+		}
+
+		// Permute the arrays in place, so that re-sorting never reallocates them
+		_sortVisited.resize(count);
+		_ApplyOrder(_positions, order, _sortVisited);
+		_ApplyOrder(_rotations, order, _sortVisited);
+		_ApplyOrder(_scales, order, _sortVisited);
+		_ApplyOrder(_localTransforms, order, _sortVisited);
+		_ApplyOrder(_worldTransforms, order, _sortVisited);
+		_ApplyOrder(_inverseLocalTransforms, order, _sortVisited);
+		_ApplyOrder(_inverseWorldTransforms, order, _sortVisited);
+		_ApplyOrder(_flags, order, _sortVisited);
+		_ApplyOrder(_worldVersions, order, _sortVisited);
+		_ApplyOrder(_parentVersions, order, _sortVisited);
+		_ApplyOrder(_localVersions, order, _sortVisited);
+		_ApplyOrder(_parentHandles, order, _sortVisited);
+		_ApplyOrder(_indexToHandle, order, _sortVisited);
+
+		// Update our lookups to point to the new locations
+		for (uint32_t ix = 0; ix < count; ix++) {
+			_handleToIndex[_indexToHandle[ix]] = ix;
+		}
+		for (uint32_t ix = 0; ix < count; ix++) {
+			Handle parent = _parentHandles[ix];
+			_parents[ix] = parent != INVALID_HANDLE ? _handleToIndex[parent] : INVALID_INDEX;
+		}
+
+		_isHierarchyDirty = false;
+	}
+
+	void TransformSystem::Update() {
+		RebuildHierarchy();
+
+		// Since parents are always before children, a single forward pass handles the whole hierarchy
+		uint32_t count = static_cast<uint32_t>(_positions.size());
+		for (uint32_t ix = 0; ix < count; ix++) {
+			_UpdateTransform(ix);
+		}
+	}
+
+	void TransformSystem::BeginParallelUpdate() {
+		Update();
+		_isParallelUpdate = true;
+	}
+
+	void TransformSystem::EndParallelUpdate() {
+		_isParallelUpdate = false;
+	}
+
+	void TransformSystem::_UpdateLocal(uint32_t index) {
+		uint8_t& flags = _flags[index];
+
+		// Build the TRS matrix directly, rather than multiplying 3 matrices together
+		if (flags & LocalDirty) {
+			glm::mat3 rotation = glm::mat3_cast(_rotations[index]);
+			const glm::vec3& scale = _scales[index];
+			glm::mat4& local = _localTransforms[index];
+			local[0] = glm::vec4(rotation[0] * scale.x, 0.0f);
+			local[1] = glm::vec4(rotation[1] * scale.y, 0.0f);
+			local[2] = glm::vec4(rotation[2] * scale.z, 0.0f);
+			local[3] = glm::vec4(_positions[index], 1.0f);
+			flags = (flags & ~LocalDirty) | InverseLocalDirty | WorldDirty;
+		}
+	}
+
+	void TransformSystem::_UpdateTransform(uint32_t index) {
+		_UpdateLocal(index);
+		uint8_t& flags = _flags[index];
+
+		// Our world matrix needs updating if our local changed, or if our parent has changed since we last updated
+		uint32_t parent = _parents[index];
+		if (parent != INVALID_INDEX) {
+			if ((flags & WorldDirty) || _parentVersions[index] != _worldVersions[parent]) {
+				_worldTransforms[index] = _worldTransforms[parent] * _localTransforms[index];
+				_parentVersions[index] = _worldVersions[parent];
+				_worldVersions[index]++;
+				flags = (flags & ~WorldDirty) | InverseWorldDirty;
+			}
+		} else if (flags & WorldDirty) {
+			_worldTransforms[index] = _localTransforms[index];
+			_worldVersions[index]++;
+			flags = (flags & ~WorldDirty) | InverseWorldDirty;
+		}
+	}
+
+	void TransformSystem::_ResolveTransform(uint32_t index) {
+		uint32_t parent = _parents[index];
+		if (parent != INVALID_INDEX) {
+			_ResolveTransform(parent);
+		}
+		_UpdateTransform(index);
+	}
+
+	void TransformSystem::_MoveTransform(uint32_t from, uint32_t to) {
+		_positions[to] = _positions[from];
+		_rotations[to] = _rotations[from];
+		_scales[to] = _scales[from];
+		_localTransforms[to] = _localTransforms[from];
+		_worldTransforms[to] = _worldTransforms[from];
+		_inverseLocalTransforms[to] = _inverseLocalTransforms[from];
+		_inverseWorldTransforms[to] = _inverseWorldTransforms[from];
+		_flags[to] = _flags[from];
+		_worldVersions[to] = _worldVersions[from];
+		_parentVersions[to] = _parentVersions[from];
+		_localVersions[to] = _localVersions[from];
+		_parents[to] = _parents[from];
+		_parentHandles[to] = _parentHandles[from];
+		_indexToHandle[to] = _indexToHandle[from];
+		_handleToIndex[_indexToHandle[to]] = to;
+	}
+
+	void TransformSystem::_LinkChild(Handle handle, Handle parent) {
+		Handle first = _firstChildHandles[parent];
+		_prevSiblingHandles[handle] = INVALID_HANDLE;
+		_nextSiblingHandles[handle] = first;
+		if (first != INVALID_HANDLE) {
+			_prevSiblingHandles[first] = handle;
+		}
+		_firstChildHandles[parent] = handle;
+	}
+
+	void TransformSystem::_UnlinkChild(Handle handle, Handle parent) {
+		Handle prev = _prevSiblingHandles[handle];
+		Handle next = _nextSiblingHandles[handle];
+		if (prev != INVALID_HANDLE) {
+			_nextSiblingHandles[prev] = next;
+		} else {
+			_firstChildHandles[parent] = next;
+		}
+		if (next != INVALID_HANDLE) {
+			_prevSiblingHandles[next] = prev;
+		}
+		_prevSiblingHandles[handle] = INVALID_HANDLE;
+		_nextSiblingHandles[handle] = INVALID_HANDLE;
+	}
+}
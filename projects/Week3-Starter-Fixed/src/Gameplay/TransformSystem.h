@@ -0,0 +1,214 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include "Utils/Macros.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// Stores the transforms for all game objects in a scene as parallel arrays (structure of arrays),
+	/// sorted so that parents always come before their children. This lets us update every world
+	/// matrix in a single linear pass, instead of chasing pointers up the hierarchy for each object
+	///
+	/// Objects refer to their transform via a stable handle, since the underlying arrays are re-ordered
+	/// whenever the hierarchy changes. For the same reason, the getters return copies rather than
+	/// references into the arrays
+	/// </summary>
+	class TransformSystem {
+	public:
+		typedef std::shared_ptr<TransformSystem> Sptr;
+		typedef uint32_t Handle;
+
+		NO_COPY(TransformSystem)
+		NO_MOVE(TransformSystem)
+
+		/// <summary>
+		/// Represents a handle that does not point to any transform
+		/// </summary>
+		static constexpr Handle INVALID_HANDLE = static_cast<Handle>(-1);
+
+		TransformSystem();
+		~TransformSystem() = default;
+
+		/// <summary>
+		/// Creates a new identity transform with no parent
+		/// </summary>
+		/// <returns>The handle for the new transform</returns>
+		Handle Create();
+		/// <summary>
+		/// Releases a transform, any children of the transform will become root transforms
+		/// </summary>
+		/// <param name="handle">The handle of the transform to release</param>
+		void Destroy(Handle handle);
+
+		/// <summary>
+		/// Sets the parent of a given transform, pass INVALID_HANDLE to make the transform a root
+		/// </summary>
+		/// <param name="handle">The transform to re-parent</param>
+		/// <param name="parent">The new parent transform, or INVALID_HANDLE</param>
+		void SetParent(Handle handle, Handle parent);
+
+		void SetPosition(Handle handle, const glm::vec3& value);
+		glm::vec3 GetPosition(Handle handle) const;
+
+		void SetRotation(Handle handle, const glm::quat& value);
+		glm::quat GetRotation(Handle handle) const;
+
+		void SetScale(Handle handle, const glm::vec3& value);
+		glm::vec3 GetScale(Handle handle) const;
+
+		/// <summary>
+		/// Gets a counter that is incremented every time the position, rotation or scale of the
+		/// given transform is set. Systems that mirror transforms elsewhere (ex: physics) can store
+		/// this and compare against it to cheaply tell if the transform has been changed since
+		/// </summary>
+		uint32_t GetLocalVersion(Handle handle) const;
+
+		/// <summary>
+		/// Gets the local transform for the given handle, recalculating it if required
+		/// </summary>
+		glm::mat4 GetLocalTransform(Handle handle);
+		/// <summary>
+		/// Gets the inverse of the local transform for the given handle, inverses are only
+		/// calculated when they are requested
+		/// </summary>
+		glm::mat4 GetInverseLocalTransform(Handle handle);
+		/// <summary>
+		/// Gets the world transform for the given handle, recalculating it and any dirty
+		/// parents if required
+		/// </summary>
+		glm::mat4 GetWorldTransform(Handle handle);
+		/// <summary>
+		/// Gets the inverse of the world transform for the given handle, inverses are only
+		/// calculated when they are requested
+		/// </summary>
+		glm::mat4 GetInverseWorldTransform(Handle handle);
+
+		/// <summary>
+		/// Re-sorts the transforms if the hierarchy has changed since the last call. This is
+		/// handled automatically, but should be called before reading transforms from multiple
+		/// threads so that the sort does not happen on a worker
+		/// </summary>
+		void RebuildHierarchy();
+
+		/// <summary>
+		/// Recalculates all dirty local and world matrices in a single pass over the arrays
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// Starts a parallel update, where each transform may be modified and read by a different thread.
+		/// All world matrices are brought up to date first, then until EndParallelUpdate is called:
+		///   - The world matrix getters return the matrices as they were at the start of the update, they
+		///     will not reflect changes made by the update until after EndParallelUpdate
+		///   - Getters only ever write to the transform they were called for, never to it's parents
+		///   - Creating, destroying and re-parenting transforms is not allowed
+		/// </summary>
+		void BeginParallelUpdate();
+		/// <summary>
+		/// Ends a parallel update started with BeginParallelUpdate
+		/// </summary>
+		void EndParallelUpdate();
+
+		/// <summary>
+		/// Gets the number of transforms that are currently alive
+		/// </summary>
+		size_t Count() const { return _positions.size(); }
+
+	private:
+		// Per-transform state bits
+		enum Flags : uint8_t {
+			LocalDirty        = 1 << 0,
+			WorldDirty        = 1 << 1,
+			InverseLocalDirty = 1 << 2,
+			InverseWorldDirty = 1 << 3,
+		};
+
+		static constexpr uint32_t INVALID_INDEX = static_cast<uint32_t>(-1);
+
+		// Local TRS values
+		std::vector<glm::vec3> _positions;
+		std::vector<glm::quat> _rotations;
+		std::vector<glm::vec3> _scales;
+
+		// Cached matrices, inverses are only valid if their dirty flag is not set
+		std::vector<glm::mat4> _localTransforms;
+		std::vector<glm::mat4> _worldTransforms;
+		std::vector<glm::mat4> _inverseLocalTransforms;
+		std::vector<glm::mat4> _inverseWorldTransforms;
+
+		std::vector<uint8_t>   _flags;
+		// Incremented each time a world matrix changes, children compare against the version they
+		// were last built from to know if their parent has moved
+		std::vector<uint32_t>  _worldVersions;
+		std::vector<uint32_t>  _parentVersions;
+		// Incremented each time the local TRS values are set, see GetLocalVersion
+		std::vector<uint32_t>  _localVersions;
+
+		// The parent of each transform, as an index into the arrays (only valid when the hierarchy
+		// is not dirty) and as a handle
+		std::vector<uint32_t>  _parents;
+		std::vector<Handle>    _parentHandles;
+
+		// Mapping between stable handles and indices in the arrays
+		std::vector<Handle>    _indexToHandle;
+		std::vector<uint32_t>  _handleToIndex;
+		std::vector<Handle>    _freeHandles;
+
+		// Links between each transform and it's children, indexed by handle so that they don't need
+		// to be re-ordered along with the arrays. Lets us find a transform's children without
+		// searching every transform
+		std::vector<Handle>    _firstChildHandles;
+		std::vector<Handle>    _nextSiblingHandles;
+		std::vector<Handle>    _prevSiblingHandles;
+
+		// Scratch space for RebuildHierarchy, kept around so that re-sorting doesn't allocate
+		std::vector<uint32_t>  _sortDepths;
+		std::vector<uint32_t>  _sortOffsets;
+		std::vector<uint32_t>  _sortOrder;
+		std::vector<uint8_t>   _sortVisited;
+
+		// Set when transforms are removed or re-parented, and the arrays need to be re-sorted
+		bool _isHierarchyDirty;
+		// Set between BeginParallelUpdate and EndParallelUpdate
+		bool _isParallelUpdate;
+
+		// Recalculates the local matrix for a single transform if it's dirty, does not touch any other transform
+		void _UpdateLocal(uint32_t index);
+		// Recalculates the matrices for a single transform, assumes the parent is up to date
+		void _UpdateTransform(uint32_t index);
+		// Recalculates the matrices for a single transform, walking up to make sure the parents are up to date
+		void _ResolveTransform(uint32_t index);
+		// Moves the transform at one index into another, used when removing transforms
+		void _MoveTransform(uint32_t from, uint32_t to);
+		// Adds a transform to the front of it's parent's list of children
+		void _LinkChild(Handle handle, Handle parent);
+		// Removes a transform from it's parent's list of children
+		void _UnlinkChild(Handle handle, Handle parent);
+
+		// Re-orders the array in place so that data[ix] becomes data[order[ix]], by following each
+		// cycle of the permutation. visited must be as large as the array, and will be overwritten
+		template <typename T>
+		static void _ApplyOrder(std::vector<T>& data, const std::vector<uint32_t>& order, std::vector<uint8_t>& visited) {
+			std::fill(visited.begin(), visited.end(), static_cast<uint8_t>(0));
+			for (uint32_t start = 0; start < static_cast<uint32_t>(data.size()); start++) {
+				if (visited[start] || order[start] == start) {
+					continue;
+				}
+				T first = std::move(data[start]);
+				uint32_t current = start;
+				while (order[current] != start) {
+					data[current] = std::move(data[order[current]]);
+					visited[current] = 1;
+					current = order[current];
+				}
+				data[current] = std::move(first);
+				visited[current] = 1;
+			}
+		}
+	};
+}
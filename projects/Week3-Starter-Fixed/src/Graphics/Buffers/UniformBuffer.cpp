@@ -3,11 +3,26 @@
 
 AbstractUniformBuffer::~AbstractUniformBuffer() {
 	delete[] _rawData;
+
+	// Make sure we don't leak any sync objects, the buffer itself is released by IBuffer
+	for (GLsync fence : _ringFences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+		}
+	}
+	if (_ringData != nullptr) {
+		Unmap();
+	}
 }
 
 AbstractUniformBuffer::AbstractUniformBuffer(uint32_t sizeInBytes, BufferUsage usage /*= BufferUsage::DynamicDraw*/) :
 	IBuffer(BufferType::Uniform, usage),
-	_rawData(nullptr)
+	_rawData(nullptr),
+	_ringData(nullptr),
+	_ringFrameSize(0),
+	_ringFrameIndex(0),
+	_ringHead(0),
+	_ringFences(std::vector<GLsync>())
 {
 	_rawData = new uint8_t[sizeInBytes];
 	_size = sizeInBytes;
@@ -33,3 +48,110 @@ void AbstractUniformBuffer::Bind(int slot) const
 	glBindBufferBase(GL_UNIFORM_BUFFER, slot, _rendererId);
 }
 
+
+void AbstractUniformBuffer::EnableRingAllocation(uint32_t bytesPerFrame, uint32_t framesInFlight /*= 3*/) {
+	LOG_ASSERT(framesInFlight > 0, "Ring buffers need at least one frame!");
+	LOG_ASSERT(_ringData == nullptr, "Ring allocation has already been enabled for this buffer!");
+	_CreateRingStorage(GetAlignedSize(bytesPerFrame), framesInFlight);
+}
+
+void AbstractUniformBuffer::BeginFrame(uint32_t requiredBytes /*= 0*/) {
+	LOG_ASSERT(_ringData != nullptr, "Ring allocation is not enabled for this buffer!");
+	uint32_t framesInFlight = static_cast<uint32_t>(_ringFences.size());
+
+	// If we need more space, we have to wait for the GPU to finish with all our regions
+	// before we can replace the storage, so this should be rare
+	if (requiredBytes > _ringFrameSize) {
+		for (uint32_t ix = 0; ix < framesInFlight; ix++) {
+			_WaitForFence(ix);
+		}
+		uint32_t newSize = GetAlignedSize(requiredBytes > _ringFrameSize * 2 ? requiredBytes : _ringFrameSize * 2);
+		LOG_INFO("Growing ring buffer from {} bytes to {} bytes per frame", _ringFrameSize, newSize);
+		Unmap();
+		_CreateRingStorage(newSize, framesInFlight);
+	}
+
+	// Move to the next region, and make sure the GPU is done reading from it
+	_ringFrameIndex = (_ringFrameIndex + 1) % framesInFlight;
+	_WaitForFence(_ringFrameIndex);
+	_ringHead = 0;
+}
+
+void AbstractUniformBuffer::EndFrame() {
+	LOG_ASSERT(_ringData != nullptr, "Ring allocation is not enabled for this buffer!");
+	_ringFences[_ringFrameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+AbstractUniformBuffer::RingAllocation AbstractUniformBuffer::Allocate(uint32_t sizeInBytes) {
+	LOG_ASSERT(_ringData != nullptr, "Ring allocation is not enabled for this buffer!");
+	RingAllocation result = { nullptr, 0, sizeInBytes };
+
+	uint32_t alignedSize = GetAlignedSize(sizeInBytes);
+	if (_ringHead + alignedSize > _ringFrameSize) {
+		LOG_WARN("Ring buffer is out of space for this frame! ({} of {} bytes used)", _ringHead, _ringFrameSize);
+		return result;
+	}
+
+	result.Offset = _ringFrameIndex * _ringFrameSize + _ringHead;
+	result.Data = _ringData + result.Offset;
+	_ringHead += alignedSize;
+	return result;
+}
+
+uint32_t AbstractUniformBuffer::GetAlignedSize(uint32_t sizeInBytes) {
+	// Ranges need to be aligned for both UBO and SSBO binding, so we use whichever is stricter
+	static GLint alignment = 0;
+	if (alignment == 0) {
+		GLint uniformAlignment = 0, storageAlignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+		alignment = uniformAlignment > storageAlignment ? uniformAlignment : storageAlignment;
+		alignment = alignment > 0 ? alignment : 256;
+	}
+	return (sizeInBytes + alignment - 1) / alignment * alignment;
+}
+
+void AbstractUniformBuffer::BindRange(const RingAllocation& allocation, int slot, BufferType target /*= BufferType::Uniform*/) const {
+	glBindBufferRange((GLenum)target, slot, _rendererId, allocation.Offset, allocation.Size);
+}
+
+void AbstractUniformBuffer::_CreateRingStorage(uint32_t bytesPerFrame, uint32_t framesInFlight) {
+	// Persistent mappings need immutable storage, so we need a fresh buffer object
+	glDeleteBuffers(1, &_rendererId);
+	uint32_t handle = 0;
+	glCreateBuffers(1, &handle);
+	_SetRenderId(handle);
+
+	_ringFrameSize = bytesPerFrame;
+	_size = bytesPerFrame * framesInFlight;
+	// Note that we shadow IBuffer's size, which is what Map uses
+	IBuffer::_size = _size;
+	glNamedBufferStorage(_rendererId, _size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+	// Coherent mapping means that our writes are visible to the GPU without any explicit flushes
+	_ringData = reinterpret_cast<uint8_t*>(Map(BufferMapMode::Write | BufferMapMode::Persistent | BufferMapMode::Coherent));
+	LOG_ASSERT(_ringData != nullptr, "Failed to map ring buffer!");
+
+	_ringFences.resize(framesInFlight, nullptr);
+	_ringFrameIndex = 0;
+	_ringHead = 0;
+}
+
+void AbstractUniformBuffer::_WaitForFence(uint32_t frameIndex) {
+	GLsync& fence = _ringFences[frameIndex];
+	if (fence == nullptr) {
+		return;
+	}
+
+	// Flush on the first wait so that the fence is guaranteed to be submitted
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true) {
+		GLenum result = glClientWaitSync(fence, flags, 1000000); // 1ms
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+			break;
+		}
+		flags = 0;
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "IBuffer.h"
 #include <memory>
+#include <vector>
 
 /// <summary>
 /// A uniform buffer that operates on raw data
@@ -12,6 +13,18 @@ class AbstractUniformBuffer : public IBuffer {
 public :
 	typedef std::shared_ptr<AbstractUniformBuffer> Sptr;
 
+	/// <summary>
+	/// Represents a block of memory that was allocated from the buffer's ring, see Allocate
+	/// </summary>
+	struct RingAllocation {
+		// Pointer to the mapped memory for the allocation, nullptr if the allocation failed
+		void*    Data;
+		// Offset of the allocation from the start of the buffer, in bytes
+		uint32_t Offset;
+		// Size of the allocation, in bytes
+		uint32_t Size;
+	};
+
 	virtual ~AbstractUniformBuffer();
 
 	/// <summary>
@@ -41,10 +54,75 @@ public :
 	/// <param name="slot">The buffer binding slot to bind to</param>
 	void Bind(int slot) const;
 
+	/// <summary>
+	/// Switches this buffer into ring allocation mode. The buffer's storage is replaced with one
+	/// large persistently mapped block, split into one region per frame in flight. Each frame,
+	/// systems can allocate blocks from the current region and write to them directly, with fences
+	/// making sure that we never write to a region that the GPU is still reading from.
+	/// 
+	/// Note that Update and LoadData should not be used once ring allocation is enabled
+	/// </summary>
+	/// <param name="bytesPerFrame">The number of bytes that can be allocated each frame</param>
+	/// <param name="framesInFlight">The number of frames that the CPU can get ahead of the GPU by</param>
+	void EnableRingAllocation(uint32_t bytesPerFrame, uint32_t framesInFlight = 3);
+	/// <summary>
+	/// Returns true if ring allocation has been enabled for this buffer
+	/// </summary>
+	bool IsRingAllocated() const { return _ringData != nullptr; }
+
+	/// <summary>
+	/// Moves to the next frame region of the ring, waiting for the GPU to finish with it if required.
+	/// Must be called each frame before any allocations are made
+	/// </summary>
+	/// <param name="requiredBytes">If non-zero, the ring will be grown if it can't fit this many bytes per frame (stalls until the GPU is idle)</param>
+	void BeginFrame(uint32_t requiredBytes = 0);
+	/// <summary>
+	/// Marks the end of the current frame's allocations, should be called after the last draw
+	/// that reads from this frame's allocations has been issued
+	/// </summary>
+	void EndFrame();
+
+	/// <summary>
+	/// Allocates a block from the current frame's region. The returned block is aligned so that it
+	/// can be bound as either a uniform or a shader storage buffer range
+	/// </summary>
+	/// <param name="sizeInBytes">The size of the block to allocate</param>
+	/// <returns>The allocation, with a null Data pointer if the frame's region is full</returns>
+	RingAllocation Allocate(uint32_t sizeInBytes);
+	/// <summary>
+	/// Gets the number of bytes that an allocation of the given size will actually consume
+	/// from the ring, after alignment
+	/// </summary>
+	static uint32_t GetAlignedSize(uint32_t sizeInBytes);
+	/// <summary>
+	/// Gets the number of bytes that have been allocated from the current frame's region
+	/// </summary>
+	uint32_t GetFrameBytesUsed() const { return _ringHead; }
+
+	/// <summary>
+	/// Binds a block that was allocated from the ring to the given binding slot
+	/// </summary>
+	/// <param name="allocation">The allocation to bind</param>
+	/// <param name="slot">The binding slot to bind to</param>
+	/// <param name="target">The target to bind to, either Uniform or ShaderStorage</param>
+	void BindRange(const RingAllocation& allocation, int slot, BufferType target = BufferType::Uniform) const;
+
 protected:
 	// Will contain the backing data store for the buffer
 	uint8_t* _rawData;
 	uint32_t _size;
+
+	// Ring allocation state, see EnableRingAllocation
+	uint8_t*             _ringData;
+	uint32_t             _ringFrameSize;
+	uint32_t             _ringFrameIndex;
+	uint32_t             _ringHead;
+	std::vector<GLsync>  _ringFences;
+
+	// Creates the persistent storage for the ring, and maps it
+	void _CreateRingStorage(uint32_t bytesPerFrame, uint32_t framesInFlight);
+	// Waits for the GPU to finish with a ring region and releases it's fence
+	void _WaitForFence(uint32_t frameIndex);
 };
 
 /// <summary>
@@ -109,4 +187,18 @@ public:
 	void Update() {
 		glNamedBufferSubData(_rendererId, 0, sizeof(Structure), _rawData);
 	}
+
+	/// <summary>
+	/// Copies a structure into a new block allocated from this frame's ring region,
+	/// the result can be bound with BindRange. Requires that ring allocation is enabled
+	/// </summary>
+	/// <param name="data">The data to copy into the ring</param>
+	/// <returns>The allocation containing the data</returns>
+	RingAllocation Push(const Structure& data) {
+		RingAllocation result = Allocate(sizeof(Structure));
+		if (result.Data != nullptr) {
+			*reinterpret_cast<Structure*>(result.Data) = data;
+		}
+		return result;
+	}
 };
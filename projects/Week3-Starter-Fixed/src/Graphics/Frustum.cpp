@@ -0,0 +1,126 @@
+#include "Graphics/Frustum.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define FRUSTUM_USE_SSE
+#endif
+
+Frustum::Frustum() :
+	_planes(),
+	_centerX(), _centerY(), _centerZ(),
+	_extentX(), _extentY(), _extentZ()
+{ }
+
+void Frustum::SetViewProjection(const glm::mat4& viewProjection) {
+	// Gribb-Hartmann plane extraction, GLM is column major so we need the rows of the matrix
+	glm::mat4 m = glm::transpose(viewProjection);
+	_planes[0] = m[3] + m[0]; // Left
+	_planes[1] = m[3] - m[0]; // Right
+	_planes[2] = m[3] + m[1]; // Bottom
+	_planes[3] = m[3] - m[1]; // Top
+	_planes[4] = m[3] + m[2]; // Near
+	_planes[5] = m[3] - m[2]; // Far
+
+	// Normalizing isn't strictly needed for a sign test, but keeps the planes usable for distances
+	for (int ix = 0; ix < 6; ix++) {
+		_planes[ix] /= glm::length(glm::vec3(_planes[ix]));
+	}
+}
+
+void Frustum::ClearBoxes() {
+	_centerX.clear(); _centerY.clear(); _centerZ.clear();
+	_extentX.clear(); _extentY.clear(); _extentZ.clear();
+}
+
+uint32_t Frustum::AddBox(const MeshBounds& bounds, const glm::mat4& transform) {
+	// Transform the box center, then find the world space extents by projecting the local
+	// extents onto each world axis (Arvo's method)
+	glm::vec3 center  = glm::vec3(transform * glm::vec4((bounds.Min + bounds.Max) * 0.5f, 1.0f));
+	glm::vec3 extents = bounds.GetExtents();
+	glm::mat3 absRot  = glm::mat3(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+	glm::vec3 worldExtents = absRot * extents;
+
+	uint32_t index = static_cast<uint32_t>(_centerX.size());
+	_centerX.push_back(center.x); _centerY.push_back(center.y); _centerZ.push_back(center.z);
+	_extentX.push_back(worldExtents.x); _extentY.push_back(worldExtents.y); _extentZ.push_back(worldExtents.z);
+	return index;
+}
+
+uint32_t Frustum::Cull(std::vector<uint8_t>& outVisible) const {
+	size_t count = _centerX.size();
+	outVisible.resize(count);
+	if (count == 0) {
+		return 0;
+	}
+
+	uint32_t visibleCount = 0;
+
+	#ifdef FRUSTUM_USE_SSE
+	// Pad our arrays so that we can always load full groups of 4
+	size_t paddedCount = (count + 3) & ~static_cast<size_t>(3);
+	_centerX.resize(paddedCount, 0.0f); _centerY.resize(paddedCount, 0.0f); _centerZ.resize(paddedCount, 0.0f);
+	_extentX.resize(paddedCount, 0.0f); _extentY.resize(paddedCount, 0.0f); _extentZ.resize(paddedCount, 0.0f);
+
+	// Splat each plane's components and absolute normals up front
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int ix = 0; ix < 6; ix++) {
+		planeX[ix] = _mm_set1_ps(_planes[ix].x);
+		planeY[ix] = _mm_set1_ps(_planes[ix].y);
+		planeZ[ix] = _mm_set1_ps(_planes[ix].z);
+		planeW[ix] = _mm_set1_ps(_planes[ix].w);
+		absX[ix]   = _mm_set1_ps(glm::abs(_planes[ix].x));
+		absY[ix]   = _mm_set1_ps(glm::abs(_planes[ix].y));
+		absZ[ix]   = _mm_set1_ps(glm::abs(_planes[ix].z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (size_t base = 0; base < count; base += 4) {
+		__m128 cx = _mm_loadu_ps(&_centerX[base]);
+		__m128 cy = _mm_loadu_ps(&_centerY[base]);
+		__m128 cz = _mm_loadu_ps(&_centerZ[base]);
+		__m128 ex = _mm_loadu_ps(&_extentX[base]);
+		__m128 ey = _mm_loadu_ps(&_extentY[base]);
+		__m128 ez = _mm_loadu_ps(&_extentZ[base]);
+
+		// A box is outside if it is fully behind any plane, ie: dot(n, c) + d + dot(|n|, e) < 0
+		__m128 outside = zero;
+		for (int ix = 0; ix < 6; ix++) {
+			__m128 dist = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(cx, planeX[ix]), _mm_mul_ps(cy, planeY[ix])),
+				_mm_add_ps(_mm_mul_ps(cz, planeZ[ix]), planeW[ix]));
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(ex, absX[ix]), _mm_mul_ps(ey, absY[ix])),
+				_mm_mul_ps(ez, absZ[ix]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		size_t groupSize = count - base < 4 ? count - base : 4;
+		for (size_t lane = 0; lane < groupSize; lane++) {
+			uint8_t visible = (mask & (1 << lane)) == 0 ? 1 : 0;
+			outVisible[base + lane] = visible;
+			visibleCount += visible;
+		}
+	}
+
+	// Trim off our padding so that AddBox keeps appending in the right place
+	_centerX.resize(count); _centerY.resize(count); _centerZ.resize(count);
+	_extentX.resize(count); _extentY.resize(count); _extentZ.resize(count);
+	#else
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 center  = glm::vec3(_centerX[ix], _centerY[ix], _centerZ[ix]);
+		glm::vec3 extents = glm::vec3(_extentX[ix], _extentY[ix], _extentZ[ix]);
+		uint8_t visible = 1;
+		for (int p = 0; p < 6 && visible; p++) {
+			glm::vec3 normal = glm::vec3(_planes[p]);
+			if (glm::dot(normal, center) + _planes[p].w + glm::dot(glm::abs(normal), extents) < 0.0f) {
+				visible = 0;
+			}
+		}
+		outVisible[ix] = visible;
+		visibleCount += visible;
+	}
+	#endif
+
+	return visibleCount;
+}
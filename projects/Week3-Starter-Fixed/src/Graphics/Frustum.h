@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/MeshBounds.h"
+
+/// <summary>
+/// Represents a view frustum as 6 planes facing into the frustum, and handles testing
+/// batches of bounding boxes against it
+/// </summary>
+class Frustum {
+public:
+	Frustum();
+
+	/// <summary>
+	/// Extracts the frustum planes from a view-projection matrix, the resulting planes
+	/// will be in world space
+	/// </summary>
+	/// <param name="viewProjection">The camera's view projection matrix</param>
+	void SetViewProjection(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Gets the frustum planes, in the order left, right, bottom, top, near, far. Each
+	/// plane is stored as (normal, distance) with the normal facing into the frustum
+	/// </summary>
+	const glm::vec4* GetPlanes() const { return _planes; }
+
+	/// <summary>
+	/// Removes all boxes that have been added to this frustum for culling
+	/// </summary>
+	void ClearBoxes();
+	/// <summary>
+	/// Adds a box to be tested by the next call to Cull. The box is transformed into world
+	/// space using the given transform, which may grow it slightly if there is rotation
+	/// </summary>
+	/// <param name="bounds">The model space bounds of the object, must be valid</param>
+	/// <param name="transform">The object's world transform</param>
+	/// <returns>The index of the box, for looking up the result of Cull</returns>
+	uint32_t AddBox(const MeshBounds& bounds, const glm::mat4& transform);
+	/// <summary>
+	/// Gets the number of boxes that have been added since the last call to ClearBoxes
+	/// </summary>
+	size_t BoxCount() const { return _centerX.size(); }
+
+	/// <summary>
+	/// Tests all boxes that have been added against the frustum, 4 at a time
+	/// </summary>
+	/// <param name="outVisible">Will be resized to the number of boxes, with 1 for visible boxes and 0 for culled ones</param>
+	/// <returns>The number of visible boxes</returns>
+	uint32_t Cull(std::vector<uint8_t>& outVisible) const;
+
+protected:
+	glm::vec4 _planes[6];
+
+	// World space box centers and half-sizes, stored as structure of arrays so we can load
+	// 4 boxes at a time into SIMD registers. Padded up to a multiple of 4 by Cull
+	mutable std::vector<float> _centerX, _centerY, _centerZ;
+	mutable std::vector<float> _extentX, _extentY, _extentZ;
+};
@@ -0,0 +1,296 @@
+#include "Graphics/GeometryStore.h"
+#include <algorithm>
+
+#include "Logging.h"
+
+// Number of draws to reserve offsets for when the store is created
+static const uint32_t INITIAL_DRAW_CAPACITY = 1024;
+
+GeometryStore::GeometryStore(const std::vector<BufferAttribute>& attributes, uint32_t vertexCapacity, uint32_t indexCapacity) :
+	_attributes(attributes),
+	_vertexStride(attributes.size() > 0 ? attributes[0].Stride : 0),
+	_vao(nullptr),
+	_vertices(nullptr),
+	_indices(nullptr),
+	_drawOffsets(nullptr),
+	_meshes(std::vector<VertexArrayObject*>()),
+	_vertexCount(0),
+	_vertexCapacity(0),
+	_indexCount(0),
+	_indexCapacity(0),
+	_drawOffsetCapacity(0),
+	_releasedVertices(0),
+	_releasedIndices(0)
+{
+	LOG_ASSERT(_vertexStride > 0, "Geometry store requires at least one vertex attribute");
+
+	_Reserve(std::max(vertexCapacity, 1u), std::max(indexCapacity, 1u));
+	_ReserveDraws(INITIAL_DRAW_CAPACITY);
+	_RebuildVao();
+}
+
+GeometryStore::~GeometryStore() {
+	// Anything still drawing out of our buffers gets a copy of it's own range, so it can keep drawing without us
+	for (VertexArrayObject* mesh : _meshes) {
+		VertexArrayObject::SharedGeometry geometry = mesh->GetSharedGeometry();
+		uint32_t vertexCount = mesh->GetVertexCount();
+
+		VertexBuffer::Sptr vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+		vertices->LoadData(nullptr, _vertexStride, vertexCount);
+		glCopyNamedBufferSubData(_vertices->GetHandle(), vertices->GetHandle(),
+			(GLintptr)geometry.BaseVertex * _vertexStride, 0, (GLsizeiptr)vertexCount * _vertexStride);
+
+		IndexBuffer::Sptr indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+		indices->LoadData(nullptr, sizeof(uint32_t), geometry.IndexCount, IndexType::UInt);
+		glCopyNamedBufferSubData(_indices->GetHandle(), indices->GetHandle(),
+			(GLintptr)geometry.FirstIndex * sizeof(uint32_t), 0, (GLsizeiptr)geometry.IndexCount * sizeof(uint32_t));
+
+		mesh->SetSharedGeometry({ nullptr, 0, geometry.IndexCount, 0 }, vertices, indices);
+	}
+}
+
+bool GeometryStore::IsSupported() {
+	return GLAD_GL_VERSION_4_3 != 0;
+}
+
+bool GeometryStore::CanStore(const VertexArrayObject* mesh) {
+	if (mesh == nullptr || !mesh->IsStatic() || mesh->GetSharedGeometry().Store != nullptr) {
+		return false;
+	}
+
+	// We only know how to copy a single interleaved vertex buffer
+	const auto& buffers = mesh->GetVertexBuffers();
+	if (buffers.size() != 1 || buffers[0]->IsInstanced() || buffers[0]->GetAttributes().size() == 0) {
+		return false;
+	}
+	if (mesh->GetVertexCount() == 0) {
+		return false;
+	}
+
+	// Smaller index types are widened by the loaders while the indices are still on the CPU, so we
+	// don't need to read them back from the GPU here
+	const IndexBuffer::Sptr& indices = mesh->GetIndexBuffer();
+	return indices == nullptr || (indices->GetElementType() == IndexType::UInt && mesh->GetIndexCount() > 0);
+}
+
+bool GeometryStore::IsCompatible(const VertexArrayObject* mesh) const {
+	if (!CanStore(mesh)) {
+		return false;
+	}
+
+	const VertexArrayObject::VertexBufferBinding* binding = mesh->GetVertexBuffers()[0];
+	if (binding->GetBuffer()->GetElementSize() != _vertexStride) {
+		return false;
+	}
+
+	const std::vector<BufferAttribute>& attributes = binding->GetAttributes();
+	if (attributes.size() != _attributes.size()) {
+		return false;
+	}
+	for (size_t ix = 0; ix < attributes.size(); ix++) {
+		const BufferAttribute& a = attributes[ix];
+		const BufferAttribute& b = _attributes[ix];
+		if (a.Slot != b.Slot || a.Size != b.Size || a.Type != b.Type || a.Normalized != b.Normalized ||
+			a.Stride != b.Stride || a.Offset != b.Offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GeometryStore::Add(VertexArrayObject* mesh) {
+	if (!IsCompatible(mesh)) {
+		return false;
+	}
+
+	// Hold on to the mesh's buffers until we're done copying, since the mesh lets go of them once it's been added
+	VertexBuffer::Sptr sourceVertices = mesh->GetVertexBuffers()[0]->GetBuffer();
+	IndexBuffer::Sptr sourceIndices = mesh->GetIndexBuffer();
+
+	// Clones of stored meshes only use part of their buffers, so we copy the mesh's range rather than the whole buffer
+	uint32_t vertexCount = mesh->GetVertexCount();
+	uint32_t indexCount = sourceIndices != nullptr ? mesh->GetIndexCount() : vertexCount;
+
+	if (_Reserve(_vertexCount + vertexCount, _indexCount + indexCount)) {
+		_RebuildVao();
+		_RebindMeshes();
+	}
+
+	// Vertices can always be copied directly, since the layouts match
+	glCopyNamedBufferSubData(sourceVertices->GetHandle(), _vertices->GetHandle(),
+		(GLintptr)mesh->GetBaseVertex() * _vertexStride, (GLintptr)_vertexCount * _vertexStride, (GLsizeiptr)vertexCount * _vertexStride);
+
+	if (sourceIndices != nullptr) {
+		glCopyNamedBufferSubData(sourceIndices->GetHandle(), _indices->GetHandle(),
+			(GLintptr)mesh->GetFirstIndex() * sizeof(uint32_t), (GLintptr)_indexCount * sizeof(uint32_t), (GLsizeiptr)indexCount * sizeof(uint32_t));
+	} else {
+		// Non-indexed meshes need indices generated, since we draw everything as indexed
+		std::vector<uint32_t> indices(indexCount);
+		for (uint32_t ix = 0; ix < indexCount; ix++) {
+			indices[ix] = ix;
+		}
+		glNamedBufferSubData(_indices->GetHandle(), (GLintptr)_indexCount * sizeof(uint32_t), (GLsizeiptr)indexCount * sizeof(uint32_t), indices.data());
+	}
+
+	VertexArrayObject::SharedGeometry geometry;
+	geometry.Store = this;
+	geometry.FirstIndex = _indexCount;
+	geometry.IndexCount = indexCount;
+	geometry.BaseVertex = static_cast<int32_t>(_vertexCount);
+
+	_vertexCount += vertexCount;
+	_indexCount += indexCount;
+	_meshes.push_back(mesh);
+
+	// From here on the mesh draws out of our buffers, so it's own copy can be freed
+	mesh->SetSharedGeometry(geometry, _vertices, _indices);
+
+	return true;
+}
+
+void GeometryStore::Release(VertexArrayObject* mesh) {
+	auto it = std::find(_meshes.begin(), _meshes.end(), mesh);
+	if (it == _meshes.end()) {
+		return;
+	}
+	*it = _meshes.back();
+	_meshes.pop_back();
+
+	_releasedVertices += mesh->GetVertexCount();
+	_releasedIndices += mesh->GetSharedGeometry().IndexCount;
+
+	// Once most of the store is unused, it's worth moving everything down so the space can be reused
+	if (_releasedVertices * 2 > _vertexCount || _releasedIndices * 2 > _indexCount) {
+		_Compact();
+	}
+}
+
+void GeometryStore::DrawMultiIndirect(GLuint indirectBuffer, uint32_t offset, uint32_t commandCount, DrawMode mode) {
+	if (commandCount == 0) {
+		return;
+	}
+
+	if (_ReserveDraws(commandCount)) {
+		_RebuildVao();
+	}
+
+	_vao->Bind();
+	glBindBuffer((GLenum)BufferType::DrawIndirect, indirectBuffer);
+	glMultiDrawElementsIndirect((GLenum)mode, GL_UNSIGNED_INT, reinterpret_cast<const void*>(static_cast<size_t>(offset)), commandCount, sizeof(DrawCommand));
+	IBuffer::UnBind(BufferType::DrawIndirect);
+	VertexArrayObject::Unbind();
+}
+
+bool GeometryStore::_Reserve(uint32_t vertexCount, uint32_t indexCount) {
+	bool replaced = false;
+
+	// We grow by doubling so that adding many meshes doesn't result in many copies, the old
+	// contents are copied over on the GPU
+	if (vertexCount > _vertexCapacity) {
+		uint32_t capacity = std::max(vertexCount, _vertexCapacity * 2);
+		VertexBuffer::Sptr vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+		vertices->SetDebugName("Geometry Store Vertices");
+		vertices->LoadData(nullptr, _vertexStride, capacity);
+		if (_vertexCount > 0) {
+			glCopyNamedBufferSubData(_vertices->GetHandle(), vertices->GetHandle(), 0, 0, (GLsizeiptr)_vertexCount * _vertexStride);
+		}
+		_vertices = vertices;
+		_vertexCapacity = capacity;
+		replaced = true;
+	}
+
+	if (indexCount > _indexCapacity) {
+		uint32_t capacity = std::max(indexCount, _indexCapacity * 2);
+		IndexBuffer::Sptr indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+		indices->SetDebugName("Geometry Store Indices");
+		indices->LoadData(nullptr, sizeof(uint32_t), capacity, IndexType::UInt);
+		if (_indexCount > 0) {
+			glCopyNamedBufferSubData(_indices->GetHandle(), indices->GetHandle(), 0, 0, (GLsizeiptr)_indexCount * sizeof(uint32_t));
+		}
+		_indices = indices;
+		_indexCapacity = capacity;
+		replaced = true;
+	}
+
+	if (replaced && !_meshes.empty()) {
+		LOG_INFO("Expanded geometry store to {} vertices and {} indices", _vertexCapacity, _indexCapacity);
+	}
+
+	return replaced;
+}
+
+bool GeometryStore::_ReserveDraws(uint32_t drawCount) {
+	if (drawCount <= _drawOffsetCapacity) {
+		return false;
+	}
+
+	// Stored as floats so we can use our regular attribute path, these are exact up to 2^24
+	uint32_t capacity = std::max(drawCount, _drawOffsetCapacity * 2);
+	std::vector<float> offsets(capacity);
+	for (uint32_t ix = 0; ix < capacity; ix++) {
+		offsets[ix] = static_cast<float>(ix);
+	}
+
+	_drawOffsets = VertexBuffer::Create(BufferUsage::StaticDraw);
+	_drawOffsets->SetDebugName("Geometry Store Draw Offsets");
+	_drawOffsets->LoadData(offsets.data(), capacity);
+	_drawOffsetCapacity = capacity;
+
+	return true;
+}
+
+void GeometryStore::_RebuildVao() {
+	// VAOs hold on to the buffer objects, so it's easier to make a new one than patch the old one
+	_vao = VertexArrayObject::Create();
+	_vao->SetDebugName("Geometry Store");
+	_vao->AddVertexBuffer(_vertices, _attributes);
+	_vao->AddVertexBuffer(_drawOffsets, {
+		BufferAttribute(DRAW_OFFSET_SLOT, 1, AttributeType::Float, sizeof(float), 0, AttribUsage::User3)
+	}, true);
+	_vao->SetIndexBuffer(_indices);
+	_vao->SetVDecl(_attributes);
+}
+
+void GeometryStore::_RebindMeshes() {
+	for (VertexArrayObject* mesh : _meshes) {
+		VertexArrayObject::SharedGeometry geometry = mesh->GetSharedGeometry();
+		mesh->SetSharedGeometry(geometry, _vertices, _indices);
+	}
+}
+
+void GeometryStore::_Compact() {
+	// We keep the same capacity, since we'll most likely fill it up again. Indices are relative to each
+	// mesh's base vertex, so they can be copied as-is
+	VertexBuffer::Sptr vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertices->SetDebugName("Geometry Store Vertices");
+	vertices->LoadData(nullptr, _vertexStride, _vertexCapacity);
+	IndexBuffer::Sptr indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+	indices->SetDebugName("Geometry Store Indices");
+	indices->LoadData(nullptr, sizeof(uint32_t), _indexCapacity, IndexType::UInt);
+
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	for (VertexArrayObject* mesh : _meshes) {
+		VertexArrayObject::SharedGeometry geometry = mesh->GetSharedGeometry();
+		uint32_t meshVertices = mesh->GetVertexCount();
+		glCopyNamedBufferSubData(_vertices->GetHandle(), vertices->GetHandle(),
+			(GLintptr)geometry.BaseVertex * _vertexStride, (GLintptr)vertexCount * _vertexStride, (GLsizeiptr)meshVertices * _vertexStride);
+		glCopyNamedBufferSubData(_indices->GetHandle(), indices->GetHandle(),
+			(GLintptr)geometry.FirstIndex * sizeof(uint32_t), (GLintptr)indexCount * sizeof(uint32_t), (GLsizeiptr)geometry.IndexCount * sizeof(uint32_t));
+
+		geometry.FirstIndex = indexCount;
+		geometry.BaseVertex = static_cast<int32_t>(vertexCount);
+		mesh->SetSharedGeometry(geometry, vertices, indices);
+
+		vertexCount += meshVertices;
+		indexCount += geometry.IndexCount;
+	}
+
+	_vertices = vertices;
+	_indices = indices;
+	_vertexCount = vertexCount;
+	_indexCount = indexCount;
+	_releasedVertices = 0;
+	_releasedIndices = 0;
+	_RebuildVao();
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/Buffers/VertexBuffer.h"
+#include "Graphics/Buffers/IndexBuffer.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Stores the geometry for many meshes that share a vertex layout inside one large vertex and
+/// index buffer, so that they can all be drawn from a single VAO using multi-draw indirect.
+///
+/// Meshes that are added draw out of the store's buffers from then on, and their own buffers are
+/// released. Ranges are allocated linearly, when a mesh is destroyed it's range is released, and the
+/// store is compacted once enough of it is unused. This should only be used for static meshes whose
+/// buffers are never modified after they are created
+/// </summary>
+class GeometryStore final {
+public:
+	MAKE_PTRS(GeometryStore);
+	NO_COPY(GeometryStore);
+	NO_MOVE(GeometryStore);
+
+	/// <summary>
+	/// A single draw command, matches the layout expected by glMultiDrawElementsIndirect
+	/// </summary>
+	struct DrawCommand {
+		uint32_t Count;
+		uint32_t InstanceCount;
+		uint32_t FirstIndex;
+		int32_t  BaseVertex;
+		uint32_t BaseInstance;
+	};
+
+	/// <summary>
+	/// The vertex shader input that receives each draw's base instance, see DrawMultiIndirect
+	/// </summary>
+	static const uint32_t DRAW_OFFSET_SLOT = 15;
+
+	/// <summary>
+	/// Creates a new empty geometry store for meshes with the given vertex layout
+	/// </summary>
+	/// <param name="attributes">The vertex attributes for meshes in this store</param>
+	/// <param name="vertexCapacity">The number of vertices to reserve space for</param>
+	/// <param name="indexCapacity">The number of indices to reserve space for</param>
+	GeometryStore(const std::vector<BufferAttribute>& attributes, uint32_t vertexCapacity = 65536, uint32_t indexCapacity = 196608);
+	~GeometryStore();
+
+	/// <summary>
+	/// Returns true if the current OpenGL context supports multi-draw indirect
+	/// </summary>
+	static bool IsSupported();
+
+	/// <summary>
+	/// Returns true if the mesh could be added to some geometry store. The mesh must be marked as
+	/// static, must have a single per-vertex buffer, must use 32 bit indices (or no indices) and must
+	/// not already be in a store
+	/// </summary>
+	/// <param name="mesh">The mesh to check</param>
+	static bool CanStore(const VertexArrayObject* mesh);
+	/// <summary>
+	/// Returns true if the mesh can be stored and has the same vertex layout as this store
+	/// </summary>
+	/// <param name="mesh">The mesh to check</param>
+	bool IsCompatible(const VertexArrayObject* mesh) const;
+
+	/// <summary>
+	/// Copies the mesh's geometry into this store on the GPU, and points the mesh at the store's buffers
+	/// (see VertexArrayObject::SetSharedGeometry), which frees the mesh's own buffers
+	/// </summary>
+	/// <param name="mesh">The mesh to add, must be compatible with this store</param>
+	/// <returns>True if the mesh was added, false if it is not compatible</returns>
+	bool Add(VertexArrayObject* mesh);
+	/// <summary>
+	/// Releases the range used by a mesh in this store, this is called by the mesh when it is destroyed
+	/// </summary>
+	/// <param name="mesh">The mesh to remove from the store</param>
+	void Release(VertexArrayObject* mesh);
+
+	/// <summary>
+	/// Draws a list of commands from an indirect buffer with a single call. Each draw's base instance is
+	/// fed to the DRAW_OFFSET_SLOT vertex input, so shaders can use it to look up per-draw data.
+	/// Commands should use an InstanceCount of 1 and a BaseInstance less than commandCount, since the
+	/// input is advanced once per instance
+	/// </summary>
+	/// <param name="indirectBuffer">The handle of the buffer containing the commands</param>
+	/// <param name="offset">The offset in bytes of the first command in the buffer</param>
+	/// <param name="commandCount">The number of commands to draw</param>
+	/// <param name="mode">The primitive mode to draw with</param>
+	void DrawMultiIndirect(GLuint indirectBuffer, uint32_t offset, uint32_t commandCount, DrawMode mode = DrawMode::TriangleList);
+
+	/// <summary>
+	/// Gets the number of vertices that have been allocated in this store, including any that were
+	/// released and have not been compacted yet
+	/// </summary>
+	uint32_t GetVertexCount() const { return _vertexCount; }
+	/// <summary>
+	/// Gets the number of indices that have been allocated in this store, including any that were
+	/// released and have not been compacted yet
+	/// </summary>
+	uint32_t GetIndexCount() const { return _indexCount; }
+	/// <summary>
+	/// Gets the number of meshes that are currently in this store
+	/// </summary>
+	uint32_t GetMeshCount() const { return static_cast<uint32_t>(_meshes.size()); }
+
+protected:
+	std::vector<BufferAttribute> _attributes;
+	uint32_t                     _vertexStride;
+
+	VertexArrayObject::Sptr _vao;
+	VertexBuffer::Sptr      _vertices;
+	IndexBuffer::Sptr       _indices;
+	// Holds the values 0..n, read once per instance so that each draw gets it's base instance
+	VertexBuffer::Sptr      _drawOffsets;
+
+	// The meshes that are drawing out of our buffers, we need to move them when our buffers are replaced
+	std::vector<VertexArrayObject*> _meshes;
+
+	uint32_t _vertexCount;
+	uint32_t _vertexCapacity;
+	uint32_t _indexCount;
+	uint32_t _indexCapacity;
+	uint32_t _drawOffsetCapacity;
+	// How many of the allocated vertices and indices belong to meshes that have been released
+	uint32_t _releasedVertices;
+	uint32_t _releasedIndices;
+
+	// Grows the vertex and index buffers so that they can hold at least the given number of elements,
+	// returns true if the buffers were replaced
+	bool _Reserve(uint32_t vertexCount, uint32_t indexCount);
+	// Grows the draw offset buffer so that it can hold at least the given number of draws, returns
+	// true if the buffer was replaced
+	bool _ReserveDraws(uint32_t drawCount);
+	// Re-creates the VAO after any of our buffers have been replaced
+	void _RebuildVao();
+	// Points all of our meshes at our current buffers, after they have been replaced
+	void _RebindMeshes();
+	// Copies the meshes that are still in the store into new buffers, packed together, so that the space
+	// left by released meshes can be used again
+	void _Compact();
+};
@@ -9,6 +9,14 @@
 #include <Logging.h>
 #include <glm/glm.hpp>
 
+// S3TC is an extension rather than core, but is supported by every desktop driver we care about
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 // We can use an enum to make our code more readable and restrict
 // values to only ones we want to accept
 ENUM(ShaderPartType, GLint,
@@ -49,7 +57,12 @@ ENUM(InternalFormat, GLint,
 	RGBA8        = GL_RGBA8,
 	SRGBA        = GL_SRGB8_ALPHA8,
 	RGBA16       = GL_RGBA16,
-	RGB32AF      = GL_RGBA32F
+	RGB32AF      = GL_RGBA32F,
+	// Block compressed formats, these can only be filled with glCompressedTextureSubImage2D
+	BC1          = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+	BC3          = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+	BC4          = GL_COMPRESSED_RED_RGTC1,
+	BC5          = GL_COMPRESSED_RG_RGTC2
 	// Note: There are sized internal formats but there is a LOT of them
 )
 
@@ -158,6 +171,29 @@ constexpr PixelFormat GetPixelFormatForChannels(int numChannels) {
 	}
 }
 
+/*
+ * Gets the number of bytes in a single 4x4 block of a block compressed format, or 0 if the format is not compressed
+ */
+constexpr size_t GetCompressedBlockSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::BC1:
+		case InternalFormat::BC4:
+			return 8;
+		case InternalFormat::BC3:
+		case InternalFormat::BC5:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Returns true if the given internal format is block compressed
+ */
+constexpr bool IsCompressedFormat(InternalFormat format) {
+	return GetCompressedBlockSize(format) != 0;
+}
+
 /*
  * Gets the number of components in a given pixel format
  */
@@ -747,7 +783,9 @@ ENUM(BlendEquation, uint32_t,
 ENUM(BufferType, GLenum,
 	Vertex  = GL_ARRAY_BUFFER,
 	Index   = GL_ELEMENT_ARRAY_BUFFER,
-	Uniform = GL_UNIFORM_BUFFER
+	Uniform = GL_UNIFORM_BUFFER,
+	ShaderStorage = GL_SHADER_STORAGE_BUFFER,
+	DrawIndirect  = GL_DRAW_INDIRECT_BUFFER
 )
 
 /// <summary>
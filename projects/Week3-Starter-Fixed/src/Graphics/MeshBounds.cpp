@@ -0,0 +1,44 @@
+#include "Graphics/MeshBounds.h"
+#include <cstring>
+
+MeshBounds::MeshBounds() :
+	Min(glm::vec3(0.0f)),
+	Max(glm::vec3(0.0f)),
+	Center(glm::vec3(0.0f)),
+	Radius(0.0f),
+	IsValid(false)
+{ }
+
+MeshBounds MeshBounds::FromVertexData(const void* data, size_t stride, size_t positionOffset, size_t count) {
+	MeshBounds result;
+	if (data == nullptr || count == 0) {
+		return result;
+	}
+
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data) + positionOffset;
+	glm::vec3 position;
+
+	// First pass finds our box
+	memcpy(&position, bytes, sizeof(glm::vec3));
+	result.Min = position;
+	result.Max = position;
+	for (size_t ix = 1; ix < count; ix++) {
+		memcpy(&position, bytes + ix * stride, sizeof(glm::vec3));
+		result.Min = glm::min(result.Min, position);
+		result.Max = glm::max(result.Max, position);
+	}
+
+	// We center the sphere on the box, and grow it to fit the furthest vertex. This is not
+	// the smallest possible sphere, but it's close enough for culling
+	result.Center = (result.Min + result.Max) * 0.5f;
+	float radiusSq = 0.0f;
+	for (size_t ix = 0; ix < count; ix++) {
+		memcpy(&position, bytes + ix * stride, sizeof(glm::vec3));
+		glm::vec3 offset = position - result.Center;
+		radiusSq = glm::max(radiusSq, glm::dot(offset, offset));
+	}
+	result.Radius = glm::sqrt(radiusSq);
+	result.IsValid = true;
+
+	return result;
+}
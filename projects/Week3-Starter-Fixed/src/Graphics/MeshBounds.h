@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Stores the bounding volumes for a mesh in model space, as both an axis-aligned
+/// bounding box and a bounding sphere. These are calculated once when a mesh is built
+/// or loaded, so that we can quickly test objects for visibility
+/// </summary>
+struct MeshBounds {
+	/// <summary>
+	/// The minimum corner of the bounding box
+	/// </summary>
+	glm::vec3 Min;
+	/// <summary>
+	/// The maximum corner of the bounding box
+	/// </summary>
+	glm::vec3 Max;
+	/// <summary>
+	/// The center of the bounding sphere (and box)
+	/// </summary>
+	glm::vec3 Center;
+	/// <summary>
+	/// The radius of the bounding sphere
+	/// </summary>
+	float     Radius;
+	/// <summary>
+	/// False if the bounds have not been calculated, in which case the mesh should
+	/// always be considered visible
+	/// </summary>
+	bool      IsValid;
+
+	MeshBounds();
+
+	/// <summary>
+	/// Gets the half-size of the bounding box along each axis
+	/// </summary>
+	glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	/// <summary>
+	/// Calculates the bounds of a set of vertices from a block of interleaved vertex data
+	/// </summary>
+	/// <param name="data">A pointer to the first vertex</param>
+	/// <param name="stride">The size of a single vertex, in bytes</param>
+	/// <param name="positionOffset">The offset of the float3 position attribute within the vertex, in bytes</param>
+	/// <param name="count">The number of vertices in data</param>
+	/// <returns>The bounds of the vertices, or invalid bounds if count is zero</returns>
+	static MeshBounds FromVertexData(const void* data, size_t stride, size_t positionOffset, size_t count);
+};
@@ -3,10 +3,19 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <iomanip>
+#include <map>
+#include <cstring>
+#include <algorithm>
 
 #include "Utils/FileHelpers.h"
+#include "Utils/MappedFile.h"
+#include "Utils/VirtualFileSystem.h"
 #include "Utils/JsonGlmHelpers.h"
 
+const std::string ShaderProgram::CACHE_DIRECTORY = "shader_cache/";
+const std::string ShaderProgram::CACHE_EXTENSION = ".spbin";
+
 ShaderProgram::ShaderProgram() : 
 	IGraphicsResource(),
 	IResource()
@@ -33,6 +42,38 @@ ShaderProgram::~ShaderProgram() {
 }
 
 bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
+	// If we're overwriting, warn before we replace the old source
+	if (_pendingSources.count(type) != 0) {
+		LOG_WARN("Another shader has been attached to this slot, overwriting");
+	}
+	// We hold on to the source until Link, where we can check the cache before compiling anything
+	_pendingSources[type] = source;
+
+	// Store info about where we got this data from
+	_fileSourceMap[type].IsFilePath = false;
+	_fileSourceMap[type].Source = source;
+
+	return true;
+}
+
+bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
+	// Make sure that the file exists before we try reading
+	if (VirtualFileSystem::Exists(path)) {
+		// Load the source from the file, using our helper that will
+		// resolve #include directives
+		std::string source = FileHelpers::ReadResolveIncludes(path);
+		// Pass off to LoadShaderPart
+		bool result =  LoadShaderPart(source.c_str(), type);
+		_fileSourceMap[type].IsFilePath = true;
+		_fileSourceMap[type].Source = path;
+		return result; 
+	} else {
+		LOG_WARN("Could not open file at \"{}\"", path);
+		return false;
+	}
+}
+
+GLuint ShaderProgram::_CompileShaderPart(const char* source, ShaderPartType type) {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader((GLenum)type);
 
@@ -64,53 +105,51 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 		// Delete the broken shader result
 		glDeleteShader(handle);
 		handle = 0;
-
-		return false;
 	}
 
-	// If we're overwriting, warn and clean up the old program before we store
-	if (_handles[type] != 0) {
-		LOG_WARN("Another shader has been attached to this slot, overwriting");
-		glDeleteShader(_handles[type]);
-	}
-	_handles[type] = handle;
+	return handle;
+}
 
-	// Store info about where we got this data from
-	_fileSourceMap[type].IsFilePath = false;
-	_fileSourceMap[type].Source = source;
+bool ShaderProgram::Link() {
 
-	return status != GL_FALSE;
-}
+	LOG_TRACE("Starting shader link:");
+	for (auto& [type, source] : _pendingSources) {
+		LOG_TRACE("\t{} - {}", ~type, _fileSourceMap[type].IsFilePath ? _fileSourceMap[type].Source : "<from source>");
+	}
 
-bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
-	// Make sure that the file exists before we try reading
-	if (std::filesystem::exists(path)) {
-		// Load the source from the file, using our helper that will
-		// resolve #include directives
-		std::string source = FileHelpers::ReadResolveIncludes(path);
-		// Pass off to LoadShaderPart
-		bool result =  LoadShaderPart(source.c_str(), type);
-		_fileSourceMap[type].IsFilePath = true;
-		_fileSourceMap[type].Source = path;
-		if (result == false) {
-			LOG_ERROR("Source File: {}", path);
+	// If we've linked these exact sources before, we can skip compiling and linking altogether
+	std::string cachePath = "";
+	uint64_t cacheFingerprint = 0;
+	if (__IsBinaryCacheSupported()) {
+		uint64_t cacheKey = _ComputeCacheKey(cacheFingerprint);
+		std::stringstream name;
+		name << CACHE_DIRECTORY << std::hex << std::setfill('0') << std::setw(16) << cacheKey << CACHE_EXTENSION;
+		cachePath = name.str();
+
+		if (_LoadFromCache(cachePath, cacheFingerprint)) {
+			LOG_TRACE("Loaded program binary from \"{}\"", cachePath);
+			_pendingSources.clear();
+			return true;
 		}
-		return result; 
-	} else {
-		LOG_WARN("Could not open file at \"{}\"", path);
-		return false;
+
+		// Let the driver know we're going to ask for the binary once linking is done
+		glProgramParameteri(_rendererId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
-}
 
-bool ShaderProgram::Link() {
+	// Compile all our shader parts
+	for (auto& [type, source] : _pendingSources) {
+		GLuint handle = _CompileShaderPart(source.c_str(), type);
+		if (handle == 0 && _fileSourceMap[type].IsFilePath) {
+			LOG_ERROR("Source File: {}", _fileSourceMap[type].Source);
+		}
+		_handles[type] = handle;
+	}
+	_pendingSources.clear();
 
-	LOG_TRACE("Starting shader link:");
-	
 	// Attach all our shaders
 	for (auto& [type, id] : _handles) {
 		if (id != 0) {
 			glAttachShader(_rendererId, id);
-			LOG_TRACE("\t{} - {}", ~type, _fileSourceMap[type].IsFilePath ? _fileSourceMap[type].Source : "<from source>");
 		}
 	}
 
@@ -153,9 +192,237 @@ bool ShaderProgram::Link() {
 	// Perform our uniform introspection to see what uniforms are in the shader
 	_Introspect();
 
+	// Store the program so that next time we can skip straight to this point
+	if (status != GL_FALSE && !cachePath.empty()) {
+		_SaveToCache(cachePath, cacheFingerprint);
+		__PruneCache();
+	}
+
 	return status != GL_FALSE;
 }
 
+bool ShaderProgram::__IsBinaryCacheSupported() {
+	// This won't change while we're running, so we only need to ask the driver once
+	static const bool supported = []() {
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		if (numFormats == 0) {
+			LOG_WARN("Driver does not support any program binary formats, shaders will not be cached");
+		}
+		return numFormats > 0;
+	}();
+	return supported;
+}
+
+uint64_t ShaderProgram::_ComputeCacheKey(uint64_t& outFingerprint) const {
+	// Binaries are only valid for the driver that created them, so the driver is part of the key
+	static const std::string driver = []() {
+		std::string result;
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			const GLubyte* value = glGetString(name);
+			result += value != nullptr ? reinterpret_cast<const char*>(value) : "";
+			result += '\n';
+		}
+		return result;
+	}();
+
+	// 64 bit FNV-1a, see http://www.isthe.com/chongo/tech/comp/fnv/
+	// The fingerprint is the same hash with a different offset basis, so a key collision won't also collide here
+	uint64_t hash = 0xcbf29ce484222325ull;
+	uint64_t fingerprint = 0x84222325cbf29ce4ull;
+	auto hashBytes = [&](const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t ix = 0; ix < size; ix++) {
+			hash ^= bytes[ix];
+			hash *= 0x100000001b3ull;
+			fingerprint ^= bytes[ix];
+			fingerprint *= 0x100000001b3ull;
+		}
+	};
+
+	hashBytes(driver.data(), driver.size());
+	hashBytes(_varyingsKey.data(), _varyingsKey.size());
+
+	// Iteration order of an unordered map isn't stable, so sort the parts by type first
+	std::map<ShaderPartType, const std::string*> parts;
+	for (auto& [type, source] : _pendingSources) {
+		parts[type] = &source;
+	}
+	for (auto& [type, source] : parts) {
+		GLenum typeValue = *type;
+		hashBytes(&typeValue, sizeof(GLenum));
+		uint64_t length = source->size();
+		hashBytes(&length, sizeof(uint64_t));
+		hashBytes(source->data(), source->size());
+	}
+
+	outFingerprint = fingerprint;
+	return hash;
+}
+
+bool ShaderProgram::_LoadFromCache(const std::string& filename, uint64_t fingerprint) {
+	MappedFile file;
+	if (!std::filesystem::exists(filename) || !file.Open(filename)) {
+		return false;
+	}
+
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+
+	// Read the header from the file, and make sure it's something we can load
+	CacheHeader header = CacheHeader();
+	if (size < sizeof(CacheHeader)) {
+		LOG_WARN("Not enough data in \"{}\"", filename);
+		return false;
+	}
+	memcpy(&header, data, sizeof(CacheHeader));
+
+	if (memcmp(header.HeaderBytes, CacheHeader().HeaderBytes, sizeof(header.HeaderBytes)) != 0 ||
+		header.Version != CACHE_VERSION ||
+		header.Fingerprint != fingerprint ||
+		size < sizeof(CacheHeader) + (size_t)header.BinarySize + (size_t)header.IntrospectionSize) {
+		LOG_WARN("\"{}\" is not a valid program binary", filename);
+		return false;
+	}
+
+	const uint8_t* binary = data + sizeof(CacheHeader);
+	const uint8_t* introspectionData = binary + header.BinarySize;
+	nlohmann::json introspection = nlohmann::json::from_msgpack(introspectionData, introspectionData + header.IntrospectionSize, true, false);
+	if (introspection.is_discarded() || !introspection.contains("uniforms") || !introspection.contains("blocks")) {
+		LOG_WARN("\"{}\" is not a valid program binary", filename);
+		return false;
+	}
+
+	// The driver can reject binaries at any time (ex: after it's been updated), in which case we just compile as usual
+	glProgramBinary(_rendererId, header.BinaryFormat, binary, header.BinarySize);
+	GLint status = 0;
+	glGetProgramiv(_rendererId, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		LOG_INFO("Driver rejected program binary \"{}\", recompiling", filename);
+		return false;
+	}
+
+	_IntrospectionFromJson(introspection);
+
+	// Mark the binary as recently used, so pruning the cache removes the binaries we've stopped loading first. The
+	// mapping only allows shared reads, so it needs to be closed before we can touch the file
+	file.Close();
+	std::error_code error;
+	std::filesystem::last_write_time(filename, std::filesystem::file_time_type::clock::now(), error);
+	return true;
+}
+
+void ShaderProgram::_SaveToCache(const std::string& filename, uint64_t fingerprint) const {
+	GLint binarySize = 0;
+	glGetProgramiv(_rendererId, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+	if (binarySize <= 0) {
+		return;
+	}
+
+	CacheHeader header = CacheHeader();
+	header.Version = CACHE_VERSION;
+	header.Fingerprint = fingerprint;
+
+	std::vector<uint8_t> binary(binarySize);
+	GLenum format = 0;
+	glGetProgramBinary(_rendererId, binarySize, &binarySize, &format, binary.data());
+	header.BinaryFormat = format;
+	header.BinarySize = static_cast<uint32_t>(binarySize);
+
+	std::vector<uint8_t> introspection = nlohmann::json::to_msgpack(_IntrospectionToJson());
+	header.IntrospectionSize = static_cast<uint32_t>(introspection.size());
+
+	std::error_code error;
+	std::filesystem::create_directories(CACHE_DIRECTORY, error);
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) {
+		LOG_WARN("Failed to open \"{}\" for writing", filename);
+		return;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+	file.write(reinterpret_cast<const char*>(binary.data()), header.BinarySize);
+	file.write(reinterpret_cast<const char*>(introspection.data()), introspection.size());
+}
+
+void ShaderProgram::__PruneCache() {
+	std::error_code error;
+	std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+	for (const auto& entry : std::filesystem::directory_iterator(CACHE_DIRECTORY, error)) {
+		if (entry.is_regular_file(error) && entry.path().extension() == CACHE_EXTENSION) {
+			files.emplace_back(entry.last_write_time(error), entry.path());
+		}
+	}
+	if (files.size() <= CACHE_MAX_FILES) {
+		return;
+	}
+
+	// Oldest first, anything past the cap gets removed
+	std::sort(files.begin(), files.end());
+	size_t numToRemove = files.size() - CACHE_MAX_FILES;
+	for (size_t ix = 0; ix < numToRemove; ix++) {
+		std::filesystem::remove(files[ix].second, error);
+	}
+	LOG_INFO("Removed {} stale program binaries from \"{}\"", numToRemove, CACHE_DIRECTORY);
+}
+
+nlohmann::json ShaderProgram::_IntrospectionToJson() const {
+	nlohmann::json uniforms = nlohmann::json::array();
+	for (auto& [name, uniform] : _uniforms) {
+		// Lookups of missing uniforms insert defaults into the map, we don't need to store those
+		if (uniform.Location == -1) {
+			continue;
+		}
+		uniforms.push_back({ uniform.Name, *uniform.Type, uniform.ArraySize, uniform.Location, uniform.Binding });
+	}
+
+	nlohmann::json blocks = nlohmann::json::array();
+	for (auto& [name, block] : _uniformBlocks) {
+		nlohmann::json subUniforms = nlohmann::json::array();
+		for (auto& uniform : block.SubUniforms) {
+			subUniforms.push_back({ uniform.Name, *uniform.Type, uniform.ArraySize, uniform.Location });
+		}
+		blocks.push_back({ block.Name, block.DefaultBinding, block.BlockIndex, block.SizeInBytes, subUniforms });
+	}
+
+	nlohmann::json result;
+	result["uniforms"] = uniforms;
+	result["blocks"] = blocks;
+	return result;
+}
+
+void ShaderProgram::_IntrospectionFromJson(const nlohmann::json& data) {
+	for (auto& blob : data["uniforms"]) {
+		UniformInfo e = UniformInfo();
+		e.Name      = blob[0].get<std::string>();
+		e.Type      = static_cast<ShaderDataType>(blob[1].get<uint32_t>());
+		e.ArraySize = blob[2].get<int>();
+		e.Location  = blob[3].get<int>();
+		e.Binding   = blob[4].get<int>();
+		_uniforms[e.Name] = e;
+	}
+
+	for (auto& blob : data["blocks"]) {
+		UniformBlockInfo block = UniformBlockInfo();
+		block.Name           = blob[0].get<std::string>();
+		block.DefaultBinding = blob[1].get<int>();
+		block.CurrentBinding = block.DefaultBinding;
+		block.BlockIndex     = blob[2].get<int>();
+		block.SizeInBytes    = blob[3].get<int>();
+		for (auto& varBlob : blob[4]) {
+			UniformInfo var = UniformInfo();
+			var.Name      = varBlob[0].get<std::string>();
+			var.Type      = static_cast<ShaderDataType>(varBlob[1].get<uint32_t>());
+			var.ArraySize = varBlob[2].get<int>();
+			var.Location  = varBlob[3].get<int>();
+			block.SubUniforms.push_back(var);
+		}
+		block.NumVariables = (int)block.SubUniforms.size();
+		_uniformBlocks[block.Name] = block;
+	}
+}
+
 void ShaderProgram::Bind() {
 	// Simply calls glUseProgram with our shader handle
 	glUseProgram(_rendererId);
@@ -520,4 +787,11 @@ GlResourceType ShaderProgram::GetResourceClass() const {
 void ShaderProgram::RegisterVaryings(const char* const* names, int numVaryings, bool interleaved /*= true*/)
 {
 	glTransformFeedbackVaryings(_rendererId, numVaryings, names, interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+
+	// The varyings are baked into the linked program, so they need to be part of our cache key
+	_varyingsKey = interleaved ? "interleaved:" : "separate:";
+	for (int ix = 0; ix < numVaryings; ix++) {
+		_varyingsKey += names[ix];
+		_varyingsKey += ';';
+	}
 }
@@ -69,8 +69,19 @@ public:
 	// Note, we don't need to make this virtual since this class is marked final (basically it can't be used as a base class)
 	~ShaderProgram();
 
+	/// <summary>
+	/// The directory that linked program binaries are cached in
+	/// </summary>
+	static const std::string CACHE_DIRECTORY;
+	/// <summary>
+	/// The extension used for cached program binaries
+	/// </summary>
+	static const std::string CACHE_EXTENSION;
+
 	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// Compilation is deferred until Link, so that programs which are already in the binary cache
+	/// never need to be compiled. Compile errors will be reported by Link
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -94,6 +105,8 @@ public:
 
 	/// <summary>
 	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// If a program with the same resolved sources has been linked before with the same driver, the
+	/// binary and uniform info will be loaded from the cache instead of compiling the shader parts
 	/// </summary>
 	/// <returns>True if the linking was successful, false if otherwise</returns>
 	bool Link();
@@ -180,6 +193,11 @@ protected:
 	// Stores all the handles to our shaders until we
 	// are ready to compile them into a program
 	std::unordered_map<ShaderPartType, int> _handles;
+	// Stores the fully resolved source for each shader part until we link,
+	// at which point we either load the program from cache or compile them
+	std::unordered_map<ShaderPartType, std::string> _pendingSources;
+	// The names of any transform feedback varyings, since they are part of the linked program
+	std::string _varyingsKey;
 	
 	// Map access to look up uniform locations and blocks
 	std::unordered_map<std::string, UniformInfo> _uniforms;
@@ -209,5 +227,73 @@ protected:
 	/// </summary>
 	void _IntrospectUnifromBlocks();
 
+	/// <summary>
+	/// Compiles a single shader part, logging any errors
+	/// </summary>
+	/// <returns>The handle to the shader part, or 0 if it failed to compile</returns>
+	static GLuint _CompileShaderPart(const char* source, ShaderPartType type);
+
+	/// <summary>
+	/// Calculates a hash of the resolved shader sources, varyings, and the driver we are running on. Since includes
+	/// are resolved before hashing, changing any file that goes into the program will change the key
+	/// </summary>
+	/// <param name="outFingerprint">Receives a second hash of the same data with a different seed, which is stored
+	/// in the cache file to catch two programs whose keys collide</param>
+	/// <returns>The key that names the cache file</returns>
+	uint64_t _ComputeCacheKey(uint64_t& outFingerprint) const;
+	/// <summary>
+	/// Tries to load the program binary and uniform info from a cache file
+	/// </summary>
+	/// <param name="filename">The path to the cache file</param>
+	/// <param name="fingerprint">The fingerprint that the file must have been written with</param>
+	/// <returns>True if the program was loaded and linked, false if we need to compile it</returns>
+	bool _LoadFromCache(const std::string& filename, uint64_t fingerprint);
+	/// <summary>
+	/// Writes the linked program binary and the uniform info to a cache file
+	/// </summary>
+	/// <param name="filename">The path to the cache file</param>
+	/// <param name="fingerprint">The fingerprint to store in the file</param>
+	void _SaveToCache(const std::string& filename, uint64_t fingerprint) const;
+	/// <summary>
+	/// Stores the results of introspection so they can be cached next to the program binary
+	/// </summary>
+	nlohmann::json _IntrospectionToJson() const;
+	/// <summary>
+	/// Restores the results of introspection that were stored with _IntrospectionToJson
+	/// </summary>
+	void _IntrospectionFromJson(const nlohmann::json& data);
+
+	// Will be put at the start of the cache file, contains info about the contents of the file
+	struct CacheHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'S', 'P', 'R', 'G' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint32_t Version = 0;
+		// A second hash of the program's sources, the file name alone can't tell apart two programs whose keys collide
+		uint64_t Fingerprint = 0;
+		// The driver specific format of the binary, from glGetProgramBinary
+		uint32_t BinaryFormat = 0;
+		// The size of the program binary, which directly follows the header
+		uint32_t BinarySize = 0;
+		// The size of the msgpack encoded introspection data, which follows the binary
+		uint32_t IntrospectionSize = 0;
+	};
+
+	// The current version of the cache format that we write out
+	static const uint32_t CACHE_VERSION = 0x02;
+	// The most program binaries we'll keep in the cache directory, the least recently used are removed past this
+	static const size_t CACHE_MAX_FILES = 256;
+
+	/// <summary>
+	/// Returns true if the driver supports at least one program binary format
+	/// </summary>
+	static bool __IsBinaryCacheSupported();
+	/// <summary>
+	/// Removes the least recently used program binaries from the cache directory until it holds at most
+	/// CACHE_MAX_FILES. Editing a shader or updating the driver changes every affected key, so without this the
+	/// old binaries would be left behind forever
+	/// </summary>
+	static void __PruneCache();
+
 	int __GetUniformLocation(const std::string& name);
 };
\ No newline at end of file
@@ -13,7 +13,7 @@ ITexture::ITexture(TextureType type) :
 
 void ITexture::_Recreate()
 {
-	if (_rendererId == 0) {
+	if (_rendererId != 0) {
 		glDeleteTextures(1, &_rendererId);
 	}
 	glCreateTextures((GLenum)_type, 1, &_rendererId);
@@ -1,6 +1,7 @@
 #include "Texture1D.h"
 #include "Utils/Base64.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/VirtualFileSystem.h"
 #include <stb_image.h>
 
 inline int CalcRequiredMipLevels(int size) {
@@ -130,7 +131,10 @@ void Texture1D::_LoadDataFromFile()
 
 		// Use STBI to load the image
 		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
+		VirtualFile file(_description.Filename);
+		uint8_t* data = file.IsOpen() ?
+			stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &numChannels, targetChannels) :
+			nullptr;
 
 		// If we could not load any data, warn and return null
 		if (data == nullptr) {
@@ -4,6 +4,12 @@
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Graphics/Textures/TextureUploader.h"
+#include "Application/JobSystem.h"
+#include "Utils/VirtualFileSystem.h"
+#include <filesystem>
+#include <GLFW/glfw3.h>
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -23,6 +29,8 @@ nlohmann::json Texture2D::ToJson() const {
 		{ "filter_mag",       ~_description.MagnificationFilter },
 		{ "anisotropic",       _description.MaxAnisotropic },
 		{ "generate_mipmaps",  _description.GenerateMipMaps },
+		{ "precomputed_mipmaps", _description.PrecomputedMipMaps },
+		{ "compress",          _description.Compress },
 	};
 
 	if (!_description.Filename.empty()) {
@@ -45,8 +53,7 @@ nlohmann::json Texture2D::ToJson() const {
 	return result;
 }
 
-Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
-{
+Texture2DDescription Texture2D::_ParseDescription(const nlohmann::json& data) {
 	Texture2DDescription descr = Texture2DDescription();
 	descr.Filename = data["filename"];
 	descr.HorizontalWrap = JsonParseEnum(WrapMode, data, "wrap_s", WrapMode::ClampToEdge);
@@ -55,6 +62,14 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.MaxAnisotropic      = JsonGet(data, "anisotropic", 0.0f);
 	descr.GenerateMipMaps     = JsonGet(data, "generate_mipmaps", false);
+	descr.PrecomputedMipMaps  = JsonGet(data, "precomputed_mipmaps", false);
+	descr.Compress            = JsonGet(data, "compress", false);
+	return descr;
+}
+
+Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
+{
+	Texture2DDescription descr = _ParseDescription(data);
 
 	Texture2D::Sptr result = std::make_shared<Texture2D>(descr);
 
@@ -73,6 +88,15 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 	return result;
 }
 
+Texture2D::Sptr Texture2D::FromJsonAsync(const nlohmann::json& data) {
+	// Only textures that come from files can be loaded in the background
+	if (!data.contains("filename") || !data["filename"].is_string() || data["filename"].get<std::string>().empty()) {
+		return FromJson(data);
+	}
+	Texture2DDescription descr = _ParseDescription(data);
+	return LoadAsync(descr.Filename, descr);
+}
+
 Texture2D::Texture2D(const Texture2DDescription& description) : 
 	ITexture(TextureType::_2D),
 	_description(description),
@@ -118,7 +142,8 @@ void Texture2D::SetAnisoLevel(float value) {
 		_description.MaxAnisotropic = glm::clamp(value, 1.0f, ITexture::GetLimits().MAX_ANISOTROPY);
 		glTextureParameterf(_rendererId, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
 
-		if (_description.GenerateMipMaps) {
+		// Compressed textures come with their mip chain, and can't be re-generated without decompressing them
+		if (_description.GenerateMipMaps && !IsCompressedFormat(_description.Format)) {
 			glGenerateTextureMipmap(_rendererId);
 		}
 	}
@@ -128,72 +153,232 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 	// Ensure the rectangle we're setting is within the bounds of the image
 	LOG_ASSERT((width + offsetX) <= _description.Width, "Pixel bounds are outside of the X extents of the image!");
 	LOG_ASSERT((height + offsetY) <= _description.Height, "Pixel bounds are outside of the Y extents of the image!");
+	LOG_ASSERT(!IsCompressedFormat(_description.Format), "Cannot load uncompressed data into a compressed texture!");
 
 	_description.FormatHint = format;
 	_pixelType = type;
 
+	// Upload our data to our image
+	_UploadLevel(0, width, height, format, type, data, offsetX, offsetY);
+
+	// If requested, generate mip-maps for our texture
+	if (_description.GenerateMipMaps) {
+		glGenerateTextureMipmap(_rendererId);
+	}
+}
+
+void Texture2D::_UploadLevel(int level, uint32_t width, uint32_t height, PixelFormat format, PixelType type, const void* data, uint32_t offsetX, uint32_t offsetY) {
 	// Align the data store to the size of a single component to ensure we don't get weirdness with images that aren't RGBA
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 	int componentSize = (GLint)GetTexelComponentSize(type);
 	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
 
-	// Upload our data to our image
-	glTextureSubImage2D(_rendererId, 0, offsetX, offsetY, width, height, (GLenum)format, (GLenum)type, data);
+	// Copy the pixels into the staging buffer so the driver can pull them over DMA instead of copying them on this thread
+	size_t dataSize = GetTexelSize(format, type) * width * height;
+	const void* pixels = data != nullptr ? TextureUploader::Stage(data, dataSize) : nullptr;
+	glTextureSubImage2D(_rendererId, level, offsetX, offsetY, width, height, (GLenum)format, (GLenum)type, pixels);
+	TextureUploader::EndUpload();
 
-	// If requested, generate mip-maps for our texture
-	if (_description.GenerateMipMaps) {
-		glGenerateTextureMipmap(_rendererId);
+	// Restore the default unpack alignment for anything else that uploads pixels
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+Texture2D::DecodedImage::DecodedImage() :
+	Levels(),
+	NumChannels(0),
+	Compressed()
+{ }
+
+Texture2D::DecodedImage::~DecodedImage() {
+	for (const Level& level : Levels) {
+		if (level.Data != nullptr) {
+			stbi_image_free(level.Data);
+		}
 	}
 }
 
-void Texture2D::_LoadDataFromFile() {
-	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
+bool Texture2D::_DecodeFile(const std::string& filename, PixelFormat formatHint, bool loadMipChain, DecodedImage& result) {
+	const int targetChannels = GetTexelComponentCount(formatHint);
+
+	// Collect the files we need to decode, each precomputed mip level lives in it's own file next to the image
+	std::vector<std::string> files = { filename };
+	if (loadMipChain) {
+		std::filesystem::path path = filename;
+		std::filesystem::path stem = path.parent_path() / path.stem();
+		for (int level = 1; ; level++) {
+			std::filesystem::path levelPath = stem;
+			levelPath += "_mip" + std::to_string(level) + path.extension().string();
+			if (!VirtualFileSystem::Exists(levelPath.string())) {
+				break;
+			}
+			files.push_back(levelPath.string());
+		}
+	}
 
-	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
-		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
+	// Use STBI to decode every level at once across the job system
+	stbi_set_flip_vertically_on_load(true);
+	std::vector<int> channels(files.size(), 0);
+	result.Levels.resize(files.size(), { nullptr, 0, 0 });
+	JobSystem::ParallelFor(files.size(), 1, [&](size_t start, size_t end) {
+		for (size_t ix = start; ix < end; ix++) {
+			DecodedImage::Level& level = result.Levels[ix];
+			// Decode from memory so that images can come from mounted asset packs
+			VirtualFile file(files[ix]);
+			level.Data = file.IsOpen() ?
+				stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &level.Width, &level.Height, &channels[ix], targetChannels) :
+				nullptr;
+		}
+	});
 
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
+	// If we could not load any data, warn and return null
+	if (result.Levels[0].Data == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", filename);
+		return false;
+	}
 
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	result.NumChannels = targetChannels != 0 ? targetChannels : channels[0];
+
+	// The mip chain is only usable if every level is present, and each one is half the size of the last
+	if (result.Levels.size() > 1) {
+		const int width  = result.Levels[0].Width;
+		const int height = result.Levels[0].Height;
+		bool valid = (int)result.Levels.size() == CalcRequiredMipLevels(width, height);
+		for (size_t ix = 1; valid && ix < result.Levels.size(); ix++) {
+			const DecodedImage::Level& level = result.Levels[ix];
+			valid = level.Data != nullptr &&
+				level.Width == glm::max(1, width >> ix) &&
+				level.Height == glm::max(1, height >> ix) &&
+				(targetChannels != 0 || channels[ix] == channels[0]);
 		}
 
-		// We should estimate a good format for our data
+		if (!valid) {
+			LOG_WARN("Mip chain for \"{}\" is incomplete or does not match the image, mips will be generated instead", filename);
+			for (size_t ix = 1; ix < result.Levels.size(); ix++) {
+				if (result.Levels[ix].Data != nullptr) {
+					stbi_image_free(result.Levels[ix].Data);
+				}
+			}
+			result.Levels.resize(1);
+		}
+	}
+
+	return true;
+}
+
+bool Texture2D::_DecodeImage(const Texture2DDescription& description, DecodedImage& result) {
+	bool loadMipChain = description.GenerateMipMaps && description.PrecomputedMipMaps;
+
+	if (description.Compress) {
+		std::string cachePath = TextureCompressor::GetCachePath(description.Filename);
+		const int targetChannels = GetTexelComponentCount(description.FormatHint);
+
+		// The cache needs to be rebuilt if the image has changed, or if we're asking for a different number of channels
+		if (!TextureCompressor::IsCacheStale(description.Filename, cachePath) && TextureCompressor::LoadCache(cachePath, result.Compressed)) {
+			if (targetChannels == 0 || result.Compressed.NumChannels == targetChannels) {
+				return true;
+			}
+			result.Compressed.File.Close();
+			result.Compressed.Levels.clear();
+			result.Compressed.Format = InternalFormat::Unknown;
+		}
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+		// Decode the source image and build the cache from it
+		DecodedImage source;
+		if (!_DecodeFile(description.Filename, description.FormatHint, loadMipChain, source)) {
+			return false;
+		}
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+		float startTime = static_cast<float>(glfwGetTime());
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+		std::vector<TextureCompressor::SourceLevel> levels;
+		levels.reserve(source.Levels.size());
+		for (const DecodedImage::Level& level : source.Levels) {
+			levels.push_back({ level.Data, level.Width, level.Height });
 		}
+		if (TextureCompressor::WriteCache(cachePath, levels, source.NumChannels) && TextureCompressor::LoadCache(cachePath, result.Compressed)) {
+			float endTime = static_cast<float>(glfwGetTime());
+			LOG_TRACE("Compressed \"{}\" to \"{}\" in {} seconds", description.Filename, cachePath, endTime - startTime);
+			return true;
+		}
+
+		// We already have the pixels, so fall back to using them uncompressed
+		LOG_WARN("Failed to build compressed texture cache for \"{}\", it will be loaded uncompressed", description.Filename);
+		result.Levels = std::move(source.Levels);
+		result.NumChannels = source.NumChannels;
+		source.Levels.clear();
+		return true;
+	}
+
+	return _DecodeFile(description.Filename, description.FormatHint, loadMipChain, result);
+}
+
+void Texture2D::_UploadImage(const DecodedImage& image) {
+	// Compressed images are uploaded block for block, with the mip chain that was built along with the cache
+	if (IsCompressedFormat(image.Compressed.Format)) {
+		const TextureCompressor::CompressedLevel& base = image.Compressed.Levels[0];
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+		_description.Format = image.Compressed.Format;
+		_description.Width = base.Width;
+		_description.Height = base.Height;
+		_description.FormatHint = GetPixelFormatForChannels(image.Compressed.NumChannels);
+		_pixelType = PixelType::UByte;
 
 		// Allocates our memory
 		_SetTextureParams();
 
-		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+		size_t numLevels = _description.GenerateMipMaps ? image.Compressed.Levels.size() : 1;
+		for (size_t ix = 0; ix < numLevels; ix++) {
+			const TextureCompressor::CompressedLevel& level = image.Compressed.Levels[ix];
+			const void* blocks = TextureUploader::Stage(level.Data, level.Size);
+			glCompressedTextureSubImage2D(_rendererId, (GLint)ix, 0, 0, level.Width, level.Height, *_description.Format, (GLsizei)level.Size, blocks);
+			TextureUploader::EndUpload();
+		}
+		return;
+	}
+
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(image.NumChannels);
+	PixelFormat    image_format = GetPixelFormatForChannels(image.NumChannels);
+
+	const DecodedImage::Level& base = image.Levels[0];
+
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Width = base.Width;
+	_description.Height = base.Height;
+
+	// Allocates our memory
+	_SetTextureParams();
+
+	// If we have the whole mip chain on hand, upload every level rather than generating them
+	if (_description.GenerateMipMaps && image.Levels.size() > 1) {
+		_description.FormatHint = image_format;
+		_pixelType = PixelType::UByte;
+		for (size_t ix = 0; ix < image.Levels.size(); ix++) {
+			const DecodedImage::Level& level = image.Levels[ix];
+			_UploadLevel((int)ix, level.Width, level.Height, image_format, PixelType::UByte, level.Data);
+		}
+	}
+	// Upload data to our texture
+	else {
+		LoadData(base.Width, base.Height, image_format, PixelType::UByte, base.Data);
+	}
+}
+
+void Texture2D::_LoadDataFromFile() {
+	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+	if (!_description.Filename.empty()) {
+		// Decode the image, the image will clean up the STBI data when we're done with it
+		DecodedImage image;
+		if (!_DecodeImage(_description, image)) {
+			return;
+		}
+		_UploadImage(image);
 	}
 	
 	SetDebugName(_description.Filename);
@@ -244,4 +429,40 @@ Texture2D::Sptr Texture2D::LoadFromFile(const std::string& path, const Texture2D
 	Texture2D::Sptr result = std::make_shared<Texture2D>(desc);
 
 	return result;
-}
\ No newline at end of file
+}
+
+Texture2D::Sptr Texture2D::LoadAsync(const std::string& path, const Texture2DDescription& description) {
+	// Start off with a single white texel, so that anything using the texture still draws sensibly
+	Texture2DDescription desc = description;
+	desc.Filename = "";
+	desc.Width    = 1;
+	desc.Height   = 1;
+	desc.Format   = InternalFormat::RGBA8;
+	Texture2D::Sptr result = std::make_shared<Texture2D>(desc);
+
+	uint8_t white[4] = { 255, 255, 255, 255 };
+	result->LoadData(1, 1, PixelFormat::RGBA, PixelType::UByte, white);
+
+	// Restore the bits of the description that describe the file, so that the texture serializes correctly
+	result->_description.Filename   = path;
+	result->_description.FormatHint = description.FormatHint;
+	result->SetDebugName(path);
+
+	// Decode on a worker, then swap our storage out for the real image on the main thread
+	Texture2DDescription fileDesc = description;
+	fileDesc.Filename = path;
+	ResourceManager::QueueLoad([result, fileDesc]() -> ResourceManager::UploadCallback {
+		std::shared_ptr<DecodedImage> image = std::make_shared<DecodedImage>();
+		if (!_DecodeImage(fileDesc, *image)) {
+			return nullptr;
+		}
+		return [result, image]() {
+			// Texture storage is immutable, so we need a new texture object to fit the real image
+			result->_Recreate();
+			result->_UploadImage(*image);
+			result->SetDebugName(result->_description.Filename);
+		};
+	});
+
+	return result;
+}
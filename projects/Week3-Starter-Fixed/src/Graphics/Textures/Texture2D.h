@@ -1,5 +1,6 @@
 #pragma once
 #include "ITexture.h"
+#include "Graphics/Textures/TextureCompressor.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -43,6 +44,18 @@ struct Texture2DDescription {
 	/// </summary>
 	bool           GenerateMipMaps;
 	/// <summary>
+	/// True if the mip chain should be loaded from files next to the image rather than generated at runtime.
+	/// Each level is stored in it's own file with a _mip suffix (ex: sand.png, sand_mip1.png, sand_mip2.png ...),
+	/// if any level is missing or the wrong size we fall back to generating mips. Only used when GenerateMipMaps is set
+	/// </summary>
+	bool           PrecomputedMipMaps;
+	/// <summary>
+	/// True if the image should be block compressed on the GPU (BC1/BC3 for color, BC4/BC5 for one or two channels).
+	/// The compressed blocks and their mip chain are cached next to the image in a .ctex file, which is built the
+	/// first time the image is loaded and rebuilt whenever the image is newer than the cache
+	/// </summary>
+	bool           Compress;
+	/// <summary>
 	/// Returns the number of samples if the texture is multisampled, default 1
 	/// </summary>
 	uint8_t        MultisampleCount;
@@ -69,6 +82,8 @@ struct Texture2DDescription {
 		MagnificationFilter(MagFilter::Linear),
 		MaxAnisotropic(-1.0f), // max aniso by default
 		GenerateMipMaps(true),
+		PrecomputedMipMaps(false),
+		Compress(false),
 		MultisampleCount(1),
 		Filename(""),
 		FormatHint(PixelFormat::RGBA)
@@ -148,6 +163,67 @@ protected:
 	Texture2DDescription _description;
 	PixelType _pixelType;
 
+	/// <summary>
+	/// Pixel data that has been decoded from an image file, and is waiting to be uploaded
+	/// </summary>
+	struct DecodedImage {
+		NO_MOVE(DecodedImage);
+		NO_COPY(DecodedImage);
+
+		/// <summary>
+		/// A single level of the image, allocated by STBI
+		/// </summary>
+		struct Level {
+			uint8_t* Data;
+			int      Width;
+			int      Height;
+		};
+
+		/// <summary>
+		/// The base image, followed by any precomputed mip levels
+		/// </summary>
+		std::vector<Level> Levels;
+		int                NumChannels;
+		/// <summary>
+		/// Set when the image was loaded from a compressed cache, in which case Levels is empty
+		/// </summary>
+		TextureCompressor::CompressedImage Compressed;
+
+		DecodedImage();
+		~DecodedImage();
+	};
+
+	/// <summary>
+	/// Decodes an image file into memory, this does not touch OpenGL so it is safe to call from any thread
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <param name="formatHint">Determines the number of channels to load</param>
+	/// <param name="loadMipChain">True to also load the precomputed mip chain stored next to the image</param>
+	/// <param name="result">Will store the decoded image</param>
+	/// <returns>True if the image was loaded, false if otherwise</returns>
+	static bool _DecodeFile(const std::string& filename, PixelFormat formatHint, bool loadMipChain, DecodedImage& result);
+	/// <summary>
+	/// Decodes the image file for a description, going through the compressed cache if the description asks
+	/// for compression. This does not touch OpenGL so it is safe to call from any thread
+	/// </summary>
+	/// <param name="description">The description of the texture to load, including the filename</param>
+	/// <param name="result">Will store the decoded image</param>
+	/// <returns>True if the image was loaded, false if otherwise</returns>
+	static bool _DecodeImage(const Texture2DDescription& description, DecodedImage& result);
+	/// <summary>
+	/// Allocates our texture's memory to fit a decoded image, then uploads the image to it
+	/// </summary>
+	/// <param name="image">The image to upload</param>
+	void _UploadImage(const DecodedImage& image);
+	/// <summary>
+	/// Uploads a region of a single mip level, staging the pixels through the TextureUploader
+	/// </summary>
+	void _UploadLevel(int level, uint32_t width, uint32_t height, PixelFormat format, PixelType type, const void* data, uint32_t offsetX = 0, uint32_t offsetY = 0);
+	/// <summary>
+	/// Extracts the texture description from a JSON blob
+	/// </summary>
+	static Texture2DDescription _ParseDescription(const nlohmann::json& data);
+
 	/// <summary>
 	/// Loads this texture from the file specified in the description
 	/// Will overwrite description size
@@ -160,4 +236,17 @@ protected:
 
 public:
 	static Texture2D::Sptr LoadFromFile(const std::string& path, const Texture2DDescription& description = Texture2DDescription(), bool forceRgba = true);
+
+	/// <summary>
+	/// Creates a texture that loads it's image in the background. Until the load completes, the texture
+	/// will be a single white texel
+	/// </summary>
+	/// <param name="path">The path to the image file to load</param>
+	/// <param name="description">The sampler parameters and format hint to use for the texture</param>
+	/// <returns>The placeholder texture, which will be filled in once loading finishes</returns>
+	static Texture2D::Sptr LoadAsync(const std::string& path, const Texture2DDescription& description = Texture2DDescription());
+	/// <summary>
+	/// Same as FromJson, but textures loaded from files will load in the background
+	/// </summary>
+	static Texture2D::Sptr FromJsonAsync(const nlohmann::json& data);
 };
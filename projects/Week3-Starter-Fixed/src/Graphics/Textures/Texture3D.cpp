@@ -2,10 +2,12 @@
 #include "Utils/Base64.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
 #include <Logging.h>
 #include <stb_image.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
 
 inline int CalcRequiredMipLevels(int width, int height, int depth) {
@@ -149,12 +151,13 @@ void Texture3D::_LoadDataFromFile()
 
 void Texture3D::_LoadCubeFile()
 {
-	std::ifstream inFile(_description.Filename);
-
-	if (!inFile.is_open()) {
+	// Read the whole file through the virtual file system, so LUTs can come from mounted asset packs
+	std::string contents;
+	if (!VirtualFileSystem::ReadFile(_description.Filename, contents)) {
 		LOG_WARN("Failed to open file .cube file: {}", _description.Filename);
 		return;
 	}
+	std::istringstream inFile(contents);
 
 	glm::u8vec3* textureData = nullptr;
 	uint32_t lutSize{ 0 };
@@ -0,0 +1,408 @@
+#include "Graphics/Textures/TextureCompressor.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cfloat>
+#include "Application/JobSystem.h"
+#include "Logging.h"
+
+namespace fs = std::filesystem;
+
+const std::string TextureCompressor::CACHE_EXTENSION = ".ctex";
+
+TextureCompressor::CompressedImage::CompressedImage() :
+	Format(InternalFormat::Unknown),
+	NumChannels(0),
+	Levels(),
+	File()
+{ }
+
+/// <summary>
+/// Gets the number of levels in a full mip chain for an image of the given size
+/// </summary>
+inline int GetMipChainLength(int width, int height) {
+	int size = glm::max(width, height);
+	int result = 1;
+	while (size > 1) {
+		size >>= 1;
+		result++;
+	}
+	return result;
+}
+
+/// <summary>
+/// Packs an 8 bit color into a 5:6:5 color
+/// </summary>
+inline uint16_t PackColor565(const glm::vec3& color) {
+	glm::ivec3 c = glm::ivec3(glm::round(glm::clamp(color, glm::vec3(0.0f), glm::vec3(255.0f)) * glm::vec3(31.0f, 63.0f, 31.0f) / 255.0f));
+	return static_cast<uint16_t>((c.r << 11) | (c.g << 5) | c.b);
+}
+
+/// <summary>
+/// Expands a 5:6:5 color back to an 8 bit color, the same way the GPU will
+/// </summary>
+inline glm::vec3 UnpackColor565(uint16_t color) {
+	int r = (color >> 11) & 0x1F;
+	int g = (color >> 5) & 0x3F;
+	int b = color & 0x1F;
+	return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+/// <summary>
+/// Encodes the RGB channels of a 4x4 block of pixels into an 8 byte BC1 color block. The endpoints are
+/// found by fitting a line through the colors along their principal axis
+/// </summary>
+static void EncodeColorBlock(const uint8_t pixels[16][4], uint8_t* result) {
+	glm::vec3 colors[16];
+	glm::vec3 mean = glm::vec3(0.0f);
+	glm::vec3 min = glm::vec3(255.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+	for (int ix = 0; ix < 16; ix++) {
+		colors[ix] = glm::vec3(pixels[ix][0], pixels[ix][1], pixels[ix][2]);
+		mean += colors[ix];
+		min = glm::min(min, colors[ix]);
+		max = glm::max(max, colors[ix]);
+	}
+	mean /= 16.0f;
+
+	uint16_t color0 = PackColor565(mean);
+	uint16_t color1 = color0;
+
+	if (min != max) {
+		// Build the covariance matrix of the colors
+		glm::mat3 covariance = glm::mat3(0.0f);
+		for (int ix = 0; ix < 16; ix++) {
+			glm::vec3 d = colors[ix] - mean;
+			covariance += glm::outerProduct(d, d);
+		}
+
+		// Power iteration converges on the axis with the most variance, the bounding box diagonal is a good starting guess
+		glm::vec3 axis = max - min;
+		for (int iteration = 0; iteration < 8; iteration++) {
+			glm::vec3 next = covariance * axis;
+			float length = glm::length(next);
+			if (length < 1e-6f) {
+				break;
+			}
+			axis = next / length;
+		}
+		axis = glm::normalize(axis);
+
+		// Our endpoints are the furthest projections of the colors onto the axis
+		float minT = 0.0f, maxT = 0.0f;
+		for (int ix = 0; ix < 16; ix++) {
+			float t = glm::dot(colors[ix] - mean, axis);
+			minT = glm::min(minT, t);
+			maxT = glm::max(maxT, t);
+		}
+		color0 = PackColor565(mean + axis * maxT);
+		color1 = PackColor565(mean + axis * minT);
+
+		// The first color needs to be larger to select the 4 color mode
+		if (color0 < color1) {
+			std::swap(color0, color1);
+		}
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1) {
+		glm::vec3 palette[4];
+		palette[0] = UnpackColor565(color0);
+		palette[1] = UnpackColor565(color1);
+		palette[2] = (palette[0] * 2.0f + palette[1]) / 3.0f;
+		palette[3] = (palette[0] + palette[1] * 2.0f) / 3.0f;
+
+		for (int ix = 0; ix < 16; ix++) {
+			int best = 0;
+			float bestError = FLT_MAX;
+			for (int p = 0; p < 4; p++) {
+				glm::vec3 d = colors[ix] - palette[p];
+				float error = glm::dot(d, d);
+				if (error < bestError) {
+					bestError = error;
+					best = p;
+				}
+			}
+			indices |= static_cast<uint32_t>(best) << (ix * 2);
+		}
+	}
+
+	result[0] = color0 & 0xFF;
+	result[1] = color0 >> 8;
+	result[2] = color1 & 0xFF;
+	result[3] = color1 >> 8;
+	memcpy(result + 4, &indices, sizeof(uint32_t));
+}
+
+/// <summary>
+/// Encodes a single channel of a 4x4 block of pixels into an 8 byte BC4 block, this is also the alpha
+/// block for BC3 and each of the channel blocks for BC5
+/// </summary>
+static void EncodeChannelBlock(const uint8_t pixels[16][4], int channel, uint8_t* result) {
+	int min = 255, max = 0;
+	for (int ix = 0; ix < 16; ix++) {
+		min = glm::min(min, (int)pixels[ix][channel]);
+		max = glm::max(max, (int)pixels[ix][channel]);
+	}
+
+	// With the larger value first we use the 8 value mode, where index 0 is the max, 1 is the min and
+	// 2-7 step from the max towards the min
+	uint64_t indices = 0;
+	if (max != min) {
+		int range = max - min;
+		for (int ix = 0; ix < 16; ix++) {
+			int step = ((pixels[ix][channel] - min) * 7 + range / 2) / range;
+			uint64_t index = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+			indices |= index << (ix * 3);
+		}
+	}
+
+	result[0] = static_cast<uint8_t>(max);
+	result[1] = static_cast<uint8_t>(min);
+	for (int ix = 0; ix < 6; ix++) {
+		result[2 + ix] = static_cast<uint8_t>(indices >> (ix * 8));
+	}
+}
+
+std::string TextureCompressor::GetCachePath(const std::string& filename) {
+	fs::path path = fs::path(filename);
+	path.replace_extension(CACHE_EXTENSION);
+	return path.string();
+}
+
+InternalFormat TextureCompressor::SelectFormat(const uint8_t* pixels, int width, int height, int numChannels) {
+	switch (numChannels) {
+		case 1:
+			return InternalFormat::BC4;
+		case 2:
+			return InternalFormat::BC5;
+		case 3:
+			return InternalFormat::BC1;
+		case 4:
+		{
+			// BC1 is half the size of BC3, so we only pay for the alpha channel if it's actually used
+			size_t count = (size_t)width * height;
+			for (size_t ix = 0; ix < count; ix++) {
+				if (pixels[ix * 4 + 3] != 255) {
+					return InternalFormat::BC3;
+				}
+			}
+			return InternalFormat::BC1;
+		}
+		default:
+			LOG_WARN("Unsupported texture format with {0} channels", numChannels);
+			return InternalFormat::Unknown;
+	}
+}
+
+size_t TextureCompressor::GetCompressedSize(InternalFormat format, int width, int height) {
+	return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * GetCompressedBlockSize(format);
+}
+
+void TextureCompressor::Compress(InternalFormat format, const uint8_t* pixels, int width, int height, int numChannels, uint8_t* result) {
+	LOG_ASSERT(IsCompressedFormat(format), "Format is not block compressed!");
+
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const size_t blockSize = GetCompressedBlockSize(format);
+
+	JobSystem::ParallelFor(blocksY, 4, [&](size_t start, size_t end) {
+		uint8_t block[16][4];
+		for (size_t by = start; by < end; by++) {
+			for (int bx = 0; bx < blocksX; bx++) {
+				// Gather the block, repeating the edge pixels for partial blocks. Missing channels are opaque
+				for (int ix = 0; ix < 16; ix++) {
+					int x = glm::min(bx * 4 + (ix & 3), width - 1);
+					int y = glm::min((int)by * 4 + (ix >> 2), height - 1);
+					const uint8_t* pixel = pixels + ((size_t)y * width + x) * numChannels;
+					for (int c = 0; c < 4; c++) {
+						block[ix][c] = c < numChannels ? pixel[c] : 255;
+					}
+				}
+
+				uint8_t* output = result + (by * blocksX + bx) * blockSize;
+				switch (format) {
+					case InternalFormat::BC1:
+						EncodeColorBlock(block, output);
+						break;
+					case InternalFormat::BC3:
+						EncodeChannelBlock(block, 3, output);
+						EncodeColorBlock(block, output + 8);
+						break;
+					case InternalFormat::BC4:
+						EncodeChannelBlock(block, 0, output);
+						break;
+					case InternalFormat::BC5:
+						EncodeChannelBlock(block, 0, output);
+						EncodeChannelBlock(block, 1, output + 8);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+	});
+}
+
+void TextureCompressor::Downsample(const uint8_t* pixels, int width, int height, int numChannels, std::vector<uint8_t>& result) {
+	const int newWidth = glm::max(1, width >> 1);
+	const int newHeight = glm::max(1, height >> 1);
+	result.resize((size_t)newWidth * newHeight * numChannels);
+
+	for (int y = 0; y < newHeight; y++) {
+		const uint8_t* row0 = pixels + (size_t)(y * 2) * width * numChannels;
+		const uint8_t* row1 = pixels + (size_t)glm::min(y * 2 + 1, height - 1) * width * numChannels;
+		for (int x = 0; x < newWidth; x++) {
+			int x0 = x * 2 * numChannels;
+			int x1 = glm::min(x * 2 + 1, width - 1) * numChannels;
+			for (int c = 0; c < numChannels; c++) {
+				int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+				result[((size_t)y * newWidth + x) * numChannels + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+bool TextureCompressor::WriteCache(const std::string& filename, const std::vector<SourceLevel>& levels, int numChannels) {
+	LOG_ASSERT(!levels.empty(), "Need at least one level to compress!");
+
+	const SourceLevel& base = levels[0];
+	InternalFormat format = SelectFormat(base.Data, base.Width, base.Height, numChannels);
+	if (format == InternalFormat::Unknown) {
+		return false;
+	}
+
+	// Fill in the rest of the mip chain, each level is downsampled from the one before it
+	const int numLevels = GetMipChainLength(base.Width, base.Height);
+	std::vector<SourceLevel> chain = levels;
+	std::vector<std::vector<uint8_t>> generated(numLevels);
+	chain.resize(glm::min((int)chain.size(), numLevels));
+	while ((int)chain.size() < numLevels) {
+		const SourceLevel& prev = chain.back();
+		std::vector<uint8_t>& pixels = generated[chain.size()];
+		Downsample(prev.Data, prev.Width, prev.Height, numChannels, pixels);
+		chain.push_back({ pixels.data(), glm::max(1, prev.Width >> 1), glm::max(1, prev.Height >> 1) });
+	}
+
+	// Lay out the file, each level starts on an aligned offset after the level table
+	CacheHeader header = CacheHeader();
+	header.Version     = CACHE_VERSION;
+	header.NumLevels   = static_cast<uint16_t>(numLevels);
+	header.Format      = static_cast<uint32_t>(*format);
+	header.NumChannels = static_cast<uint32_t>(numChannels);
+
+	std::vector<CacheLevel> table(numLevels);
+	uint64_t offset = sizeof(CacheHeader) + sizeof(CacheLevel) * numLevels;
+	for (int ix = 0; ix < numLevels; ix++) {
+		offset = (offset + LEVEL_ALIGNMENT - 1) & ~static_cast<uint64_t>(LEVEL_ALIGNMENT - 1);
+		table[ix].Offset = offset;
+		table[ix].Size   = GetCompressedSize(format, chain[ix].Width, chain[ix].Height);
+		table[ix].Width  = chain[ix].Width;
+		table[ix].Height = chain[ix].Height;
+		offset += table[ix].Size;
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) {
+		LOG_WARN("Failed to open \"{}\" for writing", filename);
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+	file.write(reinterpret_cast<const char*>(table.data()), sizeof(CacheLevel) * numLevels);
+
+	std::vector<uint8_t> blocks;
+	for (int ix = 0; ix < numLevels; ix++) {
+		// Pad with zeros until we reach the level's offset
+		static const char zeros[LEVEL_ALIGNMENT] = { 0 };
+		uint64_t position = static_cast<uint64_t>(file.tellp());
+		file.write(zeros, static_cast<std::streamsize>(table[ix].Offset - position));
+
+		blocks.resize(table[ix].Size);
+		Compress(format, chain[ix].Data, chain[ix].Width, chain[ix].Height, numChannels, blocks.data());
+		file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+	}
+
+	return file.good();
+}
+
+bool TextureCompressor::LoadCache(const std::string& filename, CompressedImage& result) {
+	result.Format = InternalFormat::Unknown;
+	result.NumChannels = 0;
+	result.Levels.clear();
+
+	if (!result.File.Open(filename)) {
+		return false;
+	}
+	result.File.Prefetch();
+
+	const uint8_t* data = result.File.GetData();
+	size_t size = result.File.GetSize();
+
+	// Read the header from the file, and make sure it's something we can load
+	CacheHeader header = CacheHeader();
+	if (size < sizeof(CacheHeader)) {
+		LOG_WARN("Not enough data in \"{}\"", filename);
+		result.File.Close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(CacheHeader));
+
+	InternalFormat format = static_cast<InternalFormat>(header.Format);
+	if (memcmp(header.HeaderBytes, CacheHeader().HeaderBytes, sizeof(header.HeaderBytes)) != 0 ||
+		header.Version != CACHE_VERSION ||
+		header.NumLevels == 0 ||
+		!IsCompressedFormat(format) ||
+		size < sizeof(CacheHeader) + sizeof(CacheLevel) * header.NumLevels) {
+		LOG_WARN("\"{}\" is not a valid compressed texture", filename);
+		result.File.Close();
+		return false;
+	}
+
+	std::vector<CacheLevel> table(header.NumLevels);
+	memcpy(table.data(), data + sizeof(CacheHeader), sizeof(CacheLevel) * header.NumLevels);
+
+	// Every level needs to be in the file, and the full mip chain needs to be there
+	bool valid = header.NumLevels == GetMipChainLength(table[0].Width, table[0].Height);
+	for (int ix = 0; valid && ix < header.NumLevels; ix++) {
+		const CacheLevel& level = table[ix];
+		valid = level.Width == glm::max(1u, table[0].Width >> ix) &&
+			level.Height == glm::max(1u, table[0].Height >> ix) &&
+			level.Size == GetCompressedSize(format, level.Width, level.Height) &&
+			level.Offset + level.Size <= size;
+		if (valid) {
+			result.Levels.push_back({ data + level.Offset, static_cast<size_t>(level.Size), (int)level.Width, (int)level.Height });
+		}
+	}
+
+	if (!valid) {
+		LOG_WARN("\"{}\" is not a valid compressed texture", filename);
+		result.Levels.clear();
+		result.File.Close();
+		return false;
+	}
+
+	result.Format = format;
+	result.NumChannels = static_cast<int>(header.NumChannels);
+	return true;
+}
+
+bool TextureCompressor::IsCacheStale(const std::string& sourceFile, const std::string& cacheFile) {
+	if (!VirtualFileSystem::Exists(cacheFile)) {
+		return true;
+	}
+
+	// If the cache isn't loose on disk it came from an asset pack, which was built with up to date caches
+	std::error_code error;
+	if (!fs::exists(cacheFile, error)) {
+		return false;
+	}
+
+	// If we can't find the source image, the cache is all we have
+	fs::file_time_type sourceTime = fs::last_write_time(sourceFile, error);
+	if (error) {
+		return false;
+	}
+	fs::file_time_type cacheTime = fs::last_write_time(cacheFile, error);
+	return error || cacheTime < sourceTime;
+}
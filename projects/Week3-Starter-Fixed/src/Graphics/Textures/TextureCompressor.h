@@ -0,0 +1,151 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Graphics/GlEnums.h"
+#include "Utils/VirtualFileSystem.h"
+
+/// <summary>
+/// Converts 8 bit images into block compressed textures (BC1, BC3, BC4 and BC5) with a full mip chain,
+/// and stores them in a cache file next to the source image. Much like the OptimizedObjLoader's .bin
+/// files, the cache is generated the first time an image is loaded, and every load after that can
+/// upload the blocks straight from the file without decoding anything
+/// </summary>
+class TextureCompressor {
+public:
+	TextureCompressor() = delete;
+
+	/// <summary>
+	/// The extension that replaces the source image's extension for cache files
+	/// </summary>
+	static const std::string CACHE_EXTENSION;
+
+	/// <summary>
+	/// A single level of an uncompressed source image, with the same number of channels as the others
+	/// </summary>
+	struct SourceLevel {
+		const uint8_t* Data;
+		int            Width;
+		int            Height;
+	};
+
+	/// <summary>
+	/// A single level of a compressed image, pointing into the mapped cache file
+	/// </summary>
+	struct CompressedLevel {
+		const uint8_t* Data;
+		size_t         Size;
+		int            Width;
+		int            Height;
+	};
+
+	/// <summary>
+	/// The contents of a cache file that has been mapped into memory, either directly or from an asset pack
+	/// </summary>
+	struct CompressedImage {
+		NO_COPY(CompressedImage);
+		NO_MOVE(CompressedImage);
+
+		InternalFormat               Format;
+		// The number of channels in the image the cache was created from
+		int                          NumChannels;
+		std::vector<CompressedLevel> Levels;
+		VirtualFile                  File;
+
+		CompressedImage();
+	};
+
+	/// <summary>
+	/// Gets the path of the cache file for the given source image
+	/// </summary>
+	static std::string GetCachePath(const std::string& filename);
+
+	/// <summary>
+	/// Selects the compressed format to use for an image, based on it's channels and whether it has any transparency
+	/// </summary>
+	/// <param name="pixels">The image's pixels, tightly packed</param>
+	/// <param name="width">The width of the image, in pixels</param>
+	/// <param name="height">The height of the image, in pixels</param>
+	/// <param name="numChannels">The number of 8 bit channels per pixel, between 1 and 4</param>
+	static InternalFormat SelectFormat(const uint8_t* pixels, int width, int height, int numChannels);
+	/// <summary>
+	/// Gets the number of bytes needed to store an image of the given size in a compressed format
+	/// </summary>
+	static size_t GetCompressedSize(InternalFormat format, int width, int height);
+
+	/// <summary>
+	/// Compresses an image into blocks, splitting rows of blocks across the job system. Blocks on the right and
+	/// bottom edges of images that aren't a multiple of 4 in size repeat the last row/column of pixels
+	/// </summary>
+	/// <param name="format">The compressed format to encode to</param>
+	/// <param name="pixels">The image's pixels, tightly packed</param>
+	/// <param name="width">The width of the image, in pixels</param>
+	/// <param name="height">The height of the image, in pixels</param>
+	/// <param name="numChannels">The number of 8 bit channels per pixel, between 1 and 4</param>
+	/// <param name="result">Will store the blocks, must be at least GetCompressedSize bytes</param>
+	static void Compress(InternalFormat format, const uint8_t* pixels, int width, int height, int numChannels, uint8_t* result);
+	/// <summary>
+	/// Box filters an image down to the next mip level, which is half the size (rounded down, minimum 1)
+	/// </summary>
+	/// <param name="pixels">The image's pixels, tightly packed</param>
+	/// <param name="width">The width of the image, in pixels</param>
+	/// <param name="height">The height of the image, in pixels</param>
+	/// <param name="numChannels">The number of 8 bit channels per pixel</param>
+	/// <param name="result">Will store the downsampled pixels</param>
+	static void Downsample(const uint8_t* pixels, int width, int height, int numChannels, std::vector<uint8_t>& result);
+
+	/// <summary>
+	/// Compresses an image and writes it to a cache file. Any levels after the base image that are given are
+	/// used as-is, the rest of the mip chain is generated by downsampling
+	/// </summary>
+	/// <param name="filename">The path of the cache file to write</param>
+	/// <param name="levels">The base image, followed by any precomputed mip levels</param>
+	/// <param name="numChannels">The number of 8 bit channels per pixel, between 1 and 4</param>
+	/// <returns>True if the file was written, false if otherwise</returns>
+	static bool WriteCache(const std::string& filename, const std::vector<SourceLevel>& levels, int numChannels);
+	/// <summary>
+	/// Maps a cache file into memory
+	/// </summary>
+	/// <param name="filename">The path of the cache file to load</param>
+	/// <param name="result">Will store the compressed image</param>
+	/// <returns>True if the file was loaded, false if it is missing or invalid</returns>
+	static bool LoadCache(const std::string& filename, CompressedImage& result);
+	/// <summary>
+	/// Returns true if the cache file for an image is missing, or older than the image itself. Caches that
+	/// are stored in a mounted asset pack are never stale
+	/// </summary>
+	/// <param name="sourceFile">The path to the source image</param>
+	/// <param name="cacheFile">The path to the cache file</param>
+	static bool IsCacheStale(const std::string& sourceFile, const std::string& cacheFile);
+
+protected:
+	// Will be put at the start of the cache file, contains info about the contents of the file
+	struct CacheHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'C', 'T', 'E', 'X' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint16_t Version = 0;
+		// The number of mip levels stored in the file
+		uint16_t NumLevels = 0;
+		// The GL internal format of the blocks
+		uint32_t Format = 0;
+		// The number of channels in the source image
+		uint32_t NumChannels = 0;
+	};
+
+	// Follows the header once for each mip level
+	struct CacheLevel {
+		// The offset of the level's blocks, from the start of the file
+		uint64_t Offset = 0;
+		// The size of the level's blocks in bytes
+		uint64_t Size = 0;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+	};
+
+	// The current version of the cache format that we write out
+	static const uint16_t CACHE_VERSION = 0x01;
+	// Every level starts on a multiple of this many bytes from the start of the file
+	static const uint32_t LEVEL_ALIGNMENT = 16;
+};
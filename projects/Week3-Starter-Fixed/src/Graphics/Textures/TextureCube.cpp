@@ -2,6 +2,15 @@
 #include <filesystem>
 #include "stb_image.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Graphics/Textures/TextureUploader.h"
+#include "Application/JobSystem.h"
+#include "Utils/VirtualFileSystem.h"
+
+TextureCube::TextureCube() :
+	ITexture(TextureType::Cubemap),
+	_description(TextureCubeDescription())
+{ }
 
 TextureCube::TextureCube(const std::string& baseFilename) :
 	ITexture(TextureType::Cubemap),
@@ -45,6 +54,16 @@ nlohmann::json TextureCube::ToJson() const
 }
 
 TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
+{
+	return std::make_shared<TextureCube>(_ParseDescription(data));
+}
+
+TextureCube::Sptr TextureCube::FromJsonAsync(const nlohmann::json& data)
+{
+	return _LoadAsync(_ParseDescription(data));
+}
+
+TextureCubeDescription TextureCube::_ParseDescription(const nlohmann::json& data)
 {
 	TextureCubeDescription descr = TextureCubeDescription();
 	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "filter_min", MinFilter::NearestMipNearest);
@@ -58,10 +77,63 @@ TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
 			}
 		}
 	}
-	return std::make_shared<TextureCube>(descr);
+	return descr;
+}
+
+TextureCube::Sptr TextureCube::LoadAsync(const std::string& baseFilename)
+{
+	TextureCubeDescription descr = TextureCubeDescription();
+	descr.Filename = baseFilename;
+	return _LoadAsync(descr);
+}
+
+TextureCube::Sptr TextureCube::_LoadAsync(const TextureCubeDescription& description)
+{
+	// We can't use make_shared here, since the empty constructor is protected
+	TextureCube::Sptr result = TextureCube::Sptr(new TextureCube());
+	result->_description = description;
+	if (!result->_ResolveFaceFilenames()) {
+		return result;
+	}
+
+	// Start off with a single white texel per face, so anything using the cubemap still draws sensibly
+	result->_description.Size       = 1;
+	result->_description.Format     = InternalFormat::RGBA8;
+	result->_description.FormatHint = PixelFormat::RGBA;
+	result->_SetTextureParams();
+	uint8_t white[4 * 6];
+	memset(white, 255, sizeof(white));
+	result->_UploadPixels(PixelFormat::RGBA, white, sizeof(white));
+
+	// Decode on a worker, then swap our storage out for the real faces on the main thread
+	std::unordered_map<CubeMapFace, std::string> faceFilenames = result->_description.FaceFileNames;
+	ResourceManager::QueueLoad([result, faceFilenames]() -> ResourceManager::UploadCallback {
+		std::shared_ptr<DecodedFaces> faces = std::make_shared<DecodedFaces>();
+		if (!_DecodeFaces(faceFilenames, *faces)) {
+			return nullptr;
+		}
+		return [result, faces]() {
+			// Texture storage is immutable, so we need a new texture object to fit the real faces
+			result->_Recreate();
+			result->_UploadFaces(*faces);
+		};
+	});
+
+	return result;
 }
 
 void TextureCube::_LoadFromDescription()
+{
+	// If we don't have 6 faces for our cube, something has gone horribly wrong (or the files don't exist)
+	if (!_ResolveFaceFilenames()) {
+		return;
+	}
+
+	// Load all the images into the texture
+	_LoadImages(_description.FaceFileNames);
+}
+
+bool TextureCube::_ResolveFaceFilenames()
 {
 	// If we weren't passed face filenames but WERE passed a base filename, try and get the 6 face files
 	if (_description.FaceFileNames.empty() && !_description.Filename.empty()) {
@@ -82,7 +154,7 @@ void TextureCube::_LoadFromDescription()
 			targetPath += baseName.extension();
 
 			// If the file exists, store it in the description
-			if (std::filesystem::exists(targetPath)) {
+			if (VirtualFileSystem::Exists(targetPath.string())) {
 				_description.FaceFileNames[face] = targetPath.string();
 			}
 		}
@@ -91,90 +163,138 @@ void TextureCube::_LoadFromDescription()
 	// If we don't have 6 faces for our cube, something has gone horribly wrong (or the files don't exist)
 	if (_description.FaceFileNames.size() != 6) {
 		LOG_ERROR("TextureCube was not given 6 faces, aborting load");
-		return;
+		return false;
 	}
-
-	// Load all the images into the texture
-	_LoadImages(_description.FaceFileNames);
+	return true;
 }
 
 void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
 {
-	// Will store all of our texture data, back to back in memory
-	uint8_t* datastore = nullptr;
-	// The size of a single face's texture, in bytes
-	size_t textureDataSize = 0;
+	DecodedFaces faces;
+	if (_DecodeFaces(faceFilenames, faces)) {
+		_UploadFaces(faces);
+	}
+}
 
-	// The number of channels that we're expecting
-	int numChannels = 0;
+TextureCube::DecodedFaces::DecodedFaces() :
+	Data(nullptr),
+	Size(0),
+	NumChannels(0)
+{ }
 
-	// Load all 6 faces
+TextureCube::DecodedFaces::~DecodedFaces() {
+	delete[] Data;
+}
+
+bool TextureCube::_DecodeFaces(const std::unordered_map<CubeMapFace, std::string>& faceFilenames, DecodedFaces& result)
+{
+	// Find the files for all 6 faces before we start decoding
+	std::string filenames[6];
 	for (int ix = 0; ix < 6; ix++) {
 		CubeMapFace face = (CubeMapFace)ix;
-		
-		const std::string& filename = _description.FaceFileNames[face];
-		int fileWidth, fileHeight, fileNumChannels;
 
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 0);
+		auto it = faceFilenames.find(face);
+		if (it == faceFilenames.end()) {
+			LOG_ERROR("TextureCube is missing an image for face {}", ~face);
+			return false;
+		}
+		filenames[ix] = it->second;
+	}
+
+	// Use STBI to decode all 6 faces at once across the job system
+	uint8_t* data[6] = { nullptr };
+	int fileWidth[6] = { 0 }, fileHeight[6] = { 0 }, fileNumChannels[6] = { 0 };
+	stbi_set_flip_vertically_on_load(true);
+	JobSystem::ParallelFor(6, 1, [&](size_t start, size_t end) {
+		for (size_t ix = start; ix < end; ix++) {
+			// Decode from memory so that faces can come from mounted asset packs
+			VirtualFile file(filenames[ix]);
+			data[ix] = file.IsOpen() ?
+				stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &fileWidth[ix], &fileHeight[ix], &fileNumChannels[ix], 0) :
+				nullptr;
+		}
+	});
+
+	// The size of a single face's texture, in bytes
+	size_t textureDataSize = 0;
+
+	// Validate the faces and copy them into a single block, so they can be uploaded in one call
+	bool success = true;
+	for (int ix = 0; ix < 6 && success; ix++) {
+		const std::string& filename = filenames[ix];
 
 		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			if (data != nullptr) { delete[] datastore; }
+		if (data[ix] == nullptr) {
 			LOG_ERROR("STBI Failed to load image from \"{}\"", filename);
-			return;
+			success = false;
 		}
 		// If the texture is not square, warn and abort
-		if (fileWidth != fileHeight) {
-			if (data != nullptr) { delete[] datastore; }
+		else if (fileWidth[ix] != fileHeight[ix]) {
 			LOG_ERROR("Image loaded from \"{}\" was not square", filename);
-			stbi_image_free(data);
-			return;
+			success = false;
 		}
 		// If the dataStore is empty, this is the first texture we loaded
-		if (datastore == nullptr) {
+		else if (result.Data == nullptr) {
 			// Store the size and number of channels
-			_description.Size = fileWidth;
-			numChannels = fileNumChannels;
-
-			// Get the format and pixel format for the number of channels
-			_description.Format = GetInternalFormatForChannels8(numChannels);
-			_description.FormatHint = GetPixelFormatForChannels(numChannels);
+			result.Size = fileWidth[ix];
+			result.NumChannels = fileNumChannels[ix];
 
 			// Determine how many bytes we'll need to store a single face worth of data
-			textureDataSize = ((size_t)_description.Size * _description.Size * GetTexelSize(_description.FormatHint, PixelType::Byte));
-
-			// This is one of those poorly documented things in OpenGL
-			if ((GetTexelSize(_description.FormatHint, PixelType::Byte) * _description.Size) % 4 != 0) {
-				LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-			}
+			PixelFormat format = GetPixelFormatForChannels(fileNumChannels[ix]);
+			textureDataSize = ((size_t)result.Size * result.Size * GetTexelSize(format, PixelType::Byte));
 
 			// Allocate the data store for our image data
-			datastore = new uint8_t[textureDataSize * 6];
+			result.Data = new uint8_t[textureDataSize * 6];
 		}
 		// If this is NOT the first image, and it does not match previous images, abort
-		else if (fileWidth != _description.Size || fileNumChannels != numChannels) {
-			delete[] datastore;
+		else if (fileWidth[ix] != result.Size || fileNumChannels[ix] != result.NumChannels) {
 			LOG_WARN("Image \"{}\" did not match size or format of texture cube", filename);
-			stbi_image_free(data);
-			return;
+			success = false;
 		}
 
 		// Copy the data we loaded into the corresponding location in the data store
-		memcpy(datastore + textureDataSize * ix, data, textureDataSize);
-		stbi_image_free(data);
+		if (success) {
+			memcpy(result.Data + textureDataSize * ix, data[ix], textureDataSize);
+		}
 	}
 
+	for (int ix = 0; ix < 6; ix++) {
+		if (data[ix] != nullptr) {
+			stbi_image_free(data[ix]);
+		}
+	}
+
+	return success;
+}
+
+void TextureCube::_UploadFaces(const DecodedFaces& faces)
+{
+	// Get the format and pixel format for the number of channels
+	_description.Size = faces.Size;
+	_description.Format = GetInternalFormatForChannels8(faces.NumChannels);
+	_description.FormatHint = GetPixelFormatForChannels(faces.NumChannels);
+
 	// Allocate memory and set up initial parameters
 	_SetTextureParams();
 
+	// Upload our data to our image (note that the custom enum tools let us convert to base type [GLenum] with the * operator)
+	size_t dataSize = (size_t)_description.Size * _description.Size * 6 * GetTexelSize(_description.FormatHint, PixelType::UByte);
+	_UploadPixels(_description.FormatHint, faces.Data, dataSize);
+}
+
+void TextureCube::_UploadPixels(PixelFormat format, const void* data, size_t dataSize)
+{
 	// Set our pixel alignment to a single byte so we don't get banding
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-	// Upload our data to our image (note that the custom enum tools let us convert to base type [GLenum] with the * operator)
-	glTextureSubImage3D(_rendererId, 0, 0, 0, 0, _description.Size, _description.Size, 6, *_description.FormatHint, *PixelType::UByte, datastore);
-	delete[] datastore;
+	// Copy the faces into the staging buffer so the driver can pull them over DMA instead of copying them on this thread
+	const void* pixels = TextureUploader::Stage(data, dataSize);
+	glTextureSubImage3D(_rendererId, 0, 0, 0, 0, _description.Size, _description.Size, 6, *format, *PixelType::UByte, pixels);
+	TextureUploader::EndUpload();
+
+	// Restore the default unpack alignment for anything else that uploads pixels
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 void TextureCube::_SetTextureParams(){
@@ -111,12 +111,76 @@ public:
 	virtual nlohmann::json ToJson() const override;
 	static TextureCube::Sptr FromJson(const nlohmann::json& data);
 
+	/// <summary>
+	/// Creates a cubemap that loads it's faces in the background. Until the load completes, each
+	/// face will be a single white texel
+	/// </summary>
+	/// <param name="baseFilename">The base filename to find the face images from, see TextureCubeDescription::Filename</param>
+	/// <returns>The placeholder cubemap, which will be filled in once loading finishes</returns>
+	static TextureCube::Sptr LoadAsync(const std::string& baseFilename);
+	/// <summary>
+	/// Same as FromJson, but the faces will be loaded in the background
+	/// </summary>
+	static TextureCube::Sptr FromJsonAsync(const nlohmann::json& data);
+
 protected:
 	TextureCubeDescription _description;
 
+	/// <summary>
+	/// Pixel data for all 6 faces that has been decoded from image files, and is waiting to be uploaded
+	/// </summary>
+	struct DecodedFaces {
+		NO_MOVE(DecodedFaces);
+		NO_COPY(DecodedFaces);
+
+		// Every face's texels, back to back in memory
+		uint8_t*    Data;
+		uint32_t    Size;
+		int         NumChannels;
+
+		DecodedFaces();
+		~DecodedFaces();
+	};
+
+	// Creates an empty cubemap with no storage, used by LoadAsync
+	TextureCube();
+
+	/// <summary>
+	/// Creates a placeholder cubemap from the description, and starts loading it's faces in the background
+	/// </summary>
+	static TextureCube::Sptr _LoadAsync(const TextureCubeDescription& description);
+	/// <summary>
+	/// Extracts the cubemap description from a JSON blob
+	/// </summary>
+	static TextureCubeDescription _ParseDescription(const nlohmann::json& data);
+
 	virtual void _LoadFromDescription();
 	virtual void _LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
 
+	/// <summary>
+	/// Fills in the face filenames from the base filename if they have not been provided
+	/// </summary>
+	/// <returns>True if we have a filename for all 6 faces</returns>
+	bool _ResolveFaceFilenames();
+	/// <summary>
+	/// Decodes the images for each face into memory, this does not touch OpenGL so it is safe to call from any thread
+	/// </summary>
+	/// <param name="faceFilenames">The images to load for each face</param>
+	/// <param name="result">Will store the decoded faces</param>
+	/// <returns>True if all faces loaded and match in size and format, false if otherwise</returns>
+	static bool _DecodeFaces(const std::unordered_map<CubeMapFace, std::string>& faceFilenames, DecodedFaces& result);
+	/// <summary>
+	/// Allocates our texture's memory to fit the decoded faces, then uploads them to it
+	/// </summary>
+	void _UploadFaces(const DecodedFaces& faces);
+	/// <summary>
+	/// Uploads all 6 faces of our allocated storage at once, staging the pixels through the TextureUploader
+	/// </summary>
+	/// <param name="format">The pixel layout of the data</param>
+	/// <param name="data">The unsigned byte pixels for all 6 faces, in face order</param>
+	/// <param name="dataSize">The size of the data, in bytes</param>
+	void _UploadPixels(PixelFormat format, const void* data, size_t dataSize);
+
 	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
@@ -0,0 +1,139 @@
+#include "Graphics/Textures/TextureUploader.h"
+#include <cstring>
+#include "Logging.h"
+
+// Staged blocks start on multiples of this, which covers the alignment needed for every pixel type
+static const uint32_t STAGING_ALIGNMENT = 16;
+
+GLuint TextureUploader::__buffer = 0;
+uint8_t* TextureUploader::__mappedData = nullptr;
+uint32_t TextureUploader::__size = 0;
+uint32_t TextureUploader::__head = 0;
+std::deque<TextureUploader::Region> TextureUploader::__regions;
+uint64_t TextureUploader::__bytesStaged = 0;
+
+void TextureUploader::Init(uint32_t stagingSize) {
+	if (__buffer != 0) {
+		return;
+	}
+
+	// Persistent mappings need immutable storage
+	glCreateBuffers(1, &__buffer);
+	glNamedBufferStorage(__buffer, stagingSize, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+	// Coherent mapping means that our writes are visible to the GPU without any explicit flushes
+	__mappedData = reinterpret_cast<uint8_t*>(glMapNamedBufferRange(__buffer, 0, stagingSize, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+	if (__mappedData == nullptr) {
+		LOG_WARN("Failed to map texture staging buffer, textures will be uploaded from client memory");
+		glDeleteBuffers(1, &__buffer);
+		__buffer = 0;
+		return;
+	}
+
+	__size = stagingSize;
+	__head = 0;
+	glObjectLabel(GL_BUFFER, __buffer, -1, "Texture Staging");
+}
+
+void TextureUploader::Cleanup() {
+	_FencePending();
+	while (!__regions.empty()) {
+		_RetireOldest();
+	}
+	if (__buffer != 0) {
+		glUnmapNamedBuffer(__buffer);
+		glDeleteBuffers(1, &__buffer);
+	}
+	__buffer = 0;
+	__mappedData = nullptr;
+	__size = 0;
+	__head = 0;
+}
+
+const void* TextureUploader::Stage(const void* data, size_t size) {
+	Init();
+
+	// Anything too big for the staging buffer goes through the driver like normal
+	if (__mappedData == nullptr || data == nullptr || size == 0 || size > __size) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return data;
+	}
+
+	// Blocks are never split, so wrap around to the start if it won't fit before the end
+	uint32_t start = (__head + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+	if (start + size > __size) {
+		start = 0;
+	}
+	uint32_t end = start + static_cast<uint32_t>(size);
+
+	// Wait for the GPU to finish with any blocks that we're about to overwrite. Regions are retired
+	// in the order they were staged, which is the same order they appear after the head in the ring
+	auto overlaps = [&]() {
+		for (const Region& region : __regions) {
+			if (region.Start < end && start < region.End) {
+				return true;
+			}
+		}
+		return false;
+	};
+	while (overlaps()) {
+		_RetireOldest();
+	}
+
+	memcpy(__mappedData + start, data, size);
+	__regions.push_back({ start, end, nullptr });
+	__head = end;
+	__bytesStaged += size;
+
+	// When a pixel unpack buffer is bound, the data pointer is treated as an offset into the buffer
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, __buffer);
+	return reinterpret_cast<const void*>(static_cast<uintptr_t>(start));
+}
+
+void TextureUploader::EndUpload() {
+	if (__buffer != 0) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	_FencePending();
+
+	// Free up any regions the GPU is already done with, without waiting on the rest
+	while (!__regions.empty()) {
+		GLenum result = glClientWaitSync(__regions.front().Fence, 0, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		_RetireOldest();
+	}
+}
+
+void TextureUploader::_FencePending() {
+	GLsync fence = nullptr;
+	for (auto it = __regions.rbegin(); it != __regions.rend() && it->Fence == nullptr; it++) {
+		if (fence == nullptr) {
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		it->Fence = fence;
+	}
+}
+
+void TextureUploader::_RetireOldest() {
+	// The uploads for any unfenced regions have already been issued, so we can fence them now
+	if (__regions.front().Fence == nullptr) {
+		_FencePending();
+	}
+
+	// Several regions can share a fence, we only wait on and delete it once
+	GLsync fence = __regions.front().Fence;
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true) {
+		GLenum result = glClientWaitSync(fence, flags, 1000000); // 1ms
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+			break;
+		}
+		flags = 0;
+	}
+	while (!__regions.empty() && __regions.front().Fence == fence) {
+		__regions.pop_front();
+	}
+	glDeleteSync(fence);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+/// <summary>
+/// Stages texture data through a persistently mapped pixel unpack buffer, so that the driver can
+/// copy it to the texture asynchronously instead of blocking on a copy out of client memory.
+/// 
+/// Usage is to call Stage with the pixel data, then pass the result to a glTextureSubImage* call in
+/// place of the pixel pointer. Once all the uploads for a texture have been issued, call EndUpload.
+/// Note that each staged block must be uploaded before the next one is staged
+/// </summary>
+class TextureUploader {
+public:
+	/// <summary>
+	/// The default size of the staging buffer, anything larger than this is uploaded from client memory
+	/// </summary>
+	static const uint32_t DEFAULT_STAGING_SIZE = 32 * 1024 * 1024;
+
+	/// <summary>
+	/// Creates the staging buffer, this will be called on the first upload if it has not been called already
+	/// </summary>
+	/// <param name="stagingSize">The size of the staging buffer in bytes</param>
+	static void Init(uint32_t stagingSize = DEFAULT_STAGING_SIZE);
+	/// <summary>
+	/// Waits for any uploads in flight, and releases the staging buffer
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Copies data into the staging buffer, and binds the staging buffer as the pixel unpack buffer
+	/// </summary>
+	/// <param name="data">The pixel data to stage</param>
+	/// <param name="size">The size of the data in bytes</param>
+	/// <returns>The value to pass as the pixel pointer to the upload, or data if it could not be staged</returns>
+	static const void* Stage(const void* data, size_t size);
+	/// <summary>
+	/// Unbinds the staging buffer, and marks everything staged since the last call as in use until the GPU
+	/// has finished reading it
+	/// </summary>
+	static void EndUpload();
+
+	/// <summary>
+	/// Gets the total number of bytes that have been uploaded through the staging buffer
+	/// </summary>
+	static uint64_t GetBytesStaged() { return __bytesStaged; }
+
+protected:
+	TextureUploader() = default;
+
+	// A block of the staging buffer that the GPU may still be reading from
+	struct Region {
+		uint32_t Start;
+		uint32_t End;
+		// Null if the region has not been fenced yet
+		GLsync   Fence;
+	};
+
+	static GLuint             __buffer;
+	static uint8_t*           __mappedData;
+	static uint32_t           __size;
+	static uint32_t           __head;
+	static std::deque<Region> __regions;
+	static uint64_t           __bytesStaged;
+
+	// Fences any regions that were staged since the last EndUpload
+	static void _FencePending();
+	// Blocks until the oldest region is no longer in use by the GPU, and frees it
+	static void _RetireOldest();
+};
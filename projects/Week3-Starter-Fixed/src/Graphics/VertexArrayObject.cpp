@@ -2,19 +2,30 @@
 #include "Buffers/IndexBuffer.h"
 #include "Buffers/VertexBuffer.h"
 #include "Logging.h"
+#include "Graphics/GeometryStore.h"
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
 	_handle(0),
 	_vertexCount(0),
 	_elementCount(0),
-	_vertexBuffers(std::vector<VertexBufferBinding*>())
+	_vertexBuffers(std::vector<VertexBufferBinding*>()),
+	_bounds(MeshBounds()),
+	_isStatic(false),
+	_sharedGeometry({ nullptr, 0, 0, 0 }),
+	_firstIndex(0),
+	_baseVertex(0)
 {
 	glCreateVertexArrays(1, &_handle);
 }
 
 VertexArrayObject::~VertexArrayObject()
 {
+	// Give our range in the store back so that it can be reused
+	if (_sharedGeometry.Store != nullptr) {
+		_sharedGeometry.Store->Release(this);
+	}
+
 	if (_handle != 0) {
 		glDeleteVertexArrays(1, &_handle);
 		_handle = 0;
@@ -43,7 +54,8 @@ VertexArrayObject::VertexBufferBinding* VertexArrayObject::AddVertexBuffer(const
 			_elementCount = _vertexCount;
 		}
 	} 
-	else if (buffer->GetElementCount() != _vertexCount) {
+	// Instanced buffers hold one element per instance, so they don't need to match our vertex count
+	else if (!instanced && buffer->GetElementCount() != _vertexCount) {
 		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 	}
 
@@ -54,17 +66,7 @@ VertexArrayObject::VertexBufferBinding* VertexArrayObject::AddVertexBuffer(const
 	_vertexBuffers.push_back(binding);
 
 
-	Bind();
-	buffer->Bind();
-	for (const BufferAttribute& attrib : attributes) {
-		glEnableVertexArrayAttrib(_handle, attrib.Slot);
-		glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
-							  (void*)attrib.Offset);
-
-		// Here is where we select whether the attribute is instanced or not
-		glVertexAttribDivisor(attrib.Slot, instanced ? 1 : 0);
-	}
-	Unbind();
+	_BindVertexBuffer(binding);
 
 	return binding;
 }
@@ -81,48 +83,73 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 			LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 		}
 
-		// Update the buffer the binding is pointing to
+		// Update the buffer the binding is pointing to, and re-bind the buffer and attributes
 		binding->Buffer = buffer;
+		_BindVertexBuffer(binding);
+	}
 
-		// Re-bind the buffer and attributes
-		Bind();
-		buffer->Bind();
-		for (const BufferAttribute& attrib : binding->Attributes) {
-			glEnableVertexArrayAttrib(_handle, attrib.Slot);
-			glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
-				(void*)attrib.Offset);
 
-			// Here is where we select whether the attribute is instanced or not
-			glVertexAttribDivisor(attrib.Slot, binding->Instanced ? 1 : 0);
-		}
-		Unbind();
-	}
+}
+
+void VertexArrayObject::SetSharedGeometry(const SharedGeometry& geometry, const VertexBuffer::Sptr& vertices, const IndexBuffer::Sptr& indices) {
+	LOG_ASSERT(_vertexBuffers.size() == 1 && indices != nullptr && indices->GetElementType() == IndexType::UInt,
+		"Only meshes with a single vertex buffer and 32 bit indices can share geometry");
 
+	_sharedGeometry = geometry;
+	_firstIndex = geometry.Store != nullptr ? geometry.FirstIndex : 0;
+	_baseVertex = geometry.Store != nullptr ? geometry.BaseVertex : 0;
 
+	// Swapping the buffers drops our references to the old ones, so the mesh's own buffers are freed
+	// once it has been copied into a store. Our vertex count stays the same, only where it starts moves
+	_vertexBuffers[0]->Buffer = vertices;
+	_BindVertexBuffer(_vertexBuffers[0]);
+
+	_indexBuffer = indices;
+	Bind();
+	_indexBuffer->Bind();
+	Unbind();
+	_elementCount = geometry.IndexCount;
+}
+
+void VertexArrayObject::_BindVertexBuffer(VertexBufferBinding* binding) {
+	Bind();
+	binding->Buffer->Bind();
+	for (const BufferAttribute& attrib : binding->Attributes) {
+		glEnableVertexArrayAttrib(_handle, attrib.Slot);
+		glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
+							  (void*)attrib.Offset);
+
+		// Here is where we select whether the attribute is instanced or not
+		glVertexAttribDivisor(attrib.Slot, binding->Instanced ? 1 : 0);
+	}
+	Unbind();
 }
 
 void VertexArrayObject::Draw(DrawMode mode) {
 	Bind();
 	if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
-		glDrawArrays((GLenum)mode, 0, elements);
+		glDrawArrays((GLenum)mode, _baseVertex, elements);
 	} else {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
-		glDrawElements((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr);
+		size_t offset = _firstIndex * GetIndexTypeSize(_indexBuffer->GetElementType());
+		glDrawElementsBaseVertex((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), reinterpret_cast<const void*>(offset), _baseVertex);
 	}
 	Unbind();
 }
 
-void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/)
+void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/, uint32_t baseInstance /*= 0*/)
 {
 	Bind();
 	if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
-		glDrawArraysInstanced((GLenum)mode, 0, elements, instanceCount);
+		glDrawArraysInstancedBaseInstance((GLenum)mode, _baseVertex, elements, instanceCount, baseInstance);
 	}
 	else {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
-		glDrawElementsInstanced((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount);
+		size_t offset = _firstIndex * GetIndexTypeSize(_indexBuffer->GetElementType());
+		glDrawElementsInstancedBaseVertexBaseInstance((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(),
+			reinterpret_cast<const void*>(offset), instanceCount, _baseVertex, baseInstance);
 	}
 	Unbind();
 	
@@ -176,7 +203,15 @@ VertexArrayObject::Sptr VertexArrayObject::Clone() const
 		result->AddVertexBuffer(binding->Buffer, binding->Attributes, binding->Instanced);
 	}
 
+	// Meshes in a geometry store only draw their own range of the store's buffers. The store never writes
+	// to a range that's in use, so the clone can keep drawing it even after the mesh has moved
+	result->_vertexCount  = _vertexCount;
+	result->_elementCount = _elementCount;
+	result->_firstIndex   = _firstIndex;
+	result->_baseVertex   = _baseVertex;
+
 	result->SetVDecl(_vDecl);
+	result->SetBounds(_bounds);
 
 	return result;
 }
@@ -9,6 +9,9 @@
 #include "Graphics/Buffers/IndexBuffer.h"
 #include "Graphics/GlEnums.h"
 #include "Graphics/IGraphicsResource.h"
+#include "Graphics/MeshBounds.h"
+
+class GeometryStore;
 
 /// <summary>
 /// This structure will represent the parameters passed to the glVertexAttribPointer commands
@@ -76,6 +79,20 @@ public:
 		std::vector<BufferAttribute> Attributes;
 		bool Instanced;
 	};
+
+	/// <summary>
+	/// Describes where a mesh's geometry lives inside of a GeometryStore
+	/// </summary>
+	struct SharedGeometry {
+		// The store containing the mesh, or nullptr if the mesh has not been added to one
+		GeometryStore* Store;
+		// The offset of the mesh's first index in the store's index buffer
+		uint32_t       FirstIndex;
+		// The number of indices in the mesh
+		uint32_t       IndexCount;
+		// The offset of the mesh's first vertex in the store's vertex buffer
+		int32_t        BaseVertex;
+	};
 	
 public:
 	/// <summary>
@@ -86,7 +103,7 @@ public:
 	~VertexArrayObject();
 
 	uint32_t GetVertexCount() const { return _vertexCount; }
-	uint32_t GetIndexCount() const { return _indexBuffer != nullptr ? _indexBuffer->GetElementCount() : 0; }
+	uint32_t GetIndexCount() const { return _indexBuffer != nullptr ? _elementCount : 0; }
 	uint32_t GetElementCount() const { return _elementCount; }
 
 	/// <summary>
@@ -119,6 +136,10 @@ public:
 	/// <param name="usage">The attribute usage hint to search for</param>
 	/// <returns>A const pointer to the binding, or nullptr if none is found</returns>
 	VertexBufferBinding* GetBufferBinding(AttribUsage usage);
+	/// <summary>
+	/// Gets all of the vertex buffer bindings for this VAO
+	/// </summary>
+	const std::vector<VertexBufferBinding*>& GetVertexBuffers() const { return _vertexBuffers; }
 
 	/// <summary>
 	/// Renders this VAO, using the specified draw mode
@@ -132,7 +153,8 @@ public:
 	/// </summary>
 	/// <param name="instanceCount">The number of instances to render</param>
 	/// <param name="mode">The primitive mode for rendering the mesh</param>
-	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
+	/// <param name="baseInstance">The index of the first instance to read from instanced buffers</param>
+	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList, uint32_t baseInstance = 0);
 
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
@@ -151,6 +173,55 @@ public:
 	void SetVDecl(const VertexDeclaration& vDecl);
 	const VertexDeclaration& GetVDecl();
 
+	/// <summary>
+	/// Sets the model space bounds of the geometry in this VAO, should be set by whatever
+	/// creates the VAO since we can't read the data back from the GPU cheaply
+	/// </summary>
+	/// <param name="bounds">The new bounds for the mesh</param>
+	void SetBounds(const MeshBounds& bounds) { _bounds = bounds; }
+	/// <summary>
+	/// Gets the model space bounds of the geometry in this VAO, if the bounds are not
+	/// valid the mesh should never be culled
+	/// </summary>
+	const MeshBounds& GetBounds() const { return _bounds; }
+
+	/// <summary>
+	/// Marks this VAO as static, meaning that it's buffers will never be modified after creation.
+	/// Static meshes may have their geometry copied into a GeometryStore by the renderer
+	/// </summary>
+	/// <param name="value">True if the mesh's geometry will never change</param>
+	void SetStatic(bool value) { _isStatic = value; }
+	/// <summary>
+	/// Returns true if this VAO has been marked as static, see SetStatic
+	/// </summary>
+	bool IsStatic() const { return _isStatic; }
+
+	/// <summary>
+	/// Records where this mesh's geometry was placed in a GeometryStore, and points this VAO at the
+	/// given buffers so that it draws it's range out of them. The buffers the mesh had before are
+	/// released. This is set by GeometryStore, which will also call it to move the mesh when it's
+	/// buffers are replaced, or to hand the mesh buffers of it's own if the store is destroyed first
+	/// </summary>
+	/// <param name="geometry">The location of the mesh in the store, or a Store of nullptr to give the mesh it's own buffers</param>
+	/// <param name="vertices">The buffer to draw vertices from</param>
+	/// <param name="indices">The buffer to draw indices from, must contain 32 bit indices</param>
+	void SetSharedGeometry(const SharedGeometry& geometry, const VertexBuffer::Sptr& vertices, const IndexBuffer::Sptr& indices);
+	/// <summary>
+	/// Gets where this mesh's geometry lives in a GeometryStore, Store will be nullptr if the
+	/// mesh has not been added to a store
+	/// </summary>
+	const SharedGeometry& GetSharedGeometry() const { return _sharedGeometry; }
+	/// <summary>
+	/// Gets the offset of this mesh's first vertex in it's vertex buffer, this is only non-zero for
+	/// meshes that live in a GeometryStore
+	/// </summary>
+	int32_t GetBaseVertex() const { return _baseVertex; }
+	/// <summary>
+	/// Gets the offset of this mesh's first index in it's index buffer, this is only non-zero for
+	/// meshes that live in a GeometryStore
+	/// </summary>
+	uint32_t GetFirstIndex() const { return _firstIndex; }
+
 protected:
 	
 	// The index buffer bound to this VAO
@@ -162,12 +233,26 @@ protected:
 	// defined in VertexTypes.cpp
 	VertexDeclaration _vDecl;
 
+	// The bounding volumes of the mesh, in model space
+	MeshBounds _bounds;
+
+	// Whether the mesh can be copied into a geometry store, and where it was placed if so
+	bool           _isStatic;
+	SharedGeometry _sharedGeometry;
+	// Where our range starts in the index and vertex buffers, these are only non-zero when the
+	// buffers belong to a geometry store
+	uint32_t       _firstIndex;
+	int32_t        _baseVertex;
+
 	uint32_t _vertexCount;
 	uint32_t _elementCount;
 
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
 
+	// Binds the binding's buffer to this VAO and sets up it's attributes
+	void _BindVertexBuffer(VertexBufferBinding* binding);
+
 	// Inherited via IGraphicsResource
 	virtual GlResourceType GetResourceClass() const override;
 };
@@ -0,0 +1,342 @@
+#include "Utils/AssetPack.h"
+#include <fstream>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <cstring>
+#include <json.hpp>
+#include <gzip/compress.hpp>
+#include <GLFW/glfw3.h>
+
+#include "Application/JobSystem.h"
+#include "Graphics/Textures/TextureCube.h"
+#include "Logging.h"
+
+namespace fs = std::filesystem;
+
+const std::string AssetPack::EXTENSION = ".pak";
+
+// Entries are only stored compressed if it saves at least this much space, otherwise
+// the time spent inflating them isn't worth it (ex: PNGs are already compressed)
+static const double COMPRESSION_THRESHOLD = 0.9;
+
+AssetPack::AssetPack() :
+	_file(),
+	_filename(""),
+	_entries(),
+	_pathIndex(),
+	_resourceIndex()
+{ }
+
+bool AssetPack::Open(const std::string& filename) {
+	Close();
+
+	if (!_file.Open(filename)) {
+		return false;
+	}
+
+	const uint8_t* data = _file.GetData();
+	size_t size = _file.GetSize();
+
+	// Read the header from the file, and make sure it's something we can load
+	PackHeader header = PackHeader();
+	if (size < sizeof(PackHeader)) {
+		LOG_WARN("Not enough data in \"{}\"", filename);
+		Close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(PackHeader));
+
+	const size_t indexSize = sizeof(PackEntry) * header.NumEntries;
+	if (memcmp(header.HeaderBytes, PackHeader().HeaderBytes, sizeof(header.HeaderBytes)) != 0 ||
+		header.Version != PACK_VERSION ||
+		size < sizeof(PackHeader) + indexSize + header.StringTableSize) {
+		LOG_WARN("\"{}\" is not a valid asset pack", filename);
+		Close();
+		return false;
+	}
+
+	std::vector<PackEntry> index(header.NumEntries);
+	memcpy(index.data(), data + sizeof(PackHeader), indexSize);
+	const char* strings = reinterpret_cast<const char*>(data + sizeof(PackHeader) + indexSize);
+
+	// Make sure every entry lies within the file before we hand out any pointers to it
+	_entries.reserve(header.NumEntries);
+	for (const PackEntry& packEntry : index) {
+		if ((uint64_t)packEntry.PathOffset + packEntry.PathLength > header.StringTableSize ||
+			packEntry.Offset + packEntry.Size > size) {
+			LOG_WARN("\"{}\" is not a valid asset pack", filename);
+			Close();
+			return false;
+		}
+
+		uint8_t resource[16];
+		memcpy(resource, packEntry.Resource, sizeof(resource));
+
+		Entry entry = Entry();
+		entry.Path             = std::string(strings + packEntry.PathOffset, packEntry.PathLength);
+		entry.Resource         = Guid::FromBytes(resource);
+		entry.Offset           = packEntry.Offset;
+		entry.Size             = packEntry.Size;
+		entry.UncompressedSize = packEntry.UncompressedSize;
+		entry.Compressed       = (packEntry.Flags & ENTRY_FLAG_COMPRESSED) != 0;
+		entry.Referenced       = (packEntry.Flags & ENTRY_FLAG_REFERENCED) != 0;
+
+		_pathIndex[entry.Path] = _entries.size();
+		if (entry.Resource.isValid() && entry.Referenced && _resourceIndex.count(entry.Resource) == 0) {
+			_resourceIndex[entry.Resource] = _entries.size();
+		}
+		_entries.push_back(entry);
+	}
+
+	_filename = filename;
+	LOG_INFO("Opened asset pack \"{}\" with {} files", filename, _entries.size());
+	return true;
+}
+
+void AssetPack::Close() {
+	_file.Close();
+	_filename = "";
+	_entries.clear();
+	_pathIndex.clear();
+	_resourceIndex.clear();
+}
+
+const AssetPack::Entry* AssetPack::Find(const std::string& path) const {
+	auto it = _pathIndex.find(NormalizePath(path));
+	return it != _pathIndex.end() ? &_entries[it->second] : nullptr;
+}
+
+const AssetPack::Entry* AssetPack::Find(Guid resource) const {
+	auto it = _resourceIndex.find(resource);
+	return it != _resourceIndex.end() ? &_entries[it->second] : nullptr;
+}
+
+const uint8_t* AssetPack::GetData(const Entry& entry) const {
+	LOG_ASSERT(IsOpen(), "Cannot get data from an asset pack that is not open!");
+	return _file.GetData() + entry.Offset;
+}
+
+std::string AssetPack::NormalizePath(const std::string& path) {
+	std::string result = fs::path(path).lexically_normal().generic_string();
+	// Strip any leading ./ so that "./shaders/foo.glsl" and "shaders/foo.glsl" match
+	while (result.size() > 2 && result[0] == '.' && result[1] == '/') {
+		result.erase(0, 2);
+	}
+	return result;
+}
+
+/// <summary>
+/// Reads an entire file from disk into a buffer
+/// </summary>
+static bool ReadLooseFile(const std::string& filename, std::string& result) {
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	file.seekg(0, std::ios::end);
+	result.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0, std::ios::beg);
+	file.read(&result[0], result.size());
+	return file.good() || result.empty();
+}
+
+/// <summary>
+/// Returns true if the file name belongs to a resource file with the given stem. This is either the stem
+/// with any extension (the file itself, or a cache such as .ctex, .bin or .hull), or the stem followed by a
+/// suffix that a loader looks for next to the file (precomputed mip levels or cubemap faces)
+/// </summary>
+static bool IsResourceSibling(const std::string& name, const std::string& stem) {
+	if (name.compare(0, stem.size(), stem) != 0) {
+		return false;
+	}
+	std::string suffix = name.substr(stem.size());
+	if (suffix.empty() || suffix[0] == '.') {
+		return true;
+	}
+
+	// Precomputed mip levels, ex: foo_mip1.png
+	if (suffix.compare(0, 4, "_mip") == 0) {
+		size_t end = suffix.find_first_not_of("0123456789", 4);
+		return end > 4 && end != std::string::npos && suffix[end] == '.';
+	}
+
+	// Cubemap faces, ex: foo_PosX.png
+	for (int ix = 0; ix < 6; ix++) {
+		std::string face = "_" + ~(CubeMapFace)ix + ".";
+		if (suffix.compare(0, face.size(), face) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/// <summary>
+/// Adds a file that was referenced by a resource to the pack, along with all the files next to it that
+/// share it's name (caches, mip levels, cubemap faces etc...)
+/// </summary>
+static void CollectResourceFile(const fs::path& file, Guid resource, std::map<std::string, Guid>& files, std::set<std::string>& referenced) {
+	std::string stem = file.stem().string();
+	fs::path directory = file.parent_path();
+
+	std::error_code error;
+	for (const auto& sibling : fs::directory_iterator(directory.empty() ? fs::path(".") : directory, error)) {
+		std::string name = sibling.path().filename().string();
+		if (sibling.is_regular_file() && IsResourceSibling(name, stem)) {
+			// Keep the path relative to the working directory, same as the manifest
+			files.emplace(AssetPack::NormalizePath((directory / name).string()), resource);
+		}
+	}
+	files.emplace(AssetPack::NormalizePath(file.string()), resource);
+	referenced.insert(AssetPack::NormalizePath(file.string()));
+}
+
+/// <summary>
+/// Walks a resource's JSON blob looking for strings that refer to files on disk
+/// </summary>
+static void CollectResourceFiles(const nlohmann::json& blob, Guid resource, std::map<std::string, Guid>& files, std::set<std::string>& referenced) {
+	if (blob.is_string()) {
+		const std::string& value = blob.get_ref<const std::string&>();
+		std::error_code error;
+		if (!value.empty() && value.size() < 260 && fs::is_regular_file(value, error)) {
+			CollectResourceFile(fs::path(value), resource, files, referenced);
+		}
+	} else if (blob.is_structured()) {
+		for (const auto& child : blob) {
+			CollectResourceFiles(child, resource, files, referenced);
+		}
+	}
+}
+
+bool AssetPack::Build(const std::string& filename, const std::string& manifestPath, const std::vector<std::string>& extraPaths, bool compress) {
+	float startTime = static_cast<float>(glfwGetTime());
+
+	std::string manifestContents;
+	if (!ReadLooseFile(manifestPath, manifestContents)) {
+		LOG_ERROR("Failed to read manifest \"{}\"", manifestPath);
+		return false;
+	}
+	nlohmann::json manifest = nlohmann::json::parse(manifestContents, nullptr, false);
+	if (manifest.is_discarded() || !manifest.is_object()) {
+		LOG_ERROR("\"{}\" is not a valid resource manifest", manifestPath);
+		return false;
+	}
+
+	// Find every file we'll need, ordered by path so that packs are deterministic
+	std::map<std::string, Guid> files;
+	std::set<std::string> referenced;
+	files.emplace(NormalizePath(manifestPath), Guid());
+	for (auto& [typeName, resources] : manifest.items()) {
+		if (!resources.is_object()) {
+			continue;
+		}
+		for (auto& [guid, blob] : resources.items()) {
+			CollectResourceFiles(blob, Guid(guid), files, referenced);
+		}
+	}
+	for (const std::string& path : extraPaths) {
+		std::error_code error;
+		if (fs::is_directory(path, error)) {
+			for (const auto& file : fs::recursive_directory_iterator(path, error)) {
+				if (file.is_regular_file()) {
+					files.emplace(NormalizePath(file.path().string()), Guid());
+				}
+			}
+		} else if (fs::is_regular_file(path, error)) {
+			files.emplace(NormalizePath(path), Guid());
+		} else {
+			LOG_WARN("Could not find \"{}\" to add to asset pack", path);
+		}
+	}
+
+	// Never try and pack the pack into itself
+	files.erase(NormalizePath(filename));
+
+	std::vector<Entry> entries;
+	entries.reserve(files.size());
+	for (auto& [path, resource] : files) {
+		Entry entry = Entry();
+		entry.Path = path;
+		entry.Resource = resource;
+		entry.Compressed = false;
+		entry.Referenced = referenced.count(path) != 0;
+		entries.push_back(entry);
+	}
+
+	// Reading and compressing is the slow part, so spread it across the job system
+	std::vector<std::string> contents(entries.size());
+	std::vector<uint8_t> failed(entries.size(), 0);
+	JobSystem::ParallelFor(entries.size(), 1, [&](size_t start, size_t end) {
+		for (size_t ix = start; ix < end; ix++) {
+			Entry& entry = entries[ix];
+			if (!ReadLooseFile(entry.Path, contents[ix])) {
+				failed[ix] = 1;
+				continue;
+			}
+			entry.UncompressedSize = contents[ix].size();
+			if (compress && !contents[ix].empty()) {
+				std::string compressed = gzip::compress(contents[ix].data(), contents[ix].size());
+				if (compressed.size() < contents[ix].size() * COMPRESSION_THRESHOLD) {
+					contents[ix] = std::move(compressed);
+					entry.Compressed = true;
+				}
+			}
+			entry.Size = contents[ix].size();
+		}
+	});
+
+	for (size_t ix = 0; ix < entries.size(); ix++) {
+		if (failed[ix]) {
+			LOG_ERROR("Failed to read \"{}\" while building asset pack", entries[ix].Path);
+			return false;
+		}
+	}
+
+	// Lay out the file, the index and strings come first, then each entry on an aligned offset
+	PackHeader header = PackHeader();
+	header.Version = PACK_VERSION;
+	header.NumEntries = static_cast<uint32_t>(entries.size());
+
+	std::string strings;
+	std::vector<PackEntry> index(entries.size());
+	for (size_t ix = 0; ix < entries.size(); ix++) {
+		index[ix].PathOffset = static_cast<uint32_t>(strings.size());
+		index[ix].PathLength = static_cast<uint32_t>(entries[ix].Path.size());
+		strings += entries[ix].Path;
+	}
+	header.StringTableSize = static_cast<uint32_t>(strings.size());
+
+	uint64_t offset = sizeof(PackHeader) + sizeof(PackEntry) * index.size() + strings.size();
+	uint64_t totalUncompressed = 0;
+	for (size_t ix = 0; ix < entries.size(); ix++) {
+		offset = (offset + ENTRY_ALIGNMENT - 1) & ~static_cast<uint64_t>(ENTRY_ALIGNMENT - 1);
+		index[ix].Offset           = offset;
+		index[ix].Size             = entries[ix].Size;
+		index[ix].UncompressedSize = entries[ix].UncompressedSize;
+		index[ix].Flags            = (entries[ix].Compressed ? ENTRY_FLAG_COMPRESSED : 0) | (entries[ix].Referenced ? ENTRY_FLAG_REFERENCED : 0);
+		memcpy(index[ix].Resource, entries[ix].Resource.bytes(), sizeof(index[ix].Resource));
+		offset += entries[ix].Size;
+		totalUncompressed += entries[ix].UncompressedSize;
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) {
+		LOG_ERROR("Failed to open \"{}\" for writing", filename);
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(PackHeader));
+	file.write(reinterpret_cast<const char*>(index.data()), sizeof(PackEntry) * index.size());
+	file.write(strings.data(), strings.size());
+	for (size_t ix = 0; ix < entries.size(); ix++) {
+		// Pad with zeros until we reach the entry's offset
+		static const char zeros[ENTRY_ALIGNMENT] = { 0 };
+		uint64_t position = static_cast<uint64_t>(file.tellp());
+		file.write(zeros, static_cast<std::streamsize>(index[ix].Offset - position));
+		file.write(contents[ix].data(), contents[ix].size());
+	}
+
+	float endTime = static_cast<float>(glfwGetTime());
+	LOG_INFO("Built asset pack \"{}\" with {} files in {} seconds ({} bytes -> {} bytes)", filename, entries.size(), endTime - startTime, totalUncompressed, offset);
+	return file.good();
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Utils/Macros.h"
+#include "Utils/GUID.hpp"
+#include "Utils/MappedFile.h"
+
+/// <summary>
+/// A single archive that holds many asset files, indexed by their path and by the GUID of the
+/// resource that uses them. The pack is memory mapped when it is opened, so uncompressed entries
+/// can be handed straight to loaders without copying them out of the file first
+///
+/// Packs are usually mounted through the VirtualFileSystem rather than used directly
+/// </summary>
+class AssetPack final {
+public:
+	MAKE_PTRS(AssetPack);
+	NO_COPY(AssetPack);
+	NO_MOVE(AssetPack);
+
+	/// <summary>
+	/// The extension used for asset packs
+	/// </summary>
+	static const std::string EXTENSION;
+
+	/// <summary>
+	/// Describes a single file stored in the pack
+	/// </summary>
+	struct Entry {
+		// The normalized path of the file, see NormalizePath
+		std::string Path;
+		// The resource in the manifest that referenced this file, or an invalid GUID if none did
+		Guid        Resource;
+		// The offset of the entry's data, from the start of the pack
+		uint64_t    Offset;
+		// The size of the entry's data in the pack
+		uint64_t    Size;
+		// The size of the file once decompressed, same as Size if the entry is not compressed
+		uint64_t    UncompressedSize;
+		// True if the entry's data has been gzip compressed
+		bool        Compressed;
+		// True if the manifest names this file directly, rather than it being a cache or other file next to it
+		bool        Referenced;
+	};
+
+	AssetPack();
+	~AssetPack() = default;
+
+	/// <summary>
+	/// Maps a pack into memory and loads it's index, closing any pack that was previously open
+	/// </summary>
+	/// <param name="filename">The path of the pack to open</param>
+	/// <returns>True if the pack was opened, false if it is missing or invalid</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Closes the pack, any pointers returned by GetData will no longer be valid
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if a pack is currently open
+	/// </summary>
+	bool IsOpen() const { return _file.IsOpen(); }
+	/// <summary>
+	/// Gets the path that the pack was opened from
+	/// </summary>
+	const std::string& GetFilename() const { return _filename; }
+	/// <summary>
+	/// Gets all the entries stored in the pack
+	/// </summary>
+	const std::vector<Entry>& GetEntries() const { return _entries; }
+
+	/// <summary>
+	/// Finds the entry for a file in the pack
+	/// </summary>
+	/// <param name="path">The path of the file, does not need to be normalized</param>
+	/// <returns>The entry for the file, or nullptr if it is not in the pack</returns>
+	const Entry* Find(const std::string& path) const;
+	/// <summary>
+	/// Finds the file in the pack that a resource's manifest entry names. If a resource names more than
+	/// one file, the first one by path is returned
+	/// </summary>
+	/// <param name="resource">The GUID of the resource in the manifest</param>
+	/// <returns>The entry for the file, or nullptr if the resource has no files in the pack</returns>
+	const Entry* Find(Guid resource) const;
+	/// <summary>
+	/// Gets a pointer to an entry's data in the mapped pack. Compressed entries will need to be
+	/// inflated before they can be used
+	/// </summary>
+	const uint8_t* GetData(const Entry& entry) const;
+
+	/// <summary>
+	/// Normalizes a path so that it can be used to look up entries, this resolves any ../ parts of
+	/// the path, and uses forward slashes for separators
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+
+	/// <summary>
+	/// Builds a new asset pack from a resource manifest. The manifest itself is stored in the pack, along with
+	/// any file that the manifest references, and any file next to those that shares the same name (for instance
+	/// the .bin cache for an OBJ file, the .ctex cache and mip chain of an image, or the faces of a cubemap)
+	/// </summary>
+	/// <param name="filename">The path of the pack to write</param>
+	/// <param name="manifestPath">The path to a resource manifest, as saved by ResourceManager::SaveManifest</param>
+	/// <param name="extraPaths">Any other files or directories to include in the pack, such as scene files or shader includes</param>
+	/// <param name="compress">True if entries should be compressed when it makes them noticeably smaller</param>
+	/// <returns>True if the pack was written, false if otherwise</returns>
+	static bool Build(const std::string& filename, const std::string& manifestPath, const std::vector<std::string>& extraPaths = std::vector<std::string>(), bool compress = true);
+
+protected:
+	// Will be put at the start of the pack, contains info about the contents of the file
+	struct PackHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'A', 'P', 'A', 'K' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint32_t Version = 0;
+		// The number of entries in the index, which directly follows the header
+		uint32_t NumEntries = 0;
+		// The size of the string table, which directly follows the index
+		uint32_t StringTableSize = 0;
+	};
+
+	// Follows the header once for each file in the pack
+	struct PackEntry {
+		// The offset of the file's data, from the start of the pack
+		uint64_t Offset = 0;
+		// The size of the file's data in the pack
+		uint64_t Size = 0;
+		// The size of the file once decompressed
+		uint64_t UncompressedSize = 0;
+		// The location of the file's path in the string table
+		uint32_t PathOffset = 0;
+		uint32_t PathLength = 0;
+		// The GUID of the resource that referenced the file, all zeros if there is none
+		uint8_t  Resource[16] = { 0 };
+		// Combination of the ENTRY_FLAG values
+		uint32_t Flags = 0;
+		uint32_t Reserved = 0;
+	};
+
+	// Set when the entry's data has been gzip compressed
+	static const uint32_t ENTRY_FLAG_COMPRESSED = 1 << 0;
+	// Set when the manifest names the entry's file directly
+	static const uint32_t ENTRY_FLAG_REFERENCED = 1 << 1;
+
+	// The current version of the pack format that we write out
+	static const uint32_t PACK_VERSION = 0x01;
+	// Every entry starts on a multiple of this many bytes from the start of the file
+	static const uint32_t ENTRY_ALIGNMENT = 64;
+
+	MappedFile                              _file;
+	std::string                             _filename;
+	std::vector<Entry>                      _entries;
+	std::unordered_map<std::string, size_t> _pathIndex;
+	std::unordered_map<Guid, size_t>        _resourceIndex;
+};
@@ -0,0 +1,143 @@
+#include "Utils/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Logging.h"
+
+MappedFile::MappedFile() :
+	_data(nullptr),
+	_size(0),
+	_fileHandle(nullptr),
+	_mappingHandle(nullptr)
+{ }
+
+MappedFile::MappedFile(const std::string& filename) :
+	MappedFile()
+{
+	Open(filename);
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filename) {
+	Close();
+
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		LOG_WARN("Failed to open \"{}\" for mapping", filename);
+		return false;
+	}
+
+	// Empty files can't be mapped, so we treat them as an error
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		LOG_WARN("Failed to create file mapping for \"{}\"", filename);
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		LOG_WARN("Failed to map view of \"{}\"", filename);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_data = reinterpret_cast<const uint8_t*>(view);
+	_size = static_cast<size_t>(size.QuadPart);
+	_fileHandle = file;
+	_mappingHandle = mapping;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+		CloseHandle(_mappingHandle);
+		CloseHandle(_fileHandle);
+	}
+	_data = nullptr;
+	_size = 0;
+	_fileHandle = nullptr;
+	_mappingHandle = nullptr;
+}
+
+void MappedFile::Prefetch() const {
+	#if _WIN32_WINNT >= 0x0602
+	if (_data != nullptr) {
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = const_cast<uint8_t*>(_data);
+		range.NumberOfBytes = _size;
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+	#endif
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filename) {
+	Close();
+
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		LOG_WARN("Failed to open \"{}\" for mapping", filename);
+		return false;
+	}
+
+	// Empty files can't be mapped, so we treat them as an error
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping keeps it's own reference to the file, so we can close it right away
+	close(file);
+	if (view == MAP_FAILED) {
+		LOG_WARN("Failed to map \"{}\"", filename);
+		return false;
+	}
+
+	_data = reinterpret_cast<const uint8_t*>(view);
+	_size = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	_data = nullptr;
+	_size = 0;
+	_fileHandle = nullptr;
+	_mappingHandle = nullptr;
+}
+
+void MappedFile::Prefetch() const {
+	if (_data != nullptr) {
+		madvise(const_cast<uint8_t*>(_data), _size, MADV_WILLNEED);
+	}
+}
+
+#endif
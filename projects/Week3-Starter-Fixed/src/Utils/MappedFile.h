@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A read-only view of a file that has been memory mapped into our address space. The OS pages
+/// the file in as it is accessed, so we can hand pointers into the file straight to OpenGL
+/// without copying the contents into our own buffers first
+/// </summary>
+class MappedFile final {
+public:
+	MAKE_PTRS(MappedFile);
+	NO_COPY(MappedFile);
+	NO_MOVE(MappedFile);
+
+	MappedFile();
+	/// <summary>
+	/// Creates a new mapped file and opens the given path
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	MappedFile(const std::string& filename);
+	~MappedFile();
+
+	/// <summary>
+	/// Maps the given file, closing any file that was previously mapped
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	/// <returns>True if the file was mapped, false if it could not be opened</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Unmaps the file, any pointers returned by GetData will no longer be valid
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if a file is currently mapped
+	/// </summary>
+	bool IsOpen() const { return _data != nullptr; }
+	/// <summary>
+	/// Gets a pointer to the start of the file's contents, or nullptr if no file is mapped
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the mapped file in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+	/// <summary>
+	/// Hints to the OS that we are about to read the whole file, so that it can start paging it in
+	/// ahead of time. This is only a hint and may do nothing
+	/// </summary>
+	void Prefetch() const;
+
+protected:
+	const uint8_t* _data;
+	size_t         _size;
+
+	// Platform handles for the file and mapping, unused on platforms that don't need them
+	void*          _fileHandle;
+	void*          _mappingHandle;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/VertexParamMap.h"
 
 /// <summary>
 /// A utility class that lets us add vertices and indices, then bake it into a final mesh, using interleaved
@@ -137,10 +138,23 @@ public:
 
 		// Store our vertex type in the VAO's vertex declaration
 		result->SetVDecl(VertType::V_DECL);
+		result->SetBounds(CalculateBounds());
 
 		return result;
 	}
 	
+	/// <summary>
+	/// Calculates the bounding box and sphere of the vertices in this mesh, returns invalid
+	/// bounds if the vertex type has no float3 position
+	/// </summary>
+	MeshBounds CalculateBounds() const {
+		VertexParamMap vMap = VertexParamMap(VertType::V_DECL);
+		if (vMap.PositionOffset == static_cast<uint32_t>(-1)) {
+			return MeshBounds();
+		}
+		return MeshBounds::FromVertexData(_vertices.data(), sizeof(VertType), vMap.PositionOffset, _vertices.size());
+	}
+
 	/// <summary>
 	/// Resets this mesh, removing all vertices and indices
 	/// </summary>
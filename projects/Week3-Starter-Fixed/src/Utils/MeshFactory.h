@@ -153,14 +153,17 @@ public:
 	/// </summary>
 	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
 	/// <param name="mesh">The mesh to manipulate</param>
+	/// <param name="allowParallel">If false, large meshes will not be spread across the job system</param>
 	template <typename Vertex>
-	static void CalculateTBN(MeshBuilder<Vertex>& mesh);
+	static void CalculateTBN(MeshBuilder<Vertex>& mesh, bool allowParallel = true);
 
 protected:	
 	MeshFactory() = default;
 	~MeshFactory() = default;
 
 	inline static const glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
+	// Meshes with at least this many triangles will have their tangents calculated across the job system
+	inline static const size_t TBN_PARALLEL_THRESHOLD = 16384;
 };
 
 #include "MeshFactory.inl"
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <GLM/gtx/euler_angles.hpp>
 #include <unordered_map>
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
+#include "Application/JobSystem.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Logging.h"
 #include "MeshFactory.h"
@@ -554,7 +555,7 @@ void MeshFactory::InvertFaces(MeshBuilder<Vertex>& mesh)
 
 
 template <typename Vertex>
-void MeshFactory::CalculateTBN(MeshBuilder<Vertex>& mesh)
+void MeshFactory::CalculateTBN(MeshBuilder<Vertex>& mesh, bool allowParallel)
 {
 	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
 	if (vMap.TangentOffset == -1 && vMap.BiTangentOffset == -1) {
@@ -575,8 +576,8 @@ void MeshFactory::CalculateTBN(MeshBuilder<Vertex>& mesh)
 		vMap.SetBiTangent(mesh._vertices[i], glm::vec3(0.0f));
 	}
 
-	// Iterate over all indices in the mesh, we'll assume that the mesh is indexed
-	for (size_t i = 0; i < mesh._indices.size(); i += 3) {
+	// Calculates the tangent and bitangent for the triangle starting at the given index
+	auto calculateFace = [&](size_t i, glm::vec3& tangent, glm::vec3& bitangent) {
 		Vertex& v1 = mesh._vertices[mesh._indices[i + 0u]];
 		Vertex& v2 = mesh._vertices[mesh._indices[i + 1u]];
 		Vertex& v3 = mesh._vertices[mesh._indices[i + 2u]];
@@ -604,8 +605,71 @@ void MeshFactory::CalculateTBN(MeshBuilder<Vertex>& mesh)
 		// Use the deltas in position and UV to calculate the tangent and bitangent
 		// https://learnopengl.com/Advanced-Lighting/Normal-Mapping
 		float r = 1.0f / (deltaT1.x * deltaT2.y - deltaT1.y * deltaT2.x);
-		glm::vec3 tangent = glm::normalize((deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r);
-		glm::vec3 bitangent = glm::normalize((deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r);
+		tangent = glm::normalize((deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r);
+		bitangent = glm::normalize((deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r);
+	};
+
+	// For big meshes, we spread the work over the job system. Every vertex blends in the tangents of
+	// the faces that use it in the same order as the serial loop, so the results are exactly the same
+	size_t triangleCount = mesh._indices.size() / 3;
+	if (allowParallel && JobSystem::WorkerCount() > 0 && triangleCount >= TBN_PARALLEL_THRESHOLD) {
+		// Calculate the tangent and bitangent of every face up front
+		std::vector<glm::vec3> faceTangents(triangleCount);
+		std::vector<glm::vec3> faceBiTangents(triangleCount);
+		JobSystem::ParallelFor(triangleCount, 4096, [&](size_t start, size_t end) {
+			for (size_t face = start; face < end; face++) {
+				calculateFace(face * 3, faceTangents[face], faceBiTangents[face]);
+			}
+		});
+
+		// Build a list of the faces that use each vertex, in the order that they appear in the mesh
+		size_t cornerCount = triangleCount * 3;
+		std::vector<uint32_t> vertexFaceStart(mesh._vertices.size() + 1, 0);
+		for (size_t i = 0; i < cornerCount; i++) {
+			vertexFaceStart[mesh._indices[i] + 1]++;
+		}
+		for (size_t i = 1; i < vertexFaceStart.size(); i++) {
+			vertexFaceStart[i] += vertexFaceStart[i - 1];
+		}
+		std::vector<uint32_t> vertexFaces(cornerCount);
+		std::vector<uint32_t> cursor(vertexFaceStart.begin(), vertexFaceStart.end() - 1);
+		for (size_t i = 0; i < cornerCount; i++) {
+			vertexFaces[cursor[mesh._indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// Each vertex can now blend it's own tangents without touching any other vertex
+		JobSystem::ParallelFor(mesh._vertices.size(), 4096, [&](size_t start, size_t end) {
+			for (size_t vertex = start; vertex < end; vertex++) {
+				Vertex& v = mesh._vertices[vertex];
+				for (uint32_t ix = vertexFaceStart[vertex]; ix < vertexFaceStart[vertex + 1]; ix++) {
+					vMap.SetTangent(v, glm::normalize((vMap.GetTangent(v) + faceTangents[vertexFaces[ix]]) / 2.0f));
+				}
+			}
+		});
+
+		// Bitangents for the 2nd and 3rd vertex of each face are based on the first vertex's, so every
+		// face depends on the ones before it and this part has to stay serial
+		for (size_t face = 0; face < triangleCount; face++) {
+			Vertex& v1 = mesh._vertices[mesh._indices[face * 3 + 0u]];
+			Vertex& v2 = mesh._vertices[mesh._indices[face * 3 + 1u]];
+			Vertex& v3 = mesh._vertices[mesh._indices[face * 3 + 2u]];
+			const glm::vec3& bitangent = faceBiTangents[face];
+
+			vMap.SetBiTangent(v1, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+			vMap.SetBiTangent(v2, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+			vMap.SetBiTangent(v3, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+		}
+		return;
+	}
+
+	// Iterate over all indices in the mesh, we'll assume that the mesh is indexed
+	for (size_t i = 0; i < mesh._indices.size(); i += 3) {
+		Vertex& v1 = mesh._vertices[mesh._indices[i + 0u]];
+		Vertex& v2 = mesh._vertices[mesh._indices[i + 1u]];
+		Vertex& v3 = mesh._vertices[mesh._indices[i + 2u]];
+
+		glm::vec3 tangent, bitangent;
+		calculateFace(i, tangent, bitangent);
 
 		// Set attributes in the vertex
 		vMap.SetTangent(v1, glm::normalize((vMap.GetTangent(v1) + tangent) / 2.0f));
@@ -0,0 +1,514 @@
+#include "Utils/ObjParser.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Utils/VirtualFileSystem.h"
+#include "Application/JobSystem.h"
+
+// Exact powers of ten that can be represented by a double, used for scaling our parsed floats
+static const double POWERS_OF_TEN[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POWER = 22;
+
+// We stop adding digits to the mantissa once it gets this big, so it can never overflow
+static const uint64_t MAX_MANTISSA = 100000000000000000ull;
+
+inline bool IsDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+// Skips spaces, tabs and carriage returns, but not newlines
+inline const char* SkipSpaces(const char* ptr, const char* end) {
+	while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r')) {
+		ptr++;
+	}
+	return ptr;
+}
+
+inline bool IsSpaceOrEnd(const char* ptr, const char* end) {
+	return ptr >= end || *ptr == ' ' || *ptr == '\t' || *ptr == '\r';
+}
+
+const char* ObjParser::ParseFloat(const char* begin, const char* end, float& value) {
+	const char* ptr = begin;
+	value = 0.0f;
+
+	bool negative = false;
+	if (ptr < end && (*ptr == '-' || *ptr == '+')) {
+		negative = *ptr == '-';
+		ptr++;
+	}
+
+	// Collect all the significant digits into one integer, tracking where the decimal place is
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+	for (; ptr < end && IsDigit(*ptr); ptr++) {
+		hasDigits = true;
+		if (mantissa < MAX_MANTISSA) {
+			mantissa = mantissa * 10 + (*ptr - '0');
+		} else {
+			exponent++;
+		}
+	}
+	if (ptr < end && *ptr == '.') {
+		ptr++;
+		for (; ptr < end && IsDigit(*ptr); ptr++) {
+			hasDigits = true;
+			if (mantissa < MAX_MANTISSA) {
+				mantissa = mantissa * 10 + (*ptr - '0');
+				exponent--;
+			}
+		}
+	}
+
+	// No digits means this wasn't a number at all
+	if (!hasDigits) {
+		return begin;
+	}
+
+	// Handle the exponent, if the e isn't followed by digits then it isn't part of the number
+	if (ptr < end && (*ptr == 'e' || *ptr == 'E')) {
+		const char* expStart = ptr + 1;
+		if (expStart < end && (*expStart == '-' || *expStart == '+')) {
+			expStart++;
+		}
+		if (expStart < end && IsDigit(*expStart)) {
+			bool expNegative = ptr[1] == '-';
+			int expValue = 0;
+			for (ptr = expStart; ptr < end && IsDigit(*ptr); ptr++) {
+				if (expValue < 10000) {
+					expValue = expValue * 10 + (*ptr - '0');
+				}
+			}
+			exponent += expNegative ? -expValue : expValue;
+		}
+	}
+
+	// For the common cases we only need a single multiply or divide by an exact power of ten
+	double result = static_cast<double>(mantissa);
+	if (mantissa != 0) {
+		if (exponent < 0 && exponent >= -MAX_EXACT_POWER) {
+			result /= POWERS_OF_TEN[-exponent];
+		} else if (exponent > 0 && exponent <= MAX_EXACT_POWER) {
+			result *= POWERS_OF_TEN[exponent];
+		} else if (exponent != 0) {
+			result *= std::pow(10.0, static_cast<double>(exponent));
+		}
+	}
+
+	value = static_cast<float>(negative ? -result : result);
+	return ptr;
+}
+
+const char* ObjParser::ParseInt(const char* begin, const char* end, int32_t& value) {
+	const char* ptr = begin;
+	value = 0;
+
+	bool negative = false;
+	if (ptr < end && (*ptr == '-' || *ptr == '+')) {
+		negative = *ptr == '-';
+		ptr++;
+	}
+	if (ptr >= end || !IsDigit(*ptr)) {
+		return begin;
+	}
+
+	int64_t result = 0;
+	for (; ptr < end && IsDigit(*ptr); ptr++) {
+		if (result < INT32_MAX) {
+			result = result * 10 + (*ptr - '0');
+		}
+	}
+	if (result > INT32_MAX) {
+		result = INT32_MAX;
+	}
+
+	value = static_cast<int32_t>(negative ? -result : result);
+	return ptr;
+}
+
+// Builds a key from a set of obj indices, which lets us quickly look up a combination of attributes to
+// see if it's already been added. Note that this limits us to 2,097,150 unique attributes for positions,
+// normals and textures
+inline uint64_t MakeVertexKey(const glm::ivec3& vertexIndices) {
+	const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+	return ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
+}
+
+// Picks which of the parallel parser's dedup partitions a vertex key belongs to
+inline size_t GetKeyPartition(uint64_t key, size_t partitionCount) {
+	return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) % partitionCount;
+}
+
+// Walks over every line in the given range, passing any attributes and face corners that we find to the
+// callbacks. Both the serial and parallel parsers use this, so they will always read files the same way
+template <typename PositionFunc, typename NormalFunc, typename UvFunc, typename CornerFunc, typename FaceFunc>
+void ScanLines(const char* begin, const char* end, const PositionFunc& onPosition, const NormalFunc& onNormal,
+			   const UvFunc& onUV, const CornerFunc& onCorner, const FaceFunc& onFaceEnd) {
+	const char* ptr = begin;
+	glm::vec3 vecData;
+
+	while (ptr < end) {
+		// Find the bounds of this line
+		ptr = SkipSpaces(ptr, end);
+		const char* lineEnd = reinterpret_cast<const char*>(memchr(ptr, '\n', end - ptr));
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+
+		// Skip empty lines
+		if (ptr == lineEnd) {
+			ptr = lineEnd + 1;
+			continue;
+		}
+
+		// The v command defines a vertex's position
+		if (ptr[0] == 'v' && IsSpaceOrEnd(ptr + 1, lineEnd)) {
+			ptr = SkipSpaces(ptr + 1, lineEnd);
+			ptr = SkipSpaces(ObjParser::ParseFloat(ptr, lineEnd, vecData.x), lineEnd);
+			ptr = SkipSpaces(ObjParser::ParseFloat(ptr, lineEnd, vecData.y), lineEnd);
+			ObjParser::ParseFloat(ptr, lineEnd, vecData.z);
+			onPosition(vecData);
+		}
+		// The vn command defines a normal
+		else if (ptr[0] == 'v' && ptr + 1 < lineEnd && ptr[1] == 'n' && IsSpaceOrEnd(ptr + 2, lineEnd)) {
+			ptr = SkipSpaces(ptr + 2, lineEnd);
+			ptr = SkipSpaces(ObjParser::ParseFloat(ptr, lineEnd, vecData.x), lineEnd);
+			ptr = SkipSpaces(ObjParser::ParseFloat(ptr, lineEnd, vecData.y), lineEnd);
+			ObjParser::ParseFloat(ptr, lineEnd, vecData.z);
+			onNormal(vecData);
+		}
+		// The vt command defines a texture coordinate, we ignore the optional 3rd component
+		else if (ptr[0] == 'v' && ptr + 1 < lineEnd && ptr[1] == 't' && IsSpaceOrEnd(ptr + 2, lineEnd)) {
+			ptr = SkipSpaces(ptr + 2, lineEnd);
+			ptr = SkipSpaces(ObjParser::ParseFloat(ptr, lineEnd, vecData.x), lineEnd);
+			ObjParser::ParseFloat(ptr, lineEnd, vecData.y);
+			onUV(glm::vec2(vecData));
+		}
+		// The f command defines a polygon in the mesh, each corner is in the form v, v/vt, v//vn or v/vt/vn
+		else if (ptr[0] == 'f' && IsSpaceOrEnd(ptr + 1, lineEnd)) {
+			ptr = SkipSpaces(ptr + 1, lineEnd);
+			while (ptr < lineEnd) {
+				glm::ivec3 vertexIndices = glm::ivec3(0);
+				const char* next = ObjParser::ParseInt(ptr, lineEnd, vertexIndices.x);
+				if (next == ptr) {
+					break;
+				}
+				ptr = next;
+				if (ptr < lineEnd && *ptr == '/') {
+					ptr = ObjParser::ParseInt(ptr + 1, lineEnd, vertexIndices.y);
+					if (ptr < lineEnd && *ptr == '/') {
+						ptr = ObjParser::ParseInt(ptr + 1, lineEnd, vertexIndices.z);
+					}
+				}
+				ptr = SkipSpaces(ptr, lineEnd);
+				onCorner(vertexIndices);
+			}
+			onFaceEnd();
+		}
+		// Anything else (comments, groups, materials, etc...) is ignored
+
+		ptr = lineEnd + 1;
+	}
+}
+
+// Flags any attributes in the vertices that are missing or out of range, so the loaders can use defaults
+static void ValidateVertices(ObjData& result, size_t start, size_t end) {
+	int numPositions = static_cast<int>(result.Positions.size());
+	int numUVs = static_cast<int>(result.UVs.size());
+	int numNormals = static_cast<int>(result.Normals.size());
+	for (size_t ix = start; ix < end; ix++) {
+		glm::ivec3& vertex = result.Vertices[ix];
+		if (vertex.x < 0 || vertex.x >= numPositions) { vertex.x = -1; }
+		if (vertex.y < 0 || vertex.y >= numUVs)       { vertex.y = -1; }
+		if (vertex.z < 0 || vertex.z >= numNormals)   { vertex.z = -1; }
+	}
+}
+
+void ObjParser::ParseFile(const std::string& filename, ObjData& result, bool allowParallel) {
+	VirtualFile file;
+	if (!file.Open(filename)) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	// Empty files are still valid (if boring) OBJ files
+	if (file.GetSize() == 0) {
+		result = ObjData();
+		return;
+	}
+	file.Prefetch();
+
+	// Only bother splitting the file up if there's someone to share the work with
+	if (allowParallel && JobSystem::WorkerCount() > 0) {
+		ParseParallel(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), result);
+	} else {
+		Parse(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), result);
+	}
+}
+
+void ObjParser::Parse(const char* text, size_t length, ObjData& result) {
+	result.Positions.clear();
+	result.Normals.clear();
+	result.UVs.clear();
+	result.Vertices.clear();
+	result.Indices.clear();
+
+	// Maps a key generated from obj indices to a vertex index that
+	// has been added to the mesh already
+	std::unordered_map<uint64_t, uint32_t> vertexMap;
+	vertexMap.reserve(length / 64);
+
+	// The vertex indices for the face we're currently reading
+	std::vector<uint32_t> polygon;
+	polygon.reserve(8);
+
+	ScanLines(text, text + length,
+		[&](const glm::vec3& position) { result.Positions.push_back(position); },
+		[&](const glm::vec3& normal) { result.Normals.push_back(normal); },
+		[&](const glm::vec2& uv) { result.UVs.push_back(uv); },
+		[&](glm::ivec3 vertexIndices) {
+			// The OBJ format can have negative values, which are a reference from the last added attributes
+			if (vertexIndices.x < 0) { vertexIndices.x = static_cast<int>(result.Positions.size()) + 1 + vertexIndices.x; }
+			if (vertexIndices.y < 0) { vertexIndices.y = static_cast<int>(result.UVs.size())       + 1 + vertexIndices.y; }
+			if (vertexIndices.z < 0) { vertexIndices.z = static_cast<int>(result.Normals.size())   + 1 + vertexIndices.z; }
+
+			// Find the index associated with the combination of attributes, or add a new vertex
+			uint64_t key = MakeVertexKey(vertexIndices);
+			auto it = vertexMap.find(key);
+			if (it != vertexMap.end()) {
+				polygon.push_back(it->second);
+			} else {
+				result.Vertices.push_back(vertexIndices - glm::ivec3(1));
+				uint32_t index = static_cast<uint32_t>(result.Vertices.size()) - 1;
+				vertexMap[key] = index;
+				polygon.push_back(index);
+			}
+		},
+		[&]() {
+			// Split the polygon into a triangle fan, for quads this gives us (0, 1, 2) and (0, 2, 3)
+			for (size_t ix = 2; ix < polygon.size(); ix++) {
+				result.Indices.push_back(polygon[0]);
+				result.Indices.push_back(polygon[ix - 1]);
+				result.Indices.push_back(polygon[ix]);
+			}
+			polygon.clear();
+		}
+	);
+
+	ValidateVertices(result, 0, result.Vertices.size());
+}
+
+// Stores the results of parsing one chunk of a file in the parallel parser, along with where it's data
+// ends up once all the chunks are stitched back together
+struct ObjChunk {
+	const char* Begin = nullptr;
+	const char* End = nullptr;
+
+	std::vector<glm::vec3>  Positions;
+	std::vector<glm::vec3>  Normals;
+	std::vector<glm::vec2>  UVs;
+	// Every face corner in the chunk, negative indices are resolved against the attributes in this chunk
+	// until we know how many attributes came before it
+	std::vector<glm::ivec3> Corners;
+	// Bits 0, 1 and 2 are set if the x, y or z of the matching corner was a negative index
+	std::vector<uint8_t>    RelativeMask;
+	// The number of corners in each face
+	std::vector<uint32_t>   FaceSizes;
+	// The global indices of this chunk's corners, split by dedup partition
+	std::vector<std::vector<uint32_t>> Partitions;
+
+	size_t PositionOffset = 0;
+	size_t NormalOffset = 0;
+	size_t UVOffset = 0;
+	size_t CornerOffset = 0;
+	size_t IndexOffset = 0;
+	size_t IndexCount = 0;
+	size_t VertexOffset = 0;
+	size_t VertexCount = 0;
+};
+
+void ObjParser::ParseParallel(const char* text, size_t length, ObjData& result, size_t chunkSize) {
+	chunkSize = chunkSize == 0 ? 1 : chunkSize;
+	if (length <= chunkSize) {
+		Parse(text, length, result);
+		return;
+	}
+
+	// Split the file into chunks, each chunk ends just after a newline so no lines get cut in half
+	std::vector<ObjChunk> chunks;
+	chunks.reserve(length / chunkSize + 1);
+	const char* end = text + length;
+	for (const char* begin = text; begin < end; ) {
+		const char* chunkEnd = begin + std::min(chunkSize, static_cast<size_t>(end - begin));
+		if (chunkEnd < end) {
+			const char* newline = reinterpret_cast<const char*>(memchr(chunkEnd - 1, '\n', end - (chunkEnd - 1)));
+			chunkEnd = newline != nullptr ? newline + 1 : end;
+		}
+		chunks.emplace_back();
+		chunks.back().Begin = begin;
+		chunks.back().End = chunkEnd;
+		begin = chunkEnd;
+	}
+
+	// Parse all the chunks at the same time, each one only sees it's own attributes and corners
+	JobSystem::ParallelFor(chunks.size(), 1, [&](size_t start, size_t stop) {
+		for (size_t ix = start; ix < stop; ix++) {
+			ObjChunk& chunk = chunks[ix];
+			size_t faceStart = 0;
+			ScanLines(chunk.Begin, chunk.End,
+				[&](const glm::vec3& position) { chunk.Positions.push_back(position); },
+				[&](const glm::vec3& normal) { chunk.Normals.push_back(normal); },
+				[&](const glm::vec2& uv) { chunk.UVs.push_back(uv); },
+				[&](glm::ivec3 vertexIndices) {
+					// Negative indices are resolved as if this chunk was the whole file, and flagged so we
+					// can shift them over once we know how many attributes were in the earlier chunks
+					uint8_t relative = 0;
+					if (vertexIndices.x < 0) { vertexIndices.x = static_cast<int>(chunk.Positions.size()) + 1 + vertexIndices.x; relative |= 0b001; }
+					if (vertexIndices.y < 0) { vertexIndices.y = static_cast<int>(chunk.UVs.size())       + 1 + vertexIndices.y; relative |= 0b010; }
+					if (vertexIndices.z < 0) { vertexIndices.z = static_cast<int>(chunk.Normals.size())   + 1 + vertexIndices.z; relative |= 0b100; }
+					chunk.Corners.push_back(vertexIndices);
+					chunk.RelativeMask.push_back(relative);
+				},
+				[&]() {
+					size_t faceSize = chunk.Corners.size() - faceStart;
+					chunk.FaceSizes.push_back(static_cast<uint32_t>(faceSize));
+					chunk.IndexCount += faceSize > 2 ? (faceSize - 2) * 3 : 0;
+					faceStart = chunk.Corners.size();
+				}
+			);
+		}
+	});
+
+	// Work out where each chunk's data will go in the final results
+	size_t numPositions = 0, numNormals = 0, numUVs = 0, numCorners = 0, numIndices = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.PositionOffset = numPositions;
+		chunk.NormalOffset = numNormals;
+		chunk.UVOffset = numUVs;
+		chunk.CornerOffset = numCorners;
+		chunk.IndexOffset = numIndices;
+		numPositions += chunk.Positions.size();
+		numNormals += chunk.Normals.size();
+		numUVs += chunk.UVs.size();
+		numCorners += chunk.Corners.size();
+		numIndices += chunk.IndexCount;
+	}
+
+	result.Positions.resize(numPositions);
+	result.Normals.resize(numNormals);
+	result.UVs.resize(numUVs);
+	result.Indices.resize(numIndices);
+
+	// We split the vertex dedup up by key, so every key is only ever looked at by one thread
+	size_t partitionCount = static_cast<size_t>(JobSystem::WorkerCount()) + 1;
+	std::vector<uint64_t> keys(numCorners);
+
+	// Move our attributes into place, and fix up any corners that used negative indices
+	JobSystem::ParallelFor(chunks.size(), 1, [&](size_t start, size_t stop) {
+		for (size_t ix = start; ix < stop; ix++) {
+			ObjChunk& chunk = chunks[ix];
+			std::copy(chunk.Positions.begin(), chunk.Positions.end(), result.Positions.begin() + chunk.PositionOffset);
+			std::copy(chunk.Normals.begin(), chunk.Normals.end(), result.Normals.begin() + chunk.NormalOffset);
+			std::copy(chunk.UVs.begin(), chunk.UVs.end(), result.UVs.begin() + chunk.UVOffset);
+			chunk.Positions = std::vector<glm::vec3>();
+			chunk.Normals = std::vector<glm::vec3>();
+			chunk.UVs = std::vector<glm::vec2>();
+
+			chunk.Partitions.resize(partitionCount);
+			for (auto& partition : chunk.Partitions) {
+				partition.reserve(chunk.Corners.size() / partitionCount + 1);
+			}
+			for (size_t corner = 0; corner < chunk.Corners.size(); corner++) {
+				glm::ivec3& vertexIndices = chunk.Corners[corner];
+				uint8_t relative = chunk.RelativeMask[corner];
+				if (relative & 0b001) { vertexIndices.x += static_cast<int>(chunk.PositionOffset); }
+				if (relative & 0b010) { vertexIndices.y += static_cast<int>(chunk.UVOffset); }
+				if (relative & 0b100) { vertexIndices.z += static_cast<int>(chunk.NormalOffset); }
+
+				size_t globalIndex = chunk.CornerOffset + corner;
+				keys[globalIndex] = MakeVertexKey(vertexIndices);
+				chunk.Partitions[GetKeyPartition(keys[globalIndex], partitionCount)].push_back(static_cast<uint32_t>(globalIndex));
+			}
+			chunk.RelativeMask = std::vector<uint8_t>();
+		}
+	});
+
+	// Each partition finds the first corner that uses each of it's keys. Corners are visited in file order,
+	// so the vertices come out in exactly the same order as the serial parser
+	std::vector<uint32_t> firstCorner(numCorners);
+	JobSystem::ParallelFor(partitionCount, 1, [&](size_t start, size_t stop) {
+		for (size_t partition = start; partition < stop; partition++) {
+			std::unordered_map<uint64_t, uint32_t> vertexMap;
+			vertexMap.reserve(length / 64 / partitionCount);
+			for (ObjChunk& chunk : chunks) {
+				for (uint32_t corner : chunk.Partitions[partition]) {
+					firstCorner[corner] = vertexMap.emplace(keys[corner], corner).first->second;
+				}
+				chunk.Partitions[partition] = std::vector<uint32_t>();
+			}
+		}
+	});
+	keys = std::vector<uint64_t>();
+
+	// Count how many new vertices each chunk introduces, so we can number them
+	JobSystem::ParallelFor(chunks.size(), 1, [&](size_t start, size_t stop) {
+		for (size_t ix = start; ix < stop; ix++) {
+			ObjChunk& chunk = chunks[ix];
+			for (size_t corner = chunk.CornerOffset; corner < chunk.CornerOffset + chunk.Corners.size(); corner++) {
+				chunk.VertexCount += firstCorner[corner] == corner ? 1 : 0;
+			}
+		}
+	});
+	size_t numVertices = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.VertexOffset = numVertices;
+		numVertices += chunk.VertexCount;
+	}
+	result.Vertices.resize(numVertices);
+
+	// Hand out vertex indices to the first corner to use each key
+	std::vector<uint32_t> cornerVertices(numCorners);
+	JobSystem::ParallelFor(chunks.size(), 1, [&](size_t start, size_t stop) {
+		for (size_t ix = start; ix < stop; ix++) {
+			ObjChunk& chunk = chunks[ix];
+			uint32_t vertex = static_cast<uint32_t>(chunk.VertexOffset);
+			for (size_t corner = 0; corner < chunk.Corners.size(); corner++) {
+				size_t globalIndex = chunk.CornerOffset + corner;
+				if (firstCorner[globalIndex] == globalIndex) {
+					result.Vertices[vertex] = chunk.Corners[corner] - glm::ivec3(1);
+					cornerVertices[globalIndex] = vertex++;
+				}
+			}
+		}
+	});
+
+	// Now every key has a vertex, we can triangulate the faces
+	JobSystem::ParallelFor(chunks.size(), 1, [&](size_t start, size_t stop) {
+		for (size_t ix = start; ix < stop; ix++) {
+			ObjChunk& chunk = chunks[ix];
+			uint32_t* indices = result.Indices.data() + chunk.IndexOffset;
+			size_t faceStart = chunk.CornerOffset;
+			for (uint32_t faceSize : chunk.FaceSizes) {
+				// Split the polygon into a triangle fan, for quads this gives us (0, 1, 2) and (0, 2, 3)
+				uint32_t first = cornerVertices[firstCorner[faceStart]];
+				for (size_t corner = 2; corner < faceSize; corner++) {
+					*indices++ = first;
+					*indices++ = cornerVertices[firstCorner[faceStart + corner - 1]];
+					*indices++ = cornerVertices[firstCorner[faceStart + corner]];
+				}
+				faceStart += faceSize;
+			}
+		}
+	});
+
+	JobSystem::ParallelFor(result.Vertices.size(), 65536, [&](size_t start, size_t stop) {
+		ValidateVertices(result, start, stop);
+	});
+}
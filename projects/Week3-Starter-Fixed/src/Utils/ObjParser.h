@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// The raw contents of an OBJ file, with faces resolved into a list of unique vertices
+/// and a triangle list indexing into them
+/// </summary>
+struct ObjData {
+	std::vector<glm::vec3>  Positions;
+	std::vector<glm::vec3>  Normals;
+	std::vector<glm::vec2>  UVs;
+	/// <summary>
+	/// Each unique combination of position, UV and normal indices that is used by a face. Indices
+	/// are zero based, and -1 is used for attributes that were not specified or were out of range
+	/// </summary>
+	std::vector<glm::ivec3> Vertices;
+	/// <summary>
+	/// Indices into Vertices, every 3 indices form a triangle
+	/// </summary>
+	std::vector<uint32_t>   Indices;
+};
+
+/// <summary>
+/// A fast OBJ parser shared by our OBJ loaders. The whole file is scanned in place with pointers
+/// rather than going through iostreams, which was by far the slowest part of loading models
+/// </summary>
+class ObjParser {
+public:
+	ObjParser() = delete;
+
+	/// <summary>
+	/// The default number of bytes given to each job when parsing in parallel
+	/// </summary>
+	static const size_t PARALLEL_CHUNK_SIZE = 1024 * 1024;
+
+	/// <summary>
+	/// Parses an OBJ file from disk, throws a runtime_error if the file cannot be opened.
+	/// Will use ParseParallel if the job system has any workers
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="result">The structure to store the results in, any existing data is cleared</param>
+	/// <param name="allowParallel">If false, the file will always be parsed on the calling thread</param>
+	static void ParseFile(const std::string& filename, ObjData& result, bool allowParallel = true);
+
+	/// <summary>
+	/// Parses OBJ data from a block of text. Supports v, vt, vn and f commands, negative indices
+	/// and polygons with more than 3 vertices, which are split into triangle fans
+	/// </summary>
+	/// <param name="text">The start of the text to parse, does not need to be null terminated</param>
+	/// <param name="length">The number of characters in the text</param>
+	/// <param name="result">The structure to store the results in, any existing data is cleared</param>
+	static void Parse(const char* text, size_t length, ObjData& result);
+	/// <summary>
+	/// Parses OBJ data from a block of text, splitting it into chunks at line boundaries that are parsed
+	/// and de-duplicated across the job system. The results are identical to Parse
+	/// </summary>
+	/// <param name="text">The start of the text to parse, does not need to be null terminated</param>
+	/// <param name="length">The number of characters in the text</param>
+	/// <param name="result">The structure to store the results in, any existing data is cleared</param>
+	/// <param name="chunkSize">The approximate number of bytes to parse in each job</param>
+	static void ParseParallel(const char* text, size_t length, ObjData& result, size_t chunkSize = PARALLEL_CHUNK_SIZE);
+
+	/// <summary>
+	/// Parses a floating point number at the start of the given range, in the same format as strtof.
+	/// Does not handle hex floats, inf or nan
+	/// </summary>
+	/// <param name="begin">The start of the text to parse</param>
+	/// <param name="end">The end of the text</param>
+	/// <param name="value">Will store the parsed value, or 0 if no number was found</param>
+	/// <returns>A pointer to the first character after the number</returns>
+	static const char* ParseFloat(const char* begin, const char* end, float& value);
+	/// <summary>
+	/// Parses a signed integer at the start of the given range
+	/// </summary>
+	/// <param name="begin">The start of the text to parse</param>
+	/// <param name="end">The end of the text</param>
+	/// <param name="value">Will store the parsed value, or 0 if no number was found</param>
+	/// <returns>A pointer to the first character after the number</returns>
+	static const char* ParseInt(const char* begin, const char* end, int32_t& value);
+};
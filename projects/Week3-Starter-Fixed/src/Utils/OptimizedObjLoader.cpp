@@ -7,8 +7,11 @@
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <cstring>
 
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/ObjParser.h"
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 
@@ -18,6 +21,11 @@ const std::string binaryExtension = ".bin";
 namespace fs = std::filesystem;
 
 VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename) {
+	std::shared_ptr<MeshData> data = LoadMeshData(filename);
+	return data != nullptr ? CreateVao(*data) : nullptr;
+}
+
+std::shared_ptr<OptimizedObjLoader::MeshData> OptimizedObjLoader::LoadMeshData(const std::string& filename) {
 	// Get the file extension and lowercase it
 	fs::path filePath = std::filesystem::path(filename);
 	std::string extension = filePath.extension().string();
@@ -28,15 +36,15 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 		// Get the binary path
 		fs::path binPath = filePath.replace_extension(binaryExtension);
 		// If the file does not exist, convert the OBJ file to a binary file
-		if (!fs::exists(binPath)) {
+		if (!VirtualFileSystem::Exists(binPath.string())) {
 			ConvertToBinary(filename, binPath.string());
 		}
 		// Load the corresponding binary file
-		return _LoadFromBinFile(binPath.string());
+		return _LoadBinMeshData(binPath.string());
 	} 
 	// Load our fancy binary files
 	else if (extension == ".bin") {
-		return _LoadFromBinFile(filename);
+		return _LoadBinMeshData(filename);
 	}
 	// We've never met this extension in our life
 	else {
@@ -72,158 +80,43 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 	delete mesh;
 }
 
-MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+std::unique_ptr<MeshBuilder<VertexPosNormTexColTangents>> OptimizedObjLoader::ParseObjFile(const std::string& filename, bool allowParallel) {
+	return std::unique_ptr<MeshBuilder<VertexPosNormTexColTangents>>(_LoadFromObjFile(filename, allowParallel));
+}
+
+MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename, bool allowParallel) {
+	float startTime = static_cast<float>(glfwGetTime());
 
-	// If our file fails to open, we will throw an error
-	if (!file) {
-		throw std::runtime_error("Failed to open file");
-	}
+	// Parse the file into it's attributes and faces, will throw if the file can't be opened
+	ObjData data;
+	ObjParser::ParseFile(filename, data, allowParallel);
 
 	// Could also take this in as a parameter
 	glm::vec4 color = glm::vec4(1.0f);
 
-	// Our attributes
-	std::vector<glm::vec3>  positions;
-	std::vector<glm::vec3>  normals;
-	std::vector<glm::vec2>  uvs;
-	std::vector<glm::ivec3> vertices;
-	std::vector<uint32_t>   indices;
-
-	// Maps a key generated from obj indices to a vertex index that
-	// has been added to the mesh already
-	std::unordered_map<uint64_t, uint32_t> vertexMap;
-
 	// We'll use the mesh builder since it supports easily adding
 	// vertices and indices
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = new MeshBuilder<VertexPosNormTexColTangents>();
 
-	// Storage for temporary data
-	std::string line;
-	glm::vec3 vecData;
-	glm::ivec3 vertexIndices;
-
-	float startTime = static_cast<float>(glfwGetTime());
-
-	// Read and process the entire file
-	while (file.peek() != EOF) {
-		// Read in the first part of the line (ex: f, v, vn, etc...)
-		std::string command;
-		file >> command;
-
-		// We will ignore the rest of the line for comment lines
-		if (command == "#") {
-			std::getline(file, line);
-		}
-
-		// The v command defines a vertex's position
-		else if (command == "v") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y >> vecData.z;
-			positions.push_back(vecData);
-		}
-		// TODO: handle normals and textures
-		else if (command == "vn") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y >> vecData.z;
-			normals.push_back(vecData);
-		} else if (command == "vt") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y;
-			uvs.push_back(vecData);
-		}
-
-		// The f command defines a polygon in the mesh
-		// NOTE: make sure you triangulate in blender, otherwise it will
-		// output quads instead of triangles
-		else if (command == "f") {
-			// Read the rest of the line from the file
-			std::getline(file, line);
-			// Trim whitespace from either end of the line
-			StringTools::Trim(line);
-			// Create a string stream so we can use streaming operators on it
-			std::stringstream stream = std::stringstream(line);
-
-			uint32_t edges[4];
-			int ix = 0;
-			// Iterate over up to 4 sets of attributes
-			for (; ix < 4; ix++) {
-				if (stream.peek() != EOF) {
-					// Load in the faces, split up by slashes
-					char tempChar;
-					vertexIndices = glm::ivec3(0);
-					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
-					// The OBJ format can have negative values, which are a reference from the last added attributes
-					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() + 1 + vertexIndices.x; }
-					if (vertexIndices.y < 0) { vertexIndices.y = uvs.size()       + 1 + vertexIndices.y; }
-					if (vertexIndices.z < 0) { vertexIndices.z = normals.size()   + 1 + vertexIndices.z; }
-
-					// We can construct a key using a bitmask of the attribute indices
-					// This let's us quickly look up a combination of attributes to see if it's already been added
-					// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
-					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
-					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
-
-					// Find the index associated with the combination of attributes
-					auto it = vertexMap.find(key);
-
-					// If it exists, we push the index to our indices
-					if (it != vertexMap.end()) {
-						edges[ix] = it->second;
-					} else {
-						vertices.push_back(vertexIndices - glm::ivec3(1));
-						uint32_t index = static_cast<uint32_t>(vertices.size()) - 1;
-
-						// Cache the index based on our key
-						vertexMap[key] = index;
-						// Add index to mesh, and add to edges list for if we are using quads
-						edges[ix] = index;
-					}
-				}
-				// We've reached the end of the line, break out of the loop
-				else { break; }
-			}
-
-			// Handling for triangle faces
-			if (ix == 3) {
-				indices.push_back(edges[0]);
-				indices.push_back(edges[1]);
-				indices.push_back(edges[2]);
-			}
-			// Handling for quad faces
-			else if (ix == 4) {
-				indices.push_back(edges[0]);
-				indices.push_back(edges[1]);
-				indices.push_back(edges[2]);
-
-				indices.push_back(edges[0]);
-				indices.push_back(edges[2]);
-				indices.push_back(edges[3]);
-			}
-		}
-	}
-
-	mesh->ReserveVertexSpace(vertices.size());
-	for (const auto& vertexIndices : vertices) {
+	mesh->ReserveVertexSpace(data.Vertices.size());
+	for (const auto& vertexIndices : data.Vertices) {
 		// Construct a new vertex using the indices for the vertex
 		VertexPosNormTexColTangents vertex;
-		vertex.Position = positions[vertexIndices.x];
-		vertex.UV       = vertexIndices.y != 0 ? uvs[vertexIndices.y] : glm::vec2(0.0f);
-		vertex.Normal   = vertexIndices.z != 0 ? normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f);
+		vertex.Position = vertexIndices.x >= 0 ? data.Positions[vertexIndices.x] : glm::vec3(0.0f);
+		vertex.UV       = vertexIndices.y >= 0 ? data.UVs[vertexIndices.y] : glm::vec2(0.0f);
+		vertex.Normal   = vertexIndices.z >= 0 ? data.Normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f);
 		vertex.Color    = color;
 
 		// Add to the mesh, get index of the added vertex
 		mesh->AddVertex(vertex);
 	}
-	mesh->ReserveIndexSpace(indices.size());
-	for (uint32_t ix : indices) {
+	mesh->ReserveIndexSpace(data.Indices.size());
+	for (uint32_t ix : data.Indices) {
 		mesh->AddIndex(ix);
 	}
 
 	// Calculate our tangents
-	MeshFactory::CalculateTBN(*mesh);
+	MeshFactory::CalculateTBN(*mesh, allowParallel);
 
 	// Calculate and trace out how long it took us to load
 	float endTime = static_cast<float>(glfwGetTime());
@@ -233,96 +126,214 @@ MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(c
 	return mesh;
 }
 
-VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
+std::shared_ptr<OptimizedObjLoader::MeshData> OptimizedObjLoader::_LoadBinMeshData(const std::string& filename) {
+	float startTime = static_cast<float>(glfwGetTime());
+
+	// Map the file into memory (or find it in a mounted asset pack), rather than reading it, so
+	// that we can hand the data straight to OpenGL without making a copy of it first
+	std::shared_ptr<MeshData> result = std::make_shared<MeshData>();
+	result->Filename = filename;
+	VirtualFile& file = result->File;
+	if (!file.Open(filename)) { throw std::runtime_error("Failed to open file"); }
+	file.Prefetch();
+
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+
+	// Find out where everything is in the file
+	BinaryLayout& layout = result->Layout;
+	if (!_ReadLayout(data, size, filename, layout)) {
+		return nullptr;
+	}
+	const BinaryHeader& header = layout.Header;
+	size_t attributeBytes = header.NumAttributes * sizeof(BufferAttribute);
+
+	// Read all attributes from the file, this is basically our VDECL
+	std::vector<BufferAttribute>& vertexDeclaration = result->VertexDeclaration;
+	vertexDeclaration.resize(header.NumAttributes);
+	if (attributeBytes > 0) {
+		memcpy(vertexDeclaration.data(), data + layout.AttributesOffset, attributeBytes);
+	}
+
+	// Older files don't store bounds, so we calculate them from the vertices, which also pages them in
+	const uint8_t* vertexStore = data + layout.VerticesOffset;
+	if (!layout.Bounds.IsValid) {
+		VertexParamMap vMap = VertexParamMap(vertexDeclaration);
+		if (vMap.PositionOffset != static_cast<uint32_t>(-1)) {
+			layout.Bounds = MeshBounds::FromVertexData(vertexStore, header.VertexStride, vMap.PositionOffset, header.NumVertices);
+		}
+	}
+
+	// Touch every page we're going to upload, so that the main thread doesn't stall on page faults. The prefetch
+	// above is only a hint, and does nothing for some files
+	size_t dataEnd = layout.VerticesOffset + header.VertexStride * static_cast<size_t>(header.NumVertices);
+	volatile uint8_t sink = 0;
+	for (size_t offset = layout.IndicesOffset; offset < dataEnd; offset += 4096) {
+		sink += data[offset];
+	}
 
-	// Open the output file
-	std::ifstream file(filename, std::ios::binary);
-	// If our file fails to open, we will throw an error
-	if (!file) { throw std::runtime_error("Failed to open file"); }
+	float endTime = static_cast<float>(glfwGetTime());
+	LOG_TRACE("Read binary mesh \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, header.NumVertices, header.NumIndices);
 
+	return result;
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::CreateVao(const MeshData& meshData) {
 	float startTime = static_cast<float>(glfwGetTime());
 
-	// Get the file size so we can avoid reading past the end
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	const uint8_t* data = meshData.File.GetData();
+	const BinaryLayout& layout = meshData.Layout;
+	const BinaryHeader& header = layout.Header;
+
+	// These will have the buffer pointers
+	IndexBuffer::Sptr indices = nullptr;
+	VertexBuffer::Sptr vertices = nullptr;
+
+	// If we have index data, load it straight from the mapped file
+	if (header.NumIndices > 0) {
+		indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+		if (header.IndicesType == IndexType::UShort || header.IndicesType == IndexType::UByte) {
+			// The renderer packs static meshes into stores with 32-bit indices, so we widen smaller indices
+			// here while we still have them on the CPU. Offsets in the file may not be aligned, so copy each one
+			const uint8_t* source = data + layout.IndicesOffset;
+			size_t indexSize = GetIndexTypeSize(header.IndicesType);
+			std::vector<uint32_t> widened(header.NumIndices);
+			for (size_t ix = 0; ix < widened.size(); ix++) {
+				if (header.IndicesType == IndexType::UShort) {
+					uint16_t index;
+					memcpy(&index, source + ix * indexSize, sizeof(uint16_t));
+					widened[ix] = index;
+				} else {
+					widened[ix] = source[ix];
+				}
+			}
+			indices->LoadData(widened.data(), static_cast<uint32_t>(widened.size()));
+		} else {
+			indices->LoadData(data + layout.IndicesOffset, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
+		}
+	}
+
+	// Create a new VBO and load our vertices straight from the mapped file
+	vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertices->LoadData(data + layout.VerticesOffset, header.VertexStride, header.NumVertices);
+
+	// Create the VAO and attach our index and vertex buffers
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->SetIndexBuffer(indices);
+	result->AddVertexBuffer(vertices, meshData.VertexDeclaration);
+
+	// Copy in the vertex declaration we loaded
+	result->SetVDecl(meshData.VertexDeclaration);
+	result->SetBounds(layout.Bounds);
+
+	// Calculate and trace out how long it took us to load
+	float endTime = static_cast<float>(glfwGetTime());
+	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", meshData.Filename, endTime - startTime, header.NumVertices, header.NumIndices);
+
+	return result;
+}
+
+bool OptimizedObjLoader::LoadPositions(const std::string& filename, std::vector<glm::vec3>& outPositions) {
+	outPositions.clear();
+
+	VirtualFile file;
+	if (!file.Open(filename)) {
+		LOG_WARN("Failed to open \"{}\"", filename);
+		return false;
+	}
+
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+
+	BinaryLayout layout = BinaryLayout();
+	if (!_ReadLayout(data, size, filename, layout)) {
+		return false;
+	}
+	const BinaryHeader& header = layout.Header;
+
+	// We need the vertex declaration to know where the positions are within each vertex
+	std::vector<BufferAttribute> vertexDeclaration;
+	vertexDeclaration.resize(header.NumAttributes);
+	if (header.NumAttributes > 0) {
+		memcpy(vertexDeclaration.data(), data + layout.AttributesOffset, header.NumAttributes * sizeof(BufferAttribute));
+	}
+	VertexParamMap vMap = VertexParamMap(vertexDeclaration);
+	if (vMap.PositionOffset == static_cast<uint32_t>(-1)) {
+		LOG_WARN("\"{}\" does not have any vertex positions", filename);
+		return false;
+	}
 
+	// Copy the positions out of the mapped vertex data
+	const uint8_t* vertexStore = data + layout.VerticesOffset + vMap.PositionOffset;
+	outPositions.resize(header.NumVertices);
+	for (size_t ix = 0; ix < header.NumVertices; ix++) {
+		memcpy(&outPositions[ix], vertexStore + ix * header.VertexStride, sizeof(glm::vec3));
+	}
+	return true;
+}
+
+bool OptimizedObjLoader::_ReadLayout(const uint8_t* data, size_t size, const std::string& filename, BinaryLayout& result) {
 	// Read the header from the file
-	BinaryHeader header = BinaryHeader();
+	BinaryHeader& header = result.Header;
 	if (size >= sizeof(BinaryHeader)) {
-		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+		memcpy(&header, data, sizeof(BinaryHeader));
 	} else {
 		LOG_ERROR("Not enough data in the file!");
-		return nullptr;
+		return false;
+	}
+
+	if (memcmp(header.HeaderBytes, HEADER_BYTES, sizeof(HEADER_BYTES)) != 0) {
+		LOG_ERROR("\"{}\" is not a binary mesh file!", filename);
+		return false;
 	}
 
-	// TODO: validate header
+	size_t attributeBytes = header.NumAttributes * sizeof(BufferAttribute);
+	size_t indexBytes = header.NumIndices * GetIndexTypeSize(header.IndicesType);
+	size_t vertexBytes = header.VertexStride * (size_t)header.NumVertices;
+
+	// Find where each of our sections are in the file
+	size_t& attributesOffset = result.AttributesOffset;
+	size_t& indicesOffset = result.IndicesOffset;
+	size_t& verticesOffset = result.VerticesOffset;
+	MeshBounds& bounds = result.Bounds;
 
-	// Handle our version
+	// Version 1 files store everything back to back after the header
 	if (header.Version == 0x01) {
-		// Determine how many bytes we need in the file
-		size_t requiredBytes =
-			sizeof(BinaryHeader) +
-			(header.NumAttributes * sizeof(BufferAttribute)) +
-			(header.VertexStride * (size_t)header.NumVertices) +
-			(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-
-		// Make sure there's enough data in the file
-		if (size < requiredBytes) {
+		attributesOffset = sizeof(BinaryHeader);
+		indicesOffset = attributesOffset + attributeBytes;
+		verticesOffset = indicesOffset + indexBytes;
+	}
+	// Version 2 files have a table of aligned sections, and store the mesh bounds
+	else if (header.Version == 0x02) {
+		if (size < sizeof(BinaryHeader) + sizeof(BinarySections)) {
 			LOG_ERROR("Not enough data in the file!");
-			return nullptr;
-		}
-
-		// Read all attributes from the file, this is basically our VDECL
-		std::vector<BufferAttribute> vertexDeclaration;
-		vertexDeclaration.resize(header.NumAttributes);
-		for (int ix = 0; ix < header.NumAttributes; ix++) {
-			file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
+			return false;
 		}
 
-		// These will have the buffer pointers
-		IndexBuffer::Sptr indices = nullptr;
-		VertexBuffer::Sptr vertices = nullptr;
-
-		// If we have index data, load it
-		if (header.NumIndices > 0) {
-			// Create index buffer
-			indices = IndexBuffer::Create(BufferUsage::StaticDraw);
-
-			// Create memory to store indices, then read from the file
-			void* dataStore = malloc(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			file.read(reinterpret_cast<char*>(dataStore), header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			
-			// Load data into OpenGL and free the CPU memory we allocated
-			indices->LoadData(dataStore, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
-			free(dataStore);
+		BinarySections sections = BinarySections();
+		memcpy(&sections, data + sizeof(BinaryHeader), sizeof(BinarySections));
+		attributesOffset = static_cast<size_t>(sections.AttributesOffset);
+		indicesOffset = static_cast<size_t>(sections.IndicesOffset);
+		verticesOffset = static_cast<size_t>(sections.VerticesOffset);
+
+		if (sections.HasBounds) {
+			bounds.Min = sections.BoundsMin;
+			bounds.Max = sections.BoundsMax;
+			bounds.Center = sections.BoundsCenter;
+			bounds.Radius = sections.BoundsRadius;
+			bounds.IsValid = true;
 		}
+	}
+	else {
+		LOG_ERROR("Unsupported binary mesh version {} in \"{}\"", header.Version, filename);
+		return false;
+	}
 
-		// Create a new VBO
-		vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
-
-		// Create memory to store vertices and load from file
-		void* vertexStore = malloc(header.NumVertices * (size_t)header.VertexStride);
-		file.read(reinterpret_cast<char*>(vertexStore), header.NumVertices * (size_t)header.VertexStride);
-
-		// Load data into OpenGL and free the CPU copy
-		vertices->LoadData(vertexStore, header.VertexStride, header.NumVertices);
-		free(vertexStore);
-
-		// Create the VAO and attach our index and vertex buffers
-		VertexArrayObject::Sptr result = VertexArrayObject::Create();
-		result->SetIndexBuffer(indices);
-		result->AddVertexBuffer(vertices, vertexDeclaration);
-
-		// Copy in the vertex declaration we loaded
-		result->SetVDecl(vertexDeclaration);
-
-		// Calculate and trace out how long it took us to load
-		float endTime = static_cast<float>(glfwGetTime());
-		LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, header.NumVertices, header.NumIndices);
-
-		return result;
+	// Make sure there's enough data in the file for every section
+	if (size < attributesOffset + attributeBytes || size < indicesOffset + indexBytes || size < verticesOffset + vertexBytes) {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
 	}
 
-	return nullptr;
+	return true;
 }
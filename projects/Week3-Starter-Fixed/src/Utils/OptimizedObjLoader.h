@@ -7,11 +7,13 @@
  */
 #pragma once
 #include <fstream>
+#include <memory>
 
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
 
 #include "Utils/MeshBuilder.h"
+#include "Utils/VirtualFileSystem.h"
 
 /// <summary>
 /// An optimized OBJ loader that can convert an OBJ file to a binary representation
@@ -26,12 +28,45 @@ public:
 	/// <param name="filename">The path to the .obj or .bin file to load</param>
 	/// <returns>A VAO loaded from disk</returns>
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+
+	// Holds a binary mesh that has been read from disk but not yet uploaded to OpenGL, see LoadMeshData
+	struct MeshData;
+	/// <summary>
+	/// Does all the work of LoadFromFile that does not need OpenGL (converting OBJ files, mapping the binary
+	/// file and paging it in), so that it can be done on a worker thread. Pass the result to CreateVao on the
+	/// main thread to create the mesh
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <returns>The mesh's data, or nullptr if the file could not be loaded</returns>
+	static std::shared_ptr<MeshData> LoadMeshData(const std::string& filename);
+	/// <summary>
+	/// Creates a VAO from mesh data returned by LoadMeshData, must be called on the main thread
+	/// </summary>
+	/// <param name="data">The mesh data to upload</param>
+	/// <returns>A VAO with the mesh's buffers</returns>
+	static VertexArrayObject::Sptr CreateVao(const MeshData& data);
 	/// <summary>
 	/// Manually converts an OBJ file into a binary mesh file
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
 	/// <param name="outFile">The output path for the bin file, or empty to use the inFile path and replace the extension with .bin</param>
 	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "");
+	/// <summary>
+	/// Parses an OBJ file into a mesh builder without writing a binary file or creating any OpenGL objects.
+	/// This is the same parse and tangent calculation that ConvertToBinary uses
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to parse</param>
+	/// <param name="allowParallel">False to keep all of the work on the calling thread</param>
+	/// <returns>The parsed mesh, throws if the file could not be opened</returns>
+	static std::unique_ptr<MeshBuilder<VertexPosNormTexColTangents>> ParseObjFile(const std::string& filename, bool allowParallel = true);
+	/// <summary>
+	/// Reads just the vertex positions out of a binary mesh file, without creating any OpenGL objects.
+	/// This is useful for things like generating collision data on the CPU
+	/// </summary>
+	/// <param name="filename">The path to the .bin file to read</param>
+	/// <param name="outPositions">The vector to store the positions in, will be cleared first</param>
+	/// <returns>True if the positions were read, false if the file could not be read or has no positions</returns>
+	static bool LoadPositions(const std::string& filename, std::vector<glm::vec3>& outPositions);
 
 	/// <summary>
 	/// Saves a mesh builder of the given type to a binary file
@@ -61,11 +96,66 @@ protected:
 		uint8_t   NumAttributes = 0;
 	};
 
+	// The current version of the binary format that we write out
+	static const uint16_t BINARY_VERSION = 0x02;
+	// In version 2 files, every data section starts on a multiple of this many bytes from the start of
+	// the file, so that the sections can be used directly from a memory mapped file
+	static const uint32_t SECTION_ALIGNMENT = 64;
+
+	// Follows the header in version 2 files, and tells us where each section of the file is
+	struct BinarySections {
+		// The offset of the vertex attributes, from the start of the file
+		uint64_t  AttributesOffset = 0;
+		// The offset of the index data, from the start of the file
+		uint64_t  IndicesOffset = 0;
+		// The offset of the vertex data, from the start of the file
+		uint64_t  VerticesOffset = 0;
+		// The model space bounds of the mesh, so we don't need to scan the vertices when loading
+		glm::vec3 BoundsMin = glm::vec3(0.0f);
+		glm::vec3 BoundsMax = glm::vec3(0.0f);
+		glm::vec3 BoundsCenter = glm::vec3(0.0f);
+		float     BoundsRadius = 0.0f;
+		// Non-zero if the bounds were calculated when the file was saved
+		uint32_t  HasBounds = 0;
+	};
+
+	// Where each section of a binary mesh file is, resolved from the header for any version of the format
+	struct BinaryLayout {
+		BinaryHeader Header = BinaryHeader();
+		size_t       AttributesOffset = 0;
+		size_t       IndicesOffset = 0;
+		size_t       VerticesOffset = 0;
+		MeshBounds   Bounds = MeshBounds();
+	};
+
+public:
+	struct MeshData {
+		NO_COPY(MeshData);
+		NO_MOVE(MeshData);
+		MeshData() = default;
+
+		std::string                  Filename;
+		// Keeps the file mapped until the buffers have been created from it
+		VirtualFile                  File;
+		BinaryLayout                 Layout;
+		std::vector<BufferAttribute> VertexDeclaration;
+	};
+
+protected:
+	// Rounds an offset up to the next multiple of SECTION_ALIGNMENT
+	static uint64_t _AlignSection(uint64_t offset) {
+		return (offset + SECTION_ALIGNMENT - 1) & ~static_cast<uint64_t>(SECTION_ALIGNMENT - 1);
+	}
+
 	OptimizedObjLoader() = default;
 	~OptimizedObjLoader() = default;
 
-	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
-	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	// Parses an OBJ file and builds it's vertices and tangents, allowParallel = false keeps everything on the calling thread
+	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename, bool allowParallel = true);
+	// Maps a binary mesh file and reads it's layout, without touching OpenGL
+	static std::shared_ptr<MeshData> _LoadBinMeshData(const std::string& filename);
+	// Reads the header of a binary mesh file and finds all of it's sections, returns false if the data is invalid
+	static bool _ReadLayout(const uint8_t* data, size_t size, const std::string& filename, BinaryLayout& result);
 };
 
 template <typename VertexType>
@@ -78,25 +168,51 @@ void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std
 
 	// Create the fixed size header for our output file
 	BinaryHeader header  = BinaryHeader();
-	header.Version       = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
+	header.Version       = BINARY_VERSION; // Update this and implement different readers if changes to format are made
 	header.NumIndices    = mesh.GetIndexCount();
 	header.IndicesType   = IndexType::UInt;
 	header.NumVertices   = mesh.GetVertexCount();
 	header.VertexStride  = sizeof(VertexType);
 	header.NumAttributes = VertexType::V_DECL.size();
 
+	// Lay out our sections, each one starts on an aligned offset so that the loader can use them in place
+	BinarySections sections = BinarySections();
+	sections.AttributesOffset = _AlignSection(sizeof(BinaryHeader) + sizeof(BinarySections));
+	sections.IndicesOffset    = _AlignSection(sections.AttributesOffset + VertexType::V_DECL.size() * sizeof(BufferAttribute));
+	sections.VerticesOffset   = _AlignSection(sections.IndicesOffset + mesh.GetIndexCount() * sizeof(uint32_t));
+
+	MeshBounds bounds = mesh.CalculateBounds();
+	sections.BoundsMin    = bounds.Min;
+	sections.BoundsMax    = bounds.Max;
+	sections.BoundsCenter = bounds.Center;
+	sections.BoundsRadius = bounds.Radius;
+	sections.HasBounds    = bounds.IsValid ? 1 : 0;
+
+	// Pads the file with zeros until we reach the given offset
+	auto padTo = [&](uint64_t offset) {
+		static const char zeros[SECTION_ALIGNMENT] = { 0 };
+		uint64_t position = static_cast<uint64_t>(file.tellp());
+		if (offset > position) {
+			file.write(zeros, static_cast<std::streamsize>(offset - position));
+		}
+	};
+
 	// Write header bytes to the stream
 	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+	file.write(reinterpret_cast<const char*>(&sections), sizeof(BinarySections));
 
 	// Write which attributes we have to the stream
+	padTo(sections.AttributesOffset);
 	for (int ix = 0; ix < VertexType::V_DECL.size(); ix++) {
 		file.write(reinterpret_cast<const char*>(&VertexType::V_DECL[ix]), sizeof(BufferAttribute));
 	}
 	// Write any index data to the file
+	padTo(sections.IndicesOffset);
 	if (mesh.GetIndexCount() > 0) {
 		file.write(reinterpret_cast<const char*>(mesh.GetIndexDataPtr()), mesh.GetIndexCount() * sizeof(uint32_t));
 	}
 
 	// Write vertex data to file
+	padTo(sections.VerticesOffset);
 	file.write(reinterpret_cast<const char*>(mesh.GetVertexDataPtr()), mesh.GetVertexCount() * sizeof(VertexType));
 }
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Provides helpers for sorting large lists of items by integer keys
+/// </summary>
+class RadixSort {
+public:
+	RadixSort() = delete;
+
+	/// <summary>
+	/// Sorts a list of items by a 64 bit key using an LSD radix sort, 8 bits at a time. The sort
+	/// is stable, and passes where every key has the same byte are skipped entirely, so keys that
+	/// only use some of their bits will sort faster
+	/// </summary>
+	/// <typeparam name="T">The type of item to sort, should be cheap to copy</typeparam>
+	/// <typeparam name="KeyFunc">A callable with the signature uint64_t(const T&amp;)</typeparam>
+	/// <param name="items">The items to sort, will contain the sorted result</param>
+	/// <param name="scratch">Scratch storage for the sort, keeping this around between calls avoids allocations</param>
+	/// <param name="getKey">Extracts the sorting key from an item</param>
+	template <typename T, typename KeyFunc>
+	static void Sort64(std::vector<T>& items, std::vector<T>& scratch, const KeyFunc& getKey) {
+		size_t count = items.size();
+		if (count < 2) {
+			return;
+		}
+		scratch.resize(count);
+
+		// Build the histograms for all 8 bytes in a single pass over the data
+		size_t histograms[8][256] = { };
+		for (const T& item : items) {
+			uint64_t key = getKey(item);
+			for (int byte = 0; byte < 8; byte++) {
+				histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+			}
+		}
+
+		T* source = items.data();
+		T* dest   = scratch.data();
+		for (int byte = 0; byte < 8; byte++) {
+			size_t* histogram = histograms[byte];
+			int shift = byte * 8;
+
+			// If every item lands in the same bucket, this pass would not change the order
+			if (histogram[(getKey(source[0]) >> shift) & 0xFF] == count) {
+				continue;
+			}
+
+			// Convert counts into starting offsets for each bucket
+			size_t offset = 0;
+			for (int bucket = 0; bucket < 256; bucket++) {
+				size_t bucketSize = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketSize;
+			}
+
+			// Scatter the items into their buckets
+			for (size_t ix = 0; ix < count; ix++) {
+				dest[histogram[(getKey(source[ix]) >> shift) & 0xFF]++] = source[ix];
+			}
+			std::swap(source, dest);
+		}
+
+		// If we did an odd number of passes, the results are sitting in the scratch buffer
+		if (source != items.data()) {
+			items.swap(scratch);
+		}
+	}
+};
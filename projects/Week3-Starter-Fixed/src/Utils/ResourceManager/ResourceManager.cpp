@@ -3,12 +3,25 @@
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Logging.h"
+
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <GLFW/glfw3.h>
 
 std::map<std::type_index, std::map<Guid, IResource::Sptr>> ResourceManager::_resources;
 std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
+std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_asyncTypeLoaders;
 
 nlohmann::ordered_json ResourceManager::_manifest;
 
+JobCounter ResourceManager::_loadCounter;
+std::deque<ResourceManager::UploadCallback> ResourceManager::_uploads;
+std::mutex ResourceManager::_uploadMutex;
+std::atomic<uint32_t> ResourceManager::_pendingLoads{ 0 };
+
 void ResourceManager::Init() {
 	// TODO: initialize the resource manager once it's a bit more complex
 	//_manifest["textures"]  = std::vector<nlohmann::json>();
@@ -21,23 +34,164 @@ const nlohmann::ordered_json& ResourceManager::GetManifest() {
 	return _manifest;
 }
 
-void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets) {
+void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets, const ProgressCallback& progress) {
 	std::string contents = FileHelpers::ReadFile(path);
 	nlohmann::ordered_json blob = nlohmann::ordered_json::parse(contents);
 	_manifest = blob;
 
 	if (preloadAssets) {
-		for (auto& [typeName, items] : blob.items()) {
-			auto& func = _typeLoaders[typeName];
-			if (func) {
-				for (auto& [guid, blob] : items.items()) {
-					func(blob);
-				}
+		_PreloadManifest(progress);
+	}
+}
+
+/// <summary>
+/// Collects every string in a resource's JSON blob that is a GUID
+/// </summary>
+static void CollectGuidReferences(const nlohmann::ordered_json& blob, std::vector<Guid>& result) {
+	if (blob.is_string()) {
+		// GUID strings are always 36 characters, checking that first saves trying to parse every string
+		const std::string& value = blob.get_ref<const std::string&>();
+		if (value.size() == 36) {
+			Guid guid = Guid(value);
+			if (guid.isValid()) {
+				result.push_back(guid);
 			}
 		}
+	} else if (blob.is_structured()) {
+		for (const auto& child : blob) {
+			CollectGuidReferences(child, result);
+		}
 	}
 }
 
+void ResourceManager::_PreloadManifest(const ProgressCallback& progress) {
+	float startTime = static_cast<float>(glfwGetTime());
+
+	// A single resource in the manifest, along with the resources that need it to be loaded first
+	struct PreloadNode {
+		const nlohmann::ordered_json*                         Blob;
+		const std::function<Guid(const nlohmann::json&)>*     Loader;
+		bool                                                  IsAsync;
+		uint32_t                                              NumDependencies;
+		std::vector<size_t>                                   Dependents;
+	};
+
+	// Gather up every resource that we know how to load
+	std::vector<PreloadNode> nodes;
+	std::unordered_map<Guid, size_t> nodeLookup;
+	for (auto& [typeName, items] : _manifest.items()) {
+		auto asyncLoader = _asyncTypeLoaders.find(typeName);
+		auto loader = _typeLoaders.find(typeName);
+		if (loader == _typeLoaders.end() || !loader->second) {
+			continue;
+		}
+
+		for (auto& [guid, blob] : items.items()) {
+			PreloadNode node = PreloadNode();
+			node.Blob    = &blob;
+			node.IsAsync = asyncLoader != _asyncTypeLoaders.end();
+			node.Loader  = node.IsAsync ? &asyncLoader->second : &loader->second;
+			nodeLookup[Guid(guid)] = nodes.size();
+			nodes.push_back(node);
+		}
+	}
+
+	// Any GUID in a resource that refers to another resource in the manifest is a dependency
+	std::vector<Guid> references;
+	for (size_t ix = 0; ix < nodes.size(); ix++) {
+		references.clear();
+		CollectGuidReferences(*nodes[ix].Blob, references);
+		std::sort(references.begin(), references.end());
+		references.erase(std::unique(references.begin(), references.end()), references.end());
+
+		for (const Guid& reference : references) {
+			auto it = nodeLookup.find(reference);
+			if (it != nodeLookup.end() && it->second != ix) {
+				nodes[it->second].Dependents.push_back(ix);
+				nodes[ix].NumDependencies++;
+			}
+		}
+	}
+
+	// Resources that can be loaded right away, background loads are started before anything that blocks
+	// the main thread so that the workers have as much time as possible to chew through them
+	std::deque<size_t> readyAsync, readySync;
+	auto markReady = [&](size_t ix) {
+		(nodes[ix].IsAsync ? readyAsync : readySync).push_back(ix);
+	};
+	for (size_t ix = 0; ix < nodes.size(); ix++) {
+		if (nodes[ix].NumDependencies == 0) {
+			markReady(ix);
+		}
+	}
+
+	const uint32_t total = static_cast<uint32_t>(nodes.size());
+	const uint32_t pendingAtStart = _pendingLoads;
+	uint32_t started = 0;
+	auto reportProgress = [&]() {
+		if (progress) {
+			uint32_t pending = _pendingLoads > pendingAtStart ? _pendingLoads - pendingAtStart : 0;
+			progress(started - std::min(pending, started), total);
+		}
+	};
+
+	std::vector<bool> loaded(nodes.size(), false);
+	auto loadNode = [&](size_t ix) {
+		PreloadNode& node = nodes[ix];
+		(*node.Loader)(*node.Blob);
+		loaded[ix] = true;
+		started++;
+
+		// Anything waiting on this resource can go once all it's other dependencies are loaded. Async resources
+		// can be referenced as soon as they're created, since they hold placeholder data until they finish
+		for (size_t dependent : node.Dependents) {
+			if (--nodes[dependent].NumDependencies == 0) {
+				markReady(dependent);
+			}
+		}
+	};
+
+	while (!readyAsync.empty() || !readySync.empty()) {
+		std::deque<size_t>& queue = !readyAsync.empty() ? readyAsync : readySync;
+		size_t ix = queue.front();
+		queue.pop_front();
+		loadNode(ix);
+
+		// Keep uploads flowing while the main thread does synchronous loads, so decoded data doesn't pile up
+		if (&queue == &readySync) {
+			ProcessUploads(0.0);
+		}
+		reportProgress();
+	}
+
+	// Anything left over is part of a cycle, we load them in manifest order and let ResourceManager::Get sort it out
+	for (size_t ix = 0; ix < nodes.size(); ix++) {
+		if (!loaded[ix]) {
+			LOG_WARN("Resource {} is part of a dependency cycle, loading in manifest order", (*nodes[ix].Blob)["guid"].dump());
+			loadNode(ix);
+			reportProgress();
+		}
+	}
+
+	// Finish off all the background loads, helping the workers with them one at a time so that we can
+	// upload and report progress in between
+	while (_pendingLoads > 0) {
+		uint32_t pendingBefore = _pendingLoads;
+		bool ranJob = JobSystem::TryRunJob(_loadCounter);
+		ProcessUploads(1.0 / 60.0);
+		if (_pendingLoads != pendingBefore) {
+			reportProgress();
+		} else if (!ranJob) {
+			// Nothing was queued or ready, the workers are busy with the last few loads
+			std::this_thread::yield();
+		}
+	}
+	reportProgress();
+
+	float endTime = static_cast<float>(glfwGetTime());
+	LOG_INFO("Preloaded {} resources in {} seconds", total, endTime - startTime);
+}
+
 void ResourceManager::SaveManifest(const std::string& path) {
 	// Update all resources in the manifest so they match their current representation
 	for (auto& [type, map] : _resources) {
@@ -52,7 +206,65 @@ void ResourceManager::SaveManifest(const std::string& path) {
 	FileHelpers::WriteContentsToFile(path, _manifest.dump(1,'\t'));
 }
 
+void ResourceManager::QueueLoad(const LoadCallback& load) {
+	_pendingLoads++;
+	JobSystem::Job job = [load]() {
+		UploadCallback upload = nullptr;
+		try {
+			upload = load();
+		}
+		catch (const std::exception& e) {
+			LOG_WARN("Background resource load failed: {}", e.what());
+		}
+
+		// We always queue something, so that the pending count is only decremented on the main thread
+		std::lock_guard<std::mutex> lock(_uploadMutex);
+		_uploads.push_back(upload != nullptr ? upload : []() {});
+	};
+
+	// Without any workers, a queued background job would only ever run when someone waits on the
+	// load counter, which the frame loop never does. In that case we just do the load right away
+	if (JobSystem::WorkerCount() == 0) {
+		job();
+	} else {
+		JobSystem::Submit(std::move(job), _loadCounter, JobPriority::Background);
+	}
+}
+
+void ResourceManager::ProcessUploads(double timeBudget) {
+	double startTime = glfwGetTime();
+	do {
+		UploadCallback upload;
+		{
+			std::lock_guard<std::mutex> lock(_uploadMutex);
+			if (_uploads.empty()) {
+				return;
+			}
+			upload = std::move(_uploads.front());
+			_uploads.pop_front();
+		}
+
+		upload();
+		_pendingLoads--;
+	} while (glfwGetTime() - startTime < timeBudget);
+}
+
+void ResourceManager::FinishLoads() {
+	// Help out with the loads while we wait, then upload everything that's left
+	JobSystem::Wait(_loadCounter);
+	while (_pendingLoads > 0) {
+		ProcessUploads(std::numeric_limits<double>::max());
+	}
+}
+
+uint32_t ResourceManager::GetPendingLoadCount() {
+	return _pendingLoads;
+}
+
 void ResourceManager::Cleanup() {
+	// Let any loads that are in flight finish, so they don't touch resources while we're freeing them
+	FinishLoads();
+
 	for (auto& [type, map] : _resources) {
 		map.clear();
 	}
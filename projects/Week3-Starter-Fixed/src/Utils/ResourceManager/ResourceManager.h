@@ -3,10 +3,13 @@
 #include <json.hpp>
 #include <unordered_map>
 #include <typeindex>
+#include <deque>
+#include <mutex>
 
 #include "Utils/GUID.hpp"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/StringUtils.h"
+#include "Application/JobSystem.h"
 
 /// <summary>
 /// Utility class for managing and loading resources from JSON
@@ -14,6 +17,21 @@
 /// </summary>
 class ResourceManager {
 public:
+	/// <summary>
+	/// Finishes loading a resource on the main thread, for instance by uploading decoded data to OpenGL
+	/// </summary>
+	typedef std::function<void()> UploadCallback;
+	/// <summary>
+	/// Performs the slow part of loading a resource (file IO, decoding) on a worker thread, and returns
+	/// the callback that will finish the load on the main thread, or nullptr if there's nothing left to do
+	/// </summary>
+	typedef std::function<UploadCallback()> LoadCallback;
+	/// <summary>
+	/// Reports how far along a manifest preload is, given the number of resources that have
+	/// finished loading and the total number of resources being loaded
+	/// </summary>
+	typedef std::function<void(uint32_t loaded, uint32_t total)> ProgressCallback;
+
 	/// <summary>
 	/// Initializes the resource manager and performs any first-time
 	/// setup required
@@ -31,17 +49,25 @@ public:
 	static std::shared_ptr<T> CreateAsset(TArgs&&... args) {
 		// Create and store the asset
 		std::shared_ptr<T> asset = std::make_shared<T>(std::forward<TArgs>(args)...);
-		_resources[std::type_index(typeid(T))][asset->IResource::GetGUID()] = asset;
-
-		// Get the JSON representation of the asset so we can store it in the manifest
-		nlohmann::json data = asset->ToJson();
-
-		// Make sure the data has the GUID
-		std::string guid = asset->IResource::GetGUID().str();
-		data["guid"] = guid;
+		_StoreAsset(asset);
+		return asset;
+	}
 
-		// Store the JSON data in the resource manifest (based on the type's name)
-		_manifest[StringTools::SanitizeClassName(typeid(T).name())][guid] = data;
+	/// <summary>
+	/// Creates a new asset that will finish loading in the background. The asset is returned right away
+	/// holding placeholder data, and is filled in by ProcessUploads once it's data is ready. The type must
+	/// provide a static LoadAsync method that accepts the given arguments
+	/// </summary>
+	/// <typeparam name="T">The type of asset to create</typeparam>
+	/// <typeparam name="...TArgs">The types for the arguments to forward to T::LoadAsync</typeparam>
+	/// <param name="...args">The arguments to forward to T::LoadAsync</param>
+	/// <returns>The newly created asset</returns>
+	template <typename T, typename ... TArgs, typename = std::enable_if<is_valid_resource<T>()>::type>
+	static std::shared_ptr<T> CreateAssetAsync(TArgs&&... args) {
+		std::shared_ptr<T> asset = T::LoadAsync(std::forward<TArgs>(args)...);
+		if (asset != nullptr) {
+			_StoreAsset(asset);
+		}
 		return asset;
 	}
 
@@ -75,6 +101,64 @@ public:
 		return result;
 	}
 
+	/// <summary>
+	/// Gets a shared pointer to the resource with the given type and GUID, if the resource needs to be loaded
+	/// from the manifest and the type supports it, the load will happen in the background and the resource will
+	/// hold placeholder data until it completes. Types without a static FromJsonAsync method are loaded right away
+	/// </summary>
+	/// <typeparam name="T">The type of resource to retreive</typeparam>
+	/// <param name="id">The ID of the resource to retrieve</param>
+	/// <returns>The resource with the given GUID, or nullptr if none exists</returns>
+	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
+	static std::shared_ptr<T> GetAsync(Guid id) {
+		if constexpr (test_json_async<T, const nlohmann::json&>::value) {
+			// Try and grab the asset from the resource pool
+			std::shared_ptr<T> result = std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
+
+			// If it's not loaded yet, we can start loading it from the manifest
+			if (result == nullptr) {
+				std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+				if (_manifest[typeName].contains(id)) {
+					const auto& data = _manifest[typeName][id];
+					result = T::FromJsonAsync(data);
+					if (result != nullptr) {
+						result->OverrideGUID(Guid(data["guid"]));
+						_resources[std::type_index(typeid(T))][result->GetGUID()] = result;
+					}
+				}
+			}
+			return result;
+		} else {
+			return Get<T>(id);
+		}
+	}
+
+	/// <summary>
+	/// Queues up a resource load to run on the job system. The callback returned by the load will be
+	/// invoked on the main thread from ProcessUploads. If the job system has no worker threads (it was
+	/// not started, or the machine only has one hardware thread), the load runs immediately on the
+	/// calling thread, but the upload is still deferred to ProcessUploads
+	/// 
+	/// Loads run at background priority, so workers only pick them up when there's no frame work to do,
+	/// and threads waiting on frame work will never pick them up
+	/// </summary>
+	/// <param name="load">The load to run in the background</param>
+	static void QueueLoad(const LoadCallback& load);
+	/// <summary>
+	/// Runs any uploads that have finished loading, should be called once per frame on the main thread
+	/// At least one upload will be processed per call, so loading will always make progress
+	/// </summary>
+	/// <param name="timeBudget">The time in seconds that can be spent on uploads before we stop for this frame</param>
+	static void ProcessUploads(double timeBudget);
+	/// <summary>
+	/// Blocks until all background loads have completed and been uploaded
+	/// </summary>
+	static void FinishLoads();
+	/// <summary>
+	/// Gets the number of background loads that have been queued and not yet uploaded
+	/// </summary>
+	static uint32_t GetPendingLoadCount();
+
 	/// <summary>
 	/// Registers a resource type with the resource manager, only types that have been registered
 	/// can be loaded from JSON manifest files!
@@ -94,6 +178,19 @@ public:
 			return res->GetGUID();
 		};
 
+		// Types that can load in the background get a second loader, which is used when preloading manifests
+		if constexpr (test_json_async<T, const nlohmann::json&>::value) {
+			_asyncTypeLoaders[typeName] = [](const nlohmann::json& data) {
+				std::shared_ptr<T> res = T::FromJsonAsync(data);
+				if (res == nullptr) {
+					return Guid();
+				}
+				res->OverrideGUID(Guid(data["guid"]));
+				_resources[std::type_index(typeid(T))][res->GetGUID()] = res;
+				return res->GetGUID();
+			};
+		}
+
 		// Make sure we haven't registered the type yet, then add an empty object
 		// to the manifest to ensure it can be saved
 		if (!_manifest.contains(typeName)) {
@@ -132,10 +229,15 @@ public:
 	/// <summary>
 	/// Loads a manifest file into the resource manager. Note that this will not perform load on the assets themselves 
 	/// unless preloadAssets is set to true
+	/// 
+	/// When preloading, resources are ordered by the GUIDs they reference (ex: materials after their shaders and textures).
+	/// Types that support background loading have their file IO and decoding spread across the job system, while everything
+	/// that touches OpenGL still happens on the calling thread. This call blocks until every resource has been uploaded
 	/// </summary>
 	/// <param name="path">The path to the JSON manifest file</param>
 	/// <param name="preloadAssets">True if all assets should be loaded into memory</param>
-	static void LoadManifest(const std::string& path, bool preloadAssets = false);
+	/// <param name="progress">Invoked on the calling thread as resources finish loading, can be used to draw a loading screen</param>
+	static void LoadManifest(const std::string& path, bool preloadAssets = false, const ProgressCallback& progress = nullptr);
 	/// <summary>
 	/// Saves the manifest to the given JSON file
 	/// </summary>
@@ -148,6 +250,24 @@ public:
 	static void Cleanup();
 
 protected:
+	/// <summary>
+	/// Stores a newly created asset and adds it to the manifest
+	/// </summary>
+	template <typename T>
+	static void _StoreAsset(const std::shared_ptr<T>& asset) {
+		_resources[std::type_index(typeid(T))][asset->IResource::GetGUID()] = asset;
+
+		// Get the JSON representation of the asset so we can store it in the manifest
+		nlohmann::json data = asset->ToJson();
+
+		// Make sure the data has the GUID
+		std::string guid = asset->IResource::GetGUID().str();
+		data["guid"] = guid;
+
+		// Store the JSON data in the resource manifest (based on the type's name)
+		_manifest[StringTools::SanitizeClassName(typeid(T).name())][guid] = data;
+	}
+
 	/// <summary>
 	/// This is a map of maps
 	/// The top level map uses type_index, so there's a map per resource type
@@ -158,10 +278,33 @@ protected:
 	/// This map stores registered types, so we can load them from JSON files
 	/// </summary>
 	static std::map<std::string, std::function<Guid(const nlohmann::json&)>> _typeLoaders;
+	/// <summary>
+	/// Same as _typeLoaders, but only for types with a FromJsonAsync method
+	/// </summary>
+	static std::map<std::string, std::function<Guid(const nlohmann::json&)>> _asyncTypeLoaders;
+
+	/// <summary>
+	/// Loads every resource in the manifest, in dependency order
+	/// </summary>
+	static void _PreloadManifest(const ProgressCallback& progress);
 
 	/// <summary>
 	/// We use an ORDERED JSON file to allow serializing types in the order they are registered.
 	/// This allows us to register dependencies before the dependent resource
 	/// </summary>
 	static nlohmann::ordered_json _manifest;
+
+	/// <summary>
+	/// Tracks all background loads that are still running on the job system
+	/// </summary>
+	static JobCounter _loadCounter;
+	/// <summary>
+	/// Uploads that are ready to be run on the main thread, guarded by _uploadMutex
+	/// </summary>
+	static std::deque<UploadCallback> _uploads;
+	static std::mutex _uploadMutex;
+	/// <summary>
+	/// The number of loads that have been queued, but not uploaded
+	/// </summary>
+	static std::atomic<uint32_t> _pendingLoads;
 };
\ No newline at end of file
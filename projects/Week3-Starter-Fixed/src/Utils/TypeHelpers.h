@@ -8,7 +8,15 @@ namespace detail {
 	static auto test_json(int)->sfinae_true<decltype(std::declval<T>().FromJson(std::declval<A0>()))>;
 	template<class, class A0>
 	static auto test_json(long)->std::false_type;
+
+	template<class T, class A0>
+	static auto test_json_async(int)->sfinae_true<decltype(T::FromJsonAsync(std::declval<A0>()))>;
+	template<class, class A0>
+	static auto test_json_async(long)->std::false_type;
 } // detail::
 
 template<class T, class Arg>
-struct test_json : decltype(detail::test_json<T, Arg>(0)){};
\ No newline at end of file
+struct test_json : decltype(detail::test_json<T, Arg>(0)){};
+
+template<class T, class Arg>
+struct test_json_async : decltype(detail::test_json_async<T, Arg>(0)){};
@@ -0,0 +1,152 @@
+#include "Utils/VirtualFileSystem.h"
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <gzip/decompress.hpp>
+
+#include "Logging.h"
+
+namespace fs = std::filesystem;
+
+std::mutex VirtualFileSystem::__mountMutex;
+std::vector<AssetPack::Sptr> VirtualFileSystem::__packs;
+
+VirtualFile::VirtualFile() :
+	_data(nullptr),
+	_size(0),
+	_isOpen(false),
+	_looseFile(),
+	_inflated(""),
+	_pack(nullptr)
+{ }
+
+VirtualFile::VirtualFile(const std::string& filename) :
+	VirtualFile()
+{
+	Open(filename);
+}
+
+bool VirtualFile::Open(const std::string& filename) {
+	Close();
+
+	// Check the mounted packs first
+	const AssetPack::Entry* entry = nullptr;
+	AssetPack::Sptr pack = VirtualFileSystem::FindInPacks(filename, &entry);
+	if (pack != nullptr) {
+		const uint8_t* data = pack->GetData(*entry);
+		if (entry->Compressed) {
+			_inflated = gzip::decompress(reinterpret_cast<const char*>(data), entry->Size);
+			if (_inflated.size() != entry->UncompressedSize) {
+				LOG_ERROR("Failed to inflate \"{}\" from \"{}\"", filename, pack->GetFilename());
+				_inflated.clear();
+				return false;
+			}
+			_data = reinterpret_cast<const uint8_t*>(_inflated.data());
+		} else {
+			_data = data;
+		}
+		_size = static_cast<size_t>(entry->UncompressedSize);
+		_pack = pack;
+		_isOpen = true;
+		return true;
+	}
+
+	// Fall back to loose files on disk
+	if (_looseFile.Open(filename)) {
+		_data = _looseFile.GetData();
+		_size = _looseFile.GetSize();
+		_isOpen = true;
+		return true;
+	}
+
+	// Empty files can't be mapped, but they still exist
+	std::error_code error;
+	if (fs::is_regular_file(filename, error) && fs::file_size(filename, error) == 0 && !error) {
+		_isOpen = true;
+		return true;
+	}
+
+	return false;
+}
+
+void VirtualFile::Close() {
+	_looseFile.Close();
+	_inflated.clear();
+	_inflated.shrink_to_fit();
+	_pack = nullptr;
+	_data = nullptr;
+	_size = 0;
+	_isOpen = false;
+}
+
+void VirtualFile::Prefetch() const {
+	// Inflated data is already in memory, and packs are left to page in as they are read
+	if (_looseFile.IsOpen()) {
+		_looseFile.Prefetch();
+	}
+}
+
+bool VirtualFileSystem::Mount(const std::string& filename) {
+	AssetPack::Sptr pack = std::make_shared<AssetPack>();
+	if (!pack->Open(filename)) {
+		LOG_WARN("Failed to mount asset pack \"{}\"", filename);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(__mountMutex);
+	__packs.push_back(pack);
+	return true;
+}
+
+void VirtualFileSystem::Unmount(const std::string& filename) {
+	std::lock_guard<std::mutex> lock(__mountMutex);
+	__packs.erase(std::remove_if(__packs.begin(), __packs.end(), [&](const AssetPack::Sptr& pack) {
+		return pack->GetFilename() == filename;
+	}), __packs.end());
+}
+
+void VirtualFileSystem::UnmountAll() {
+	std::lock_guard<std::mutex> lock(__mountMutex);
+	__packs.clear();
+}
+
+AssetPack::Sptr VirtualFileSystem::FindInPacks(const std::string& filename, const AssetPack::Entry** entry) {
+	std::lock_guard<std::mutex> lock(__mountMutex);
+	if (__packs.empty()) {
+		return nullptr;
+	}
+
+	// Packs mounted later take priority, so they can patch earlier packs
+	std::string path = AssetPack::NormalizePath(filename);
+	for (auto it = __packs.rbegin(); it != __packs.rend(); it++) {
+		const AssetPack::Entry* result = (*it)->Find(path);
+		if (result != nullptr) {
+			if (entry != nullptr) {
+				*entry = result;
+			}
+			return *it;
+		}
+	}
+	return nullptr;
+}
+
+bool VirtualFileSystem::Exists(const std::string& filename) {
+	if (FindInPacks(filename, nullptr) != nullptr) {
+		return true;
+	}
+	std::error_code error;
+	return fs::is_regular_file(filename, error);
+}
+
+bool VirtualFileSystem::ReadFile(const std::string& filename, std::string& result) {
+	VirtualFile file;
+	if (!file.Open(filename)) {
+		return false;
+	}
+	if (file.GetSize() > 0) {
+		result.assign(reinterpret_cast<const char*>(file.GetData()), file.GetSize());
+	} else {
+		result.clear();
+	}
+	return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include "Utils/Macros.h"
+#include "Utils/MappedFile.h"
+#include "Utils/AssetPack.h"
+
+/// <summary>
+/// A read-only view of a file that may come from a mounted asset pack, or from a loose file on disk.
+/// Uncompressed entries in a pack and loose files are both memory mapped, so no copies are made unless
+/// the entry was compressed in the pack
+/// </summary>
+class VirtualFile final {
+public:
+	MAKE_PTRS(VirtualFile);
+	NO_COPY(VirtualFile);
+	NO_MOVE(VirtualFile);
+
+	VirtualFile();
+	/// <summary>
+	/// Creates a new virtual file and opens the given path
+	/// </summary>
+	/// <param name="filename">The path of the file to open</param>
+	VirtualFile(const std::string& filename);
+	~VirtualFile() = default;
+
+	/// <summary>
+	/// Opens a file through the VirtualFileSystem, closing any file that was previously open. Mounted packs
+	/// are searched first, then the file system
+	/// </summary>
+	/// <param name="filename">The path of the file to open</param>
+	/// <returns>True if the file was opened, false if it could not be found</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Closes the file, any pointers returned by GetData will no longer be valid
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if a file is currently open
+	/// </summary>
+	bool IsOpen() const { return _isOpen; }
+	/// <summary>
+	/// Returns true if the file was found in an asset pack, rather than on disk
+	/// </summary>
+	bool IsPacked() const { return _pack != nullptr; }
+	/// <summary>
+	/// Gets a pointer to the start of the file's contents, or nullptr if no file is open (or the file is empty)
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the file in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+	/// <summary>
+	/// Hints to the OS that we are about to read the whole file, so that it can start paging it in
+	/// ahead of time. This is only a hint and may do nothing
+	/// </summary>
+	void Prefetch() const;
+
+protected:
+	const uint8_t*  _data;
+	size_t          _size;
+	bool            _isOpen;
+
+	// Used when the file is loose on disk
+	MappedFile      _looseFile;
+	// Used when the file was compressed in a pack, and had to be inflated
+	std::string     _inflated;
+	// Keeps the pack mapped for as long as we're pointing into it
+	AssetPack::Sptr _pack;
+};
+
+/// <summary>
+/// Lets loaders read files without needing to know whether they are loose on disk or stored in an asset pack.
+/// Any number of packs can be mounted, packs that are mounted later are searched first. Files that aren't in
+/// any mounted pack are read from disk, so packs can hold a subset of the game's files
+/// </summary>
+class VirtualFileSystem {
+public:
+	VirtualFileSystem() = delete;
+
+	/// <summary>
+	/// Opens an asset pack and adds it to the search list
+	/// </summary>
+	/// <param name="filename">The path to the asset pack to mount</param>
+	/// <returns>True if the pack was mounted, false if it could not be opened</returns>
+	static bool Mount(const std::string& filename);
+	/// <summary>
+	/// Removes an asset pack from the search list. The pack will stay mapped until any files that
+	/// were opened from it are closed
+	/// </summary>
+	/// <param name="filename">The path the pack was mounted from</param>
+	static void Unmount(const std::string& filename);
+	/// <summary>
+	/// Removes all asset packs from the search list
+	/// </summary>
+	static void UnmountAll();
+
+	/// <summary>
+	/// Returns true if the file exists in a mounted pack or on disk
+	/// </summary>
+	static bool Exists(const std::string& filename);
+	/// <summary>
+	/// Finds the mounted pack that holds a file
+	/// </summary>
+	/// <param name="filename">The path of the file to find</param>
+	/// <param name="entry">Will store the file's entry in the pack, if found</param>
+	/// <returns>The pack containing the file, or nullptr if it's not in any mounted pack</returns>
+	static AssetPack::Sptr FindInPacks(const std::string& filename, const AssetPack::Entry** entry);
+
+	/// <summary>
+	/// Reads the entire contents of a file into a string
+	/// </summary>
+	/// <param name="filename">The path of the file to read</param>
+	/// <param name="result">Will store the contents of the file</param>
+	/// <returns>True if the file was read, false if it could not be found</returns>
+	static bool ReadFile(const std::string& filename, std::string& result);
+
+protected:
+	// Guards the mount list, since loaders may look up files from worker threads
+	static std::mutex __mountMutex;
+	static std::vector<AssetPack::Sptr> __packs;
+};